@@ -0,0 +1,241 @@
+/* adc_openhpsdr_u.c
+ * OpenHPSDR USB over IP protocol EP4 raw ADC sample statistics and histograms
+ *
+ * Version: 0.5.0
+ * Author:  Matthew J Wolf, N4MTT
+ *
+ * This file is part of the OpenHPSDR-USB Plug-in for Wireshark.
+ * Matthew J. Wolf <matthew.wolf.hpsdr@speciosus.net>
+ * Copyright 2020 Matthew J. Wolf
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * The OpenHPSDR-USB Plug-in for Wireshark is free software: you can
+ * redistribute it and/or modify it under the terms of the GNU
+ * General Public License as published by the Free Software Foundation,
+ * either version 2 of the License, or (at your option) any later version.
+ *
+ * The OpenHPSDR-USB Plug-in for Wireshark is distributed in the hope that
+ * it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See
+ * the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the OpenHPSDR-USB Plug-in for Wireshark.
+ * If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <epan/packet.h>
+
+#include <math.h>
+#include "adc_openhpsdr_u.h"
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+// 16 bit big endian signed sample
+#define ADC_SAMPLE(p) ( (gint16)( ( (p)[0] << 8 ) | (p)[1] ) )
+
+// Histogram index, offset binary. Index 0 is code -32768.
+#define ADC_INDEX(p)  ( ( ( (p)[0] << 8 ) | (p)[1] ) ^ 0x8000 )
+
+// Samples per SSE2 block, the 16 and 32 bit lane counters do not overflow.
+#define ADC_BLOCK 4096
+
+void hpsdr_u_adc_stats_add(hpsdr_u_adc_stats_t *stats, const guint8 *data, int count)
+{
+   double sum = 0;
+   double sum_sq = 0;
+   guint32 near_rail = 0;
+   guint32 rail = 0;
+   gint32 min = 32767;
+   gint32 max = -32768;
+   gint32 sample = 0;
+   int x = 0;
+
+#ifdef __SSE2__
+   // Eight samples at a time. The bytes are swapped to host order in the
+   // registers. The sums of squares are added as unsigned 32 bit pairs
+   // (two full scale samples are 2^31) then as 64 bit.
+   __m128i v_min = _mm_set1_epi16(32767);
+   __m128i v_max = _mm_set1_epi16(-32768);
+   __m128i v_ones = _mm_set1_epi16(1);
+   __m128i v_near_hi = _mm_set1_epi16(HPSDR_U_ADC_NEAR_RAIL - 1);
+   __m128i v_near_lo = _mm_set1_epi16(-( HPSDR_U_ADC_NEAR_RAIL - 1 ));
+   __m128i v_rail_hi = _mm_set1_epi16(32767);
+   __m128i v_rail_lo = _mm_set1_epi16(-32768);
+   __m128i v_zero = _mm_setzero_si128();
+   __m128i v, v_sq, v_sum, v_sum_sq, v_near, v_rail;
+   gint16 lanes16[8];
+   gint32 lanes32[4];
+   gint64 lanes64[2];
+   int block = 0;
+   int y = 0;
+
+   for (x = 0; x + 8 <= count; ) {
+      block = x + ADC_BLOCK;
+      if ( block > count ) { block = count; }
+
+      v_sum = _mm_setzero_si128();
+      v_sum_sq = _mm_setzero_si128();
+      v_near = _mm_setzero_si128();
+      v_rail = _mm_setzero_si128();
+
+      for (; x + 8 <= block; x += 8) {
+         v = _mm_loadu_si128((const __m128i *)( data + ( x * 2 ) ));
+         v = _mm_or_si128(_mm_slli_epi16(v, 8), _mm_srli_epi16(v, 8));
+
+         v_min = _mm_min_epi16(v_min, v);
+         v_max = _mm_max_epi16(v_max, v);
+
+         v_sum = _mm_add_epi32(v_sum, _mm_madd_epi16(v, v_ones));
+         v_sq = _mm_madd_epi16(v, v);
+         v_sum_sq = _mm_add_epi64(v_sum_sq, _mm_unpacklo_epi32(v_sq, v_zero));
+         v_sum_sq = _mm_add_epi64(v_sum_sq, _mm_unpackhi_epi32(v_sq, v_zero));
+
+         // A compare is -1 in the lanes that match.
+         v_near = _mm_sub_epi16(v_near, _mm_or_si128(_mm_cmpgt_epi16(v, v_near_hi),
+                                                     _mm_cmplt_epi16(v, v_near_lo)));
+         v_rail = _mm_sub_epi16(v_rail, _mm_or_si128(_mm_cmpeq_epi16(v, v_rail_hi),
+                                                     _mm_cmpeq_epi16(v, v_rail_lo)));
+      }
+
+      _mm_storeu_si128((__m128i *)lanes32, v_sum);
+      sum += (double)lanes32[0] + lanes32[1] + lanes32[2] + lanes32[3];
+      _mm_storeu_si128((__m128i *)lanes64, v_sum_sq);
+      sum_sq += (double)lanes64[0] + (double)lanes64[1];
+      _mm_storeu_si128((__m128i *)lanes16, v_near);
+      for (y = 0; y < 8; y++) { near_rail += (guint16)lanes16[y]; }
+      _mm_storeu_si128((__m128i *)lanes16, v_rail);
+      for (y = 0; y < 8; y++) { rail += (guint16)lanes16[y]; }
+   }
+
+   _mm_storeu_si128((__m128i *)lanes16, v_min);
+   for (y = 0; y < 8; y++) { if ( lanes16[y] < min ) { min = lanes16[y]; } }
+   _mm_storeu_si128((__m128i *)lanes16, v_max);
+   for (y = 0; y < 8; y++) { if ( lanes16[y] > max ) { max = lanes16[y]; } }
+#endif
+
+   // The samples left over from the SSE2 loop, or all of them without SSE2.
+   for (; x < count; x++) {
+      sample = ADC_SAMPLE(data + ( x * 2 ));
+
+      if ( sample < min ) { min = sample; }
+      if ( sample > max ) { max = sample; }
+      if ( sample >= HPSDR_U_ADC_NEAR_RAIL || sample <= -HPSDR_U_ADC_NEAR_RAIL ) { near_rail += 1; }
+      if ( sample == 32767 || sample == -32768 ) { rail += 1; }
+
+      sum += sample;
+      sum_sq += (double)sample * sample;
+   }
+
+   if ( count <= 0 ) { return; }
+
+   if ( stats->count == 0 || min < stats->min ) { stats->min = min; }
+   if ( stats->count == 0 || max > stats->max ) { stats->max = max; }
+   stats->count += count;
+   stats->near_rail += near_rail;
+   stats->rail += rail;
+   stats->sum += sum;
+   stats->sum_sq += sum_sq;
+}
+
+void hpsdr_u_adc_stats_merge(hpsdr_u_adc_stats_t *to, const hpsdr_u_adc_stats_t *from)
+{
+   if ( from->count == 0 ) { return; }
+
+   if ( to->count == 0 || from->min < to->min ) { to->min = from->min; }
+   if ( to->count == 0 || from->max > to->max ) { to->max = from->max; }
+   to->count += from->count;
+   to->near_rail += from->near_rail;
+   to->rail += from->rail;
+   to->sum += from->sum;
+   to->sum_sq += from->sum_sq;
+}
+
+// A scatter does not vectorize with SSE2. Samples next to each other often
+// have the same code, with one table every increment waits for the one
+// before it. The even and odd samples go to their own table so two
+// increments are in flight at a time.
+void hpsdr_u_adc_hist_add(guint32 *hist, const guint8 *data, int count)
+{
+   guint32 *odd = hist + HPSDR_U_ADC_CODES;
+   const guint8 *p = data;
+   int x = 0;
+
+   for (x = 0; x + 2 <= count; x += 2) {
+      hist[ADC_INDEX(p)] += 1;
+      odd[ADC_INDEX(p + 2)] += 1;
+      p += 4;
+   }
+
+   if ( x < count ) { hist[ADC_INDEX(p)] += 1; }
+}
+
+guint32 hpsdr_u_adc_hist_count(const guint32 *hist, int code)
+{
+   int index = ( code + 32768 ) & 0xFFFF;
+
+   return hist[index] + hist[HPSDR_U_ADC_CODES + index];
+}
+
+double hpsdr_u_adc_dc(const hpsdr_u_adc_stats_t *stats)
+{
+   if ( stats->count == 0 ) { return 0.0; }
+
+   return ( stats->sum / stats->count );
+}
+
+// 0 dBFS is a sample of 2^15.
+double hpsdr_u_adc_rms_dbfs(const hpsdr_u_adc_stats_t *stats)
+{
+   if ( stats->count == 0 || stats->sum_sq <= 0 ) { return HPSDR_U_ADC_DBFS_FLOOR; }
+
+   return ( 10.0 * log10(( stats->sum_sq / stats->count ) /
+                         ( HPSDR_U_ADC_FULL_SCALE * HPSDR_U_ADC_FULL_SCALE )) );
+}
+
+double hpsdr_u_adc_peak_dbfs(const hpsdr_u_adc_stats_t *stats)
+{
+   double peak = 0;
+
+   if ( stats->count == 0 ) { return HPSDR_U_ADC_DBFS_FLOOR; }
+
+   peak = MAX(fabs((double)stats->min), fabs((double)stats->max));
+   if ( peak <= 0 ) { return HPSDR_U_ADC_DBFS_FLOOR; }
+
+   return ( 20.0 * log10(peak / HPSDR_U_ADC_FULL_SCALE) );
+}
+
+// Bits used by the peak to peak swing of the samples, 16 is full scale.
+double hpsdr_u_adc_peak_bits(const hpsdr_u_adc_stats_t *stats)
+{
+   if ( stats->count == 0 ) { return 0.0; }
+
+   return log2((double)stats->max - stats->min + 1);
+}
+
+// Effective bits used, the entropy of the code histogram. Noise that only
+// moves the lowest bits is a few bits, a signal that uses every code
+// evenly is 16 bits.
+double hpsdr_u_adc_hist_bits(const guint32 *hist)
+{
+   double total = 0;
+   double sum = 0;
+   guint32 count = 0;
+   int x = 0;
+
+   for (x = 0; x < HPSDR_U_ADC_CODES; x++) {
+      count = hist[x] + hist[HPSDR_U_ADC_CODES + x];
+      if ( count == 0 ) { continue; }
+      total += count;
+      sum += count * log2((double)count);
+   }
+
+   if ( total == 0 ) { return 0.0; }
+
+   return ( log2(total) - ( sum / total ) );
+}
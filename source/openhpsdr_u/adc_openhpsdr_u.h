@@ -0,0 +1,62 @@
+/* adc_openhpsdr_u.h
+ * Header file for the OpenHPSDR USB over IP protocol EP4 raw ADC sample statistics
+ *
+ * Version: 0.5.0
+ * Author:  Matthew J Wolf, N4MTT
+ *
+ * This file is part of the OpenHPSDR-USB Plug-in for Wireshark.
+ * Matthew J. Wolf <matthew.wolf.hpsdr@speciosus.net>
+ * Copyright 2020 Matthew J. Wolf
+ *
+ * The OpenHPSDR-USB Plug-in for Wireshark is free software: you can
+ * redistribute it and/or modify it under the terms of the GNU
+ * General Public License as published by the Free Software Foundation,
+ * either version 2 of the License, or (at your option) any later version.
+ *
+ * The OpenHPSDR-USB Plug-in for Wireshark is distributed in the hope that
+ * it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See
+ * the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the OpenHPSDR-USB Plug-in for Wireshark.
+ * If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __ADC_OPENHPSDR_U_H__
+#define __ADC_OPENHPSDR_U_H__
+
+#define HPSDR_U_ADC_CODES      65536     // 16 bit ADC codes
+#define HPSDR_U_ADC_FULL_SCALE 32768.0   // 2^15, 16 bit signed samples
+#define HPSDR_U_ADC_NEAR_RAIL  32440     // 99% of full scale
+#define HPSDR_U_ADC_DBFS_FLOOR -200.0    // dBFS used for no signal
+
+// Sums of EP4 raw ADC samples. Merged with hpsdr_u_adc_stats_merge().
+typedef struct _hpsdr_u_adc_stats_t {
+   guint32 count;               // Samples
+   guint32 near_rail;           // Samples at 99% of full scale or more
+   guint32 rail;                // Samples at the largest or smallest code
+   gint32 min;
+   gint32 max;
+   double sum;
+   double sum_sq;
+} hpsdr_u_adc_stats_t;
+
+// Add count big endian 16 bit samples.
+void hpsdr_u_adc_stats_add(hpsdr_u_adc_stats_t *stats, const guint8 *data, int count);
+void hpsdr_u_adc_stats_merge(hpsdr_u_adc_stats_t *to, const hpsdr_u_adc_stats_t *from);
+
+// Code histogram of count big endian 16 bit samples. hist has room for
+// 2 * HPSDR_U_ADC_CODES counts, the even and the odd samples are counted
+// in their own table. Index 0 is code -32768. hpsdr_u_adc_hist_count()
+// adds the two tables.
+void hpsdr_u_adc_hist_add(guint32 *hist, const guint8 *data, int count);
+guint32 hpsdr_u_adc_hist_count(const guint32 *hist, int code);
+
+double hpsdr_u_adc_dc(const hpsdr_u_adc_stats_t *stats);
+double hpsdr_u_adc_rms_dbfs(const hpsdr_u_adc_stats_t *stats);
+double hpsdr_u_adc_peak_dbfs(const hpsdr_u_adc_stats_t *stats);
+double hpsdr_u_adc_peak_bits(const hpsdr_u_adc_stats_t *stats);
+double hpsdr_u_adc_hist_bits(const guint32 *hist);
+
+#endif
@@ -0,0 +1,81 @@
+/* cal_openhpsdr_u.c
+ * OpenHPSDR USB over IP protocol telemetry calibration
+ *
+ * Version: 0.5.0
+ * Author:  Matthew J Wolf, N4MTT
+ *
+ * This file is part of the OpenHPSDR-USB Plug-in for Wireshark.
+ * Matthew J. Wolf <matthew.wolf.hpsdr@speciosus.net>
+ * Copyright 2020 Matthew J. Wolf
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * The OpenHPSDR-USB Plug-in for Wireshark is free software: you can
+ * redistribute it and/or modify it under the terms of the GNU
+ * General Public License as published by the Free Software Foundation,
+ * either version 2 of the License, or (at your option) any later version.
+ *
+ * The OpenHPSDR-USB Plug-in for Wireshark is distributed in the hope that
+ * it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See
+ * the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the OpenHPSDR-USB Plug-in for Wireshark.
+ * If not, see <http://www.gnu.org/licenses/>.
+ *
+ * One calibration table for the dissector and the telemetry tap, the
+ * values of a reading are the same in the tree and in the report.
+ */
+
+#include <epan/packet.h>
+
+#include "cal_openhpsdr_u.h"
+
+static const hpsdr_u_cal_t hpsdr_u_cals[] = {
+   { 0x00, "Metis",       0.09f,  3.3f,  6, 3.3f, ( 4.7f + 0.82f ) / 0.82f },
+   { 0x01, "Hermes",      0.09f,  3.3f,  6, 3.3f, ( 4.7f + 0.82f ) / 0.82f },
+   { 0x02, "Griffin",     0.09f,  3.3f,  6, 3.3f, ( 4.7f + 0.82f ) / 0.82f },
+   { 0x04, "Angelia",     0.095f, 3.3f,  6, 3.3f, ( 4.7f + 0.82f ) / 0.82f },
+   { 0x05, "Orion",       0.108f, 5.0f,  4, 5.0f, ( 22.0f + 1.0f ) / 1.1f  },
+   { 0x06, "Hermes-Lite", 1.5f,   3.3f,  6, 3.3f, ( 4.7f + 0.82f ) / 0.82f },
+   { 0x0A, "Orion MkII",  0.08f,  5.0f, 18, 5.0f, ( 22.0f + 1.0f ) / 1.1f  },
+};
+
+// Used when no discovery reply was captured.
+static const hpsdr_u_cal_t hpsdr_u_cal_unknown =
+   { 0xFF, "Unknown (Hermes)", 0.09f, 3.3f, 6, 3.3f, ( 4.7f + 0.82f ) / 0.82f };
+
+const hpsdr_u_cal_t *hpsdr_u_cal(guint8 board_id)
+{
+   guint x = 0;
+
+   for (x = 0; x < G_N_ELEMENTS(hpsdr_u_cals); x++) {
+      if ( hpsdr_u_cals[x].board_id == board_id ) { return &hpsdr_u_cals[x]; }
+   }
+
+   return &hpsdr_u_cal_unknown;
+}
+
+double hpsdr_u_cal_power_volts(const hpsdr_u_cal_t *cal, guint16 raw_bytes)
+{
+   if ( raw_bytes <= cal->adc_cal_offset ) { return 0.0; }
+
+   return ( raw_bytes - cal->adc_cal_offset ) / 4095.0 * cal->refvoltage;
+}
+
+double hpsdr_u_cal_power_watts(const hpsdr_u_cal_t *cal, guint16 raw_bytes)
+{
+   double volts = 0;
+
+   volts = hpsdr_u_cal_power_volts(cal, raw_bytes);
+
+   return ( ( volts * volts ) / cal->bridge_volt );
+}
+
+double hpsdr_u_cal_supply_volts(const hpsdr_u_cal_t *cal, guint16 raw_bytes)
+{
+   return ( raw_bytes / 4095.0 * cal->supply_ref ) * cal->supply_divider;
+}
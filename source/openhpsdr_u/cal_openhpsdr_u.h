@@ -0,0 +1,53 @@
+/* cal_openhpsdr_u.h
+ * Header file for the OpenHPSDR USB over IP protocol telemetry calibration
+ *
+ * Version: 0.5.0
+ * Author:  Matthew J Wolf, N4MTT
+ *
+ * This file is part of the OpenHPSDR-USB Plug-in for Wireshark.
+ * Matthew J. Wolf <matthew.wolf.hpsdr@speciosus.net>
+ * Copyright 2020 Matthew J. Wolf
+ *
+ * The OpenHPSDR-USB Plug-in for Wireshark is free software: you can
+ * redistribute it and/or modify it under the terms of the GNU
+ * General Public License as published by the Free Software Foundation,
+ * either version 2 of the License, or (at your option) any later version.
+ *
+ * The OpenHPSDR-USB Plug-in for Wireshark is distributed in the hope that
+ * it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See
+ * the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the OpenHPSDR-USB Plug-in for Wireshark.
+ * If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __CAL_OPENHPSDR_U_H__
+#define __CAL_OPENHPSDR_U_H__
+
+// Calibration of the EP6 telemetry readings of a board.
+// Math from OpenHPSDR PowerSDR - console.cs
+// Bill Tracey (KD5TFD) - Doug Wigley (W5WC) - Warren Pratt (NR0V)
+typedef struct _hpsdr_u_cal_t {
+   guint8 board_id;
+   const gchar *name;
+   float bridge_volt;           // Alex / PA coupler bridge voltage
+   float refvoltage;            // ADC reference voltage
+   int adc_cal_offset;          // ADC counts subtracted from the power readings
+   float supply_ref;            // Power supply (AIN6) ADC reference voltage
+   float supply_divider;        // Power supply (AIN6) resistor divider
+} hpsdr_u_cal_t;
+
+// Calibration of the board, the Hermes calibration when the board ID is
+// not known (0xFF) or not in the table.
+const hpsdr_u_cal_t *hpsdr_u_cal(guint8 board_id);
+
+// Volts and watts of a forward or reverse power reading.
+double hpsdr_u_cal_power_volts(const hpsdr_u_cal_t *cal, guint16 raw_bytes);
+double hpsdr_u_cal_power_watts(const hpsdr_u_cal_t *cal, guint16 raw_bytes);
+
+// Volts of the power supply reading.
+double hpsdr_u_cal_supply_volts(const hpsdr_u_cal_t *cal, guint16 raw_bytes);
+
+#endif
@@ -0,0 +1,142 @@
+/* continuity_openhpsdr_u.c
+ * OpenHPSDR USB over IP protocol IQ sample continuity
+ *
+ * Version: 0.5.0
+ * Author:  Matthew J Wolf, N4MTT
+ *
+ * This file is part of the OpenHPSDR-USB Plug-in for Wireshark.
+ * Matthew J. Wolf <matthew.wolf.hpsdr@speciosus.net>
+ * Copyright 2020 Matthew J. Wolf
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * The OpenHPSDR-USB Plug-in for Wireshark is free software: you can
+ * redistribute it and/or modify it under the terms of the GNU
+ * General Public License as published by the Free Software Foundation,
+ * either version 2 of the License, or (at your option) any later version.
+ *
+ * The OpenHPSDR-USB Plug-in for Wireshark is distributed in the hope that
+ * it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See
+ * the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the OpenHPSDR-USB Plug-in for Wireshark.
+ * If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <epan/packet.h>
+
+#include <math.h>
+#include "iq_openhpsdr_u.h"
+#include "continuity_openhpsdr_u.h"
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+int hpsdr_u_cont_add(hpsdr_u_cont_t *cont, const gint32 *i, const gint32 *q, int count,
+                     hpsdr_u_cont_event_t *events, int max)
+{
+   const double level = HPSDR_U_CONT_LEVEL * HPSDR_U_CONT_LEVEL * HPSDR_U_IQ_FULL_SCALE * HPSDR_U_IQ_FULL_SCALE;
+   double si = 0;
+   double sq = 0;
+   double p = 0;
+   double norm = 0;
+   double ui = 0;
+   double uq = 0;
+   double ri = 0;
+   double rq = 0;
+   double pi = 0;
+   double pq = 0;
+   double ei = 0;
+   double eq = 0;
+   double coherence = 0;
+   double error = 0;
+   int found = 0;
+   int x = 0;
+
+   for (x = 0; x < count; x++) {
+      si = i[x];
+      sq = q[x];
+      p = ( si * si ) + ( sq * sq );
+      cont->samples += 1;
+
+      if ( !cont->have_prev ) {
+         cont->prev_i = si;
+         cont->prev_q = sq;
+         cont->power = p;
+         cont->have_prev = TRUE;
+         continue;
+      }
+
+      coherence = sqrt(( cont->rot_i * cont->rot_i ) + ( cont->rot_q * cont->rot_q ));
+      error = -1;
+
+      if ( coherence > 0 && cont->power > 0 ) {
+         // Predicted sample, the sample before turned by the carrier rotation.
+         ri = cont->rot_i / coherence;
+         rq = cont->rot_q / coherence;
+         pi = ( cont->prev_i * ri ) - ( cont->prev_q * rq );
+         pq = ( cont->prev_i * rq ) + ( cont->prev_q * ri );
+         ei = si - pi;
+         eq = sq - pq;
+         error = ( ( ei * ei ) + ( eq * eq ) ) / cont->power;
+      }
+
+      if ( cont->steady >= HPSDR_U_CONT_LOCK ) {
+         cont->checked += 1;
+
+         if ( error > HPSDR_U_CONT_ERROR_MIN && error > HPSDR_U_CONT_ERROR * cont->error ) {
+            if ( found < max ) {
+               events[found].offset = x;
+               events[found].phase_deg = atan2(( sq * pi ) - ( si * pq ), ( si * pi ) + ( sq * pq )) * 180.0 / M_PI;
+               events[found].amp_db = ( p > 0 ) ? 10.0 * log10(p / cont->power) : HPSDR_U_IQ_DBFS_FLOOR;
+            }
+            found += 1;
+            cont->events += 1;
+
+            // The carrier goes on from the new phase, the averages are kept.
+            cont->prev_i = si;
+            cont->prev_q = sq;
+            continue;
+         }
+      }
+
+      // Rotation from the sample before, made unit length.
+      ui = ( si * cont->prev_i ) + ( sq * cont->prev_q );
+      uq = ( sq * cont->prev_i ) - ( si * cont->prev_q );
+      norm = sqrt(( ui * ui ) + ( uq * uq ));
+      if ( norm > 0 ) {
+         ui /= norm;
+         uq /= norm;
+      }
+
+      cont->rot_i += HPSDR_U_CONT_SMOOTH * ( ui - cont->rot_i );
+      cont->rot_q += HPSDR_U_CONT_SMOOTH * ( uq - cont->rot_q );
+      cont->power += HPSDR_U_CONT_SMOOTH * ( p - cont->power );
+      if ( error >= 0 ) { cont->error += HPSDR_U_CONT_SMOOTH * ( error - cont->error ); }
+
+      if ( cont->power > level && coherence > HPSDR_U_CONT_COHERENCE ) {
+         cont->steady += 1;
+      } else {
+         cont->steady = 0;
+      }
+
+      cont->prev_i = si;
+      cont->prev_q = sq;
+   }
+
+   return found;
+}
+
+void hpsdr_u_cont_break(hpsdr_u_cont_t *cont)
+{
+   cont->have_prev = FALSE;
+   cont->rot_i = 0;
+   cont->rot_q = 0;
+   cont->error = 0;
+   cont->steady = 0;
+}
@@ -0,0 +1,71 @@
+/* continuity_openhpsdr_u.h
+ * Header file for the OpenHPSDR USB over IP protocol IQ continuity
+ *
+ * Version: 0.5.0
+ * Author:  Matthew J Wolf, N4MTT
+ *
+ * This file is part of the OpenHPSDR-USB Plug-in for Wireshark.
+ * Matthew J. Wolf <matthew.wolf.hpsdr@speciosus.net>
+ * Copyright 2020 Matthew J. Wolf
+ *
+ * The OpenHPSDR-USB Plug-in for Wireshark is free software: you can
+ * redistribute it and/or modify it under the terms of the GNU
+ * General Public License as published by the Free Software Foundation,
+ * either version 2 of the License, or (at your option) any later version.
+ *
+ * The OpenHPSDR-USB Plug-in for Wireshark is distributed in the hope that
+ * it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See
+ * the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the OpenHPSDR-USB Plug-in for Wireshark.
+ * If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __CONTINUITY_OPENHPSDR_U_H__
+#define __CONTINUITY_OPENHPSDR_U_H__
+
+#define HPSDR_U_CONT_LEVEL     0.001  // Carrier magnitude, -60 dBFS of 2^23
+#define HPSDR_U_CONT_COHERENCE 0.98   // Length of the average rotation for a steady carrier
+#define HPSDR_U_CONT_LOCK      64     // Steady samples before the samples are checked
+#define HPSDR_U_CONT_ERROR     20.0   // Prediction error over the average prediction error, 13 dB
+#define HPSDR_U_CONT_ERROR_MIN 0.0001 // Smallest prediction error power over the carrier power, -40 dB
+#define HPSDR_U_CONT_SMOOTH    ( 1.0 / 32 )
+
+// Predictor of the IQ samples of one receiver. With a steady carrier a
+// sample is the sample before it turned by the average rotation (phase
+// step) of the carrier. Dropped samples are a jump in phase, and in
+// amplitude when the level is changing. A sample is a discontinuity when
+// the prediction error is well over the usual error of the carrier. A
+// whole number of carrier cycles dropped can not be seen.
+typedef struct _hpsdr_u_cont_t {
+   gboolean have_prev;
+   double prev_i;
+   double prev_q;
+   double rot_i;                // Average rotation from one sample to the next, unit length when steady
+   double rot_q;
+   double power;                // Average I*I + Q*Q
+   double error;                // Average prediction error power over the carrier power
+   guint32 steady;              // Samples in a row with a steady carrier
+   guint64 samples;
+   guint64 checked;             // Samples checked with a steady carrier
+   guint32 events;
+} hpsdr_u_cont_t;
+
+typedef struct _hpsdr_u_cont_event_t {
+   int offset;                  // Sample in the block
+   double phase_deg;            // Phase of the sample from the predicted sample
+   double amp_db;               // Magnitude of the sample over the carrier
+} hpsdr_u_cont_event_t;
+
+// Check count samples that follow the samples before them. Up to max
+// discontinuities are put in events, all are counted. Returns the number
+// of discontinuities in the block.
+int hpsdr_u_cont_add(hpsdr_u_cont_t *cont, const gint32 *i, const gint32 *q, int count,
+                     hpsdr_u_cont_event_t *events, int max);
+
+// Samples are missing (lost datagrams), the next sample does not follow.
+void hpsdr_u_cont_break(hpsdr_u_cont_t *cont);
+
+#endif
@@ -0,0 +1,145 @@
+/* fft_openhpsdr_u.c
+ * OpenHPSDR USB over IP protocol IQ sample radix-2 FFT
+ *
+ * Version: 0.5.0
+ * Author:  Matthew J Wolf, N4MTT
+ *
+ * This file is part of the OpenHPSDR-USB Plug-in for Wireshark.
+ * Matthew J. Wolf <matthew.wolf.hpsdr@speciosus.net>
+ * Copyright 2020 Matthew J. Wolf
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * The OpenHPSDR-USB Plug-in for Wireshark is free software: you can
+ * redistribute it and/or modify it under the terms of the GNU
+ * General Public License as published by the Free Software Foundation,
+ * either version 2 of the License, or (at your option) any later version.
+ *
+ * The OpenHPSDR-USB Plug-in for Wireshark is distributed in the hope that
+ * it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See
+ * the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the OpenHPSDR-USB Plug-in for Wireshark.
+ * If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <epan/packet.h>
+
+#include <math.h>
+#include "fft_openhpsdr_u.h"
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+// Index is log2 of the length.
+static hpsdr_u_fft_plan_t *fft_plans[HPSDR_U_FFT_MAX_LOG2 + 1];
+
+const hpsdr_u_fft_plan_t *hpsdr_u_fft_plan(int n)
+{
+   hpsdr_u_fft_plan_t *plan = NULL;
+   int log2n = 0;
+   int k = 0;
+   int b = 0;
+   guint32 r = 0;
+
+   while ( ( 1 << log2n ) < n ) { log2n++; }
+   if ( ( 1 << log2n ) != n || log2n < HPSDR_U_FFT_MIN_LOG2 || log2n > HPSDR_U_FFT_MAX_LOG2 ) { return NULL; }
+
+   if ( fft_plans[log2n] != NULL ) { return fft_plans[log2n]; }
+
+   plan = g_new0(hpsdr_u_fft_plan_t, 1);
+   plan->n = n;
+   plan->log2n = log2n;
+   plan->cos_tab = g_new(double, n / 2);
+   plan->sin_tab = g_new(double, n / 2);
+   plan->bitrev = g_new(guint32, n);
+   plan->window = g_new(double, n);
+
+   for (k = 0; k < n / 2; k++) {
+      plan->cos_tab[k] = cos(2.0 * M_PI * k / n);
+      plan->sin_tab[k] = sin(2.0 * M_PI * k / n);
+   }
+
+   for (k = 0; k < n; k++) {
+      r = 0;
+      for (b = 0; b < log2n; b++) {
+         if ( k & ( 1 << b ) ) { r |= 1 << ( log2n - 1 - b ); }
+      }
+      plan->bitrev[k] = r;
+
+      plan->window[k] = 0.5 - ( 0.5 * cos(2.0 * M_PI * k / n) );
+      plan->window_sum += plan->window[k];
+   }
+
+   fft_plans[log2n] = plan;
+
+   return plan;
+}
+
+void hpsdr_u_fft(const hpsdr_u_fft_plan_t *plan, double *re, double *im)
+{
+   double tr = 0;
+   double ti = 0;
+   double wr = 0;
+   double wi = 0;
+   int n = plan->n;
+   int len = 0;
+   int half = 0;
+   int step = 0;
+   int x = 0;
+   int k = 0;
+   int a = 0;
+   int b = 0;
+
+   for (x = 0; x < n; x++) {
+      a = plan->bitrev[x];
+      if ( a > x ) {
+         tr = re[x]; re[x] = re[a]; re[a] = tr;
+         ti = im[x]; im[x] = im[a]; im[a] = ti;
+      }
+   }
+
+   for (len = 2; len <= n; len <<= 1) {
+      half = len / 2;
+      step = n / len;
+      for (x = 0; x < n; x += len) {
+         for (k = 0; k < half; k++) {
+            wr = plan->cos_tab[k * step];
+            wi = -plan->sin_tab[k * step];
+            a = x + k;
+            b = a + half;
+
+            tr = ( re[b] * wr ) - ( im[b] * wi );
+            ti = ( re[b] * wi ) + ( im[b] * wr );
+            re[b] = re[a] - tr;
+            im[b] = im[a] - ti;
+            re[a] += tr;
+            im[a] += ti;
+         }
+      }
+   }
+}
+
+void hpsdr_u_fft_power_add(const hpsdr_u_fft_plan_t *plan, const double *i, const double *q,
+                           double *re, double *im, double *power)
+{
+   int n = plan->n;
+   int x = 0;
+
+   for (x = 0; x < n; x++) {
+      re[x] = i[x] * plan->window[x];
+      im[x] = q[x] * plan->window[x];
+   }
+
+   hpsdr_u_fft(plan, re, im);
+
+   // Negative frequencies first, 0 Hz in the middle.
+   for (x = 0; x < n; x++) {
+      power[( x + ( n / 2 ) ) & ( n - 1 )] += ( re[x] * re[x] ) + ( im[x] * im[x] );
+   }
+}
@@ -0,0 +1,57 @@
+/* fft_openhpsdr_u.h
+ * Header file for the OpenHPSDR USB over IP protocol IQ sample FFT
+ *
+ * Version: 0.5.0
+ * Author:  Matthew J Wolf, N4MTT
+ *
+ * This file is part of the OpenHPSDR-USB Plug-in for Wireshark.
+ * Matthew J. Wolf <matthew.wolf.hpsdr@speciosus.net>
+ * Copyright 2020 Matthew J. Wolf
+ *
+ * The OpenHPSDR-USB Plug-in for Wireshark is free software: you can
+ * redistribute it and/or modify it under the terms of the GNU
+ * General Public License as published by the Free Software Foundation,
+ * either version 2 of the License, or (at your option) any later version.
+ *
+ * The OpenHPSDR-USB Plug-in for Wireshark is distributed in the hope that
+ * it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See
+ * the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the OpenHPSDR-USB Plug-in for Wireshark.
+ * If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __FFT_OPENHPSDR_U_H__
+#define __FFT_OPENHPSDR_U_H__
+
+#define HPSDR_U_FFT_MIN_LOG2 6    // 64 points
+#define HPSDR_U_FFT_MAX_LOG2 16   // 65536 points
+
+// Radix-2 FFT plan. Made once for a length and kept, see hpsdr_u_fft_plan().
+typedef struct _hpsdr_u_fft_plan_t {
+   int n;                       // Points, a power of 2
+   int log2n;
+   double *cos_tab;             // cos(2 pi k / n), k < n / 2
+   double *sin_tab;             // sin(2 pi k / n), k < n / 2
+   guint32 *bitrev;             // Bit reversed index
+   double *window;              // Hann window
+   double window_sum;           // Sum of the window, the gain for a tone
+} hpsdr_u_fft_plan_t;
+
+// Plan of n points, NULL when n is not a power of 2 from 64 to 65536.
+// The plans are made the first time a length is used and kept for the
+// life of the program.
+const hpsdr_u_fft_plan_t *hpsdr_u_fft_plan(int n);
+
+// In place FFT of re and im.
+void hpsdr_u_fft(const hpsdr_u_fft_plan_t *plan, double *re, double *im);
+
+// Hann windowed FFT of n IQ samples. |X|^2 of every bin is added to power,
+// power[0] is the lowest frequency (-rate / 2), power[n / 2] is 0 Hz.
+// re and im are work space of n points.
+void hpsdr_u_fft_power_add(const hpsdr_u_fft_plan_t *plan, const double *i, const double *q,
+                           double *re, double *im, double *power);
+
+#endif
@@ -0,0 +1,147 @@
+/* infer_openhpsdr_u.c
+ * OpenHPSDR USB over IP protocol number of receivers from the EP6 samples
+ *
+ * Version: 0.5.0
+ * Author:  Matthew J Wolf, N4MTT
+ *
+ * This file is part of the OpenHPSDR-USB Plug-in for Wireshark.
+ * Matthew J. Wolf <matthew.wolf.hpsdr@speciosus.net>
+ * Copyright 2020 Matthew J. Wolf
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * The OpenHPSDR-USB Plug-in for Wireshark is free software: you can
+ * redistribute it and/or modify it under the terms of the GNU
+ * General Public License as published by the Free Software Foundation,
+ * either version 2 of the License, or (at your option) any later version.
+ *
+ * The OpenHPSDR-USB Plug-in for Wireshark is distributed in the hope that
+ * it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See
+ * the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the OpenHPSDR-USB Plug-in for Wireshark.
+ * If not, see <http://www.gnu.org/licenses/>.
+ *
+ * When the capture does not have the EP2 C0=0x00 USB frame the number of
+ * receivers is not known. Every layout is tried on the EP6 samples:
+ *
+ *  - The pad bytes at the end of the USB frame are zero. A layout with
+ *    pad bytes that are not zero is wrong.
+ *  - The Mic/Line samples are small, a quiet or no microphone.
+ *  - The IQ samples are well below full scale. The top bits are only the
+ *    sign. With the wrong layout the IQ samples are made of the low bytes
+ *    of other samples and look like random 24 bit numbers.
+ *  - Next IQ samples of a receiver are close to each other.
+ */
+
+#include <epan/packet.h>
+
+#include <stdlib.h>
+#include "iq_openhpsdr_u.h"
+#include "infer_openhpsdr_u.h"
+
+#define INFER_IQ_SMALL  ( 1 << 20 )  // 18 dB below full scale
+#define INFER_MIC_SMALL ( 1 << 12 )
+
+hpsdr_u_infer_t *hpsdr_u_infer_new(wmem_allocator_t *scope)
+{
+   return wmem_new0(scope, hpsdr_u_infer_t);
+}
+
+// Score between -2 and 2.5 of one layout. Higher is a better fit. Zero pad
+// bytes do not add to the score, near silent samples fit every layout.
+static double infer_score(const guint8 *data, const hpsdr_u_ep6_layout_t *layout)
+{
+   gint32 i[HPSDR_U_IQ_FRAME_MAX];
+   gint32 q[HPSDR_U_IQ_FRAME_MAX];
+   const guint8 *p = NULL;
+
+   int samples = 0;
+   int small = 0;
+   int close = 0;
+   int mic_small = 0;
+   int pad_set = 0;
+   int x = -1;
+   gint16 mic = 0;
+   double score = 0;
+
+   samples = hpsdr_u_iq_unpack(data, layout->rx_num, i, q) * layout->rx_num;
+
+   for (x = 0; x < samples; x++) {
+      if ( abs(i[x]) < INFER_IQ_SMALL ) { small += 1; }
+      if ( abs(q[x]) < INFER_IQ_SMALL ) { small += 1; }
+
+      // Receivers are one after the other, a receiver boundary is not checked.
+      if ( ( x + 1 ) % layout->samp_num != 0 ) {
+         if ( abs(i[x + 1] - i[x]) < INFER_IQ_SMALL ) { close += 1; }
+      }
+   }
+
+   for (x = 0; x < layout->samp_num; x++) {
+      p = data + ( x * layout->stride ) + ( layout->rx_num * 6 );
+      mic = (gint16)(( p[0] << 8 ) | p[1] );
+      if ( abs(mic) < INFER_MIC_SMALL ) { mic_small += 1; }
+   }
+
+   score = ( 2.0 * small ) / ( 2 * samples );
+   score += (double)close / ( samples - layout->rx_num );
+   score += 0.5 * mic_small / layout->samp_num;
+
+   if ( layout->pad > 0 ) {
+      p = data + ( layout->samp_num * layout->stride );
+      for (x = 0; x < layout->pad; x++) {
+         if ( p[x] != 0 ) { pad_set += 1; }
+      }
+      score -= 2.0 * pad_set / layout->pad;
+   }
+
+   return score;
+}
+
+int hpsdr_u_infer_add(hpsdr_u_infer_t *infer, const guint8 *data, int rx_max)
+{
+   double score = 0;
+   double high = 0;
+   double second = 0;
+   int frame_best = 0;
+   int best = 0;
+   int rx = -1;
+
+   if ( infer->rx_num != 0 ) { return ( infer->rx_num > 0 ) ? infer->rx_num : 0; }
+   if ( rx_max > HPSDR_U_RX_MAX ) { rx_max = HPSDR_U_RX_MAX; }
+
+   for (rx = 1; rx <= rx_max; rx++) {
+      score = infer_score(data, hpsdr_u_ep6_layout(rx));
+      if ( frame_best == 0 || score > high ) {
+         second = high;
+         high = score;
+         frame_best = rx;
+      } else if ( score > second ) {
+         second = score;
+      }
+   }
+
+   // No layout fits best, near silent or all zero samples. Not counted.
+   if ( rx_max < 2 || high - second < 0.01 ) { return 0; }
+
+   infer->wins[frame_best] += 1;
+   infer->frames += 1;
+
+   if ( infer->frames < HPSDR_U_INFER_MIN_FRAMES ) { return 0; }
+
+   for (rx = 1; rx <= rx_max; rx++) {
+      if ( best == 0 || infer->wins[rx] > infer->wins[best] ) { best = rx; }
+   }
+
+   if ( infer->wins[best] >= infer->frames * HPSDR_U_INFER_WINS ) {
+      infer->rx_num = best;
+   } else if ( infer->frames >= HPSDR_U_INFER_MAX_FRAMES ) {
+      infer->rx_num = -1;
+   }
+
+   return ( infer->rx_num > 0 ) ? infer->rx_num : 0;
+}
@@ -0,0 +1,47 @@
+/* infer_openhpsdr_u.h
+ * Header file for the OpenHPSDR USB over IP protocol receiver count inference
+ *
+ * Version: 0.5.0
+ * Author:  Matthew J Wolf, N4MTT
+ *
+ * This file is part of the OpenHPSDR-USB Plug-in for Wireshark.
+ * Matthew J. Wolf <matthew.wolf.hpsdr@speciosus.net>
+ * Copyright 2020 Matthew J. Wolf
+ *
+ * The OpenHPSDR-USB Plug-in for Wireshark is free software: you can
+ * redistribute it and/or modify it under the terms of the GNU
+ * General Public License as published by the Free Software Foundation,
+ * either version 2 of the License, or (at your option) any later version.
+ *
+ * The OpenHPSDR-USB Plug-in for Wireshark is distributed in the hope that
+ * it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See
+ * the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the OpenHPSDR-USB Plug-in for Wireshark.
+ * If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __INFER_OPENHPSDR_U_H__
+#define __INFER_OPENHPSDR_U_H__
+
+#define HPSDR_U_INFER_MIN_FRAMES 32   // USB frames scored before an answer
+#define HPSDR_U_INFER_MAX_FRAMES 2048 // USB frames scored before giving up
+#define HPSDR_U_INFER_WINS       0.9  // Part of the USB frames the best layout fits best
+
+// Scores of the EP6 layouts of a conversation.
+typedef struct _hpsdr_u_infer_t {
+   guint32 frames;              // USB frames scored
+   guint32 wins[HPSDR_U_RX_MAX + 1]; // USB frames a layout fit best, index is the number of receivers
+   int rx_num;                  // 0 while scoring, -1 gave up
+} hpsdr_u_infer_t;
+
+hpsdr_u_infer_t *hpsdr_u_infer_new(wmem_allocator_t *scope);
+
+// Score the 504 sample bytes of one EP6 USB frame for 1 to rx_max
+// receivers. Returns the number of receivers once the best layout has a
+// clear lead, 0 before then. After that the scoring is not done again.
+int hpsdr_u_infer_add(hpsdr_u_infer_t *infer, const guint8 *data, int rx_max);
+
+#endif
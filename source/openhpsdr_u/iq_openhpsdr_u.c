@@ -0,0 +1,240 @@
+/* iq_openhpsdr_u.c
+ * OpenHPSDR USB over IP protocol IQ sample unpacking and statistics
+ *
+ * Version: 0.5.0
+ * Author:  Matthew J Wolf, N4MTT
+ *
+ * This file is part of the OpenHPSDR-USB Plug-in for Wireshark.
+ * Matthew J. Wolf <matthew.wolf.hpsdr@speciosus.net>
+ * Copyright 2020 Matthew J. Wolf
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * The OpenHPSDR-USB Plug-in for Wireshark is free software: you can
+ * redistribute it and/or modify it under the terms of the GNU
+ * General Public License as published by the Free Software Foundation,
+ * either version 2 of the License, or (at your option) any later version.
+ *
+ * The OpenHPSDR-USB Plug-in for Wireshark is distributed in the hope that
+ * it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See
+ * the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the OpenHPSDR-USB Plug-in for Wireshark.
+ * If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <epan/packet.h>
+
+#include <math.h>
+#include "iq_openhpsdr_u.h"
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+// 24 bit big endian signed sample
+#define IQ_SAMPLE(p) ( ((gint32)( (guint32)(p)[0] << 24 | (guint32)(p)[1] << 16 | (guint32)(p)[2] << 8 )) >> 8 )
+
+#define EP6_LAYOUT(rx) { rx, HPSDR_U_EP6_STRIDE(rx), HPSDR_U_EP6_SAMP_NUM(rx), HPSDR_U_EP6_PAD(rx) }
+
+// Worked out by the compiler, index is the number of receivers.
+static const hpsdr_u_ep6_layout_t ep6_layouts[HPSDR_U_RX_MAX + 1] = {
+   { 0, 0, 0, 0 },
+   EP6_LAYOUT(1),  EP6_LAYOUT(2),  EP6_LAYOUT(3),  EP6_LAYOUT(4),
+   EP6_LAYOUT(5),  EP6_LAYOUT(6),  EP6_LAYOUT(7),  EP6_LAYOUT(8),
+   EP6_LAYOUT(9),  EP6_LAYOUT(10), EP6_LAYOUT(11), EP6_LAYOUT(12),
+   EP6_LAYOUT(13), EP6_LAYOUT(14), EP6_LAYOUT(15), EP6_LAYOUT(16),
+};
+
+const hpsdr_u_ep6_layout_t *hpsdr_u_ep6_layout(int rx_num)
+{
+   if ( rx_num <= 0 || rx_num > HPSDR_U_RX_MAX ) { return NULL; }
+
+   return &ep6_layouts[rx_num];
+}
+
+// One unpack function for every number of receivers. The loop counts are
+// constants, the compiler unrolls the receiver loop.
+#define IQ_UNPACK_RX(rx) \
+static int iq_unpack_rx##rx(const guint8 *data, gint32 *i, gint32 *q) \
+{ \
+   const guint8 *p = data; \
+   int x = 0; \
+   int z = 0; \
+   for (x = 0; x < HPSDR_U_EP6_SAMP_NUM(rx); x++) { \
+      for (z = 0; z < ( rx ); z++) { \
+         i[( z * HPSDR_U_EP6_SAMP_NUM(rx) ) + x] = IQ_SAMPLE(p); \
+         q[( z * HPSDR_U_EP6_SAMP_NUM(rx) ) + x] = IQ_SAMPLE(p + 3); \
+         p += 6; \
+      } \
+      p += 2;   /* Mic/Line */ \
+   } \
+   return HPSDR_U_EP6_SAMP_NUM(rx); \
+}
+
+IQ_UNPACK_RX(1)
+IQ_UNPACK_RX(2)
+IQ_UNPACK_RX(3)
+IQ_UNPACK_RX(4)
+IQ_UNPACK_RX(5)
+IQ_UNPACK_RX(6)
+IQ_UNPACK_RX(7)
+IQ_UNPACK_RX(8)
+IQ_UNPACK_RX(9)
+IQ_UNPACK_RX(10)
+IQ_UNPACK_RX(11)
+IQ_UNPACK_RX(12)
+IQ_UNPACK_RX(13)
+IQ_UNPACK_RX(14)
+IQ_UNPACK_RX(15)
+IQ_UNPACK_RX(16)
+
+typedef int (*iq_unpack_fn)(const guint8 *data, gint32 *i, gint32 *q);
+
+static const iq_unpack_fn iq_unpack_fns[HPSDR_U_RX_MAX + 1] = {
+   NULL,
+   iq_unpack_rx1,  iq_unpack_rx2,  iq_unpack_rx3,  iq_unpack_rx4,
+   iq_unpack_rx5,  iq_unpack_rx6,  iq_unpack_rx7,  iq_unpack_rx8,
+   iq_unpack_rx9,  iq_unpack_rx10, iq_unpack_rx11, iq_unpack_rx12,
+   iq_unpack_rx13, iq_unpack_rx14, iq_unpack_rx15, iq_unpack_rx16,
+};
+
+int hpsdr_u_iq_unpack(const guint8 *data, int rx_num, gint32 *i, gint32 *q)
+{
+   if ( rx_num <= 0 || rx_num > HPSDR_U_RX_MAX ) { return 0; }
+
+   return iq_unpack_fns[rx_num](data, i, q);
+}
+
+void hpsdr_u_iq_stats_add(hpsdr_u_iq_stats_t *stats, const gint32 *i, const gint32 *q, int count)
+{
+   double sum_i = 0;
+   double sum_q = 0;
+   double sum_power = 0;
+   double peak_power = stats->peak_power;
+   double power = 0;
+   guint32 near_fs = 0;
+   gint32 abs_i = 0;
+   gint32 abs_q = 0;
+   int x = 0;
+
+#ifdef __SSE2__
+   // Four IQ samples at a time. The sums are done in double, the
+   // squares of 24 bit samples do not fit in 32 bits.
+   __m128d v_sum_i = _mm_setzero_pd();
+   __m128d v_sum_q = _mm_setzero_pd();
+   __m128d v_sum_power = _mm_setzero_pd();
+   __m128d v_peak = _mm_set1_pd(peak_power);
+   __m128i v_near = _mm_set1_epi32(HPSDR_U_IQ_NEAR_FS - 1);
+   __m128i v_i, v_q, v_sign, v_abs, v_fs;
+   __m128d i_lo, i_hi, q_lo, q_hi, p_lo, p_hi;
+   double lanes[2];
+   int mask = 0;
+
+   for (x = 0; x + 4 <= count; x += 4) {
+      v_i = _mm_loadu_si128((const __m128i *)(i + x));
+      v_q = _mm_loadu_si128((const __m128i *)(q + x));
+
+      // Near full scale, |I| or |Q|
+      v_sign = _mm_srai_epi32(v_i, 31);
+      v_abs = _mm_sub_epi32(_mm_xor_si128(v_i, v_sign), v_sign);
+      v_fs = _mm_cmpgt_epi32(v_abs, v_near);
+      v_sign = _mm_srai_epi32(v_q, 31);
+      v_abs = _mm_sub_epi32(_mm_xor_si128(v_q, v_sign), v_sign);
+      v_fs = _mm_or_si128(v_fs, _mm_cmpgt_epi32(v_abs, v_near));
+      mask = _mm_movemask_ps(_mm_castsi128_ps(v_fs));
+      near_fs += ( mask & 1 ) + (( mask >> 1 ) & 1 ) + (( mask >> 2 ) & 1 ) + (( mask >> 3 ) & 1 );
+
+      i_lo = _mm_cvtepi32_pd(v_i);
+      i_hi = _mm_cvtepi32_pd(_mm_shuffle_epi32(v_i, _MM_SHUFFLE(1, 0, 3, 2)));
+      q_lo = _mm_cvtepi32_pd(v_q);
+      q_hi = _mm_cvtepi32_pd(_mm_shuffle_epi32(v_q, _MM_SHUFFLE(1, 0, 3, 2)));
+
+      p_lo = _mm_add_pd(_mm_mul_pd(i_lo, i_lo), _mm_mul_pd(q_lo, q_lo));
+      p_hi = _mm_add_pd(_mm_mul_pd(i_hi, i_hi), _mm_mul_pd(q_hi, q_hi));
+
+      v_sum_i = _mm_add_pd(v_sum_i, _mm_add_pd(i_lo, i_hi));
+      v_sum_q = _mm_add_pd(v_sum_q, _mm_add_pd(q_lo, q_hi));
+      v_sum_power = _mm_add_pd(v_sum_power, _mm_add_pd(p_lo, p_hi));
+      v_peak = _mm_max_pd(v_peak, _mm_max_pd(p_lo, p_hi));
+   }
+
+   _mm_storeu_pd(lanes, v_sum_i);
+   sum_i = lanes[0] + lanes[1];
+   _mm_storeu_pd(lanes, v_sum_q);
+   sum_q = lanes[0] + lanes[1];
+   _mm_storeu_pd(lanes, v_sum_power);
+   sum_power = lanes[0] + lanes[1];
+   _mm_storeu_pd(lanes, v_peak);
+   peak_power = ( lanes[0] > lanes[1] ) ? lanes[0] : lanes[1];
+#endif
+
+   // The samples left over from the SSE2 loop, or all of them without SSE2.
+   for (; x < count; x++) {
+      abs_i = ( i[x] < 0 ) ? -i[x] : i[x];
+      abs_q = ( q[x] < 0 ) ? -q[x] : q[x];
+      if ( abs_i >= HPSDR_U_IQ_NEAR_FS || abs_q >= HPSDR_U_IQ_NEAR_FS ) { near_fs += 1; }
+
+      power = ( (double)i[x] * i[x] ) + ( (double)q[x] * q[x] );
+      sum_i += i[x];
+      sum_q += q[x];
+      sum_power += power;
+      if ( power > peak_power ) { peak_power = power; }
+   }
+
+   stats->count += count;
+   stats->near_fs += near_fs;
+   stats->sum_i += sum_i;
+   stats->sum_q += sum_q;
+   stats->sum_power += sum_power;
+   stats->peak_power = peak_power;
+}
+
+void hpsdr_u_iq_stats_merge(hpsdr_u_iq_stats_t *to, const hpsdr_u_iq_stats_t *from)
+{
+   to->count += from->count;
+   to->near_fs += from->near_fs;
+   to->sum_i += from->sum_i;
+   to->sum_q += from->sum_q;
+   to->sum_power += from->sum_power;
+   if ( from->peak_power > to->peak_power ) { to->peak_power = from->peak_power; }
+}
+
+double hpsdr_u_iq_dc_i(const hpsdr_u_iq_stats_t *stats)
+{
+   if ( stats->count == 0 ) { return 0.0; }
+
+   return ( stats->sum_i / stats->count );
+}
+
+double hpsdr_u_iq_dc_q(const hpsdr_u_iq_stats_t *stats)
+{
+   if ( stats->count == 0 ) { return 0.0; }
+
+   return ( stats->sum_q / stats->count );
+}
+
+double hpsdr_u_iq_peak(const hpsdr_u_iq_stats_t *stats)
+{
+   return sqrt(stats->peak_power);
+}
+
+// 0 dBFS is a IQ magnitude of 2^23.
+double hpsdr_u_iq_rms_dbfs(const hpsdr_u_iq_stats_t *stats)
+{
+   if ( stats->count == 0 || stats->sum_power <= 0 ) { return HPSDR_U_IQ_DBFS_FLOOR; }
+
+   return ( 10.0 * log10(( stats->sum_power / stats->count ) /
+                         ( HPSDR_U_IQ_FULL_SCALE * HPSDR_U_IQ_FULL_SCALE )) );
+}
+
+double hpsdr_u_iq_peak_dbfs(const hpsdr_u_iq_stats_t *stats)
+{
+   if ( stats->peak_power <= 0 ) { return HPSDR_U_IQ_DBFS_FLOOR; }
+
+   return ( 10.0 * log10(stats->peak_power / ( HPSDR_U_IQ_FULL_SCALE * HPSDR_U_IQ_FULL_SCALE )) );
+}
@@ -0,0 +1,74 @@
+/* iq_openhpsdr_u.h
+ * Header file for the OpenHPSDR USB over IP protocol IQ sample math
+ *
+ * Version: 0.5.0
+ * Author:  Matthew J Wolf, N4MTT
+ *
+ * This file is part of the OpenHPSDR-USB Plug-in for Wireshark.
+ * Matthew J. Wolf <matthew.wolf.hpsdr@speciosus.net>
+ * Copyright 2020 Matthew J. Wolf
+ *
+ * The OpenHPSDR-USB Plug-in for Wireshark is free software: you can
+ * redistribute it and/or modify it under the terms of the GNU
+ * General Public License as published by the Free Software Foundation,
+ * either version 2 of the License, or (at your option) any later version.
+ *
+ * The OpenHPSDR-USB Plug-in for Wireshark is distributed in the hope that
+ * it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See
+ * the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the OpenHPSDR-USB Plug-in for Wireshark.
+ * If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __IQ_OPENHPSDR_U_H__
+#define __IQ_OPENHPSDR_U_H__
+
+#define HPSDR_U_RX_MAX        16        // Largest number of receivers unpacked
+#define HPSDR_U_IQ_FRAME_MAX  84        // Most IQ samples (all receivers) in a USB frame, 504 / 6
+#define HPSDR_U_IQ_FULL_SCALE 8388608.0 // 2^23, 24 bit signed samples
+#define HPSDR_U_IQ_NEAR_FS    8304722   // 99% of full scale
+#define HPSDR_U_IQ_DBFS_FLOOR -200.0    // dBFS used for no signal
+
+#define HPSDR_U_EP6_STRIDE(rx)   ((( rx ) * 6 ) + 2 )                  // Bytes per sample slot
+#define HPSDR_U_EP6_SAMP_NUM(rx) ( 504 / HPSDR_U_EP6_STRIDE(rx) )       // Sample slots in a USB frame
+#define HPSDR_U_EP6_PAD(rx)      ( 504 % HPSDR_U_EP6_STRIDE(rx) )       // Pad bytes at the end
+
+// Layout of the 504 sample bytes of a EP6 USB frame.
+typedef struct _hpsdr_u_ep6_layout_t {
+   int rx_num;
+   int stride;                  // Bytes per sample slot, 6 per receiver and 2 Mic/Line
+   int samp_num;                // Sample slots
+   int pad;                     // Pad bytes after the last sample slot
+} hpsdr_u_ep6_layout_t;
+
+// Sums of the IQ samples of one receiver. Merged with hpsdr_u_iq_stats_merge().
+typedef struct _hpsdr_u_iq_stats_t {
+   guint64 count;               // IQ samples
+   guint64 near_fs;             // IQ samples with I or Q at 99% of full scale or more
+   double sum_i;
+   double sum_q;
+   double sum_power;            // I*I + Q*Q
+   double peak_power;           // Largest I*I + Q*Q
+} hpsdr_u_iq_stats_t;
+
+// Layout for 1 to HPSDR_U_RX_MAX receivers, NULL for any other number.
+const hpsdr_u_ep6_layout_t *hpsdr_u_ep6_layout(int rx_num);
+
+// Unpack the 504 sample bytes of a EP6 USB frame. The samples of receiver
+// n are at i[n * samples] and q[n * samples], n starts at 0. i and q have
+// room for HPSDR_U_IQ_FRAME_MAX samples. Returns the samples per receiver.
+int hpsdr_u_iq_unpack(const guint8 *data, int rx_num, gint32 *i, gint32 *q);
+
+void hpsdr_u_iq_stats_add(hpsdr_u_iq_stats_t *stats, const gint32 *i, const gint32 *q, int count);
+void hpsdr_u_iq_stats_merge(hpsdr_u_iq_stats_t *to, const hpsdr_u_iq_stats_t *from);
+
+double hpsdr_u_iq_dc_i(const hpsdr_u_iq_stats_t *stats);
+double hpsdr_u_iq_dc_q(const hpsdr_u_iq_stats_t *stats);
+double hpsdr_u_iq_peak(const hpsdr_u_iq_stats_t *stats);
+double hpsdr_u_iq_rms_dbfs(const hpsdr_u_iq_stats_t *stats);
+double hpsdr_u_iq_peak_dbfs(const hpsdr_u_iq_stats_t *stats);
+
+#endif
@@ -1,7 +1,7 @@
 /* packet_openhpsdr_u.c
  * Routines for the OpenHPSDR USB over IP protocol packet disassembly
  *
- * Version: 0.4.0
+ * Version: 0.5.0
  * Author:  Matthew J Wolf, N4MTT
  * Date:    06-JUN-2019
  *
@@ -58,10 +58,21 @@
 #include <epan/packet.h>
 #include <epan/expert.h>
 #include <epan/prefs.h>
+#include <epan/tap.h>
+#include <epan/conversation.h>
+#include <epan/proto_data.h>
+#include <epan/reassemble.h>
+#include <wsutil/pint.h>
 
 #include <stdlib.h>
 #include <string.h>
 #include <math.h>
+#include "tap_openhpsdr_u.h"
+#include "iq_openhpsdr_u.h"
+#include "sample_openhpsdr_u.h"
+#include "infer_openhpsdr_u.h"
+#include "zero_openhpsdr_u.h"
+#include "cal_openhpsdr_u.h"
 #include "packet_openhpsdr_u.h"
 
 //Port definition in packet-openhpsdr-u.h header
@@ -89,10 +100,18 @@ static gint ett_hpsdr_u_cc_ps = -1;
 static gint ett_hpsdr_u_cc_ov = -1;
 static gint ett_hpsdr_u_ep6_data_1 = -1;
 static gint ett_hpsdr_u_ep6_data_2 = -1;
+static gint ett_hpsdr_u_rx = -1;
+static gint ett_hpsdr_u_cc_bits = -1;
+static gint ett_hpsdr_u_ep4_fragment = -1;
+static gint ett_hpsdr_u_ep4_fragments = -1;
+static gint ett_hpsdr_u_ep4_buffer = -1;
 
 /* protocol variables */
 static int proto_hpsdr_u = -1;
 
+/* tap */
+static int hpsdr_u_tap = -1;
+
 /* fields */
 static int hf_hpsdr_u_ei = -1;
 static int hf_hpsdr_u_id = -1;
@@ -349,9 +368,28 @@ static int hf_hpsdr_u_ep2_l = -1;
 static int hf_hpsdr_u_ep2_r = -1;
 static int hf_hpsdr_u_ep2_i = -1;
 static int hf_hpsdr_u_ep2_q = -1;
+static int hf_hpsdr_u_ep2_sum_count = -1;
+static int hf_hpsdr_u_ep2_sum_l_peak = -1;
+static int hf_hpsdr_u_ep2_sum_r_peak = -1;
+static int hf_hpsdr_u_ep2_sum_iq_peak = -1;
 static int hf_hpsdr_u_ep4_separator = -1;
 static int hf_hpsdr_u_ep4_sample_idx  = -1;
 static int hf_hpsdr_u_ep4_sample = -1;
+static int hf_hpsdr_u_ep4_fragments = -1;
+static int hf_hpsdr_u_ep4_fragment = -1;
+static int hf_hpsdr_u_ep4_fragment_overlap = -1;
+static int hf_hpsdr_u_ep4_fragment_overlap_conflicts = -1;
+static int hf_hpsdr_u_ep4_fragment_multiple_tails = -1;
+static int hf_hpsdr_u_ep4_fragment_too_long_fragment = -1;
+static int hf_hpsdr_u_ep4_fragment_error = -1;
+static int hf_hpsdr_u_ep4_fragment_count = -1;
+static int hf_hpsdr_u_ep4_reassembled_in = -1;
+static int hf_hpsdr_u_ep4_reassembled_length = -1;
+static int hf_hpsdr_u_ep4_reassembled_data = -1;
+static int hf_hpsdr_u_ep4_buffer_id = -1;
+static int hf_hpsdr_u_ep4_buffer_fragment = -1;
+static int hf_hpsdr_u_ep4_buffer_samples = -1;
+static int hf_hpsdr_u_ep4_missing = -1;
 static int hf_hpsdr_u_ep6_data_sub_1 = -1;
 static int hf_hpsdr_u_ep6_data_sub_2 = -1;
 static int hf_hpsdr_u_ep6_idx = -1;
@@ -362,26 +400,268 @@ static int hf_hpsdr_u_ep6_data_string_ml = -1;
 static int hf_hpsdr_u_ep6_ml = -1;
 static int hf_hpsdr_u_ep6_data_string_end = -1;
 static int hf_hpsdr_u_ep6_data_pad = -1;
+static int hf_hpsdr_u_overflow_adc = -1;
+static int hf_hpsdr_u_overflow_rx = -1;
+static int hf_hpsdr_u_rx_idx = -1;
+static int hf_hpsdr_u_rx_dc_i = -1;
+static int hf_hpsdr_u_rx_dc_q = -1;
+static int hf_hpsdr_u_rx_peak = -1;
+static int hf_hpsdr_u_rx_clip = -1;
+static int hf_hpsdr_u_rx_rms_dbfs = -1;
+static int hf_hpsdr_u_rx_peak_dbfs = -1;
+static int hf_hpsdr_u_sample_first = -1;
+static int hf_hpsdr_u_sample_count = -1;
+static int hf_hpsdr_u_sample_gap = -1;
+static int hf_hpsdr_u_rx_num_inferred = -1;
+static int hf_hpsdr_u_rx_num_backfill = -1;
+static int hf_hpsdr_u_ep2_zero = -1;
+static int hf_hpsdr_u_ep2_starved = -1;
+static int hf_hpsdr_u_ep2_starved_runs = -1;
+static int hf_hpsdr_u_ep2_run_start = -1;
+static int hf_hpsdr_u_ep2_run_end = -1;
+
+// EP2 C&C byte bit fields. One proto_tree_add_bitmask() call adds the byte
+// and its bits. The masks are in packet_openhpsdr_u.h.
+
+// C0 0x00 Configuration
+static const int *cc_conf_c1_bits[] = {
+   &hf_hpsdr_u_cc_speed,
+   &hf_hpsdr_u_cc_10mhz,
+   &hf_hpsdr_u_cc_122mhz,
+   &hf_hpsdr_u_cc_conf,
+   &hf_hpsdr_u_cc_mic_s,
+   NULL
+};
+
+static const int *cc_conf_c2_bits[] = {
+   &hf_hpsdr_u_cc_mode,
+   &hf_hpsdr_u_cc_oco_0,
+   &hf_hpsdr_u_cc_oco_1,
+   &hf_hpsdr_u_cc_oco_2,
+   &hf_hpsdr_u_cc_oco_3,
+   &hf_hpsdr_u_cc_oco_4,
+   &hf_hpsdr_u_cc_oco_5,
+   &hf_hpsdr_u_cc_oco_6,
+   NULL
+};
+
+static const int *cc_conf_c3_bits[] = {
+   &hf_hpsdr_u_cc_ant_pre_attn,
+   &hf_hpsdr_u_cc_ant_pre_pre_amp,
+   &hf_hpsdr_u_cc_adc_dither,
+   &hf_hpsdr_u_cc_adc_random,
+   &hf_hpsdr_u_cc_ant_pre_ant,
+   &hf_hpsdr_u_cc_ant_pre_rx_out,
+   NULL
+};
+
+// Hermes-Lite: Dither is RX LNA gain, Random is RX ADC AGC.
+static const int *cc_conf_c3_hl1_bits[] = {
+   &hf_hpsdr_u_cc_ant_pre_attn,
+   &hf_hpsdr_u_cc_ant_pre_pre_amp,
+   &hf_hpsdr_u_cc_hl1_rx_lna_gain,
+   &hf_hpsdr_u_cc_hl1_adc_agc,
+   &hf_hpsdr_u_cc_ant_pre_ant,
+   &hf_hpsdr_u_cc_ant_pre_rx_out,
+   NULL
+};
+
+// Hermes-Lite2: Pre-amp is VNA fixed gain, Random is hardware AGC.
+static const int *cc_conf_c3_hl2_bits[] = {
+   &hf_hpsdr_u_cc_ant_pre_attn,
+   &hf_hpsdr_u_cc_hl2_vna_gain,
+   &hf_hpsdr_u_cc_adc_dither,
+   &hf_hpsdr_u_cc_hl2_hw_agc,
+   &hf_hpsdr_u_cc_ant_pre_ant,
+   &hf_hpsdr_u_cc_ant_pre_rx_out,
+   NULL
+};
+
+// Both Hermes-Lite preferences set.
+static const int *cc_conf_c3_hl1_hl2_bits[] = {
+   &hf_hpsdr_u_cc_ant_pre_attn,
+   &hf_hpsdr_u_cc_hl2_vna_gain,
+   &hf_hpsdr_u_cc_hl1_rx_lna_gain,
+   &hf_hpsdr_u_cc_hl1_adc_agc,
+   &hf_hpsdr_u_cc_ant_pre_ant,
+   &hf_hpsdr_u_cc_ant_pre_rx_out,
+   NULL
+};
+
+// C0 0x09 TX Drive, HPF and LPF, VNA
+static const int *cc_filter_c2_bits[] = {
+   &hf_hpsdr_u_cc_mic_boost,
+   &hf_hpsdr_u_cc_mic_l,
+   &hf_hpsdr_u_cc_apollo_filter,
+   &hf_hpsdr_u_cc_apollo_tunner,
+   &hf_hpsdr_u_cc_apollo_auto,
+   &hf_hpsdr_u_cc_herm_fil_s,
+   &hf_hpsdr_u_cc_filter_man,
+   &hf_hpsdr_u_cc_vna,
+   NULL
+};
+
+static const int *cc_filter_c2_hl2_bits[] = {
+   &hf_hpsdr_u_cc_mic_boost,
+   &hf_hpsdr_u_cc_mic_l,
+   &hf_hpsdr_u_cc_hl2_ext_ptt,
+   &hf_hpsdr_u_cc_hl2_pa,
+   &hf_hpsdr_u_cc_apollo_auto,
+   &hf_hpsdr_u_cc_herm_fil_s,
+   &hf_hpsdr_u_cc_filter_man,
+   &hf_hpsdr_u_cc_vna,
+   NULL
+};
+
+static const int *cc_filter_c3_bits[] = {
+   &hf_hpsdr_u_cc_hpf_13,
+   &hf_hpsdr_u_cc_hpf_20,
+   &hf_hpsdr_u_cc_hpf_9_5,
+   &hf_hpsdr_u_cc_hpf_6_5,
+   &hf_hpsdr_u_cc_hpf_1_5,
+   &hf_hpsdr_u_cc_bypass_hpf,
+   &hf_hpsdr_u_cc_6m_amp,
+   &hf_hpsdr_u_cc_dis_ant_pre_tr,
+   NULL
+};
+
+static const int *cc_filter_c4_bits[] = {
+   &hf_hpsdr_u_cc_lpf_30_20,
+   &hf_hpsdr_u_cc_lpf_60_40,
+   &hf_hpsdr_u_cc_lpf_80,
+   &hf_hpsdr_u_cc_lpf_160,
+   &hf_hpsdr_u_cc_lpf_6,
+   &hf_hpsdr_u_cc_lpf_12_10,
+   &hf_hpsdr_u_cc_lpf_17_15,
+   NULL
+};
+
+// C0 0x0A RX Pre-amp, IF Gain, PureSignal, Open Drain, TTL
+static const int *cc_misc_c1_bits[] = {
+   &hf_hpsdr_u_cc_rx1_preamp,
+   &hf_hpsdr_u_cc_rx2_preamp,
+   &hf_hpsdr_u_cc_rx3_preamp,
+   &hf_hpsdr_u_cc_rx4_preamp,
+   &hf_hpsdr_u_cc_orion_mic_tr,
+   &hf_hpsdr_u_cc_orion_mic_bias,
+   &hf_hpsdr_u_cc_orion_mic_ptt,
+   NULL
+};
+
+static const int *cc_misc_c3_bits[] = {
+   &hf_hpsdr_u_cc_metis_p1,
+   &hf_hpsdr_u_cc_metis_p2,
+   &hf_hpsdr_u_cc_metis_p3,
+   &hf_hpsdr_u_cc_metis_p4,
+   &hf_hpsdr_u_cc_merc_tx_atten_c3,
+   NULL
+};
+
+// C0 0x0B ADC[123] Attn, CW Config
+static const int *cc_adc_cw_c4_bits[] = {
+   &hf_hpsdr_u_cc_cw_keyer_weight,
+   &hf_hpsdr_u_cc_cw_keyer_spacing,
+   NULL
+};
+
+// C0 0x0E ADC RX Assignment
+static const int *cc_rx_adc_c1_bits[] = {
+   &hf_hpsdr_u_cc_rx1_adc_assign,
+   &hf_hpsdr_u_cc_rx2_adc_assign,
+   &hf_hpsdr_u_cc_rx3_adc_assign,
+   &hf_hpsdr_u_cc_rx4_adc_assign,
+   NULL
+};
+
+// C0 0x12 2nd Alex
+static const int *cc_a2_c1_bits[] = {
+   &hf_hpsdr_u_cc_a2_c1_0,
+   &hf_hpsdr_u_cc_a2_c1_1,
+   &hf_hpsdr_u_cc_a2_c1_2,
+   &hf_hpsdr_u_cc_a2_c1_3,
+   &hf_hpsdr_u_cc_a2_c1_4,
+   &hf_hpsdr_u_cc_a2_c1_5,
+   &hf_hpsdr_u_cc_a2_c1_6,
+   &hf_hpsdr_u_cc_a2_c1_7,
+   NULL
+};
+
+static const int *cc_a2_c2_bits[] = {
+   &hf_hpsdr_u_cc_a2_c2_0,
+   &hf_hpsdr_u_cc_a2_c2_1,
+   &hf_hpsdr_u_cc_a2_c2_2,
+   &hf_hpsdr_u_cc_a2_c2_3,
+   &hf_hpsdr_u_cc_a2_c2_4,
+   &hf_hpsdr_u_cc_a2_c2_5,
+   &hf_hpsdr_u_cc_a2_c2_6,
+   &hf_hpsdr_u_cc_a2_c2_7,
+   NULL
+};
 
 
 // Expert Items
 static expert_field ei_ep2_sync = EI_INIT;
 static expert_field ei_extra_length = EI_INIT;
+static expert_field ei_rx_num_inferred = EI_INIT;
+static expert_field ei_ep2_sync_missing = EI_INIT;
+static expert_field ei_ep4_missing = EI_INIT;
+static expert_field ei_ep4_incomplete = EI_INIT;
+static expert_field ei_ep2_starved = EI_INIT;
+static expert_field ei_not_captured = EI_INIT;
+
+// EP4 wide band buffer reassembly
+static reassembly_table hpsdr_u_ep4_reassembly_table;
+
+static const fragment_items hpsdr_u_ep4_frag_items = {
+   &ett_hpsdr_u_ep4_fragment,
+   &ett_hpsdr_u_ep4_fragments,
+   &hf_hpsdr_u_ep4_fragments,
+   &hf_hpsdr_u_ep4_fragment,
+   &hf_hpsdr_u_ep4_fragment_overlap,
+   &hf_hpsdr_u_ep4_fragment_overlap_conflicts,
+   &hf_hpsdr_u_ep4_fragment_multiple_tails,
+   &hf_hpsdr_u_ep4_fragment_too_long_fragment,
+   &hf_hpsdr_u_ep4_fragment_error,
+   &hf_hpsdr_u_ep4_fragment_count,
+   &hf_hpsdr_u_ep4_reassembled_in,
+   &hf_hpsdr_u_ep4_reassembled_length,
+   &hf_hpsdr_u_ep4_reassembled_data,
+   "EP4 wide band fragments"
+};
 
 // Preferences
 static gboolean hpsdr_u_pref_strict_size  = TRUE;
 static gboolean hpsdr_u_pref_strict_pad = TRUE;
 static gboolean hpsdr_u_pref_ep2_sync = TRUE;
+static guint hpsdr_u_pref_ep2_sync_max = 64;
+static gboolean hpsdr_u_pref_ep2_samples = FALSE;
 static gboolean hpsdr_u_pref_hermes_lite_1_cc = FALSE;
 static gboolean hpsdr_u_pref_hermes_lite_2 = FALSE;
+static gboolean hpsdr_u_pref_infer_rx_num = TRUE;
+static guint hpsdr_u_pref_ep4_buffer = 0;
+static guint hpsdr_u_pref_ep2_starved_max = 4800;
 
 static guint8 board_id = -1;
 
 static int rx_num = 0;       // Number of Recevers
                              // Inital value of 0 until the real number is discovered.
 
+static int speed_num = 0;    // EP2 C0=0x00 C1 Speed (ep2_speed), Inital value of 0 is 48kHz
+
 static int global_flags = 0; // Inital state is all stoped, aka 0
 
+static guint8 rx_adc[HPSDR_U_RX_ADC] = {0}; // EP2 C0=0x0E ADC assigned to RX1 .. RX7, 0 is ADC1
+
+// Back to the inital state when a capture file is opened.
+static void hpsdr_u_init(void)
+{
+   board_id = 0xFF;
+   rx_num = 0;
+   speed_num = 0;
+   global_flags = 0;
+   memset(rx_adc, 0, sizeof(rx_adc));
+}
+
 
 static const value_string hpsdr_u_status_types[] = {
    { 0x01, "Data TX" },
@@ -465,7 +745,7 @@ static const value_string ep2_cw_mode[] = {
 static const value_string ep2_adc_asign[] = {
    { 0x00, "ADC 1" },
    { 0x01, "ADC 2" },
-   { 0x10, "ADC 3" },
+   { 0x02, "ADC 3" },
    {0, NULL}
 };
 
@@ -1251,6 +1531,76 @@ proto_register_hpsdr_u(void)
           FT_NONE, BASE_NONE,
           NULL, ZERO_MASK,
           NULL, HFILL }},
+      { &hf_hpsdr_u_overflow_adc,
+        { "ADC Overflow", "hpsdr-u.overflow.adc",
+          FT_UINT8, BASE_DEC,
+          NULL, ZERO_MASK,
+          "ADC number with an overflow", HFILL }},
+      { &hf_hpsdr_u_overflow_rx,
+        { "Receiver Overflow", "hpsdr-u.overflow.rx",
+          FT_UINT8, BASE_DEC,
+          NULL, ZERO_MASK,
+          "Receiver fed by an ADC with an overflow, from the EP2 ADC RX Assignment", HFILL }},
+      { &hf_hpsdr_u_rx_idx,
+        { "Receiver", "hpsdr-u.rx.idx",
+          FT_UINT8, BASE_DEC,
+          NULL, ZERO_MASK,
+          "Receiver number of the IQ signal statistics", HFILL }},
+      { &hf_hpsdr_u_rx_dc_i,
+        { "DC Offset I", "hpsdr-u.rx.dc_i",
+          FT_DOUBLE, BASE_NONE,
+          NULL, ZERO_MASK,
+          "Average of the I samples in the datagram, ADC counts", HFILL }},
+      { &hf_hpsdr_u_rx_dc_q,
+        { "DC Offset Q", "hpsdr-u.rx.dc_q",
+          FT_DOUBLE, BASE_NONE,
+          NULL, ZERO_MASK,
+          "Average of the Q samples in the datagram, ADC counts", HFILL }},
+      { &hf_hpsdr_u_rx_peak,
+        { "Peak Magnitude", "hpsdr-u.rx.peak",
+          FT_DOUBLE, BASE_NONE,
+          NULL, ZERO_MASK,
+          "Largest IQ magnitude in the datagram, full scale is 8388608", HFILL }},
+      { &hf_hpsdr_u_rx_clip,
+        { "Near Full Scale Samples", "hpsdr-u.rx.clip",
+          FT_UINT32, BASE_DEC,
+          NULL, ZERO_MASK,
+          "IQ samples with I or Q at 99% of full scale or more", HFILL }},
+      { &hf_hpsdr_u_rx_rms_dbfs,
+        { "RMS Power dBFS", "hpsdr-u.rx.rms_dbfs",
+          FT_DOUBLE, BASE_NONE,
+          NULL, ZERO_MASK,
+          "RMS IQ power of the datagram, 0 dBFS is a magnitude of 2^23", HFILL }},
+      { &hf_hpsdr_u_rx_peak_dbfs,
+        { "Peak Power dBFS", "hpsdr-u.rx.peak_dbfs",
+          FT_DOUBLE, BASE_NONE,
+          NULL, ZERO_MASK,
+          "Largest IQ power of the datagram, 0 dBFS is a magnitude of 2^23", HFILL }},
+      { &hf_hpsdr_u_sample_first,
+        { "First Sample Number", "hpsdr-u.sample.first",
+          FT_UINT64, BASE_DEC,
+          NULL, ZERO_MASK,
+          "Absolute number of the first IQ sample of the datagram in the receiver stream", HFILL }},
+      { &hf_hpsdr_u_sample_count,
+        { "Samples per Receiver", "hpsdr-u.sample.count",
+          FT_UINT32, BASE_DEC,
+          NULL, ZERO_MASK,
+          NULL, HFILL }},
+      { &hf_hpsdr_u_sample_gap,
+        { "Missing Datagrams", "hpsdr-u.sample.gap",
+          FT_UINT32, BASE_DEC,
+          NULL, ZERO_MASK,
+          "Datagrams missing from the sequence numbers before this datagram", HFILL }},
+      { &hf_hpsdr_u_rx_num_inferred,
+        { "Number of Receivers (Inferred)", "hpsdr-u.rx_num.inferred",
+          FT_UINT8, BASE_DEC,
+          NULL, ZERO_MASK,
+          "Number of receivers inferred from the EP6 samples, the EP2 configuration was not captured", HFILL }},
+      { &hf_hpsdr_u_rx_num_backfill,
+        { "Number of Receivers Learned Later", "hpsdr-u.rx_num.backfill",
+          FT_BOOLEAN, BASE_NONE,
+          NULL, ZERO_MASK,
+          "The number of receivers was not known when the first pass got to this datagram", HFILL }},
       { &hf_hpsdr_u_cc_nco_tx,
         { "TX NCO Frequency", "hpsdr-u.cc.nco-tx",
           FT_UINT32, BASE_DEC,
@@ -1911,6 +2261,51 @@ proto_register_hpsdr_u(void)
           FT_UINT8, BASE_DEC,
           NULL, ALL_BITS_MASK,
           NULL, HFILL }},
+      { &hf_hpsdr_u_ep2_sum_count,
+        { "Samples", "hpsdr-u.ep2.summary.count",
+          FT_UINT8, BASE_DEC,
+          NULL, ZERO_MASK,
+          "Left, Right, I and Q samples in the USB frame", HFILL }},
+      { &hf_hpsdr_u_ep2_sum_l_peak,
+        { "Left Audio Peak dBFS", "hpsdr-u.ep2.summary.l_peak_dbfs",
+          FT_DOUBLE, BASE_NONE,
+          NULL, ZERO_MASK,
+          "Peak of the Left audio samples, 0 dBFS is 2^15", HFILL }},
+      { &hf_hpsdr_u_ep2_sum_r_peak,
+        { "Right Audio Peak dBFS", "hpsdr-u.ep2.summary.r_peak_dbfs",
+          FT_DOUBLE, BASE_NONE,
+          NULL, ZERO_MASK,
+          "Peak of the Right audio samples, 0 dBFS is 2^15", HFILL }},
+      { &hf_hpsdr_u_ep2_sum_iq_peak,
+        { "TX IQ Peak dBFS", "hpsdr-u.ep2.summary.iq_peak_dbfs",
+          FT_DOUBLE, BASE_NONE,
+          NULL, ZERO_MASK,
+          "Peak magnitude of the TX IQ samples, 0 dBFS is a magnitude of 2^15", HFILL }},
+      { &hf_hpsdr_u_ep2_zero,
+        { "Zero Samples", "hpsdr-u.ep2.zero",
+          FT_UINT32, BASE_DEC,
+          NULL, ZERO_MASK,
+          "EP2 samples of the datagram with Left, Right, I and Q all zero", HFILL }},
+      { &hf_hpsdr_u_ep2_starved,
+        { "Starved Samples", "hpsdr-u.ep2.starved",
+          FT_UINT32, BASE_DEC,
+          NULL, ZERO_MASK,
+          "Zero samples of the starved runs that end in this datagram", HFILL }},
+      { &hf_hpsdr_u_ep2_starved_runs,
+        { "Starved Runs", "hpsdr-u.ep2.starved.runs",
+          FT_UINT32, BASE_DEC,
+          NULL, ZERO_MASK,
+          "Starved runs that end in this datagram", HFILL }},
+      { &hf_hpsdr_u_ep2_run_start,
+        { "Starved Run Start", "hpsdr-u.ep2.starved.start",
+          FT_FRAMENUM, BASE_NONE,
+          NULL, ZERO_MASK,
+          "Datagram the starved run of zero samples starts in", HFILL }},
+      { &hf_hpsdr_u_ep2_run_end,
+        { "Starved Run End", "hpsdr-u.ep2.starved.end",
+          FT_FRAMENUM, BASE_NONE,
+          NULL, ZERO_MASK,
+          "Datagram the starved run of zero samples ends in", HFILL }},
       { &hf_hpsdr_u_ep4_separator,
         { "Wide Band Data Sample Separator", "hpsdr-u.ep4.separator",
           FT_STRING, STR_ASCII,
@@ -1926,6 +2321,81 @@ proto_register_hpsdr_u(void)
           FT_UINT16, BASE_HEX,
           NULL, ZERO_MASK,
           NULL, HFILL }},
+      { &hf_hpsdr_u_ep4_buffer_id,
+        { "Wide Band Buffer", "hpsdr-u.ep4.buffer",
+          FT_UINT32, BASE_DEC,
+          NULL, ZERO_MASK,
+          "Wide band buffer number, sequence number divided by the datagrams per buffer", HFILL }},
+      { &hf_hpsdr_u_ep4_buffer_fragment,
+        { "Wide Band Buffer Datagram", "hpsdr-u.ep4.buffer.fragment",
+          FT_UINT32, BASE_DEC,
+          NULL, ZERO_MASK,
+          "Datagram in the wide band buffer, 0 is the first", HFILL }},
+      { &hf_hpsdr_u_ep4_buffer_samples,
+        { "Wide Band Buffer Samples", "hpsdr-u.ep4.buffer.samples",
+          FT_UINT32, BASE_DEC,
+          NULL, ZERO_MASK,
+          NULL, HFILL }},
+      { &hf_hpsdr_u_ep4_missing,
+        { "Missing EP4 Datagrams", "hpsdr-u.ep4.missing",
+          FT_UINT32, BASE_DEC,
+          NULL, ZERO_MASK,
+          "EP4 datagrams missing before this datagram", HFILL }},
+      { &hf_hpsdr_u_ep4_fragments,
+        { "Wide Band Fragments", "hpsdr-u.ep4.fragments",
+          FT_NONE, BASE_NONE,
+          NULL, ZERO_MASK,
+          NULL, HFILL }},
+      { &hf_hpsdr_u_ep4_fragment,
+        { "Wide Band Fragment", "hpsdr-u.ep4.fragment",
+          FT_FRAMENUM, BASE_NONE,
+          NULL, ZERO_MASK,
+          NULL, HFILL }},
+      { &hf_hpsdr_u_ep4_fragment_overlap,
+        { "Fragment Overlap", "hpsdr-u.ep4.fragment.overlap",
+          FT_BOOLEAN, BASE_NONE,
+          NULL, ZERO_MASK,
+          NULL, HFILL }},
+      { &hf_hpsdr_u_ep4_fragment_overlap_conflicts,
+        { "Fragment Overlapping with Conflicting Data", "hpsdr-u.ep4.fragment.overlap.conflicts",
+          FT_BOOLEAN, BASE_NONE,
+          NULL, ZERO_MASK,
+          NULL, HFILL }},
+      { &hf_hpsdr_u_ep4_fragment_multiple_tails,
+        { "Fragment has Multiple Tails", "hpsdr-u.ep4.fragment.multiple_tails",
+          FT_BOOLEAN, BASE_NONE,
+          NULL, ZERO_MASK,
+          NULL, HFILL }},
+      { &hf_hpsdr_u_ep4_fragment_too_long_fragment,
+        { "Fragment too Long", "hpsdr-u.ep4.fragment.too_long_fragment",
+          FT_BOOLEAN, BASE_NONE,
+          NULL, ZERO_MASK,
+          NULL, HFILL }},
+      { &hf_hpsdr_u_ep4_fragment_error,
+        { "Defragmentation Error", "hpsdr-u.ep4.fragment.error",
+          FT_FRAMENUM, BASE_NONE,
+          NULL, ZERO_MASK,
+          NULL, HFILL }},
+      { &hf_hpsdr_u_ep4_fragment_count,
+        { "Fragment Count", "hpsdr-u.ep4.fragment.count",
+          FT_UINT32, BASE_DEC,
+          NULL, ZERO_MASK,
+          NULL, HFILL }},
+      { &hf_hpsdr_u_ep4_reassembled_in,
+        { "Reassembled in", "hpsdr-u.ep4.reassembled.in",
+          FT_FRAMENUM, BASE_NONE,
+          NULL, ZERO_MASK,
+          NULL, HFILL }},
+      { &hf_hpsdr_u_ep4_reassembled_length,
+        { "Reassembled Length", "hpsdr-u.ep4.reassembled.length",
+          FT_UINT32, BASE_DEC,
+          NULL, ZERO_MASK,
+          NULL, HFILL }},
+      { &hf_hpsdr_u_ep4_reassembled_data,
+        { "Reassembled Data", "hpsdr-u.ep4.reassembled.data",
+          FT_BYTES, BASE_NONE,
+          NULL, ZERO_MASK,
+          NULL, HFILL }},
    };
 
    /* protocol subtree array */
@@ -1952,9 +2422,16 @@ proto_register_hpsdr_u(void)
       &ett_hpsdr_u_cc_ov,
       &ett_hpsdr_u_ep6_data_1,
       &ett_hpsdr_u_ep6_data_2,
+      &ett_hpsdr_u_rx,
+      &ett_hpsdr_u_cc_bits,
+      &ett_hpsdr_u_ep4_fragment,
+      &ett_hpsdr_u_ep4_fragments,
+      &ett_hpsdr_u_ep4_buffer,
    };
 
-   /* Setup protocol expert items */
+   /* Setup protocol expert items. The new names start with the protocol abbrev,
+      ".expert" is added where a field has the same name. ep2.sync.error and
+      extra-length keep the names of earlier versions, filters use them. */
    static ei_register_info ei[] = {
       { &ei_ep2_sync,
         { "ep2.sync.error", PI_MALFORMED, PI_WARN,
@@ -1962,6 +2439,24 @@ proto_register_hpsdr_u(void)
       { &ei_extra_length,
         { "extra-length", PI_MALFORMED, PI_WARN,
           "Extra Bytes", EXPFILL }},
+      { &ei_ep2_sync_missing,
+        { "hpsdr-u.ep2.sync.missing", PI_MALFORMED, PI_ERROR,
+          "EP2 Sync not found", EXPFILL }},
+      { &ei_rx_num_inferred,
+        { "hpsdr-u.rx_num.inferred.expert", PI_ASSUMPTION, PI_NOTE,
+          "Number of receivers inferred from the EP6 samples", EXPFILL }},
+      { &ei_ep4_missing,
+        { "hpsdr-u.ep4.missing.expert", PI_SEQUENCE, PI_WARN,
+          "EP4 datagrams missing", EXPFILL }},
+      { &ei_ep4_incomplete,
+        { "hpsdr-u.ep4.incomplete", PI_REASSEMBLE, PI_WARN,
+          "EP4 wide band buffer not complete", EXPFILL }},
+      { &ei_ep2_starved,
+        { "hpsdr-u.ep2.starved.expert", PI_SEQUENCE, PI_WARN,
+          "EP2 host starved, zero samples in place of samples", EXPFILL }},
+      { &ei_not_captured,
+        { "hpsdr-u.not_captured", PI_UNDECODED, PI_NOTE,
+          "Not captured, the capture snaplen is shorter than the datagram", EXPFILL }},
    };
 
    proto_hpsdr_u = proto_register_protocol (
@@ -1973,6 +2468,32 @@ proto_register_hpsdr_u(void)
    proto_register_field_array(proto_hpsdr_u, hf, array_length(hf));
    proto_register_subtree_array(ett, array_length(ett));
 
+   hpsdr_u_tap = register_tap("hpsdr-u");
+
+   // tshark -z statistics taps
+   register_hpsdr_u_audio_tap();
+   register_hpsdr_u_telemetry_tap();
+   register_hpsdr_u_overflow_tap();
+   register_hpsdr_u_iq_tap();
+   register_hpsdr_u_seek_tap();
+   register_hpsdr_u_sync_tap();
+   register_hpsdr_u_adc_tap();
+   register_hpsdr_u_spectrum_tap();
+   register_hpsdr_u_continuity_tap();
+   register_hpsdr_u_ptt_tap();
+   register_hpsdr_u_confirm_tap();
+   register_hpsdr_u_cadence_tap();
+   register_hpsdr_u_txbuffer_tap();
+   register_hpsdr_u_starved_tap();
+   register_hpsdr_u_reaction_tap();
+   register_hpsdr_u_burst_tap();
+   register_hpsdr_u_clock_tap();
+
+   reassembly_table_register(&hpsdr_u_ep4_reassembly_table, &addresses_ports_reassembly_table_functions);
+
+   // The state learned from a capture is not carried into the next one.
+   register_init_routine(hpsdr_u_init);
+
    /* Required function calls to register expert items */
    expert_hpsdr_u = expert_register_protocol(proto_hpsdr_u);
    expert_register_field_array(expert_hpsdr_u, ei, array_length(ei));
@@ -2003,6 +2524,20 @@ proto_register_hpsdr_u(void)
                                   " extra bytes.",
                                   &hpsdr_u_pref_ep2_sync);
 
+   prefs_register_uint_preference(hpsdr_u_prefs,"ep2_sync_max",
+                                  "End Point 2 Sync Maximum Extra Bytes",
+                                  "Largest number of extra bytes searched in front of the USB end point 2"
+                                  " sync. A USB frame without the sync in that many bytes is not decoded.",
+                                  10, &hpsdr_u_pref_ep2_sync_max);
+
+   prefs_register_bool_preference(hpsdr_u_prefs,"ep2_samples",
+                                  "End Point 2 Sample Details",
+                                  "Add the index, Left, Right, I and Q items of every end point 2 sample."
+                                  " When disabled, only a summary (sample count and peak levels) is added."
+                                  " The samples are still added when the subtree was expanded or a"
+                                  " filter uses the hpsdr-u.ep2.data fields.",
+                                  &hpsdr_u_pref_ep2_samples);
+
    prefs_register_bool_preference(hpsdr_u_prefs,"hermes_lite_1_cc",
                                   "Hermes-Lite1 Command and Control",
                                   "- MOX repurposed as PTT.\n"
@@ -2032,6 +2567,30 @@ proto_register_hpsdr_u(void)
                                   "-- I2C\n"
                                   "-- Extended Write Data",
                                   &hpsdr_u_pref_hermes_lite_2);
+
+   prefs_register_bool_preference(hpsdr_u_prefs,"infer_rx_num",
+                                  "Infer the Number of Receivers",
+                                  "When the capture does not have the EP2 configuration (C0=0x00)"
+                                  " the number of receivers is inferred from the EP6 samples."
+                                  " The pad bytes, Mic/Line samples and IQ samples of every"
+                                  " layout are scored. The EP6 datagrams before the answer are"
+                                  " not decoded.",
+                                  &hpsdr_u_pref_infer_rx_num);
+
+   prefs_register_uint_preference(hpsdr_u_prefs,"ep4_buffer",
+                                  "End Point 4 Wide Band Buffer Samples",
+                                  "Samples (16 bit) in a wide band buffer. The buffer is reassembled from"
+                                  " that many samples divided by 512 EP4 datagrams."
+                                  " 0 uses the board ID: 4096 for Metis, 16384 for the other boards.",
+                                  10, &hpsdr_u_pref_ep4_buffer);
+
+   prefs_register_uint_preference(hpsdr_u_prefs,"ep2_starved_max",
+                                  "End Point 2 Starved Run Maximum Samples",
+                                  "A run of zero EP2 samples (Left, Right, I and Q all zero) after samples"
+                                  " that are not zero is a starved host when samples that are not zero"
+                                  " follow within this many samples. A longer run is a idle host, not"
+                                  " transmitting and no audio. 4800 is 100 ms at 48 kHz.",
+                                  10, &hpsdr_u_pref_ep2_starved_max);
 }
 
 gint packet_end_pad(tvbuff_t *tvb, proto_tree *tree, gint offset, gint size)
@@ -2073,7 +2632,578 @@ void check_length(tvbuff_t *tvb, packet_info *pinfo, proto_tree *tree, gint offs
 
 }
 
-static int hpsdr_usb_ep2_frame(proto_tree *tree, tvbuff_t *tvb, packet_info *pinfo, int offset, int frame_num) {
+// Captured bytes of length bytes at offset. Less than length when the
+// capture was taken with a snaplen shorter than the datagram.
+static gint captured_bytes(tvbuff_t *tvb, gint offset, gint length)
+{
+   gint remaining = -1;
+
+   remaining = tvb_captured_length_remaining(tvb, offset);
+   if ( remaining < 0 ) { return 0; }
+
+   return ( remaining < length ) ? remaining : length;
+}
+
+// Item for a part of the datagram that is not in the capture. The sequence
+// number and the C&C bytes in front of it are still decoded.
+static void not_captured_item(proto_tree *tree, tvbuff_t *tvb, packet_info *pinfo, gint offset, gint length,
+                              const char *part)
+{
+   proto_item *ei_item = NULL;
+   gint captured = -1;
+
+   captured = captured_bytes(tvb, offset, length);
+   ei_item = proto_tree_add_string_format(tree, hf_hpsdr_u_ei, tvb, offset, captured, NULL,
+                                          "%s not captured (%d Bytes)", part, length);
+   expert_add_info_format(pinfo, ei_item, &ei_not_captured,
+                          "%s not captured, %d of %d bytes are in the capture.", part, captured, length);
+}
+
+// TRUE when a filter, column or IO graph uses a per sample EP2 field. Not
+// TRUE for a visible tree, the summary is shown instead.
+static gboolean ep2_samples_referenced(void)
+{
+   return ( proto_registrar_get_nth(hf_hpsdr_u_ep2_idx)->ref_type != HF_REF_TYPE_NONE ||
+            proto_registrar_get_nth(hf_hpsdr_u_ep2_l)->ref_type != HF_REF_TYPE_NONE ||
+            proto_registrar_get_nth(hf_hpsdr_u_ep2_r)->ref_type != HF_REF_TYPE_NONE ||
+            proto_registrar_get_nth(hf_hpsdr_u_ep2_i)->ref_type != HF_REF_TYPE_NONE ||
+            proto_registrar_get_nth(hf_hpsdr_u_ep2_q)->ref_type != HF_REF_TYPE_NONE );
+}
+
+// Peak of 16 bit samples in dBFS, 0 dBFS is 2^15.
+static double ep2_peak_dbfs(double peak_power)
+{
+   if ( peak_power <= 0 ) { return HPSDR_U_IQ_DBFS_FLOOR; }
+
+   return 10.0 * log10(peak_power / ( 32768.0 * 32768.0 ));
+}
+
+// Sample count and peak levels of the 63 Left, Right, I and Q samples of a
+// EP2 USB frame. Added to the data item text and as generated items.
+static void ep2_sample_summary(proto_tree *tree, proto_item *item, tvbuff_t *tvb, gint offset,
+                               const guint8 *data)
+{
+   proto_item *summary_item = NULL;
+
+   double peak_l = 0;
+   double peak_r = 0;
+   double peak_iq = 0;
+   double power = 0;
+   gint16 I = 0;
+   gint16 Q = 0;
+   gint16 L = 0;
+   gint16 R = 0;
+   int x = -1;
+
+   for (x = 0; x < HPSDR_U_EP2_SAMPLES; x++) {
+      L = (gint16)pntoh16(data + ( x * 8 ));
+      R = (gint16)pntoh16(data + ( x * 8 ) + 2);
+      I = (gint16)pntoh16(data + ( x * 8 ) + 4);
+      Q = (gint16)pntoh16(data + ( x * 8 ) + 6);
+
+      if ( (double)L * L > peak_l ) { peak_l = (double)L * L; }
+      if ( (double)R * R > peak_r ) { peak_r = (double)R * R; }
+      power = ( (double)I * I ) + ( (double)Q * Q );
+      if ( power > peak_iq ) { peak_iq = power; }
+   }
+
+   proto_item_append_text(item, ": %d Samples, Audio Peak L %.1f dBFS R %.1f dBFS, TX IQ Peak %.1f dBFS",
+                          HPSDR_U_EP2_SAMPLES, ep2_peak_dbfs(peak_l), ep2_peak_dbfs(peak_r),
+                          ep2_peak_dbfs(peak_iq));
+
+   summary_item = proto_tree_add_uint(tree, hf_hpsdr_u_ep2_sum_count, tvb, offset, 504, HPSDR_U_EP2_SAMPLES);
+   proto_item_set_generated(summary_item);
+   summary_item = proto_tree_add_double(tree, hf_hpsdr_u_ep2_sum_l_peak, tvb, offset, 504, ep2_peak_dbfs(peak_l));
+   proto_item_set_generated(summary_item);
+   summary_item = proto_tree_add_double(tree, hf_hpsdr_u_ep2_sum_r_peak, tvb, offset, 504, ep2_peak_dbfs(peak_r));
+   proto_item_set_generated(summary_item);
+   summary_item = proto_tree_add_double(tree, hf_hpsdr_u_ep2_sum_iq_peak, tvb, offset, 504, ep2_peak_dbfs(peak_iq));
+   proto_item_set_generated(summary_item);
+}
+
+// TRUE when the datagram is displayed or a filter, column or IO graph uses
+// one of the per receiver IQ signal fields.
+static gboolean ep6_rx_signal_referenced(proto_tree *tree)
+{
+   return ( proto_field_is_referenced(tree, hf_hpsdr_u_rx_idx) ||
+            proto_field_is_referenced(tree, hf_hpsdr_u_rx_dc_i) ||
+            proto_field_is_referenced(tree, hf_hpsdr_u_rx_dc_q) ||
+            proto_field_is_referenced(tree, hf_hpsdr_u_rx_peak) ||
+            proto_field_is_referenced(tree, hf_hpsdr_u_rx_clip) ||
+            proto_field_is_referenced(tree, hf_hpsdr_u_rx_rms_dbfs) ||
+            proto_field_is_referenced(tree, hf_hpsdr_u_rx_peak_dbfs) );
+}
+
+// Generated per receiver IQ signal statistics of the two EP6 USB frames.
+static void ep6_rx_signal(proto_tree *tree, tvbuff_t *tvb, gint offset, const hpsdr_u_tap_info_t *tap_info)
+{
+   proto_item *rx_item = NULL;
+   proto_tree *hpsdr_u_tree_rx = NULL;
+
+   hpsdr_u_iq_stats_t stats[HPSDR_U_RX_MAX];
+   gint32 i[HPSDR_U_IQ_FRAME_MAX];
+   gint32 q[HPSDR_U_IQ_FRAME_MAX];
+
+   int samp_num = -1;
+   int x = -1;
+   int z = -1;
+
+   if ( tap_info->rx_num <= 0 || tap_info->rx_num > HPSDR_U_RX_MAX ) { return; }
+
+   // Samples not captured (snaplen), no statistics.
+   if ( tap_info->frame[0].data == NULL && tap_info->frame[1].data == NULL ) { return; }
+
+   memset(stats, 0, sizeof(stats));
+
+   for (x = 0; x < HPSDR_U_FRAMES; x++) {
+      if ( tap_info->frame[x].data == NULL ) { continue; }
+
+      samp_num = hpsdr_u_iq_unpack(tap_info->frame[x].data, tap_info->rx_num, i, q);
+      for (z = 0; z < tap_info->rx_num; z++) {
+         hpsdr_u_iq_stats_add(&stats[z], &i[z * samp_num], &q[z * samp_num], samp_num);
+      }
+   }
+
+   for (z = 0; z < tap_info->rx_num; z++) {
+      rx_item = proto_tree_add_uint_format(tree, hf_hpsdr_u_rx_idx, tvb, offset, 1024, z + 1,
+                                           "Receiver %d Signal: RMS %.2f dBFS  Peak %.2f dBFS", z + 1,
+                                           hpsdr_u_iq_rms_dbfs(&stats[z]), hpsdr_u_iq_peak_dbfs(&stats[z]));
+      proto_item_set_generated(rx_item);
+      hpsdr_u_tree_rx = proto_item_add_subtree(rx_item, ett_hpsdr_u_rx);
+
+      rx_item = proto_tree_add_double(hpsdr_u_tree_rx, hf_hpsdr_u_rx_rms_dbfs, tvb, offset, 1024,
+                                      hpsdr_u_iq_rms_dbfs(&stats[z]));
+      proto_item_set_generated(rx_item);
+      rx_item = proto_tree_add_double(hpsdr_u_tree_rx, hf_hpsdr_u_rx_peak_dbfs, tvb, offset, 1024,
+                                      hpsdr_u_iq_peak_dbfs(&stats[z]));
+      proto_item_set_generated(rx_item);
+
+      rx_item = proto_tree_add_double(hpsdr_u_tree_rx, hf_hpsdr_u_rx_dc_i, tvb, offset, 1024,
+                                      hpsdr_u_iq_dc_i(&stats[z]));
+      proto_item_set_generated(rx_item);
+      rx_item = proto_tree_add_double(hpsdr_u_tree_rx, hf_hpsdr_u_rx_dc_q, tvb, offset, 1024,
+                                      hpsdr_u_iq_dc_q(&stats[z]));
+      proto_item_set_generated(rx_item);
+      rx_item = proto_tree_add_double(hpsdr_u_tree_rx, hf_hpsdr_u_rx_peak, tvb, offset, 1024,
+                                      hpsdr_u_iq_peak(&stats[z]));
+      proto_item_set_generated(rx_item);
+      rx_item = proto_tree_add_uint(hpsdr_u_tree_rx, hf_hpsdr_u_rx_clip, tvb, offset, 1024,
+                                    (guint32)stats[z].near_fs);
+      proto_item_set_generated(rx_item);
+   }
+}
+
+// Data of the conversation, made on the first EP2, EP4 or EP6 datagram.
+static hpsdr_u_conv_data_t *hpsdr_u_conv_data(packet_info *pinfo)
+{
+   conversation_t *conversation = NULL;
+   hpsdr_u_conv_data_t *conv_data = NULL;
+
+   conversation = find_or_create_conversation(pinfo);
+   conv_data = (hpsdr_u_conv_data_t *)conversation_get_proto_data(conversation, proto_hpsdr_u);
+   if ( conv_data == NULL ) {
+      conv_data = wmem_new0(wmem_file_scope(), hpsdr_u_conv_data_t);
+      conv_data->stream = hpsdr_u_sample_stream_new(wmem_file_scope());
+      conv_data->infer = hpsdr_u_infer_new(wmem_file_scope());
+      conv_data->unknown_rx = wmem_stack_new(wmem_file_scope());
+      conv_data->unknown_board = wmem_stack_new(wmem_file_scope());
+      conv_data->ep2_run_data = wmem_stack_new(wmem_file_scope());
+      conversation_add_proto_data(conversation, proto_hpsdr_u, conv_data);
+   }
+
+   return conv_data;
+}
+
+// Number of receivers of the conversation, from EP2 C0=0x00 or inferred
+// from the EP6 samples. 0 when not known.
+static int hpsdr_u_conv_rx_num(const hpsdr_u_conv_data_t *conv_data)
+{
+   return ( conv_data->rx_num != 0 ) ? conv_data->rx_num : conv_data->rx_num_inferred;
+}
+
+// Number of receivers from the EP6 samples when the conversation has not
+// had a EP2 C0=0x00 USB frame. Only on the first pass, the answer is kept
+// by the conversation and the scoring is not done after that.
+static void ep6_rx_num_infer(packet_info *pinfo, tvbuff_t *tvb, gint offset)
+{
+   hpsdr_u_conv_data_t *conv_data = NULL;
+   int rx_max = 0;
+   int found = 0;
+   int x = -1;
+
+   if ( !hpsdr_u_pref_infer_rx_num || PINFO_FD_VISITED(pinfo) ) { return; }
+
+   // Sync, C0 to C4 and 504 sample bytes of both USB frames
+   if ( !tvb_bytes_exist(tvb, offset, 1024) ) { return; }
+
+   conv_data = hpsdr_u_conv_data(pinfo);
+   if ( hpsdr_u_conv_rx_num(conv_data) != 0 ) { return; }
+
+   // The largest number of receivers EP2 C0=0x00 C4 can set.
+   rx_max = ( ( ( hpsdr_u_pref_hermes_lite_2 ? HOST_C4_HL2_RX_NU : HOST_C4_RX_NU ) >> 3 ) + 1 );
+
+   for (x = 0; x < HPSDR_U_FRAMES && found == 0; x++) {
+      found = hpsdr_u_infer_add(conv_data->infer, tvb_get_ptr(tvb, offset + ( x * 512 ) + 8, 504), rx_max);
+   }
+
+   if ( found > 0 ) { conv_data->rx_num_inferred = found; }
+}
+
+// The EP6 datagrams the first pass decoded before the number of receivers
+// or the board ID was known get them once they are known. Re-dissection
+// (selecting a packet, a filter, a reload) then decodes them correctly.
+// The back-filled datagrams do not get sample numbers.
+static void ep6_backfill(hpsdr_u_conv_data_t *conv_data)
+{
+   hpsdr_u_packet_data_t *packet_data = NULL;
+
+   if ( hpsdr_u_conv_rx_num(conv_data) != 0 ) {
+      while ( wmem_stack_count(conv_data->unknown_rx) > 0 ) {
+         packet_data = (hpsdr_u_packet_data_t *)wmem_stack_pop(conv_data->unknown_rx);
+         packet_data->rx_num = hpsdr_u_conv_rx_num(conv_data);
+         packet_data->rx_num_inferred = ( conv_data->rx_num == 0 ) ? conv_data->rx_num_inferred : 0;
+         packet_data->backfill = TRUE;
+      }
+   }
+
+   if ( board_id != 0xFF ) {
+      while ( wmem_stack_count(conv_data->unknown_board) > 0 ) {
+         packet_data = (hpsdr_u_packet_data_t *)wmem_stack_pop(conv_data->unknown_board);
+         packet_data->board_id = board_id;
+      }
+   }
+}
+
+// State (number of receivers, board ID, speed, ADC of the receivers) and
+// absolute sample numbers of the EP6 datagram. Worked out on the first
+// pass, in frame order, and saved with the packet.
+static hpsdr_u_packet_data_t *ep6_packet_data(packet_info *pinfo, guint32 seq)
+{
+   hpsdr_u_conv_data_t *conv_data = NULL;
+   hpsdr_u_packet_data_t *packet_data = NULL;
+
+   packet_data = (hpsdr_u_packet_data_t *)p_get_proto_data(wmem_file_scope(), pinfo, proto_hpsdr_u, HPSDR_U_PDATA_EP6);
+   if ( packet_data != NULL || PINFO_FD_VISITED(pinfo) ) { return packet_data; }
+
+   conv_data = hpsdr_u_conv_data(pinfo);
+   ep6_backfill(conv_data);
+
+   packet_data = wmem_new0(wmem_file_scope(), hpsdr_u_packet_data_t);
+   packet_data->rx_num = hpsdr_u_conv_rx_num(conv_data);
+   packet_data->board_id = board_id;
+   packet_data->speed_num = speed_num;
+   memcpy(packet_data->rx_adc, rx_adc, sizeof(rx_adc));
+   packet_data->sample_index = conv_data->stream->index;
+   packet_data->rx_num_inferred = ( conv_data->rx_num == 0 ) ? conv_data->rx_num_inferred : 0;
+   packet_data->have_sample = hpsdr_u_sample_stream_add(conv_data->stream, seq, packet_data->rx_num, pinfo->num,
+                                                        &packet_data->first_sample, &packet_data->gap);
+   if ( packet_data->have_sample ) { packet_data->samples = conv_data->stream->per_datagram; }
+
+   if ( packet_data->rx_num == 0 ) { wmem_stack_push(conv_data->unknown_rx, packet_data); }
+   if ( board_id == 0xFF ) { wmem_stack_push(conv_data->unknown_board, packet_data); }
+
+   p_add_proto_data(wmem_file_scope(), pinfo, proto_hpsdr_u, HPSDR_U_PDATA_EP6, packet_data);
+
+   return packet_data;
+}
+
+// A run of zero samples that ends within the preference is a host that did
+// not have the samples. Every datagram of the run gets the run.
+static void ep2_run_end(hpsdr_u_conv_data_t *conv_data, hpsdr_u_ep2_data_t *ep2_data, guint32 frame_num)
+{
+   hpsdr_u_ep2_data_t *run_data = NULL;
+
+   if ( conv_data->ep2_run > 0 && conv_data->ep2_run <= hpsdr_u_pref_ep2_starved_max ) {
+      ep2_data->runs += 1;
+      ep2_data->starved += conv_data->ep2_run;
+      if ( conv_data->ep2_run > ep2_data->longest ) { ep2_data->longest = conv_data->ep2_run; }
+
+      while ( wmem_stack_count(conv_data->ep2_run_data) > 0 ) {
+         run_data = (hpsdr_u_ep2_data_t *)wmem_stack_pop(conv_data->ep2_run_data);
+         if ( run_data->run_start == 0 ) {
+            run_data->run_start = conv_data->ep2_run_start;
+            run_data->run_end = frame_num;
+         }
+      }
+
+      if ( ep2_data->run_start == 0 ) {
+         ep2_data->run_start = conv_data->ep2_run_start;
+         ep2_data->run_end = frame_num;
+      }
+   }
+
+   conv_data->ep2_run = 0;
+}
+
+// Zero samples and starved runs of the EP2 datagram. Worked out on the
+// first pass, in frame order, and saved with the packet.
+static hpsdr_u_ep2_data_t *ep2_packet_data(packet_info *pinfo, const hpsdr_u_tap_info_t *tap_info)
+{
+   hpsdr_u_conv_data_t *conv_data = NULL;
+   hpsdr_u_ep2_data_t *ep2_data = NULL;
+   guint64 mask = 0;
+   int f = -1;
+   int x = -1;
+
+   ep2_data = (hpsdr_u_ep2_data_t *)p_get_proto_data(wmem_file_scope(), pinfo, proto_hpsdr_u, HPSDR_U_PDATA_EP2);
+   if ( ep2_data != NULL || PINFO_FD_VISITED(pinfo) ) { return ep2_data; }
+
+   conv_data = hpsdr_u_conv_data(pinfo);
+   ep2_data = wmem_new0(wmem_file_scope(), hpsdr_u_ep2_data_t);
+
+   for (f = 0; f < HPSDR_U_FRAMES; f++) {
+      // No samples when the EP2 sync was not found.
+      if ( tap_info->frame[f].data == NULL ) { continue; }
+
+      mask = hpsdr_u_zero_mask(tap_info->frame[f].data, HPSDR_U_EP2_SAMPLES);
+
+      // Most USB frames do not have a zero sample.
+      if ( mask == 0 ) {
+         ep2_run_end(conv_data, ep2_data, pinfo->num);
+         conv_data->ep2_live = TRUE;
+         continue;
+      }
+
+      for (x = 0; x < HPSDR_U_EP2_SAMPLES; x++) {
+         if ( ( mask & ( G_GUINT64_CONSTANT(1) << x ) ) == 0 ) {
+            ep2_run_end(conv_data, ep2_data, pinfo->num);
+            conv_data->ep2_live = TRUE;
+            continue;
+         }
+
+         ep2_data->zero += 1;
+
+         // Zero samples before the first sample that is not zero are a host that has not started.
+         if ( !conv_data->ep2_live ) { continue; }
+
+         if ( conv_data->ep2_run == 0 ) { conv_data->ep2_run_start = pinfo->num; }
+         conv_data->ep2_run += 1;
+
+         // Too long for a starved host, the host is idle.
+         if ( conv_data->ep2_run > hpsdr_u_pref_ep2_starved_max ) {
+            while ( wmem_stack_count(conv_data->ep2_run_data) > 0 ) { wmem_stack_pop(conv_data->ep2_run_data); }
+         } else if ( wmem_stack_count(conv_data->ep2_run_data) == 0 ||
+                     wmem_stack_peek(conv_data->ep2_run_data) != ep2_data ) {
+            wmem_stack_push(conv_data->ep2_run_data, ep2_data);
+         }
+      }
+   }
+
+   p_add_proto_data(wmem_file_scope(), pinfo, proto_hpsdr_u, HPSDR_U_PDATA_EP2, ep2_data);
+
+   return ep2_data;
+}
+
+// Generated zero sample and starved run items of a EP2 datagram.
+static void ep2_starved_items(proto_tree *tree, tvbuff_t *tvb, packet_info *pinfo, gint offset,
+                              const hpsdr_u_ep2_data_t *ep2_data)
+{
+   proto_item *starved_item = NULL;
+
+   starved_item = proto_tree_add_uint(tree, hf_hpsdr_u_ep2_zero, tvb, offset, 1024, ep2_data->zero);
+   proto_item_set_generated(starved_item);
+
+   if ( ep2_data->run_start != 0 ) {
+      starved_item = proto_tree_add_uint(tree, hf_hpsdr_u_ep2_run_start, tvb, offset, 0, ep2_data->run_start);
+      proto_item_set_generated(starved_item);
+      starved_item = proto_tree_add_uint(tree, hf_hpsdr_u_ep2_run_end, tvb, offset, 0, ep2_data->run_end);
+      proto_item_set_generated(starved_item);
+   }
+
+   if ( ep2_data->runs > 0 ) {
+      starved_item = proto_tree_add_uint(tree, hf_hpsdr_u_ep2_starved_runs, tvb, offset, 0, ep2_data->runs);
+      proto_item_set_generated(starved_item);
+      starved_item = proto_tree_add_uint(tree, hf_hpsdr_u_ep2_starved, tvb, offset, 0, ep2_data->starved);
+      proto_item_set_generated(starved_item);
+      expert_add_info_format(pinfo, starved_item, &ei_ep2_starved,
+                             "EP2 host starved, %u zero samples (%.3f ms) in place of samples, the run started in frame %u.",
+                             ep2_data->starved, 1000.0 * ep2_data->starved / HPSDR_U_AUDIO_RATE, ep2_data->run_start);
+   }
+}
+
+// Datagrams (512 samples) in a wide band buffer of the board.
+static guint32 ep4_fragments(guint8 ep4_board_id)
+{
+   guint samples = 0;
+
+   samples = hpsdr_u_pref_ep4_buffer;
+   if ( samples == 0 ) {
+      samples = ( ep4_board_id == 0x00 ) ? HPSDR_U_EP4_BUFFER_METIS : HPSDR_U_EP4_BUFFER;
+   }
+
+   if ( samples > HPSDR_U_EP4_BUFFER_MAX ) { samples = HPSDR_U_EP4_BUFFER_MAX; }
+   if ( samples < HPSDR_U_EP4_SAMPLES ) { samples = HPSDR_U_EP4_SAMPLES; }
+
+   return samples / HPSDR_U_EP4_SAMPLES;
+}
+
+// Buffer and fragment numbers of the EP4 datagram. The radio starts the EP4
+// sequence numbers at 0 with the wide band data, a buffer starts on a
+// sequence number that is a multiple of the datagrams per buffer.
+static hpsdr_u_ep4_data_t *ep4_packet_data(packet_info *pinfo, guint32 seq)
+{
+   hpsdr_u_conv_data_t *conv_data = NULL;
+   hpsdr_u_ep4_data_t *ep4_data = NULL;
+
+   ep4_data = (hpsdr_u_ep4_data_t *)p_get_proto_data(wmem_file_scope(), pinfo, proto_hpsdr_u, HPSDR_U_PDATA_EP4);
+   if ( ep4_data != NULL || PINFO_FD_VISITED(pinfo) ) { return ep4_data; }
+
+   conv_data = hpsdr_u_conv_data(pinfo);
+
+   ep4_data = wmem_new0(wmem_file_scope(), hpsdr_u_ep4_data_t);
+   ep4_data->fragments = ep4_fragments(board_id);
+   ep4_data->buffer_id = seq / ep4_data->fragments;
+   ep4_data->fragment = seq % ep4_data->fragments;
+
+   if ( conv_data->ep4_started && (gint32)( seq - conv_data->ep4_next_seq ) > 0 ) {
+      ep4_data->missing = seq - conv_data->ep4_next_seq;
+   }
+   if ( !conv_data->ep4_started || (gint32)( seq - conv_data->ep4_next_seq ) >= 0 ) {
+      conv_data->ep4_next_seq = seq + 1;
+      conv_data->ep4_started = TRUE;
+   }
+
+   p_add_proto_data(wmem_file_scope(), pinfo, proto_hpsdr_u, HPSDR_U_PDATA_EP4, ep4_data);
+
+   return ep4_data;
+}
+
+// Adds the EP4 datagram to its wide band buffer. Returns the reassembled
+// buffer on the datagram that completes it, NULL on the other datagrams.
+static tvbuff_t *ep4_reassemble(proto_tree *tree, tvbuff_t *tvb, packet_info *pinfo, gint offset,
+                                guint32 seq, hpsdr_u_tap_info_t *tap_info)
+{
+   hpsdr_u_ep4_data_t *ep4_data = NULL;
+   fragment_head *fd_head = NULL;
+   tvbuff_t *buffer_tvb = NULL;
+   proto_item *ep4_item = NULL;
+   proto_item *buffer_item = NULL;
+   proto_tree *hpsdr_u_tree_ep4 = NULL;
+   gboolean save_fragmented = FALSE;
+   gboolean last = FALSE;
+
+   ep4_data = ep4_packet_data(pinfo, seq);
+   if ( ep4_data == NULL ) { return NULL; }
+
+   last = ( ep4_data->fragment + 1 == ep4_data->fragments );
+
+   buffer_item = proto_tree_add_uint(tree, hf_hpsdr_u_ep4_buffer_id, tvb, offset, 0, ep4_data->buffer_id);
+   proto_item_set_generated(buffer_item);
+   ep4_item = proto_tree_add_uint_format_value(tree, hf_hpsdr_u_ep4_buffer_fragment, tvb, offset, 0,
+                                               ep4_data->fragment, "%u of %u",
+                                               ep4_data->fragment + 1, ep4_data->fragments);
+   proto_item_set_generated(ep4_item);
+
+   if ( ep4_data->missing > 0 ) {
+      ep4_item = proto_tree_add_uint(tree, hf_hpsdr_u_ep4_missing, tvb, offset, 0, ep4_data->missing);
+      proto_item_set_generated(ep4_item);
+      expert_add_info_format(pinfo, ep4_item, &ei_ep4_missing,
+                             "%u EP4 datagrams missing, the wide band buffers they are in are not complete.",
+                             ep4_data->missing);
+   }
+
+   if ( !tvb_bytes_exist(tvb, offset, HPSDR_U_EP4_SAMPLES * 2) ) { return NULL; }
+
+   save_fragmented = pinfo->fragmented;
+   pinfo->fragmented = TRUE;
+
+   fd_head = fragment_add_seq_check(&hpsdr_u_ep4_reassembly_table, tvb, offset, pinfo,
+                                    ep4_data->buffer_id, NULL, ep4_data->fragment,
+                                    HPSDR_U_EP4_SAMPLES * 2, !last);
+   buffer_tvb = process_reassembled_data(tvb, offset, pinfo, "Wide Band Buffer", fd_head,
+                                         &hpsdr_u_ep4_frag_items, NULL, tree);
+
+   pinfo->fragmented = save_fragmented;
+
+   if ( last && buffer_tvb == NULL ) {
+      expert_add_info_format(pinfo, buffer_item, &ei_ep4_incomplete,
+                             "Wide band buffer %u is missing datagrams, it is not reassembled.",
+                             ep4_data->buffer_id);
+   }
+
+   if ( buffer_tvb != NULL ) {
+      ep4_item = proto_tree_add_uint(tree, hf_hpsdr_u_ep4_buffer_samples, buffer_tvb, 0,
+                                     tvb_reported_length(buffer_tvb),
+                                     tvb_reported_length(buffer_tvb) / 2);
+      proto_item_set_generated(ep4_item);
+      hpsdr_u_tree_ep4 = proto_item_add_subtree(ep4_item, ett_hpsdr_u_ep4_buffer);
+      proto_tree_add_uint(hpsdr_u_tree_ep4, hf_hpsdr_u_ep4_buffer_id, buffer_tvb, 0, 0, ep4_data->buffer_id);
+
+      tap_info->ep4_buffer = buffer_tvb;
+      tap_info->ep4_buffer_id = ep4_data->buffer_id;
+   }
+
+   return buffer_tvb;
+}
+
+// Bytes searched for the EP2 sync, the captured bytes up to max_skew
+// extra bytes and the sync.
+static gint ep2_sync_window(tvbuff_t *tvb, gint offset, guint max_skew)
+{
+   gint length = -1;
+
+   length = tvb_captured_length_remaining(tvb, offset);
+   if ( length < 0 ) { return 0; }
+   if ( length > (gint)max_skew + 3 ) { length = max_skew + 3; }
+
+   return length;
+}
+
+// Extra bytes in front of the EP2 sync (0x7F7F7F), -1 when the sync is not
+// in the window. A malformed or foreign datagram costs no more than the
+// window. memchr() finds the 0x7F bytes, the C library uses SIMD for it.
+static gint ep2_sync_skew(tvbuff_t *tvb, gint offset, guint max_skew)
+{
+   const guint8 *view = NULL;
+   const guint8 *p = NULL;
+   gint length = -1;
+
+   length = ep2_sync_window(tvb, offset, max_skew);
+   if ( length < 3 ) { return -1; }
+
+   view = tvb_get_ptr(tvb, offset, length);
+
+   for (p = view; p + 3 <= view + length; p++) {
+      p = (const guint8 *)memchr(p, 0x7F, ( view + length - 2 ) - p);
+      if ( p == NULL ) { return -1; }
+      if ( p[1] == 0x7F && p[2] == 0x7F ) { return (gint)( p - view ); }
+   }
+
+   return -1;
+}
+
+// Generated items for the ADCs with an overflow and the receivers they feed.
+// overflow: bit 0 is ADC1 .. bit 3 is ADC4
+static void ep6_overflow_items(proto_tree *tree, tvbuff_t *tvb, gint offset, guint8 overflow, int ep6_rx_num,
+                               const guint8 *ep6_rx_adc)
+{
+   proto_item *overflow_item = NULL;
+
+   int adc = -1;
+   int rx = -1;
+   int rx_max = -1;
+
+   // The first receiver is there when the number of receivers is not known.
+   rx_max = ( ep6_rx_num > 0 ) ? ep6_rx_num : 1;
+   if ( rx_max > HPSDR_U_RX_ADC ) { rx_max = HPSDR_U_RX_ADC; }
+
+   for (adc = 0; adc < 4; adc++) {
+      if ( !( overflow & ( 1 << adc ) ) ) { continue; }
+
+      overflow_item = proto_tree_add_uint(tree, hf_hpsdr_u_overflow_adc, tvb, offset, 4, adc + 1);
+      proto_item_set_generated(overflow_item);
+
+      for (rx = 0; rx < rx_max; rx++) {
+         if ( ep6_rx_adc[rx] != adc ) { continue; }
+
+         overflow_item = proto_tree_add_uint(tree, hf_hpsdr_u_overflow_rx, tvb, offset, 4, rx + 1);
+         proto_item_set_generated(overflow_item);
+      }
+   }
+}
+
+static int hpsdr_usb_ep2_frame(proto_tree *tree, tvbuff_t *tvb, packet_info *pinfo, int offset, int frame_num,
+                               hpsdr_u_tap_frame_t *tap_frame) {
 
    //Submenu items
    proto_item *c0_item = NULL;
@@ -2132,6 +3262,7 @@ static int hpsdr_usb_ep2_frame(proto_tree *tree, tvbuff_t *tvb, packet_info *pin
    int *cc_conf_c3_c4 = NULL;
    int *cc_conf_sub = NULL;
    int *ett_ep2_data = NULL;
+   const int **cc_conf_c3_fields = NULL;
    int *ep2_data_sub = NULL;
 
    int sync_error = 0;
@@ -2202,9 +3333,28 @@ static int hpsdr_usb_ep2_frame(proto_tree *tree, tvbuff_t *tvb, packet_info *pin
 
    // Find Sync
    // Needed because host appilcations do behave VERY BADLY !!!!!!!
-   while ( hpsdr_u_pref_ep2_sync && ( tvb_get_guint24(tvb, offset,3) != 0x7F7F7F ) ) {
-      offset += 1;
-      sync_error += 1;
+   tap_frame->sync_skew = HPSDR_U_SYNC_NOT_SEARCHED;
+   // Not searched past the snaplen, a short capture is not a missing sync.
+   if ( hpsdr_u_pref_ep2_sync && captured_bytes(tvb, offset, 8) == 8 ) {
+      sync_error = ep2_sync_skew(tvb, offset, hpsdr_u_pref_ep2_sync_max);
+      tap_frame->sync_skew = sync_error;
+
+      if ( sync_error < 0 ) {
+         ei_sync_item = proto_tree_add_string_format(tree, hf_hpsdr_u_ei, tvb, offset,
+                                                     ep2_sync_window(tvb, offset, hpsdr_u_pref_ep2_sync_max),
+                                                     NULL, "EP2 Sync not found");
+         expert_add_info_format(pinfo,ei_sync_item,&ei_ep2_sync_missing,
+                                "EP2 Sync not found in the first %u bytes of the USB frame.",
+                                hpsdr_u_pref_ep2_sync_max + 3);
+         return offset + 512;
+      }
+
+      offset += sync_error;
+   }
+
+   if ( captured_bytes(tvb, offset, 8) < 8 ) {
+      not_captured_item(tree, tvb, pinfo, offset, 512, "EP2 USB frame");
+      return offset + 512;
    }
 
    ei_sync_item = proto_tree_add_item(tree, *sync, tvb,offset, 3, ENC_BIG_ENDIAN);
@@ -2216,6 +3366,12 @@ static int hpsdr_usb_ep2_frame(proto_tree *tree, tvbuff_t *tvb, packet_info *pin
 
    offset += 3;
 
+   // Raw C&C bytes for the taps
+   for (x = 0; x <= 4; x++) {
+      tap_frame->cc[x] = tvb_get_guint8(tvb, offset + x);
+   }
+   tap_frame->have_cc = TRUE;
+
    C0 = tvb_get_guint8(tvb, offset);
 
    c0_item = proto_tree_add_uint_format(tree, *c0_sub, tvb, offset, 1,
@@ -2245,6 +3401,7 @@ static int hpsdr_usb_ep2_frame(proto_tree *tree, tvbuff_t *tvb, packet_info *pin
    }
 
    proto_item_append_text(c0_type_item,"0x%02X %d", C0_masked, C0_masked);
+   tap_frame->c0_type = C0_masked;
    offset += 1;
 
    // The "C0 Types" are 7 bit numbers.
@@ -2290,79 +3447,50 @@ static int hpsdr_usb_ep2_frame(proto_tree *tree, tvbuff_t *tvb, packet_info *pin
       hpsdr_u_tree_cc_conf = proto_item_add_subtree(cc_conf_item, ett_hpsdr_u_cc_conf);
 
       C1 = tvb_get_guint8(tvb, offset);
-      proto_tree_add_item(hpsdr_u_tree_cc_conf, *cc_conf_c1, tvb,offset, 1, ENC_BIG_ENDIAN);
+      speed_num = ( C1 & HOST_C1_SPEED );
 
-      proto_tree_add_item(hpsdr_u_tree_cc_conf, hf_hpsdr_u_cc_speed, tvb,offset, 1, C1);
-      proto_tree_add_item(hpsdr_u_tree_cc_conf, hf_hpsdr_u_cc_10mhz, tvb,offset, 1, C1);
-      proto_tree_add_boolean(hpsdr_u_tree_cc_conf, hf_hpsdr_u_cc_122mhz, tvb,offset, 1, C1);
-      proto_tree_add_item(hpsdr_u_tree_cc_conf, hf_hpsdr_u_cc_conf, tvb,offset, 1, C1);
-      proto_tree_add_boolean(hpsdr_u_tree_cc_conf, hf_hpsdr_u_cc_mic_s,tvb,offset, 1, C1);
+      proto_tree_add_bitmask(hpsdr_u_tree_cc_conf, tvb, offset, *cc_conf_c1, ett_hpsdr_u_cc_bits,
+                             cc_conf_c1_bits, ENC_BIG_ENDIAN);
       offset += 1;
 
-      C2 = tvb_get_guint8(tvb, offset);
-      proto_tree_add_item(hpsdr_u_tree_cc_conf, *cc_conf_c2, tvb,offset, 1, ENC_BIG_ENDIAN);
-
-      proto_tree_add_boolean(hpsdr_u_tree_cc_conf, hf_hpsdr_u_cc_mode,tvb,offset, 1, C2);
-      proto_tree_add_boolean(hpsdr_u_tree_cc_conf, hf_hpsdr_u_cc_oco_0,tvb,offset, 1, C2);
-      proto_tree_add_boolean(hpsdr_u_tree_cc_conf, hf_hpsdr_u_cc_oco_1,tvb,offset, 1, C2);
-      proto_tree_add_boolean(hpsdr_u_tree_cc_conf, hf_hpsdr_u_cc_oco_2,tvb,offset, 1, C2);
-      proto_tree_add_boolean(hpsdr_u_tree_cc_conf, hf_hpsdr_u_cc_oco_3,tvb,offset, 1, C2);
-      proto_tree_add_boolean(hpsdr_u_tree_cc_conf, hf_hpsdr_u_cc_oco_4,tvb,offset, 1, C2);
-      proto_tree_add_boolean(hpsdr_u_tree_cc_conf, hf_hpsdr_u_cc_oco_5,tvb,offset, 1, C2);
-      proto_tree_add_boolean(hpsdr_u_tree_cc_conf, hf_hpsdr_u_cc_oco_6,tvb,offset, 1, C2);
+      proto_tree_add_bitmask(hpsdr_u_tree_cc_conf, tvb, offset, *cc_conf_c2, ett_hpsdr_u_cc_bits,
+                             cc_conf_c2_bits, ENC_BIG_ENDIAN);
       offset += 1;
 
-      C3 = tvb_get_guint8(tvb, offset);
-      proto_tree_add_item(hpsdr_u_tree_cc_conf, *cc_conf_c3, tvb,offset, 1, ENC_BIG_ENDIAN);
-
-      proto_tree_add_item(hpsdr_u_tree_cc_conf, hf_hpsdr_u_cc_ant_pre_attn,tvb,offset, 1, C3);
-
-      if ( !( hpsdr_u_pref_hermes_lite_2 )) {
-         proto_tree_add_boolean(hpsdr_u_tree_cc_conf, hf_hpsdr_u_cc_ant_pre_pre_amp,tvb,offset, 1, C3);
-      } else {
-         proto_tree_add_boolean(hpsdr_u_tree_cc_conf, hf_hpsdr_u_cc_hl2_vna_gain,tvb,offset, 1, C3);
-      }
-
-      // // When hpsdr_u_pref_hermes_lite_1_cc is true.
-      // // Replace Dither with RX LNA gain.
-      // // Replace Random with RX ADC AGC.
-      // if ( !( hpsdr_u_pref_hermes_lite_1_cc )) {
-      //    proto_tree_add_boolean(hpsdr_u_tree_cc_conf, hf_hpsdr_u_cc_adc_dither,tvb,offset, 1, C3);
-      //    proto_tree_add_boolean(hpsdr_u_tree_cc_conf, hf_hpsdr_u_cc_adc_random,tvb,offset, 1, C3);
-      // } else {
-      //    proto_tree_add_boolean(hpsdr_u_tree_cc_conf, hf_hpsdr_u_cc_hl1_rx_lna_gain,tvb,offset, 1, C3);
-      //    proto_tree_add_boolean(hpsdr_u_tree_cc_conf, hf_hpsdr_u_cc_hl1_adc_agc,tvb,offset, 1, C3);
-      // }
-
       // When hpsdr_u_pref_hermes_lite_1_cc is true.
       // Replace Dither with RX LNA gain.
       // Replace Random with RX ADC AGC.
-      if ( hpsdr_u_pref_hermes_lite_1_cc ) {
-         proto_tree_add_boolean(hpsdr_u_tree_cc_conf, hf_hpsdr_u_cc_hl1_rx_lna_gain,tvb,offset, 1, C3);
-         proto_tree_add_boolean(hpsdr_u_tree_cc_conf, hf_hpsdr_u_cc_hl1_adc_agc,tvb,offset, 1, C3);
-      } else if (hpsdr_u_pref_hermes_lite_2 ) {
-         proto_tree_add_boolean(hpsdr_u_tree_cc_conf, hf_hpsdr_u_cc_adc_dither,tvb,offset, 1, C3);
-         proto_tree_add_boolean(hpsdr_u_tree_cc_conf, hf_hpsdr_u_cc_hl2_hw_agc,tvb,offset, 1, C3);
-
+      if ( hpsdr_u_pref_hermes_lite_1_cc && hpsdr_u_pref_hermes_lite_2 ) {
+         cc_conf_c3_fields = cc_conf_c3_hl1_hl2_bits;
+      } else if ( hpsdr_u_pref_hermes_lite_1_cc ) {
+         cc_conf_c3_fields = cc_conf_c3_hl1_bits;
+      } else if ( hpsdr_u_pref_hermes_lite_2 ) {
+         cc_conf_c3_fields = cc_conf_c3_hl2_bits;
       } else {
-         proto_tree_add_boolean(hpsdr_u_tree_cc_conf, hf_hpsdr_u_cc_adc_dither,tvb,offset, 1, C3);
-         proto_tree_add_boolean(hpsdr_u_tree_cc_conf, hf_hpsdr_u_cc_adc_random,tvb,offset, 1, C3);
+         cc_conf_c3_fields = cc_conf_c3_bits;
       }
 
-
-      proto_tree_add_item(hpsdr_u_tree_cc_conf, hf_hpsdr_u_cc_ant_pre_ant,tvb,offset, 1, C3);
-      proto_tree_add_boolean(hpsdr_u_tree_cc_conf, hf_hpsdr_u_cc_ant_pre_rx_out,tvb,offset, 1, C3);
+      proto_tree_add_bitmask(hpsdr_u_tree_cc_conf, tvb, offset, *cc_conf_c3, ett_hpsdr_u_cc_bits,
+                             cc_conf_c3_fields, ENC_BIG_ENDIAN);
       offset += 1;
 
       C4 = tvb_get_guint8(tvb, offset);
       proto_tree_add_item(hpsdr_u_tree_cc_conf, *cc_conf_c4, tvb,offset, 1, ENC_BIG_ENDIAN);
 
       //ep2_0_rx_num = ( ( (C4 & 0b00111000) >> 3 ) + 1) ; // bitwise and shift right 3 bits
-      ep2_0_rx_num = ( ( ( C4 & 0x38 ) >> 3 ) + 1 );
+      // Hermes-Lite2 has one more bit, up to 16 receivers.
+      if (!hpsdr_u_pref_hermes_lite_2) {
+         ep2_0_rx_num = ( ( ( C4 & HOST_C4_RX_NU ) >> 3 ) + 1 );
+      } else {
+         ep2_0_rx_num = ( ( ( C4 & HOST_C4_HL2_RX_NU ) >> 3 ) + 1 );
+      }
 
       // Get and save num of RX - When the IQ state is STOP.
       if ( (( global_flags & GF_BW_IQ_ST_ST ) == 0 ) | (( global_flags & GF_BW_IQ_ST_ST ) == 5 ) ) {
          rx_num = ep2_0_rx_num;
+
+         // Kept per conversation for the EP6 datagrams of the radio, first pass only.
+         if ( !PINFO_FD_VISITED(pinfo) ) { hpsdr_u_conv_data(pinfo)->rx_num = ep2_0_rx_num; }
       }
 
       proto_tree_add_item(hpsdr_u_tree_cc_conf, hf_hpsdr_u_cc_ant_pre_tx_relay,tvb,offset, 1, C4);
@@ -2470,47 +3598,21 @@ static int hpsdr_usb_ep2_frame(proto_tree *tree, tvbuff_t *tvb, packet_info *pin
                                                   C0_masked, "C&C C2,C3,C4 - HPF and LPF, VNA");
       hpsdr_u_tree_cc_filter = proto_item_add_subtree(cc_filter_item, ett_hpsdr_u_cc_filter);
 
-      C2 = tvb_get_guint8(tvb, offset);
-      proto_tree_add_item(hpsdr_u_tree_cc_filter, *cc_conf_c2, tvb,offset, 1, ENC_BIG_ENDIAN);
-
-      proto_tree_add_boolean(hpsdr_u_tree_cc_filter, hf_hpsdr_u_cc_mic_boost,tvb,offset, 1, C2);
-      proto_tree_add_boolean(hpsdr_u_tree_cc_filter, hf_hpsdr_u_cc_mic_l,tvb,offset, 1, C2);
       if (!hpsdr_u_pref_hermes_lite_2) {
-         proto_tree_add_boolean(hpsdr_u_tree_cc_filter, hf_hpsdr_u_cc_apollo_filter,tvb,offset, 1, C2);
-         proto_tree_add_boolean(hpsdr_u_tree_cc_filter, hf_hpsdr_u_cc_apollo_tunner,tvb,offset, 1, C2);
+         proto_tree_add_bitmask(hpsdr_u_tree_cc_filter, tvb, offset, *cc_conf_c2, ett_hpsdr_u_cc_bits,
+                                cc_filter_c2_bits, ENC_BIG_ENDIAN);
       } else {
-         proto_tree_add_boolean(hpsdr_u_tree_cc_filter, hf_hpsdr_u_cc_hl2_ext_ptt,tvb,offset, 1, C2);
-         proto_tree_add_boolean(hpsdr_u_tree_cc_filter, hf_hpsdr_u_cc_hl2_pa,tvb,offset, 1, C2);
+         proto_tree_add_bitmask(hpsdr_u_tree_cc_filter, tvb, offset, *cc_conf_c2, ett_hpsdr_u_cc_bits,
+                                cc_filter_c2_hl2_bits, ENC_BIG_ENDIAN);
       }
-      proto_tree_add_boolean(hpsdr_u_tree_cc_filter, hf_hpsdr_u_cc_apollo_auto,tvb,offset, 1, C2);
-      proto_tree_add_boolean(hpsdr_u_tree_cc_filter, hf_hpsdr_u_cc_herm_fil_s,tvb,offset, 1, C2);
-      proto_tree_add_boolean(hpsdr_u_tree_cc_filter, hf_hpsdr_u_cc_filter_man,tvb,offset, 1, C2);
-      proto_tree_add_boolean(hpsdr_u_tree_cc_filter, hf_hpsdr_u_cc_vna,tvb,offset, 1, C2);
       offset += 1;
 
-      C3 = tvb_get_guint8(tvb, offset);
-      proto_tree_add_item(hpsdr_u_tree_cc_filter, *cc_conf_c3, tvb,offset, 1, ENC_BIG_ENDIAN);
-
-      proto_tree_add_boolean(hpsdr_u_tree_cc_filter, hf_hpsdr_u_cc_hpf_13,tvb,offset, 1, C3);
-      proto_tree_add_boolean(hpsdr_u_tree_cc_filter, hf_hpsdr_u_cc_hpf_20,tvb,offset, 1, C3);
-      proto_tree_add_boolean(hpsdr_u_tree_cc_filter, hf_hpsdr_u_cc_hpf_9_5,tvb,offset, 1, C3);
-      proto_tree_add_boolean(hpsdr_u_tree_cc_filter, hf_hpsdr_u_cc_hpf_6_5,tvb,offset, 1, C3);
-      proto_tree_add_boolean(hpsdr_u_tree_cc_filter, hf_hpsdr_u_cc_hpf_1_5,tvb,offset, 1, C3);
-      proto_tree_add_boolean(hpsdr_u_tree_cc_filter, hf_hpsdr_u_cc_bypass_hpf,tvb,offset, 1, C3);
-      proto_tree_add_boolean(hpsdr_u_tree_cc_filter, hf_hpsdr_u_cc_6m_amp,tvb,offset, 1, C3);
-      proto_tree_add_boolean(hpsdr_u_tree_cc_filter, hf_hpsdr_u_cc_dis_ant_pre_tr,tvb,offset, 1, C3);
+      proto_tree_add_bitmask(hpsdr_u_tree_cc_filter, tvb, offset, *cc_conf_c3, ett_hpsdr_u_cc_bits,
+                             cc_filter_c3_bits, ENC_BIG_ENDIAN);
       offset += 1;
 
-      C4 = tvb_get_guint8(tvb, offset);
-      proto_tree_add_item(hpsdr_u_tree_cc_filter, hf_hpsdr_u_cc_ep2_c4_12, tvb,offset, 1, ENC_BIG_ENDIAN);
-
-      proto_tree_add_boolean(hpsdr_u_tree_cc_filter, hf_hpsdr_u_cc_lpf_30_20,tvb,offset, 1, C4);
-      proto_tree_add_boolean(hpsdr_u_tree_cc_filter, hf_hpsdr_u_cc_lpf_60_40,tvb,offset, 1, C4);
-      proto_tree_add_boolean(hpsdr_u_tree_cc_filter, hf_hpsdr_u_cc_lpf_80,tvb,offset, 1, C4);
-      proto_tree_add_boolean(hpsdr_u_tree_cc_filter, hf_hpsdr_u_cc_lpf_160,tvb,offset, 1, C4);
-      proto_tree_add_boolean(hpsdr_u_tree_cc_filter, hf_hpsdr_u_cc_lpf_6,tvb,offset, 1, C4);
-      proto_tree_add_boolean(hpsdr_u_tree_cc_filter, hf_hpsdr_u_cc_lpf_12_10,tvb,offset, 1, C4);
-      proto_tree_add_boolean(hpsdr_u_tree_cc_filter, hf_hpsdr_u_cc_lpf_17_15,tvb,offset, 1, C4);
+      proto_tree_add_bitmask(hpsdr_u_tree_cc_filter, tvb, offset, hf_hpsdr_u_cc_ep2_c4_12, ett_hpsdr_u_cc_bits,
+                             cc_filter_c4_bits, ENC_BIG_ENDIAN);
       offset += 1;
 
    } else if ( C0_masked == 0x0A ) { // RX Pre-amp, IF Gain, PureSignal, Open Drain, TTL, 20db/ADC1 Attn
@@ -2531,16 +3633,8 @@ static int hpsdr_usb_ep2_frame(proto_tree *tree, tvbuff_t *tvb, packet_info *pin
 
       hpsdr_u_tree_cc_misc = proto_item_add_subtree(cc_misc_item, ett_hpsdr_u_cc_misc);
 
-      C1 = tvb_get_guint8(tvb, offset);
-      proto_tree_add_item(hpsdr_u_tree_cc_misc, hf_hpsdr_u_cc_ep2_c1_14, tvb,offset, 1, ENC_BIG_ENDIAN);
-
-      proto_tree_add_boolean(hpsdr_u_tree_cc_misc, hf_hpsdr_u_cc_rx1_preamp,tvb,offset, 1, C1);
-      proto_tree_add_boolean(hpsdr_u_tree_cc_misc, hf_hpsdr_u_cc_rx2_preamp,tvb,offset, 1, C1);
-      proto_tree_add_boolean(hpsdr_u_tree_cc_misc, hf_hpsdr_u_cc_rx3_preamp,tvb,offset, 1, C1);
-      proto_tree_add_boolean(hpsdr_u_tree_cc_misc, hf_hpsdr_u_cc_rx4_preamp,tvb,offset, 1, C1);
-      proto_tree_add_boolean(hpsdr_u_tree_cc_misc, hf_hpsdr_u_cc_orion_mic_tr,tvb,offset, 1, C1);
-      proto_tree_add_boolean(hpsdr_u_tree_cc_misc, hf_hpsdr_u_cc_orion_mic_bias,tvb,offset, 1, C1);
-      proto_tree_add_boolean(hpsdr_u_tree_cc_misc, hf_hpsdr_u_cc_orion_mic_ptt,tvb,offset, 1, C1);
+      proto_tree_add_bitmask(hpsdr_u_tree_cc_misc, tvb, offset, hf_hpsdr_u_cc_ep2_c1_14, ett_hpsdr_u_cc_bits,
+                             cc_misc_c1_bits, ENC_BIG_ENDIAN);
       offset += 1;
 
       C2 = tvb_get_guint8(tvb, offset);
@@ -2556,14 +3650,8 @@ static int hpsdr_usb_ep2_frame(proto_tree *tree, tvbuff_t *tvb, packet_info *pin
 
       offset += 1;
 
-      C3 = tvb_get_guint8(tvb, offset);
-      proto_tree_add_item(hpsdr_u_tree_cc_misc, hf_hpsdr_u_cc_ep2_c3_14, tvb,offset, 1, ENC_BIG_ENDIAN);
-
-      proto_tree_add_boolean(hpsdr_u_tree_cc_misc, hf_hpsdr_u_cc_metis_p1,tvb,offset, 1, C3);
-      proto_tree_add_boolean(hpsdr_u_tree_cc_misc, hf_hpsdr_u_cc_metis_p2,tvb,offset, 1, C3);
-      proto_tree_add_boolean(hpsdr_u_tree_cc_misc, hf_hpsdr_u_cc_metis_p3,tvb,offset, 1, C3);
-      proto_tree_add_boolean(hpsdr_u_tree_cc_misc, hf_hpsdr_u_cc_metis_p4,tvb,offset, 1, C3);
-      proto_tree_add_boolean(hpsdr_u_tree_cc_misc, hf_hpsdr_u_cc_merc_tx_atten_c3,tvb,offset, 1, C3);
+      proto_tree_add_bitmask(hpsdr_u_tree_cc_misc, tvb, offset, hf_hpsdr_u_cc_ep2_c3_14, ett_hpsdr_u_cc_bits,
+                             cc_misc_c3_bits, ENC_BIG_ENDIAN);
       offset += 1;
 
       C4 = tvb_get_guint8(tvb, offset);
@@ -2622,11 +3710,8 @@ static int hpsdr_usb_ep2_frame(proto_tree *tree, tvbuff_t *tvb, packet_info *pin
       proto_tree_add_item(hpsdr_u_tree_cc_adc_cw, hf_hpsdr_u_cc_cw_keyer_mode, tvb,offset, 1, C3);
       offset += 1;
 
-      C4 = tvb_get_guint8(tvb, offset);
-      proto_tree_add_item(hpsdr_u_tree_cc_adc_cw, *cc_conf_c4, tvb,offset, 1, ENC_BIG_ENDIAN);
-
-      proto_tree_add_item(hpsdr_u_tree_cc_adc_cw, hf_hpsdr_u_cc_cw_keyer_weight, tvb,offset, 1, C4);
-      proto_tree_add_boolean(hpsdr_u_tree_cc_adc_cw, hf_hpsdr_u_cc_cw_keyer_spacing,tvb,offset, 1, C2);
+      proto_tree_add_bitmask(hpsdr_u_tree_cc_adc_cw, tvb, offset, *cc_conf_c4, ett_hpsdr_u_cc_bits,
+                             cc_adc_cw_c4_bits, ENC_BIG_ENDIAN);
       offset += 1;
 
    } else if ( C0_masked == 0x0C ) { // Additional Mercury 1
@@ -2651,14 +3736,15 @@ static int hpsdr_usb_ep2_frame(proto_tree *tree, tvbuff_t *tvb, packet_info *pin
       hpsdr_u_tree_cc_rx_adc = proto_item_add_subtree(cc_rx_adc_item, ett_hpsdr_u_cc_rx_adc);
 
       C1 = tvb_get_guint8(tvb, offset);
-      proto_tree_add_item(hpsdr_u_tree_cc_rx_adc, *cc_conf_c1, tvb,offset, 1, ENC_BIG_ENDIAN);
-
-      proto_tree_add_item(hpsdr_u_tree_cc_rx_adc, hf_hpsdr_u_cc_rx1_adc_assign, tvb,offset, 1, C1);
-      proto_tree_add_item(hpsdr_u_tree_cc_rx_adc, hf_hpsdr_u_cc_rx2_adc_assign, tvb,offset, 1, C1);
-      proto_tree_add_item(hpsdr_u_tree_cc_rx_adc, hf_hpsdr_u_cc_rx3_adc_assign, tvb,offset, 1, C1);
-      proto_tree_add_item(hpsdr_u_tree_cc_rx_adc, hf_hpsdr_u_cc_rx4_adc_assign, tvb,offset, 1, C1);
+      proto_tree_add_bitmask(hpsdr_u_tree_cc_rx_adc, tvb, offset, *cc_conf_c1, ett_hpsdr_u_cc_bits,
+                             cc_rx_adc_c1_bits, ENC_BIG_ENDIAN);
       offset += 1;
 
+      rx_adc[0] = ( C1 & HOST_C1_R1_AD );
+      rx_adc[1] = ( C1 & HOST_C1_R2_AD ) >> 2;
+      rx_adc[2] = ( C1 & HOST_C1_R3_AD ) >> 4;
+      rx_adc[3] = ( C1 & HOST_C1_R4_AD ) >> 6;
+
       C2 = tvb_get_guint8(tvb, offset);
       proto_tree_add_item(hpsdr_u_tree_cc_rx_adc, hf_hpsdr_u_cc_ep2_c2_1c, tvb,offset, 1, ENC_BIG_ENDIAN);
 
@@ -2669,6 +3755,10 @@ static int hpsdr_usb_ep2_frame(proto_tree *tree, tvbuff_t *tvb, packet_info *pin
       proto_tree_add_item(hpsdr_u_tree_cc_rx_adc, hf_hpsdr_u_cc_rx7_adc_assign, tvb,offset, 1, C2);
       offset += 1;
 
+      rx_adc[4] = ( C2 & HOST_C2_R5_AD );
+      rx_adc[5] = ( C2 & HOST_C2_R6_AD ) >> 2;
+      rx_adc[6] = ( C2 & HOST_C2_R7_AD ) >> 4;
+
       append_text_item = proto_tree_add_item(hpsdr_u_tree_cc_rx_adc, hf_hpsdr_u_cc_adc_input_atten_tx, tvb,offset, 1, ENC_BIG_ENDIAN);
       proto_item_append_text(append_text_item," dB");
 
@@ -2770,32 +3860,14 @@ static int hpsdr_usb_ep2_frame(proto_tree *tree, tvbuff_t *tvb, packet_info *pin
                                                      C0_masked, C0_masked);
          hpsdr_u_tree_cc_a2_feg = proto_item_add_subtree(cc_a2_feg_item, ett_hpsdr_u_cc_a2_feg);
 
-         C1 = tvb_get_guint8(tvb, offset);
-         append_text_item = proto_tree_add_item(hpsdr_u_tree_cc_a2_feg, *cc_conf_c1, tvb,offset, 1, ENC_BIG_ENDIAN);
+         append_text_item = proto_tree_add_bitmask(hpsdr_u_tree_cc_a2_feg, tvb, offset, *cc_conf_c1, ett_hpsdr_u_cc_bits,
+                                                   cc_a2_c1_bits, ENC_BIG_ENDIAN);
          proto_item_append_text(append_text_item," - 2nd Alex");
-
-         proto_tree_add_boolean(hpsdr_u_tree_cc_a2_feg, hf_hpsdr_u_cc_a2_c1_0, tvb,offset, 1, C1);
-         proto_tree_add_boolean(hpsdr_u_tree_cc_a2_feg, hf_hpsdr_u_cc_a2_c1_1, tvb,offset, 1, C1);
-         proto_tree_add_boolean(hpsdr_u_tree_cc_a2_feg, hf_hpsdr_u_cc_a2_c1_2, tvb,offset, 1, C1);
-         proto_tree_add_boolean(hpsdr_u_tree_cc_a2_feg, hf_hpsdr_u_cc_a2_c1_3, tvb,offset, 1, C1);
-         proto_tree_add_boolean(hpsdr_u_tree_cc_a2_feg, hf_hpsdr_u_cc_a2_c1_4, tvb,offset, 1, C1);
-         proto_tree_add_boolean(hpsdr_u_tree_cc_a2_feg, hf_hpsdr_u_cc_a2_c1_5, tvb,offset, 1, C1);
-         proto_tree_add_boolean(hpsdr_u_tree_cc_a2_feg, hf_hpsdr_u_cc_a2_c1_6, tvb,offset, 1, C1);
-         proto_tree_add_boolean(hpsdr_u_tree_cc_a2_feg, hf_hpsdr_u_cc_a2_c1_7, tvb,offset, 1, C1);
          offset += 1;
 
-         C2 = tvb_get_guint8(tvb, offset);
-         append_text_item = proto_tree_add_item(hpsdr_u_tree_cc_a2_feg, *cc_conf_c2, tvb,offset, 1, ENC_BIG_ENDIAN);
+         append_text_item = proto_tree_add_bitmask(hpsdr_u_tree_cc_a2_feg, tvb, offset, *cc_conf_c2, ett_hpsdr_u_cc_bits,
+                                                   cc_a2_c2_bits, ENC_BIG_ENDIAN);
          proto_item_append_text(append_text_item," - 2nd Alex");
-
-         proto_tree_add_boolean(hpsdr_u_tree_cc_a2_feg, hf_hpsdr_u_cc_a2_c2_0, tvb,offset, 1, C1);
-         proto_tree_add_boolean(hpsdr_u_tree_cc_a2_feg, hf_hpsdr_u_cc_a2_c2_1, tvb,offset, 1, C1);
-         proto_tree_add_boolean(hpsdr_u_tree_cc_a2_feg, hf_hpsdr_u_cc_a2_c2_2, tvb,offset, 1, C1);
-         proto_tree_add_boolean(hpsdr_u_tree_cc_a2_feg, hf_hpsdr_u_cc_a2_c2_3, tvb,offset, 1, C1);
-         proto_tree_add_boolean(hpsdr_u_tree_cc_a2_feg, hf_hpsdr_u_cc_a2_c2_4, tvb,offset, 1, C1);
-         proto_tree_add_boolean(hpsdr_u_tree_cc_a2_feg, hf_hpsdr_u_cc_a2_c2_5, tvb,offset, 1, C1);
-         proto_tree_add_boolean(hpsdr_u_tree_cc_a2_feg, hf_hpsdr_u_cc_a2_c2_6, tvb,offset, 1, C1);
-         proto_tree_add_boolean(hpsdr_u_tree_cc_a2_feg, hf_hpsdr_u_cc_a2_c2_7, tvb,offset, 1, C1);
          offset += 1;
 
          proto_tree_add_item(hpsdr_u_tree_cc_a2_feg, *cc_conf_c3_c4, tvb,offset, 2, ENC_BIG_ENDIAN);
@@ -2938,6 +4010,23 @@ static int hpsdr_usb_ep2_frame(proto_tree *tree, tvbuff_t *tvb, packet_info *pin
                                               ENC_BIG_ENDIAN, "Left Right Audio Samples and IQ Samples (504 Bytes)");
    hpsdr_u_tree_ep2_data = proto_item_add_subtree(ep2_data_item, *ett_ep2_data);
 
+   if ( captured_bytes(tvb, offset, 504) < 504 ) {
+      not_captured_item(hpsdr_u_tree_ep2_data, tvb, pinfo, offset, 504, "EP2 samples");
+      return offset + 504;
+   }
+
+   tap_frame->data = tvb_get_ptr(tvb, offset, 504);
+
+   // Summary first. The five items per sample (630 per datagram) are only
+   // added when the preference is on, the subtree was expanded or a filter,
+   // column or IO graph uses a per sample field.
+   if ( tree == NULL ) { return offset + 504; }
+
+   ep2_sample_summary(hpsdr_u_tree_ep2_data, ep2_data_item, tvb, offset, tap_frame->data);
+
+   if ( !hpsdr_u_pref_ep2_samples && !tree_expanded(*ett_ep2_data) && !ep2_samples_referenced() ) {
+      return offset + 504;
+   }
 
    for (x = 0; x <= 62; x++) {
       proto_tree_add_uint_format(hpsdr_u_tree_ep2_data,hf_hpsdr_u_ep2_idx, tvb, offset, 0,x,"Index: %d",x);
@@ -2964,7 +4053,9 @@ static int hpsdr_usb_ep2_frame(proto_tree *tree, tvbuff_t *tvb, packet_info *pin
 
 }
 
-static int hpsdr_usb_ep6_frame(proto_tree *tree, tvbuff_t *tvb, int offset, int frame_num) {
+static int hpsdr_usb_ep6_frame(proto_tree *tree, tvbuff_t *tvb, packet_info *pinfo, int offset, int frame_num,
+                               int ep6_rx_num, const guint8 *ep6_rx_adc, guint8 ep6_board_id,
+                               hpsdr_u_tap_frame_t *tap_frame) {
 
    //Submenu Items
    proto_item *c0_item = NULL;
@@ -3017,13 +4108,17 @@ static int hpsdr_usb_ep6_frame(proto_tree *tree, tvbuff_t *tvb, int offset, int
 
    int samp_num = -1;
    int pad = -1;
-   int adc_cal_offset = -1;
+
+   const hpsdr_u_cal_t *cal = NULL;
+
+   const hpsdr_u_ep6_layout_t *layout = NULL;
+   gint32 iq_i[HPSDR_U_IQ_FRAME_MAX];
+   gint32 iq_q[HPSDR_U_IQ_FRAME_MAX];
+   int iq_x = -1;
 
    double power_f = -1;
    double result = -1;
 
-   float bridge_volt = -1;
-   float refvoltage = -1;
    float volts = -1;
    float watts = -1;
 
@@ -3072,10 +4167,20 @@ static int hpsdr_usb_ep6_frame(proto_tree *tree, tvbuff_t *tvb, int offset, int
       break;
    }
 
+   if ( captured_bytes(tvb, offset, 8) < 8 ) {
+      not_captured_item(tree, tvb, pinfo, offset, 512, "EP6 USB frame");
+      return offset + 512;
+   }
 
    proto_tree_add_item(tree, *sync, tvb,offset, 3, ENC_BIG_ENDIAN);
    offset += 3;
 
+   // Raw C&C bytes for the taps
+   for (x = 0; x <= 4; x++) {
+      tap_frame->cc[x] = tvb_get_guint8(tvb, offset + x);
+   }
+   tap_frame->have_cc = TRUE;
+
    C0 = tvb_get_guint8(tvb, offset);
    c0_item = proto_tree_add_uint_format(tree, *c0_sub, tvb, offset, 1,
                                         C0, "C&C Byte 0  : 0x%02X",C0 );
@@ -3136,6 +4241,8 @@ static int hpsdr_usb_ep6_frame(proto_tree *tree, tvbuff_t *tvb, int offset, int
    }
 
 
+   tap_frame->c0_type = C0_masked;
+
    // The "C0 Types" are 5 bit numbers.
    // Before version 0.4.0 they were in-correctly treated as 8 bit numbers.
    // 0 0x00 SDR Info
@@ -3248,15 +4355,11 @@ static int hpsdr_usb_ep6_frame(proto_tree *tree, tvbuff_t *tvb, int offset, int
       proto_tree_add_item(hpsdr_u_tree_cc_fp, hf_hpsdr_u_cc_fwdpw_ant_pre,tvb,offset, 2,ENC_BIG_ENDIAN);
 
       raw_bytes = tvb_get_guint16(tvb, offset, ENC_BIG_ENDIAN);
-      volts = 0;
-      watts = 0;
-      // Math from OpenHPSDR PowerSDR - console.cs
-      // Bill Tracey (KD5TFD) - Doug Wigley (W5WC) - Warren Pratt (NR0V)
-      bridge_volt = 0.09f;
-      refvoltage = 3.3f;
 
-      volts = (float)( raw_bytes / 4095.0f * refvoltage );
-      if (volts != 0 ) { watts = (float)( pow(volts,2) / bridge_volt ); }
+      // Calibration of the board, the telemetry tap uses the same - cal_openhpsdr_u.c
+      cal = hpsdr_u_cal(ep6_board_id);
+      volts = (float)hpsdr_u_cal_power_volts(cal, raw_bytes);
+      watts = (float)hpsdr_u_cal_power_watts(cal, raw_bytes);
 
       proto_tree_add_uint_format(hpsdr_u_tree_cc_fp, hf_hpsdr_u_cc_fwdpw_ant_pre,tvb,offset, 2, watts,
                                  "SDR TX Power From Anntena Preselector       - ADC: %d  Volts: %f  Watts: %f",raw_bytes,volts,watts);
@@ -3270,16 +4373,11 @@ static int hpsdr_usb_ep6_frame(proto_tree *tree, tvbuff_t *tvb, int offset, int
       hpsdr_u_tree_cc_rp = proto_item_add_subtree(cc_rp_item, ett_hpsdr_u_cc_rp);
 
       raw_bytes = tvb_get_guint16(tvb, offset, ENC_BIG_ENDIAN);
-      volts = 0;
-      watts = 0;
-      // Math from OpenHPSDR PowerSDR - console.cs
-      // Bill Tracey (KD5TFD) - Doug Wigley (W5WC) - Warren Pratt (NR0V)
-      bridge_volt = 0.09f;
-      refvoltage = 3.3f;
-      adc_cal_offset = 10;
-      if (raw_bytes < adc_cal_offset) { raw_bytes = adc_cal_offset = 0; }
-      volts = (float)(( raw_bytes - adc_cal_offset ) / 4095.0 * refvoltage );
-      if (volts != 0 ) { watts = (float)pow(volts,2) / bridge_volt; }
+
+      // Calibration of the board, the telemetry tap uses the same - cal_openhpsdr_u.c
+      cal = hpsdr_u_cal(ep6_board_id);
+      volts = (float)hpsdr_u_cal_power_volts(cal, raw_bytes);
+      watts = (float)hpsdr_u_cal_power_watts(cal, raw_bytes);
 
       proto_tree_add_uint_format(hpsdr_u_tree_cc_rp, hf_hpsdr_u_cc_revpwd_rev,tvb,offset, 2, watts,
                                  "SDR Reverse Power From Anntena Preselector - ADC: %d  Volts: %f  Watts: %f",raw_bytes,volts,watts);
@@ -3305,12 +4403,12 @@ static int hpsdr_usb_ep6_frame(proto_tree *tree, tvbuff_t *tvb, int offset, int
 
       raw_bytes = tvb_get_guint16(tvb, offset, ENC_BIG_ENDIAN);
 
-      // Math from OpenHPSDR PowerSDR - console.cs
-      // Bill Tracey (KD5TFD) - Doug Wigley (W5WC) - Warren Pratt (NR0V)
-      volts = ( ((float)raw_bytes / 4095 ) * 3.3f ) * (( 4.7f + 0.82f ) / 0.82f );
+      // Calibration of the board, the telemetry tap uses the same - cal_openhpsdr_u.c
+      cal = hpsdr_u_cal(ep6_board_id);
+      volts = (float)hpsdr_u_cal_supply_volts(cal, raw_bytes);
 
       append_text_item = proto_tree_add_uint_format(hpsdr_u_tree_cc_ps, hf_hpsdr_u_cc_pwsupp_vol,tvb,offset, 2, volts,
-                                                    "SDR (Hermes) Power Supply Value: %f",volts);
+                                                    "SDR (%s) Power Supply Value: %f",cal->name,volts);
       proto_item_append_text(append_text_item," Volts - Calculated, not on wire value.");
 
       offset += 2;
@@ -3356,24 +4454,47 @@ static int hpsdr_usb_ep6_frame(proto_tree *tree, tvbuff_t *tvb, int offset, int
 
    }
 
+   // C0 Type 0x00 C1 is the ADC1 overflow. C0 Type 0x04 C1 to C4 are the ADC1 to ADC4 overflows.
+   if ( C0_masked == 0x00 ) {
+      tap_frame->overflow = ( C1 & SDR_C1_OVER );
+   } else if ( C0_masked == 0x04 ) {
+      tap_frame->overflow = ( C1 & SDR_OVER_MASK ) | (( C2 & SDR_OVER_MASK ) << 1 ) |
+                            (( C3 & SDR_OVER_MASK ) << 2 ) | (( C4 & SDR_OVER_MASK ) << 3 );
+   }
+
+   if ( tap_frame->overflow != 0 ) {
+      ep6_overflow_items(tree, tvb, offset - 4, tap_frame->overflow, ep6_rx_num, ep6_rx_adc);
+   }
+
+   // The telemetry and overflows above are decoded without the samples.
+   if ( captured_bytes(tvb, offset, 504) < 504 ) {
+      not_captured_item(tree, tvb, pinfo, offset, 504, "EP6 IQ samples");
+      return offset + 504;
+   }
+
+   tap_frame->data = tvb_get_ptr(tvb, offset, 504);
+
+   // The taps use the samples in tap_frame, the per sample items are only for the tree.
+   if ( tree == NULL ) { return offset + 504; }
+
    // 0
    // 1
    // more then 1
-   if ( rx_num == 0 ) {
+   if ( ep6_rx_num == 0 ) {
       append_text_item = proto_tree_add_item(tree, *ep6_data, tvb,offset, 504,
                                              ENC_BIG_ENDIAN);
       proto_item_append_text(append_text_item,": IQ Samples and Mic/Line Samples (504 Bytes)");
 
       offset += 504;
 
-   } else if (rx_num == 1) {
+   } else if (ep6_rx_num == 1) {
 
       ep6_data_item = proto_tree_add_uint_format(tree, *ep6_data_sub, tvb, offset, 504,ENC_BIG_ENDIAN,
                                                  "IQ Samples and Mic/Line Samples (504 Bytes)");
       hpsdr_u_tree_ep6_data = proto_item_add_subtree(ep6_data_item, *ett_ep6_data);
 
-      proto_tree_add_uint_format(hpsdr_u_tree_ep6_data,*num_of_rx,tvb,offset, 0, rx_num,
-                                 "Number of Receivers: %d",rx_num);
+      proto_tree_add_uint_format(hpsdr_u_tree_ep6_data,*num_of_rx,tvb,offset, 0, ep6_rx_num,
+                                 "Number of Receivers: %d",ep6_rx_num);
 
       for (x = 1; x <= 63; x++) {
          proto_tree_add_uint_format(hpsdr_u_tree_ep6_data,hf_hpsdr_u_ep6_idx, tvb, offset, 0,x,"Index: %d",x);
@@ -3392,30 +4513,39 @@ static int hpsdr_usb_ep6_frame(proto_tree *tree, tvbuff_t *tvb, int offset, int
 
       }
 
-   } else if (rx_num > 1) {
+   } else if (ep6_rx_num > 1) {
 
-      samp_num = ( 504 / (( rx_num * 6 ) + 2 ) );
-      pad = ( 504 % (( rx_num * 6 ) + 2 ) );
+      // Layouts are worked out at compile time - iq_openhpsdr_u.c
+      layout = hpsdr_u_ep6_layout(ep6_rx_num);
+      samp_num = layout->samp_num;
+      pad = layout->pad;
 
       ep6_data_item = proto_tree_add_uint_format(tree, *ep6_data_sub, tvb, offset, 504,ENC_BIG_ENDIAN,
                                                  "IQ Samples and Mic/Line Samples (504 Bytes)");
       hpsdr_u_tree_ep6_data = proto_item_add_subtree(ep6_data_item, *ett_ep6_data);
 
 
-      proto_tree_add_uint_format(hpsdr_u_tree_ep6_data,*num_of_rx,tvb,offset, 0, rx_num,
-                                 "Number of Receivers: %d - Number of Samples: %d - Pad Bytes: %d",rx_num,samp_num,pad);
+      proto_tree_add_uint_format(hpsdr_u_tree_ep6_data,*num_of_rx,tvb,offset, 0, ep6_rx_num,
+                                 "Number of Receivers: %d - Number of Samples: %d - Pad Bytes: %d",ep6_rx_num,samp_num,pad);
+
+      // The USB frame is unpacked once by the function made for the number of
+      // receivers (iq_openhpsdr_u.c), the items are added from the samples.
+      hpsdr_u_iq_unpack(tap_frame->data, ep6_rx_num, iq_i, iq_q);
 
       for (x = 1; x <= samp_num; x++) {
          proto_tree_add_uint_format(hpsdr_u_tree_ep6_data,hf_hpsdr_u_ep6_idx, tvb, offset, 0,x,"Index: %d",x);
 
-         for ( z = 1; z <= rx_num; z++) {
+         for ( z = 1; z <= ep6_rx_num; z++) {
             proto_tree_add_uint_format(hpsdr_u_tree_ep6_data,hf_hpsdr_u_ep6_rx_idx, tvb, offset, 0,z,"RX: %d",z);
 
-            I = tvb_get_guint24(tvb, offset,3);
+            // Receiver z - 1 is at [( z - 1 ) * samp_num], the fields are the 24 bits on the wire.
+            iq_x = (( z - 1 ) * samp_num ) + ( x - 1 );
+
+            I = (guint32)iq_i[iq_x] & 0xFFFFFF;
             proto_tree_add_uint(hpsdr_u_tree_ep6_data, hf_hpsdr_u_ep6_i, tvb,offset, 3, I);
             offset += 3;
 
-            Q = tvb_get_guint24(tvb, offset,3);
+            Q = (guint32)iq_q[iq_x] & 0xFFFFFF;
             proto_tree_add_uint(hpsdr_u_tree_ep6_data, hf_hpsdr_u_ep6_q, tvb,offset, 3, Q);
             offset += 3;
          }
@@ -3446,74 +4576,144 @@ static void dissect_hpsdr_u(tvbuff_t *tvb, packet_info *pinfo, proto_tree *tree)
 {
    gint offset = 0;
 
-   col_set_str(pinfo->cinfo, COL_PROTOCOL, "HPSDR-USB");
-   /* Clear out stuff in the info column */
-   col_clear(pinfo->cinfo,COL_INFO);
+   proto_item *ti = NULL;
+   proto_item *f1_item = NULL;
+   proto_item *f2_item = NULL;
 
+   proto_tree *hpsdr_u_tree = NULL;
+   proto_tree *hpsdr_u_tree_f1 = NULL;
+   proto_tree *hpsdr_u_tree_f2 = NULL;
 
-   if (tree) {
-      proto_item *ti = NULL;
-      proto_item *f1_item = NULL;
-      proto_item *f2_item = NULL;
+   //proto_item *append_text_item = NULL;
 
-      proto_tree *hpsdr_u_tree = NULL;
-      proto_tree *hpsdr_u_tree_f1 = NULL;
-      proto_tree *hpsdr_u_tree_f2 = NULL;
+   static guint8 status;
+   static guint8 usb_end_point;
 
-      //proto_item *append_text_item = NULL;
+   static guint8 value = -1;
+   static guint8 flags;
+   static guint8 f1 = 1;
+   static guint8 f2 = 2;
 
-      static guint8 status;
-      static guint8 usb_end_point;
+   int x = 0;
 
-      static guint8 value = -1;
-      static guint8 flags;
-      static guint8 f1 = 1;
-      static guint8 f2 = 2;
+   const char *placehold = NULL;
+
+   hpsdr_u_tap_info_t *tap_info = NULL;
+   hpsdr_u_packet_data_t *packet_data = NULL;
+   hpsdr_u_ep2_data_t *ep2_data = NULL;
+   proto_item *sample_item = NULL;
 
-      int x = 0;
+   const guint8 *discovery_ether_address;
+   discovery_ether_address = tvb_get_ptr(tvb, 3, 6);  // Has to be defined before using.
 
-      const char *placehold = NULL;
+   col_set_str(pinfo->cinfo, COL_PROTOCOL, "HPSDR-USB");
+   /* Clear out stuff in the info column */
+   col_clear(pinfo->cinfo,COL_INFO);
 
-      const guint8 *discovery_ether_address;
-      discovery_ether_address = tvb_get_ptr(tvb, 3, 6);  // Has to be defined before using.
+   // The disassembly is not limited to when there is a tree. The state
+   // (number of receivers, speed) and the taps are needed on the first pass.
+   tap_info = wmem_new0(wmem_packet_scope(), hpsdr_u_tap_info_t);
 
-      ti = proto_tree_add_item(tree, proto_hpsdr_u, tvb, 0, -1, ENC_NA);
-      hpsdr_u_tree = proto_item_add_subtree(ti, ett_hpsdr_u);
-      proto_tree_add_item(hpsdr_u_tree, hf_hpsdr_u_id, tvb,offset, 2, ENC_BIG_ENDIAN);
-      offset += 2;
-      proto_tree_add_item(hpsdr_u_tree, hf_hpsdr_u_status, tvb,offset, 1, ENC_BIG_ENDIAN);
+   ti = proto_tree_add_item(tree, proto_hpsdr_u, tvb, 0, -1, ENC_NA);
+   hpsdr_u_tree = proto_item_add_subtree(ti, ett_hpsdr_u);
+   proto_tree_add_item(hpsdr_u_tree, hf_hpsdr_u_id, tvb,offset, 2, ENC_BIG_ENDIAN);
+   offset += 2;
+   proto_tree_add_item(hpsdr_u_tree, hf_hpsdr_u_status, tvb,offset, 1, ENC_BIG_ENDIAN);
 
-      status = tvb_get_guint8(tvb, offset);
+   status = tvb_get_guint8(tvb, offset);
+   offset += 1;
+
+   if ( status == 1 ) {   // Data TX
+      proto_tree_add_item(hpsdr_u_tree, hf_hpsdr_u_end_point, tvb,offset, 1, ENC_BIG_ENDIAN);
+      usb_end_point = tvb_get_guint8(tvb, offset);
       offset += 1;
+      proto_tree_add_item(hpsdr_u_tree, hf_hpsdr_u_seq, tvb,offset, 4, ENC_BIG_ENDIAN);
+
+      tap_info->end_point = usb_end_point;
+      tap_info->seq = tvb_get_ntohl(tvb, offset);
+      tap_info->rx_num = rx_num;
+      tap_info->speed_num = speed_num;
+      tap_info->board_id = board_id;
+      memcpy(tap_info->rx_adc, rx_adc, sizeof(rx_adc));
+      offset += 4;
 
-      if ( status == 1 ) {   // Data TX
-         proto_tree_add_item(hpsdr_u_tree, hf_hpsdr_u_end_point, tvb,offset, 1, ENC_BIG_ENDIAN);
-         usb_end_point = tvb_get_guint8(tvb, offset);
-         offset += 1;
-         proto_tree_add_item(hpsdr_u_tree, hf_hpsdr_u_seq, tvb,offset, 4, ENC_BIG_ENDIAN);
-         offset += 4;
+      if ( usb_end_point == 6) {   // HPSDR USB Frames to HOST
+
+         ep6_rx_num_infer(pinfo, tvb, offset);
+
+         // Decoded with the state of the datagram, not the state at the end of the first pass.
+         packet_data = ep6_packet_data(pinfo, tap_info->seq);
+         if ( packet_data != NULL ) {
+            tap_info->rx_num = packet_data->rx_num;
+            tap_info->board_id = packet_data->board_id;
+            tap_info->speed_num = packet_data->speed_num;
+            memcpy(tap_info->rx_adc, packet_data->rx_adc, sizeof(packet_data->rx_adc));
+         }
+         if ( packet_data != NULL && packet_data->backfill ) {
+            sample_item = proto_tree_add_boolean(hpsdr_u_tree, hf_hpsdr_u_rx_num_backfill, tvb, offset, 0,
+                                                 packet_data->backfill);
+            proto_item_set_generated(sample_item);
+         }
+         if ( packet_data != NULL && packet_data->rx_num_inferred > 0 ) {
+            sample_item = proto_tree_add_uint(hpsdr_u_tree, hf_hpsdr_u_rx_num_inferred, tvb, offset, 0,
+                                              packet_data->rx_num_inferred);
+            proto_item_set_generated(sample_item);
+            expert_add_info(pinfo, sample_item, &ei_rx_num_inferred);
+         }
+         if ( packet_data != NULL && packet_data->have_sample ) {
+            sample_item = proto_tree_add_uint64(hpsdr_u_tree, hf_hpsdr_u_sample_first, tvb, offset, 0,
+                                                packet_data->first_sample);
+            proto_item_set_generated(sample_item);
+            sample_item = proto_tree_add_uint(hpsdr_u_tree, hf_hpsdr_u_sample_count, tvb, offset, 0,
+                                              packet_data->samples);
+            proto_item_set_generated(sample_item);
+
+            tap_info->have_sample = TRUE;
+            tap_info->first_sample = packet_data->first_sample;
+            tap_info->sample_index = packet_data->sample_index;
+         }
+         if ( packet_data != NULL && packet_data->gap > 0 ) {
+            sample_item = proto_tree_add_uint(hpsdr_u_tree, hf_hpsdr_u_sample_gap, tvb, offset, 0,
+                                              packet_data->gap);
+            proto_item_set_generated(sample_item);
+         }
 
-         if ( usb_end_point == 6) {   // HPSDR USB Frames to HOST
+         // EP 6 Frame 1
+         f1_item = proto_tree_add_uint_format(hpsdr_u_tree, hf_hpsdr_u_ep_f1, tvb, offset, 512, f1,
+                                              "HPSDR USB EP6 Frame 1 (512 Bytes)");
+         hpsdr_u_tree_f1 = proto_item_add_subtree(f1_item, ett_hpsdr_u_f1);
 
-            // EP 6 Frame 1
-            f1_item = proto_tree_add_uint_format(hpsdr_u_tree, hf_hpsdr_u_ep_f1, tvb, offset, 512, f1,
-                                                 "HPSDR USB EP6 Frame 1 (512 Bytes)");
-            hpsdr_u_tree_f1 = proto_item_add_subtree(f1_item, ett_hpsdr_u_f1);
+         offset = hpsdr_usb_ep6_frame(hpsdr_u_tree_f1, tvb, pinfo, offset,1, tap_info->rx_num, tap_info->rx_adc,
+                                      tap_info->board_id, &tap_info->frame[0]);
 
-            offset = hpsdr_usb_ep6_frame(hpsdr_u_tree_f1, tvb, offset,1);
+         // EP 6 Frame 2
+         f2_item = proto_tree_add_uint_format(hpsdr_u_tree, hf_hpsdr_u_ep_f2, tvb, offset, 512, f2,
+                                              "HPSDR USB EP6 Frame 2 (512 Bytes)");
+         hpsdr_u_tree_f2 = proto_item_add_subtree(f2_item, ett_hpsdr_u_f1);
 
-            // EP 6 Frame 2
-            f2_item = proto_tree_add_uint_format(hpsdr_u_tree, hf_hpsdr_u_ep_f2, tvb, offset, 512, f2,
-                                                 "HPSDR USB EP6 Frame 2 (512 Bytes)");
-            hpsdr_u_tree_f2 = proto_item_add_subtree(f2_item, ett_hpsdr_u_f1);
+         offset = hpsdr_usb_ep6_frame(hpsdr_u_tree_f2, tvb, pinfo, offset,2, tap_info->rx_num, tap_info->rx_adc,
+                                      tap_info->board_id, &tap_info->frame[1]);
 
-            offset = hpsdr_usb_ep6_frame(hpsdr_u_tree_f2, tvb, offset,2);
+         // Only worked out when the fields are referenced, other dissection does not pay for it.
+         if ( ep6_rx_signal_referenced(tree) ) {
+            ep6_rx_signal(hpsdr_u_tree, tvb, offset - 1024, tap_info);
+         }
+
+      } else if ( usb_end_point == 4) {   // Raw ADC Samples From SDR to Host
 
-         } else if ( usb_end_point == 4) {   // Raw ADC Samples From SDR to Host
+         // The wide band buffer spans many EP4 datagrams.
+         ep4_reassemble(hpsdr_u_tree, tvb, pinfo, offset, tap_info->seq, tap_info);
 
-            proto_tree_add_uint_format(hpsdr_u_tree,hf_hpsdr_u_ep_f1, tvb,offset, 1024, f1,
-                                       "Assuming 512 by 16 bit samples.");
+         proto_tree_add_uint_format(hpsdr_u_tree,hf_hpsdr_u_ep_f1, tvb,offset, 1024, f1,
+                                    "512 by 16 bit samples.");
 
+         // Not reassembled when not captured, see ep4_reassemble().
+         if ( captured_bytes(tvb, offset, 1024) < 1024 ) {
+            not_captured_item(hpsdr_u_tree, tvb, pinfo, offset, 1024, "EP4 samples");
+            offset += 1024;
+         } else if ( tree == NULL ) {
+            offset += 1024;
+         } else {
             for ( x = 0; x <= 511; x++) {
                proto_tree_add_string_format(hpsdr_u_tree, hf_hpsdr_u_ep4_separator, tvb, offset, 0, placehold,
                                             "-------------------------");
@@ -3525,87 +4725,103 @@ static void dissect_hpsdr_u(tvbuff_t *tvb, packet_info *pinfo, proto_tree *tree)
                offset += 2;
 
             }
+         }
+
 
+      } else if ( usb_end_point == 2) {   // Host to SDR - HPSDR USB Frames
 
-         } else if ( usb_end_point == 2) {   // Host to SDR - HPSDR USB Frames
+         // EP 2 Frame 1
+         f1_item = proto_tree_add_uint_format(hpsdr_u_tree, hf_hpsdr_u_ep_f1, tvb, offset, 512, f1,
+                                              "HPSDR USB EP2 Frame 1 (512 Bytes)");
+         hpsdr_u_tree_f1 = proto_item_add_subtree(f1_item, ett_hpsdr_u_f1);
 
-            // EP 2 Frame 1
-            f1_item = proto_tree_add_uint_format(hpsdr_u_tree, hf_hpsdr_u_ep_f1, tvb, offset, 512, f1,
-                                                 "HPSDR USB EP2 Frame 1 (512 Bytes)");
-            hpsdr_u_tree_f1 = proto_item_add_subtree(f1_item, ett_hpsdr_u_f1);
+         offset = hpsdr_usb_ep2_frame(hpsdr_u_tree_f1, tvb, pinfo, offset,1, &tap_info->frame[0]);
 
-            offset = hpsdr_usb_ep2_frame(hpsdr_u_tree_f1, tvb, pinfo, offset,1);
+         // EP 2 Frame 2
+         f2_item = proto_tree_add_uint_format(hpsdr_u_tree, hf_hpsdr_u_ep_f2, tvb, offset, 512, f2,
+                                              "HPSDR USB EP2 Frame 2 (512 Bytes)");
+         hpsdr_u_tree_f2 = proto_item_add_subtree(f2_item, ett_hpsdr_u_f1);
 
-            // EP 2 Frame 2
-            f2_item = proto_tree_add_uint_format(hpsdr_u_tree, hf_hpsdr_u_ep_f2, tvb, offset, 512, f2,
-                                                 "HPSDR USB EP2 Frame 2 (512 Bytes)");
-            hpsdr_u_tree_f2 = proto_item_add_subtree(f2_item, ett_hpsdr_u_f1);
+         offset = hpsdr_usb_ep2_frame(hpsdr_u_tree_f2, tvb, pinfo, offset,2, &tap_info->frame[1]);
 
-            offset = hpsdr_usb_ep2_frame(hpsdr_u_tree_f2, tvb, pinfo, offset,2);
+         // Decoded with the runs of the first pass.
+         ep2_data = ep2_packet_data(pinfo, tap_info);
+         if ( ep2_data != NULL ) {
+            ep2_starved_items(hpsdr_u_tree, tvb, pinfo, offset - 1024, ep2_data);
+
+            tap_info->ep2_zero = ep2_data->zero;
+            tap_info->ep2_starved = ep2_data->starved;
+            tap_info->ep2_starved_runs = ep2_data->runs;
+            tap_info->ep2_starved_longest = ep2_data->longest;
+            tap_info->ep2_run_start = ep2_data->run_start;
          }
+      }
 
-      } else if ( status == 2 ) {  // Discovery
+      if ( have_tap_listener(hpsdr_u_tap) ) {
+         tap_queue_packet(hpsdr_u_tap, pinfo, tap_info);
+      }
 
-         if (pinfo->destport == HPSDR_U_PORT) {
+   } else if ( status == 2 ) {  // Discovery
 
-            proto_tree_add_string_format(hpsdr_u_tree, hf_hpsdr_u_host_discover, tvb, offset, 0, placehold,
-                                         "Host Discovery Query");
+      if (pinfo->destport == HPSDR_U_PORT) {
 
-            offset = packet_end_pad(tvb,hpsdr_u_tree,offset,60);
+         proto_tree_add_string_format(hpsdr_u_tree, hf_hpsdr_u_host_discover, tvb, offset, 0, placehold,
+                                      "Host Discovery Query");
 
-         } else if (pinfo->srcport == HPSDR_U_PORT) {
+         offset = packet_end_pad(tvb,hpsdr_u_tree,offset,60);
 
-            proto_tree_add_string_format(hpsdr_u_tree, hf_hpsdr_u_host_discover, tvb, offset, 1, placehold,
-                                         "Hardware Discovery Reply");
+      } else if (pinfo->srcport == HPSDR_U_PORT) {
 
-            proto_tree_add_ether(hpsdr_u_tree, hf_hpsdr_u_eth, tvb,offset, 6, discovery_ether_address);
-            offset += 6;
+         proto_tree_add_string_format(hpsdr_u_tree, hf_hpsdr_u_host_discover, tvb, offset, 1, placehold,
+                                      "Hardware Discovery Reply");
 
-            value = tvb_get_guint8(tvb, offset);
-            proto_tree_add_uint_format(hpsdr_u_tree,hf_hpsdr_u_ver,tvb,offset,1,value,
-                                       "SDR Code Version: %d.%.1d",( value / 10 ),( value % 10 ));
-            offset += 1;
+         proto_tree_add_ether(hpsdr_u_tree, hf_hpsdr_u_eth, tvb,offset, 6, discovery_ether_address);
+         offset += 6;
 
-            proto_tree_add_item(hpsdr_u_tree, hf_hpsdr_u_bid, tvb,offset, 1, ENC_BIG_ENDIAN);
-            board_id = tvb_get_guint8(tvb, offset);
-            offset += 1;
-//hl 1?
-            if ( board_id == 0x06) {    // Hermes_Lite
-               proto_tree_add_item(hpsdr_u_tree, hf_hpsdr_u_hlite_ver, tvb,offset, 9, ENC_BIG_ENDIAN);
-               offset += 9;
+         value = tvb_get_guint8(tvb, offset);
+         proto_tree_add_uint_format(hpsdr_u_tree,hf_hpsdr_u_ver,tvb,offset,1,value,
+                                    "SDR Code Version: %d.%.1d",( value / 10 ),( value % 10 ));
+         offset += 1;
 
-               offset = packet_end_pad(tvb,hpsdr_u_tree,offset,40);
-            }
+         proto_tree_add_item(hpsdr_u_tree, hf_hpsdr_u_bid, tvb,offset, 1, ENC_BIG_ENDIAN);
+         board_id = tvb_get_guint8(tvb, offset);
+         offset += 1;
+//hl 1?
+         if ( board_id == 0x06) {    // Hermes_Lite
+            proto_tree_add_item(hpsdr_u_tree, hf_hpsdr_u_hlite_ver, tvb,offset, 9, ENC_BIG_ENDIAN);
+            offset += 9;
 
-            else {
-               offset = packet_end_pad(tvb,hpsdr_u_tree,offset,49);
-            }
+            offset = packet_end_pad(tvb,hpsdr_u_tree,offset,40);
+         }
 
+         else {
+            offset = packet_end_pad(tvb,hpsdr_u_tree,offset,49);
          }
 
+      }
 
-      } else if ( status == 3 ) {  // not included:  Set IP - Program
-         proto_tree_add_ether(hpsdr_u_tree, hf_hpsdr_u_setip_mac, tvb,offset, 6, discovery_ether_address);
-         offset += 6;
 
-         proto_tree_add_ipv4(hpsdr_u_tree, hf_hpsdr_u_setip_address, tvb,offset, 4,tvb_get_ipv4(tvb,offset));
-         offset += 4;
+   } else if ( status == 3 ) {  // not included:  Set IP - Program
+      proto_tree_add_ether(hpsdr_u_tree, hf_hpsdr_u_setip_mac, tvb,offset, 6, discovery_ether_address);
+      offset += 6;
 
-         offset = packet_end_pad(tvb,hpsdr_u_tree,offset,8);
+      proto_tree_add_ipv4(hpsdr_u_tree, hf_hpsdr_u_setip_address, tvb,offset, 4,tvb_get_ipv4(tvb,offset));
+      offset += 4;
 
-      } else if ( status == 4 ) {  // Start - Stop
+      offset = packet_end_pad(tvb,hpsdr_u_tree,offset,8);
 
-         flags = tvb_get_guint8(tvb, offset);
-         proto_tree_add_boolean(hpsdr_u_tree, hf_hpsdr_u_com_iq, tvb,offset, 1, flags);
-         proto_tree_add_boolean(hpsdr_u_tree, hf_hpsdr_u_com_wb, tvb,offset, 1, flags);
-         offset += 1;
+   } else if ( status == 4 ) {  // Start - Stop
 
-         offset = packet_end_pad(tvb,hpsdr_u_tree,offset,60);
-      }
+      flags = tvb_get_guint8(tvb, offset);
+      proto_tree_add_boolean(hpsdr_u_tree, hf_hpsdr_u_com_iq, tvb,offset, 1, flags);
+      proto_tree_add_boolean(hpsdr_u_tree, hf_hpsdr_u_com_wb, tvb,offset, 1, flags);
+      offset += 1;
 
-      check_length(tvb,pinfo,hpsdr_u_tree,offset);
+      offset = packet_end_pad(tvb,hpsdr_u_tree,offset,60);
    }
 
+   check_length(tvb,pinfo,hpsdr_u_tree,offset);
+
 
 }
 
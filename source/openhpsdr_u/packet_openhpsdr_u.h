@@ -26,172 +26,104 @@
 
 #define HPSDR_U_PORT 1024
 
-#define ZERO_MASK     0x00
-#define BOOLEAN_MASK  0x08
-#define ALL_BITS_MASK 0xFF
-#define BIT12_MASK    0x0FFF
-#define BIT16_MASK    0xFFFF
-#define BIT24_MASK    0xFFFFFF
-
-//GLOBAL FLAGS MASKS
-#define GF_START_STOP_ST 0x01 //0b00000001
-#define GF_IQ_STATE      0x02 //0b00000010
-#define GF_WB_STATE      0x04 //0b00000100
-#define GF_BW_IQ_ST_ST   0x07 //0b00000111
-
-// START-STOP MASKS
-#define TH_IQ              0x01 //0b00000001
-#define TH_WIDE_BANDSCOPE  0x02 //0b00000010
-#define TH_MASK            0x07 //0b00000011
-
-//USB C0 MASKS
-#define SDR_C0_PTT      0x01 //0b00000001
-#define SDR_C0_DASH     0x02 //0b00000010
-#define SDR_C0_DOT      0x04 //0b00000100
-#define SDR_C0_TYPE_EP2 0x7F //0b01111111
-#define SDR_C0_TYPE_EP6 0x1F //0b00011111
-
-//USB EP6 C1 TYPE 0 MASKS
-#define SDR_C1_OVER  0x01 //0b00000001
-#define SDR_C1_I01   0x02 //0b00000010
-#define SDR_C1_I02   0x04 //0b00000100
-#define SDR_C1_I03   0x08 //0b00001000
-#define SDR_C1_I04   0x10 //0b00010000
-#define SDR_C1_PLL   0x20 //0b00100000
-#define SDR_C1_FREQ  0x40 //0b01000000
-#define SDR_C1_MASK  0x7F //0b01111111
-
-//SB EP6 C1 TYPE 0x04 MASKS
-#define SDR_OVER_MASK 0x01 //0b00000001
-#define SDR_MER_MASK  0xFE //0b11111110
-
-//USB EP2 C0 MASKS
-#define HOST_C0_MOX  0x01 //0b00000001
-#define HOST_C0_TYPE 0xFE //0b11111110
-
-//USB EP2 TYPE 0 MASKS
-#define HOST_C1_SPEED 0x03 //0b00000011
-#define HOST_C1_10MHZ 0x0C //0b00001100
-#define HOST_C1_122S  0x10 //0b00010000
-#define HOST_C1_CONF  0x60 //0b01100000
-#define HOST_C1_MICS  0x80 //0b10000000
-#define HOST_C2_MODE  0x01 //0b00000001
-#define HOST_C2_OC0   0x02 //0b00000010
-#define HOST_C2_OC1   0x04 //0b00000100
-#define HOST_C2_OC2   0x08 //0b00001000
-#define HOST_C2_OC3   0x10 //0b00010000
-#define HOST_C2_OC4   0x20 //0b00100000
-#define HOST_C2_OC5   0x40 //0b01000000
-#define HOST_C2_OC6   0x80 //0b10000000
-#define HOST_C3_P_ATT 0x03 //0b00000011
-#define HOST_C3_PREAM 0x04 //0b00000100
-#define HOST_C3_IFDIT 0x08 //0b00001000
-#define HOST_C3_IFRAD 0x10 //0b00010000
-#define HOST_C3_P_ANT 0x60 //0b01100000
-#define HOST_C3_P_OUT 0x80 //0b10000000
-#define HOST_C4_P_T_R 0x03 //0b00000011
-#define HOST_C4_DUP   0x04 //0b00000100
-#define HOST_C4_RX_NU 0x38 //0b00111000
-#define HOST_C4_HL2_RX_NU 0x78 //0b01111000
-#define HOST_C4_T_ST  0x40 //0b01000000
-#define HOST_C4_C_FEQ 0x80 //0b10000000
-
-
-//USB EP2 TYPE 0x09 MASKS
-#define HOST_C2_MIC_B 0x01 //0b00000001
-#define HOST_C2_MIC_L 0x02 //0b00000010
-#define HOST_C2_E_T_F 0x04 //0b00000100
-#define HOST_C2_EN_TU 0x08 //0b00001000
-#define HOST_C2_AU_TU 0x10 //0b00010000
-#define HOST_C2_AL_AP 0x20 //0b00100000
-#define HOST_C2_AP_MA 0x40 //0b01000000
-#define HOST_C2_VNA   0x80 //0b10000000
-#define HOST_C3_F_13  0x01 //0b00000001
-#define HOST_C3_F_20  0x02 //0b00000010
-#define HOST_C3_F_9_5 0x04 //0b00000100
-#define HOST_C3_F_6_5 0x08 //0b00001000
-#define HOST_C3_F_1_5 0x10 //0b00010000
-#define HOST_C3_HPF_B 0x20 //0b00100000
-#define HOST_C3_6M_B  0x40 //b01000000
-#define HOST_C3_D_P_R 0x80 //0b10000000
-#define HOST_C4_20_30 0x01 //0b00000001
-#define HOST_C4_60_40 0x02 //0b00000010
-#define HOST_C4_F_80  0x04 //0b00000100
-#define HOST_C4_F_160 0x08 //0b00001000
-#define HOST_C4_F_6   0x10 //0b00010000
-#define HOST_C4_12_10 0x20 //0b00100000
-#define HOST_C4_17_15 0x40 //0b01000000
-#define HOST_C4_T_12  0x7F //0b01111111
-
-//USB EP2 TYPE 0x0A MASKS
-#define HOST_C1_2_14 0x7F //0b01111111
-#define HOST_C1_RX1P 0x01 //0b00000001
-#define HOST_C1_RX2P 0x02 //0b00000010
-#define HOST_C1_RX3P 0x04 //0b00000100
-#define HOST_C1_RX4P 0x08 //0b00001000
-#define HOST_C1_O_TR 0x10 //0b00010000
-#define HOST_C1_O_B  0x20 //0b00100000
-#define HOST_C1_O_PT 0x40 //0b01000000
-#define HOST_C2_TLV  0x1F //0b00011111
-#define HOST_C2_A_TX 0x20 //0b00100000
-#define HOST_C2_PURE 0x40 //0b01000000
-#define HOST_C2_P_CW 0x80 //0b10000000
-#define HOST_C3_2_14 0x1F //0b00011111
-#define HOST_C3_M_P1 0x01 //0b00000001
-#define HOST_C3_M_P2 0x02 //0b00000010
-#define HOST_C3_M_P3 0x04 //0b00000100
-#define HOST_C3_M_P4 0x08 //0b00001000
-#define HOST_C3_A_TX 0x10 //0b00010000
-#define HOST_C4_2_14 0x3F //0b00111111
-#define HOST_C4_A1_A 0x1F //0b00011111
-#define HOST_C4_HA_A 0x20 //0b00100000
-
-//USB EP2 TYPE 0x0B MASKS
-#define HOST_C1_2_16  0x3F //0b00111111
-#define HOST_2_16_ADC 0x1F //0b00011111
-#define HOST_2_16_AS  0x20 //0b00100000
-#define HOST_C2_2_16  0x7F //00b01111111
-#define HOST_C2_CW_R  0x40 //0b01000000
-#define HOST_C3_CW_S  0x3F //0b00111111
-#define HOST_C3_CW_KM 0xC0 //0b11000000
-#define HOST_C4_CW_KW 0x7F //0b01111111
-#define HOST_C4_CW_KS 0x80 //0b10000000
-
-//USB EP2 TYPE 0X0E MASKS
-#define HOST_C1_R1_AD 0x03 //0b00000011
-#define HOST_C1_R2_AD 0x0C //0b00001100
-#define HOST_C1_R3_AD 0x30 //0b00110000
-#define HOST_C1_R4_AD 0xC0 //0b11000000
-#define HOST_C2_2_1E  0x3F //0b00111111
-#define HOST_C2_R5_AD 0x03 //0b00000011
-#define HOST_C2_R6_AD 0x0C //0b00001100
-#define HOST_C2_R7_AD 0x30 //0b00110000
-#define HOST_C3_A_I_A 0x1F //0b00011111
-
-//USB EP2 TYPE 0x0F MASKS
-#define HOST_C1_CW_SO 0x01 //0b00000001
-
-//USB EP2 TYPE 0x10 MASKS
-#define HOST_2_20_CW_H 0x03FF //0b0000001111111111
-#define HOST_2_20_CW_F 0x0FFF //0b0000111111111111
-
-//USB EP2 TYPE 0x11 MASKS
-#define HOST_2_22 0x03FF //0b0000001111111111
-
-//BOOLEAN BIT BITMAKS
-#define BOOLEAN_B0 0x01 //0b00000001
-#define BOOLEAN_B1 0x02 //0b00000010
-#define BOOLEAN_B2 0x04 //0b00000100
-#define BOOLEAN_B3 0x08 //0b00001000
-#define BOOLEAN_B4 0x10 //0b00010000
-#define BOOLEAN_B5 0x20 //0b00100000
-#define BOOLEAN_B6 0x40 //0b01000000
-#define BOOLEAN_B7 0x80 //0b10000000
+// EP4 wide band buffers, 512 16 bit samples per datagram
+#define HPSDR_U_EP4_SAMPLES      512
+#define HPSDR_U_EP4_BUFFER_METIS 4096   // Metis and Mercury, 8 datagrams
+#define HPSDR_U_EP4_BUFFER       16384  // Hermes and later boards, 32 datagrams
+#define HPSDR_U_EP4_BUFFER_MAX   65536
+
+// Keys of the per packet data
+#define HPSDR_U_PDATA_EP6 0
+#define HPSDR_U_PDATA_EP4 1
+#define HPSDR_U_PDATA_EP2 2
+
+// C&C and state bit masks, also used by the taps
+#include "cc_openhpsdr_u.h"
+
+// Per packet data, saved on the first pass.
+typedef struct _hpsdr_u_packet_data_t {
+   int rx_num;                  // Number of receivers the EP6 datagram is decoded with, 0 not known
+   guint8 board_id;             // Board ID of the radio, 0xFF not known
+   int speed_num;               // EP2 C0=0x00 speed when the datagram was dissected first
+   guint8 rx_adc[HPSDR_U_RX_ADC]; // ADC assigned to RX1 .. RX7 when the datagram was dissected first
+   gboolean backfill;           // rx_num was learned after the first pass got to this datagram
+   gboolean have_sample;
+   guint64 first_sample;        // Absolute number of the first IQ sample
+   guint32 samples;             // Samples per receiver
+   guint32 gap;                 // Datagrams missing before this datagram
+   wmem_array_t *sample_index;  // Sample index of the conversation
+   int rx_num_inferred;         // Number of receivers inferred from the EP6 samples, 0 when from EP2
+} hpsdr_u_packet_data_t;
+
+// Per packet data of a EP4 datagram. Saved on the first pass, the
+// reassembly uses the same buffer and fragment numbers on every pass.
+typedef struct _hpsdr_u_ep4_data_t {
+   guint32 buffer_id;           // Wide band buffer of the datagram
+   guint32 fragment;            // Datagram in the buffer, 0 is the first
+   guint32 fragments;           // Datagrams in the buffer
+   guint32 missing;             // Datagrams missing before this datagram
+} hpsdr_u_ep4_data_t;
+
+// Per packet data of a EP2 datagram. Saved on the first pass, the starved
+// run is added to every datagram of the run once the run ends.
+typedef struct _hpsdr_u_ep2_data_t {
+   guint32 zero;                // Zero samples (Left, Right, I and Q all zero)
+   guint32 runs;                // Starved runs that end in the datagram
+   guint32 starved;             // Zero samples of the runs that end in the datagram
+   guint32 longest;             // Longest run that ends in the datagram
+   guint32 run_start;           // First frame of the starved run of the zero samples, 0 none
+   guint32 run_end;             // Frame the starved run ends in
+} hpsdr_u_ep2_data_t;
+
+// Per conversation data.
+typedef struct _hpsdr_u_conv_data_t {
+   hpsdr_u_sample_stream_t *stream; // EP6 receiver sample numbers
+   hpsdr_u_infer_t *infer;          // EP6 layout scores when the number of receivers is not known
+   wmem_stack_t *unknown_rx;        // hpsdr_u_packet_data_t of EP6 datagrams without a number of receivers
+   wmem_stack_t *unknown_board;     // hpsdr_u_packet_data_t of EP6 datagrams without a board ID
+   int rx_num;                      // Number of receivers from EP2 C0=0x00, 0 not known
+   int rx_num_inferred;             // Number of receivers inferred from the EP6 samples, 0 none
+   gboolean ep4_started;
+   guint32 ep4_next_seq;            // EP4 sequence number expected next
+   gboolean ep2_live;               // A EP2 sample that is not zero has been seen
+   guint32 ep2_run;                 // Zero EP2 samples in the run
+   guint32 ep2_run_start;           // Frame of the first zero sample of the run
+   wmem_stack_t *ep2_run_data;      // hpsdr_u_ep2_data_t of the datagrams in the run
+} hpsdr_u_conv_data_t;
 
 void proto_register_hpsdr_u(void);
 
-static int hpsdr_usb_ep2_frame(proto_tree *tree, tvbuff_t *tvb, packet_info *pinfo, int offset, int frame_num);
-static int hpsdr_usb_ep6_frame(proto_tree *tree, tvbuff_t *tvb, int offset, int frame_num);
+static int hpsdr_usb_ep2_frame(proto_tree *tree, tvbuff_t *tvb, packet_info *pinfo, int offset, int frame_num,
+                               hpsdr_u_tap_frame_t *tap_frame);
+static int hpsdr_usb_ep6_frame(proto_tree *tree, tvbuff_t *tvb, packet_info *pinfo, int offset, int frame_num,
+                               int ep6_rx_num, const guint8 *ep6_rx_adc, guint8 ep6_board_id,
+                               hpsdr_u_tap_frame_t *tap_frame);
+static gint captured_bytes(tvbuff_t *tvb, gint offset, gint length);
+static void not_captured_item(proto_tree *tree, tvbuff_t *tvb, packet_info *pinfo, gint offset, gint length,
+                              const char *part);
+static gboolean ep2_samples_referenced(void);
+static double ep2_peak_dbfs(double peak_power);
+static void ep2_sample_summary(proto_tree *tree, proto_item *item, tvbuff_t *tvb, gint offset,
+                               const guint8 *data);
+static gboolean ep6_rx_signal_referenced(proto_tree *tree);
+static void ep6_rx_signal(proto_tree *tree, tvbuff_t *tvb, gint offset, const hpsdr_u_tap_info_t *tap_info);
+static hpsdr_u_conv_data_t *hpsdr_u_conv_data(packet_info *pinfo);
+static int hpsdr_u_conv_rx_num(const hpsdr_u_conv_data_t *conv_data);
+static void ep6_rx_num_infer(packet_info *pinfo, tvbuff_t *tvb, gint offset);
+static void ep6_backfill(hpsdr_u_conv_data_t *conv_data);
+static hpsdr_u_packet_data_t *ep6_packet_data(packet_info *pinfo, guint32 seq);
+static void ep2_run_end(hpsdr_u_conv_data_t *conv_data, hpsdr_u_ep2_data_t *ep2_data, guint32 frame_num);
+static hpsdr_u_ep2_data_t *ep2_packet_data(packet_info *pinfo, const hpsdr_u_tap_info_t *tap_info);
+static void ep2_starved_items(proto_tree *tree, tvbuff_t *tvb, packet_info *pinfo, gint offset,
+                              const hpsdr_u_ep2_data_t *ep2_data);
+static guint32 ep4_fragments(guint8 ep4_board_id);
+static hpsdr_u_ep4_data_t *ep4_packet_data(packet_info *pinfo, guint32 seq);
+static tvbuff_t *ep4_reassemble(proto_tree *tree, tvbuff_t *tvb, packet_info *pinfo, gint offset,
+                                guint32 seq, hpsdr_u_tap_info_t *tap_info);
+static gint ep2_sync_window(tvbuff_t *tvb, gint offset, guint max_skew);
+static gint ep2_sync_skew(tvbuff_t *tvb, gint offset, guint max_skew);
+static void ep6_overflow_items(proto_tree *tree, tvbuff_t *tvb, gint offset, guint8 overflow, int ep6_rx_num,
+                               const guint8 *ep6_rx_adc);
 
 static void dissect_hpsdr_u(tvbuff_t *tvb, packet_info *pinfo, proto_tree *tree);
 void proto_reg_handoff_hpsdr_u(void);
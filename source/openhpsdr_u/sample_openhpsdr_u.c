@@ -0,0 +1,128 @@
+/* sample_openhpsdr_u.c
+ * OpenHPSDR USB over IP protocol absolute receiver sample numbers and index
+ *
+ * Version: 0.5.0
+ * Author:  Matthew J Wolf, N4MTT
+ *
+ * This file is part of the OpenHPSDR-USB Plug-in for Wireshark.
+ * Matthew J. Wolf <matthew.wolf.hpsdr@speciosus.net>
+ * Copyright 2020 Matthew J. Wolf
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * The OpenHPSDR-USB Plug-in for Wireshark is free software: you can
+ * redistribute it and/or modify it under the terms of the GNU
+ * General Public License as published by the Free Software Foundation,
+ * either version 2 of the License, or (at your option) any later version.
+ *
+ * The OpenHPSDR-USB Plug-in for Wireshark is distributed in the hope that
+ * it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See
+ * the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the OpenHPSDR-USB Plug-in for Wireshark.
+ * If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <epan/packet.h>
+
+#include "iq_openhpsdr_u.h"
+#include "sample_openhpsdr_u.h"
+
+hpsdr_u_sample_stream_t *hpsdr_u_sample_stream_new(wmem_allocator_t *scope)
+{
+   hpsdr_u_sample_stream_t *stream = NULL;
+
+   stream = wmem_new0(scope, hpsdr_u_sample_stream_t);
+   stream->index = wmem_array_new(scope, sizeof(hpsdr_u_sample_entry_t));
+
+   return stream;
+}
+
+// The sequence number counts datagrams. The missing datagrams are counted
+// with the layout (number of receivers) of the datagram before them.
+gboolean hpsdr_u_sample_stream_add(hpsdr_u_sample_stream_t *stream, guint32 seq, int rx_num,
+                                   guint32 frame_num, guint64 *first_sample, guint32 *gap)
+{
+   hpsdr_u_sample_entry_t entry;
+   guint32 per_datagram = 0;
+   gint32 seq_delta = 0;
+   gboolean restart = FALSE;
+
+   *gap = 0;
+
+   if ( hpsdr_u_ep6_layout(rx_num) == NULL ) { return FALSE; }
+
+   per_datagram = 2 * hpsdr_u_ep6_layout(rx_num)->samp_num;
+
+   if ( stream->started ) {
+      seq_delta = (gint32)( seq - stream->last_seq );
+      if ( seq_delta > 1 ) { *gap = seq_delta - 1; }
+
+      // Restarted sequence numbers, the jump is not missing samples.
+      if ( seq_delta < -HPSDR_U_SAMPLE_LATE_MAX || seq_delta > HPSDR_U_SAMPLE_GAP_MAX ) {
+         restart = TRUE;
+         *gap = 0;
+      }
+   }
+
+   // A new layout or segment starts after the newest datagram and the missing ones.
+   if ( !stream->started || restart || rx_num != stream->rx_num ) {
+      stream->base_sample = stream->next_sample + ( (guint64)*gap * stream->per_datagram );
+      stream->base_seq = seq;
+      stream->per_datagram = per_datagram;
+      stream->rx_num = rx_num;
+      stream->last_seq = seq;
+      stream->started = TRUE;
+   }
+
+   seq_delta = (gint32)( seq - stream->base_seq );
+   if ( seq_delta < 0 ) { return FALSE; }   // Before the start of the layout
+
+   *first_sample = stream->base_sample + ( (guint64)seq_delta * per_datagram );
+
+   // Late (out of order) datagrams are numbered, they are not in the index.
+   if ( *first_sample >= stream->next_sample ) {
+      entry.first_sample = *first_sample;
+      entry.samples = per_datagram;
+      entry.frame_num = frame_num;
+      wmem_array_append_one(stream->index, entry);
+
+      stream->next_sample = *first_sample + per_datagram;
+      stream->last_seq = seq;
+   }
+
+   return TRUE;
+}
+
+const hpsdr_u_sample_entry_t *hpsdr_u_sample_index_find(wmem_array_t *index, guint64 sample)
+{
+   const hpsdr_u_sample_entry_t *entries = NULL;
+   const hpsdr_u_sample_entry_t *entry = NULL;
+   guint low = 0;
+   guint high = 0;
+   guint mid = 0;
+
+   high = wmem_array_get_count(index);
+   if ( high == 0 ) { return NULL; }
+
+   entries = (const hpsdr_u_sample_entry_t *)wmem_array_get_raw(index);
+
+   // Last entry with first_sample <= sample
+   while ( high - low > 1 ) {
+      mid = low + (( high - low ) / 2 );
+      if ( entries[mid].first_sample <= sample ) {
+         low = mid;
+      } else {
+         high = mid;
+      }
+   }
+
+   entry = &entries[low];
+   if ( sample < entry->first_sample || sample >= entry->first_sample + entry->samples ) { return NULL; }
+
+   return entry;
+}
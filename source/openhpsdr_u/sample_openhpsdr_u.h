@@ -0,0 +1,66 @@
+/* sample_openhpsdr_u.h
+ * Header file for the OpenHPSDR USB over IP protocol receiver sample index
+ *
+ * Version: 0.5.0
+ * Author:  Matthew J Wolf, N4MTT
+ *
+ * This file is part of the OpenHPSDR-USB Plug-in for Wireshark.
+ * Matthew J. Wolf <matthew.wolf.hpsdr@speciosus.net>
+ * Copyright 2020 Matthew J. Wolf
+ *
+ * The OpenHPSDR-USB Plug-in for Wireshark is free software: you can
+ * redistribute it and/or modify it under the terms of the GNU
+ * General Public License as published by the Free Software Foundation,
+ * either version 2 of the License, or (at your option) any later version.
+ *
+ * The OpenHPSDR-USB Plug-in for Wireshark is distributed in the hope that
+ * it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See
+ * the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the OpenHPSDR-USB Plug-in for Wireshark.
+ * If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __SAMPLE_OPENHPSDR_U_H__
+#define __SAMPLE_OPENHPSDR_U_H__
+
+#define HPSDR_U_SAMPLE_LATE_MAX 64      // Datagrams a late datagram can be behind the newest
+#define HPSDR_U_SAMPLE_GAP_MAX  65536   // Datagrams missing in one gap, a longer jump is a restart
+
+// One EP6 datagram in the sample index.
+typedef struct _hpsdr_u_sample_entry_t {
+   guint64 first_sample;        // Absolute number of the first sample, every receiver has the same number
+   guint32 samples;             // Samples per receiver in the datagram
+   guint32 frame_num;           // Wireshark frame number
+} hpsdr_u_sample_entry_t;
+
+// The EP6 receiver stream of a conversation. The samples are numbered from
+// the first datagram with a known number of receivers.
+typedef struct _hpsdr_u_sample_stream_t {
+   gboolean started;
+   int rx_num;                  // Number of receivers of the current layout
+   guint32 base_seq;            // Sequence number where the current layout starts
+   guint64 base_sample;         // First sample of the datagram with base_seq
+   guint32 per_datagram;        // Samples per receiver in a datagram of the current layout
+   guint32 last_seq;            // Sequence number of the newest datagram
+   guint64 next_sample;         // Sample after the newest datagram
+   wmem_array_t *index;         // hpsdr_u_sample_entry_t, sorted by first_sample
+} hpsdr_u_sample_stream_t;
+
+hpsdr_u_sample_stream_t *hpsdr_u_sample_stream_new(wmem_allocator_t *scope);
+
+// Number the samples of a EP6 datagram. Returns FALSE when the datagram can
+// not be numbered. gap is the number of datagrams missing before it. A
+// sequence number that goes back further than a late datagram (the radio
+// was stopped and started) or jumps ahead more than a gap starts a new
+// segment after the newest datagram.
+gboolean hpsdr_u_sample_stream_add(hpsdr_u_sample_stream_t *stream, guint32 seq, int rx_num,
+                                   guint32 frame_num, guint64 *first_sample, guint32 *gap);
+
+// The datagram with the sample, NULL when the sample is in a gap or
+// after the end. Binary search, O(log n).
+const hpsdr_u_sample_entry_t *hpsdr_u_sample_index_find(wmem_array_t *index, guint64 sample);
+
+#endif
@@ -0,0 +1,351 @@
+/* tap_openhpsdr_u.c
+ * Routines shared by the OpenHPSDR USB over IP protocol taps and statistics
+ *
+ * Version: 0.5.0
+ * Author:  Matthew J Wolf, N4MTT
+ *
+ * This file is part of the OpenHPSDR-USB Plug-in for Wireshark.
+ * Matthew J. Wolf <matthew.wolf.hpsdr@speciosus.net>
+ * Copyright 2020 Matthew J. Wolf
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * The OpenHPSDR-USB Plug-in for Wireshark is free software: you can
+ * redistribute it and/or modify it under the terms of the GNU
+ * General Public License as published by the Free Software Foundation,
+ * either version 2 of the License, or (at your option) any later version.
+ *
+ * The OpenHPSDR-USB Plug-in for Wireshark is distributed in the hope that
+ * it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See
+ * the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the OpenHPSDR-USB Plug-in for Wireshark.
+ * If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <epan/packet.h>
+#include <epan/tap.h>
+#include <epan/to_str.h>
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include "tap_openhpsdr_u.h"
+#include "iq_openhpsdr_u.h"
+
+// The radio is the source of EP4 and EP6 datagrams and the
+// destination of EP2 datagrams.
+gchar *hpsdr_u_tap_radio_name(packet_info *pinfo, const hpsdr_u_tap_info_t *tap_info)
+{
+   if ( tap_info->end_point == 2 ) {
+      return wmem_strdup_printf(wmem_packet_scope(), "%s:%u",
+                                address_to_str(wmem_packet_scope(), &pinfo->dst), pinfo->destport);
+   }
+
+   return wmem_strdup_printf(wmem_packet_scope(), "%s:%u",
+                             address_to_str(wmem_packet_scope(), &pinfo->src), pinfo->srcport);
+}
+
+// The host is the source of EP2 datagrams and the destination of EP4 and
+// EP6 datagrams.
+gchar *hpsdr_u_tap_host_name(packet_info *pinfo, const hpsdr_u_tap_info_t *tap_info)
+{
+   if ( tap_info->end_point == 2 ) {
+      return wmem_strdup_printf(wmem_packet_scope(), "%s:%u",
+                                address_to_str(wmem_packet_scope(), &pinfo->src), pinfo->srcport);
+   }
+
+   return wmem_strdup_printf(wmem_packet_scope(), "%s:%u",
+                             address_to_str(wmem_packet_scope(), &pinfo->dst), pinfo->destport);
+}
+
+// Record of a radio and host pair, the key is "<radio>-<host>".
+gpointer hpsdr_u_tap_link_lookup(GHashTable *table, packet_info *pinfo, const hpsdr_u_tap_info_t *tap_info, gsize size)
+{
+   hpsdr_u_tap_link_t *link = NULL;
+   gchar *radio = NULL;
+   gchar *host = NULL;
+
+   radio = hpsdr_u_tap_radio_name(pinfo, tap_info);
+   host = hpsdr_u_tap_host_name(pinfo, tap_info);
+
+   link = (hpsdr_u_tap_link_t *)hpsdr_u_tap_radio_lookup(table,
+                                                         wmem_strdup_printf(wmem_packet_scope(), "%s-%s", radio, host),
+                                                         size);
+   if ( link->radio == NULL ) {
+      link->radio = g_strdup(radio);
+      link->host = g_strdup(host);
+   }
+
+   return link;
+}
+
+// <prefix>_<radio><suffix>, with the characters in the radio name that
+// do not belong in a file name replaced.
+gchar *hpsdr_u_tap_file_name(const gchar *prefix, const gchar *radio, const gchar *suffix)
+{
+   gchar *name = NULL;
+   gchar *c = NULL;
+
+   name = g_strdup_printf("%s_%s%s", prefix, radio, suffix);
+
+   for (c = name + strlen(prefix) + 1; *c != '\0'; c++) {
+      if ( *c == ':' || *c == '/' || *c == '\\' ) { *c = '_'; }
+   }
+
+   return name;
+}
+
+void hpsdr_u_tap_radio_free(gpointer record)
+{
+   g_free(((hpsdr_u_tap_radio_t *)record)->name);
+   g_free(record);
+}
+
+void hpsdr_u_tap_link_free(gpointer record)
+{
+   g_free(((hpsdr_u_tap_link_t *)record)->radio);
+   g_free(((hpsdr_u_tap_link_t *)record)->host);
+   hpsdr_u_tap_radio_free(record);
+}
+
+// Table of per radio records keyed by the radio name. The record_free
+// function has to free the name, NULL uses hpsdr_u_tap_radio_free().
+GHashTable *hpsdr_u_tap_radio_table(GDestroyNotify record_free)
+{
+   if ( record_free == NULL ) { record_free = hpsdr_u_tap_radio_free; }
+
+   return g_hash_table_new_full(g_str_hash, g_str_equal, NULL, record_free);
+}
+
+// Find the record of a radio. A zeroed record of size bytes is added when
+// the radio is new. The table owns the records.
+gpointer hpsdr_u_tap_radio_lookup(GHashTable *table, const gchar *radio, gsize size)
+{
+   hpsdr_u_tap_radio_t *record = NULL;
+
+   record = (hpsdr_u_tap_radio_t *)g_hash_table_lookup(table, radio);
+
+   if ( record == NULL ) {
+      record = (hpsdr_u_tap_radio_t *)g_malloc0(size);
+      record->name = g_strdup(radio);
+      g_hash_table_insert(table, record->name, record);
+   }
+
+   return record;
+}
+
+static gint hpsdr_u_tap_radio_compare(gconstpointer a, gconstpointer b)
+{
+   return strcmp(((const hpsdr_u_tap_radio_t *)a)->name, ((const hpsdr_u_tap_radio_t *)b)->name);
+}
+
+// Records sorted by radio name. Free the list with g_list_free().
+GList *hpsdr_u_tap_radio_list(GHashTable *table)
+{
+   return g_list_sort(g_hash_table_get_values(table), hpsdr_u_tap_radio_compare);
+}
+
+// Split "<cli_string>,<arg 1>,..,<arg nargs>,<filter>" into nargs arguments.
+// Missing arguments are empty strings. The filter is everything after the
+// last argument, it can have commas. Free the result with g_strfreev().
+gchar **hpsdr_u_tap_args(const char *opt_arg, const char *cli_string, guint nargs, const gchar **filter)
+{
+   gchar **args = NULL;
+   gchar **split = NULL;
+   const char *rest = NULL;
+   guint x = 0;
+
+   *filter = NULL;
+
+   rest = opt_arg + strlen(cli_string);
+   if ( *rest == ',' ) { rest++; }
+
+   split = g_strsplit(rest, ",", nargs + 1);
+
+   args = g_new0(gchar *, nargs + 1);
+   for (x = 0; x < nargs; x++) {
+      if ( x < g_strv_length(split) ) {
+         args[x] = g_strdup(split[x]);
+      } else {
+         args[x] = g_strdup("");
+      }
+   }
+
+   if ( g_strv_length(split) > nargs && split[nargs][0] != '\0' ) {
+      // Points into opt_arg so it does not have to be freed.
+      *filter = opt_arg + strlen(opt_arg) - strlen(split[nargs]);
+   }
+
+   g_strfreev(split);
+
+   return args;
+}
+
+// Number argument of a tap, value when the argument is empty. The arguments
+// are by position, a filter given in place of a number stops tshark with
+// an error instead of being dropped.
+double hpsdr_u_tap_number(const gchar *arg, const char *cli_string, const char *name, double value)
+{
+   gchar *end = NULL;
+
+   if ( arg[0] == '\0' ) { return value; }
+
+   value = g_ascii_strtod(arg, &end);
+   if ( end == arg || *end != '\0' ) {
+      fprintf(stderr, "tshark: %s %s \"%s\" is not a number, the filter is after the other arguments"
+                      " (leave a argument empty with ,,)\n", cli_string, name, arg);
+      exit(1);
+   }
+
+   return value;
+}
+
+void hpsdr_u_tap_listen(const char *cli_string, void *tapdata, const gchar *filter,
+                        tap_reset_cb reset, tap_packet_cb packet, tap_draw_cb draw, tap_finish_cb finish)
+{
+   GString *error_string = NULL;
+
+   error_string = register_tap_listener("hpsdr-u", tapdata, filter, TL_REQUIRES_NOTHING,
+                                        reset, packet, draw, finish);
+
+   if ( error_string ) {
+      fprintf(stderr, "tshark: Couldn't register %s tap: %s\n", cli_string, error_string->str);
+      g_string_free(error_string, TRUE);
+      exit(1);
+   }
+}
+
+// Name of a EP2 C0 Type (register). 0x12 is the 2nd Alex, or the RX 8 NCO
+// on a Hermes-Lite2.
+const gchar *hpsdr_u_tap_c0_name(guint8 c0_type)
+{
+   static const value_string c0_names[] = {
+      { 0x00, "Configuration" },
+      { 0x01, "TX NCO" },
+      { 0x02, "RX 1 NCO" },
+      { 0x03, "RX 2 NCO" },
+      { 0x04, "RX 3 NCO" },
+      { 0x05, "RX 4 NCO" },
+      { 0x06, "RX 5 NCO" },
+      { 0x07, "RX 6 NCO" },
+      { 0x08, "RX 7 NCO" },
+      { 0x09, "TX Drive, Filters" },
+      { 0x0A, "Preamp, Attenuator" },
+      { 0x0B, "ADC Attn, CW" },
+      { 0x0C, "Mercury 1" },
+      { 0x0D, "Mercury 2" },
+      { 0x0E, "ADC RX Assignment" },
+      { 0x0F, "CW 2" },
+      { 0x10, "CW 3" },
+      { 0x11, "PWM" },
+      { 0x12, "2nd Alex / HL2 RX 8 NCO" },
+      { 0x13, "HL2 RX 9 NCO" },
+      { 0x14, "HL2 RX 10 NCO" },
+      { 0x15, "HL2 RX 11 NCO" },
+      { 0x16, "HL2 RX 12 NCO" },
+      { 0x2B, "HL2 Predistortion" },
+      { 0x3B, "HL2 AD9866 SPI" },
+      { 0x3C, "HL2 I2C1" },
+      { 0x3D, "HL2 I2C2" },
+      { 0x3F, "HL2 Extended Write" },
+      { 0, NULL }
+   };
+
+   return val_to_str_const(c0_type, c0_names, "Unknown");
+}
+
+// Number of IQ samples in a EP6 USB frame.
+int hpsdr_u_ep6_samples(int rx)
+{
+   if ( hpsdr_u_ep6_layout(rx) == NULL ) { return 0; }
+
+   return hpsdr_u_ep6_layout(rx)->samp_num;
+}
+
+// Bin of a value, the negative values are below the zero bin.
+static int hpsdr_u_tap_dist_bin(double value)
+{
+   double magnitude = fabs(value);
+   int bin = 0;
+
+   if ( magnitude < pow(10, HPSDR_U_TAP_DIST_LOW) ) { return HPSDR_U_TAP_DIST_SIDE; }
+
+   bin = (int)floor(( log10(magnitude) - HPSDR_U_TAP_DIST_LOW ) * HPSDR_U_TAP_DIST_DECADE);
+   if ( bin < 0 ) { bin = 0; }
+   if ( bin >= HPSDR_U_TAP_DIST_SIDE ) { bin = HPSDR_U_TAP_DIST_SIDE - 1; }
+
+   return ( value > 0 ) ? HPSDR_U_TAP_DIST_SIDE + 1 + bin : HPSDR_U_TAP_DIST_SIDE - 1 - bin;
+}
+
+// Middle of a bin on the log scale.
+static double hpsdr_u_tap_dist_value(int bin)
+{
+   double magnitude = 0;
+
+   if ( bin == HPSDR_U_TAP_DIST_SIDE ) { return 0; }
+
+   if ( bin > HPSDR_U_TAP_DIST_SIDE ) {
+      magnitude = bin - HPSDR_U_TAP_DIST_SIDE - 1;
+   } else {
+      magnitude = HPSDR_U_TAP_DIST_SIDE - 1 - bin;
+   }
+   magnitude = pow(10, HPSDR_U_TAP_DIST_LOW + ( magnitude + 0.5 ) / HPSDR_U_TAP_DIST_DECADE);
+
+   return ( bin > HPSDR_U_TAP_DIST_SIDE ) ? magnitude : -magnitude;
+}
+
+void hpsdr_u_tap_dist_add(hpsdr_u_tap_dist_t *dist, double value)
+{
+   if ( dist->bins == NULL ) { dist->bins = g_new0(guint32, HPSDR_U_TAP_DIST_BINS); }
+
+   if ( dist->count == 0 || value < dist->min ) { dist->min = value; }
+   if ( dist->count == 0 || value > dist->max ) { dist->max = value; }
+
+   dist->bins[hpsdr_u_tap_dist_bin(value)] += 1;
+   dist->count += 1;
+}
+
+guint hpsdr_u_tap_dist_count(const hpsdr_u_tap_dist_t *dist)
+{
+   return dist->count;
+}
+
+// Nearest rank percentile, 0 is the smallest value and 100 the largest.
+double hpsdr_u_tap_dist_percentile(hpsdr_u_tap_dist_t *dist, double percent)
+{
+   guint rank = 0;
+   guint below = 0;
+   double value = 0;
+   int bin = 0;
+
+   if ( dist->count == 0 ) { return 0; }
+
+   rank = (guint)ceil(percent / 100.0 * dist->count);
+   if ( rank > 0 ) { rank -= 1; }
+   if ( rank >= dist->count ) { rank = dist->count - 1; }
+
+   if ( rank == 0 ) { return dist->min; }
+   if ( rank == dist->count - 1 ) { return dist->max; }
+
+   for (bin = 0; bin < HPSDR_U_TAP_DIST_BINS - 1; bin++) {
+      below += dist->bins[bin];
+      if ( below > rank ) { break; }
+   }
+
+   value = hpsdr_u_tap_dist_value(bin);
+   if ( value < dist->min ) { value = dist->min; }
+   if ( value > dist->max ) { value = dist->max; }
+
+   return value;
+}
+
+void hpsdr_u_tap_dist_free(hpsdr_u_tap_dist_t *dist)
+{
+   g_free(dist->bins);
+   memset(dist, 0, sizeof(*dist));
+}
@@ -0,0 +1,140 @@
+/* tap_openhpsdr_u.h
+ * Header file for the OpenHPSDR USB over IP protocol taps and statistics
+ *
+ * Version: 0.5.0
+ * Author:  Matthew J Wolf, N4MTT
+ *
+ * This file is part of the OpenHPSDR-USB Plug-in for Wireshark.
+ * Matthew J. Wolf <matthew.wolf.hpsdr@speciosus.net>
+ * Copyright 2020 Matthew J. Wolf
+ *
+ * The OpenHPSDR-USB Plug-in for Wireshark is free software: you can
+ * redistribute it and/or modify it under the terms of the GNU
+ * General Public License as published by the Free Software Foundation,
+ * either version 2 of the License, or (at your option) any later version.
+ *
+ * The OpenHPSDR-USB Plug-in for Wireshark is distributed in the hope that
+ * it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See
+ * the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the OpenHPSDR-USB Plug-in for Wireshark.
+ * If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __TAP_OPENHPSDR_U_H__
+#define __TAP_OPENHPSDR_U_H__
+
+#define HPSDR_U_FRAMES      2   // USB frames in a Data TX datagram
+#define HPSDR_U_FRAME_DATA  504 // Bytes of samples in a USB frame
+#define HPSDR_U_EP2_SAMPLES 63  // EP2 L, R, I, Q samples in a USB frame
+#define HPSDR_U_AUDIO_RATE  48000
+#define HPSDR_U_RX_ADC      7   // Receivers in the EP2 C0=0x0E ADC RX Assignment
+#define HPSDR_U_ADC         4
+#define HPSDR_U_SYNC_NOT_SEARCHED -2 // sync_skew when the EP2 sync search did not run
+
+// One USB frame of a Data TX (status 1) datagram.
+typedef struct _hpsdr_u_tap_frame_t {
+   gboolean have_cc;            // C&C bytes captured, FALSE past the snaplen or no EP2 sync
+   guint8 cc[5];                // C&C bytes C0 to C4 as on the wire
+   guint8 c0_type;              // "C0 Type" after the MOX/PTT bits are removed
+   const guint8 *data;          // The 504 sample bytes, NULL when not captured or no EP2 sync
+   guint8 overflow;             // EP6 ADC overflow bits, bit 0 is ADC1 .. bit 3 is ADC4
+   gint sync_skew;              // EP2 extra bytes in front of the sync, -1 not found,
+                                // HPSDR_U_SYNC_NOT_SEARCHED preference off or not captured
+} hpsdr_u_tap_frame_t;
+
+// Queued to the "hpsdr-u" tap for every Data TX (status 1) datagram.
+typedef struct _hpsdr_u_tap_info_t {
+   guint8  end_point;           // USB end point 2, 4 or 6
+   guint32 seq;                 // Sequence number
+   int     rx_num;              // Number of receivers used for the EP6 layout, 0 unknown
+   int     speed_num;           // EP2 C0=0x00 speed, 0 = 48kHz .. 3 = 384kHz
+   guint8  board_id;            // From the last discovery reply
+   guint8  rx_adc[HPSDR_U_RX_ADC]; // ADC assigned to RX1 .. RX7, 0 is ADC1
+   gboolean have_sample;        // EP6, first_sample is known
+   guint64 first_sample;        // EP6 absolute number of the first IQ sample, per receiver
+   wmem_array_t *sample_index;  // EP6 sample index of the conversation, sample_openhpsdr_u.h
+   tvbuff_t *ep4_buffer;        // EP4 reassembled wide band buffer, only on the datagram that completes it
+   guint32 ep4_buffer_id;       // EP4 wide band buffer number in the conversation
+   guint32 ep2_zero;            // EP2 zero samples (Left, Right, I and Q all zero)
+   guint32 ep2_starved;         // EP2 zero samples of the starved runs that end in the datagram
+   guint32 ep2_starved_runs;    // EP2 starved runs that end in the datagram
+   guint32 ep2_starved_longest; // EP2 longest starved run that ends in the datagram
+   guint32 ep2_run_start;       // EP2 first frame of the starved run, 0 none
+   hpsdr_u_tap_frame_t frame[HPSDR_U_FRAMES];
+} hpsdr_u_tap_info_t;
+
+// Every per radio record of a tap starts with the radio name.
+typedef struct _hpsdr_u_tap_radio_t {
+   gchar *name;
+} hpsdr_u_tap_radio_t;
+
+// Every per radio and host record of a tap starts with the pair names.
+typedef struct _hpsdr_u_tap_link_t {
+   gchar *name;                 // <radio>-<host>
+   gchar *radio;
+   gchar *host;
+} hpsdr_u_tap_link_t;
+
+// Distribution of values (latencies, intervals) in log bins, the memory
+// does not grow with the capture. HPSDR_U_TAP_DIST_DECADE bins a decade
+// from 10^HPSDR_U_TAP_DIST_LOW to 10^HPSDR_U_TAP_DIST_HIGH for each sign,
+// and a bin for zero. A percentile is within 1.2% of the value, the minimum
+// and the maximum are exact. Zero it to start, free it with
+// hpsdr_u_tap_dist_free().
+#define HPSDR_U_TAP_DIST_DECADE 100
+#define HPSDR_U_TAP_DIST_LOW    -9
+#define HPSDR_U_TAP_DIST_HIGH   12
+#define HPSDR_U_TAP_DIST_SIDE   ( ( HPSDR_U_TAP_DIST_HIGH - HPSDR_U_TAP_DIST_LOW ) * HPSDR_U_TAP_DIST_DECADE )
+#define HPSDR_U_TAP_DIST_BINS   ( 2 * HPSDR_U_TAP_DIST_SIDE + 1 )
+
+typedef struct _hpsdr_u_tap_dist_t {
+   guint32 *bins;               // HPSDR_U_TAP_DIST_BINS, NULL until the first value
+   guint count;
+   double min;
+   double max;
+} hpsdr_u_tap_dist_t;
+
+// Helpers shared by the taps - tap_openhpsdr_u.c
+gchar *hpsdr_u_tap_radio_name(packet_info *pinfo, const hpsdr_u_tap_info_t *tap_info);
+gchar *hpsdr_u_tap_host_name(packet_info *pinfo, const hpsdr_u_tap_info_t *tap_info);
+gpointer hpsdr_u_tap_link_lookup(GHashTable *table, packet_info *pinfo, const hpsdr_u_tap_info_t *tap_info, gsize size);
+gchar *hpsdr_u_tap_file_name(const gchar *prefix, const gchar *radio, const gchar *suffix);
+void hpsdr_u_tap_radio_free(gpointer record);
+void hpsdr_u_tap_link_free(gpointer record);
+GHashTable *hpsdr_u_tap_radio_table(GDestroyNotify record_free);
+gpointer hpsdr_u_tap_radio_lookup(GHashTable *table, const gchar *radio, gsize size);
+GList *hpsdr_u_tap_radio_list(GHashTable *table);
+gchar **hpsdr_u_tap_args(const char *opt_arg, const char *cli_string, guint nargs, const gchar **filter);
+double hpsdr_u_tap_number(const gchar *arg, const char *cli_string, const char *name, double value);
+void hpsdr_u_tap_listen(const char *cli_string, void *tapdata, const gchar *filter,
+                        tap_reset_cb reset, tap_packet_cb packet, tap_draw_cb draw, tap_finish_cb finish);
+int hpsdr_u_ep6_samples(int rx);
+const gchar *hpsdr_u_tap_c0_name(guint8 c0_type);
+void hpsdr_u_tap_dist_add(hpsdr_u_tap_dist_t *dist, double value);
+guint hpsdr_u_tap_dist_count(const hpsdr_u_tap_dist_t *dist);
+double hpsdr_u_tap_dist_percentile(hpsdr_u_tap_dist_t *dist, double percent);
+void hpsdr_u_tap_dist_free(hpsdr_u_tap_dist_t *dist);
+
+// Registration of the tshark -z statistics taps
+void register_hpsdr_u_audio_tap(void);
+void register_hpsdr_u_telemetry_tap(void);
+void register_hpsdr_u_overflow_tap(void);
+void register_hpsdr_u_iq_tap(void);
+void register_hpsdr_u_seek_tap(void);
+void register_hpsdr_u_sync_tap(void);
+void register_hpsdr_u_adc_tap(void);
+void register_hpsdr_u_spectrum_tap(void);
+void register_hpsdr_u_continuity_tap(void);
+void register_hpsdr_u_ptt_tap(void);
+void register_hpsdr_u_confirm_tap(void);
+void register_hpsdr_u_cadence_tap(void);
+void register_hpsdr_u_txbuffer_tap(void);
+void register_hpsdr_u_starved_tap(void);
+void register_hpsdr_u_reaction_tap(void);
+void register_hpsdr_u_burst_tap(void);
+void register_hpsdr_u_clock_tap(void);
+
+#endif
@@ -0,0 +1,367 @@
+/* tap_openhpsdr_u_adc.c
+ * OpenHPSDR USB over IP protocol EP4 raw ADC code histograms and levels
+ *
+ * Version: 0.5.0
+ * Author:  Matthew J Wolf, N4MTT
+ *
+ * This file is part of the OpenHPSDR-USB Plug-in for Wireshark.
+ * Matthew J. Wolf <matthew.wolf.hpsdr@speciosus.net>
+ * Copyright 2020 Matthew J. Wolf
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * The OpenHPSDR-USB Plug-in for Wireshark is free software: you can
+ * redistribute it and/or modify it under the terms of the GNU
+ * General Public License as published by the Free Software Foundation,
+ * either version 2 of the License, or (at your option) any later version.
+ *
+ * The OpenHPSDR-USB Plug-in for Wireshark is distributed in the hope that
+ * it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See
+ * the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the OpenHPSDR-USB Plug-in for Wireshark.
+ * If not, see <http://www.gnu.org/licenses/>.
+ *
+ * tshark -z hpsdr-u,adc[,<interval seconds>[,<csv file prefix>[,<filter>]]]
+ *
+ * Code histogram, effective bits used, DC offset, RMS and peak levels and
+ * near rail counts of the raw ADC1 samples in the reassembled EP4 wide band
+ * buffers, per radio. The EP2 attenuator and preamp settings in effect are
+ * listed with every interval, to check the gain staging against the real
+ * signal levels. The whole capture is always reported, the intervals are
+ * only reported when a interval is given.
+ *
+ *  <csv file prefix>_<radio>.csv       Levels per interval
+ *  <csv file prefix>_<radio>_hist.csv  Code histogram, codes with samples
+ */
+
+#include <epan/packet.h>
+#include <epan/tap.h>
+#include <epan/stat_tap_ui.h>
+#include <wsutil/file_util.h>
+
+#include <stdlib.h>
+#include <string.h>
+#include "tap_openhpsdr_u.h"
+#include "adc_openhpsdr_u.h"
+#include "cc_openhpsdr_u.h"
+
+// EP2 C0 types of the ADC1 gain settings, the bits are in cc_openhpsdr_u.h
+#define ADC_C0_CONF      0x00 // C3 Alex attenuator (0, 10, 20, 30 dB) and preamp
+#define ADC_C0_MISC      0x0A // C4 step attenuator (0 to 31 dB) and enable
+
+// ADC1 gain settings from the EP2 USB frames, -1 not seen yet.
+typedef struct _hpsdr_u_adc_gain_t {
+   int alex_att;                // Alex attenuator dB
+   int preamp;                  // 1 on
+   int step_att;                // Step attenuator dB, 0 when not enabled
+} hpsdr_u_adc_gain_t;
+
+typedef struct _hpsdr_u_adc_row_t {
+   guint32 interval;            // Interval number from the start of the capture
+   guint32 buffers;
+   hpsdr_u_adc_stats_t stats;
+   hpsdr_u_adc_gain_t gain;     // At the last buffer of the interval
+} hpsdr_u_adc_row_t;
+
+typedef struct _hpsdr_u_adc_radio_t {
+   gchar *name;
+   guint32 buffers;             // EP4 wide band buffers
+   guint32 rail_frame;          // Frame number of the first buffer with a sample at the rail
+   hpsdr_u_adc_stats_t stats;
+   hpsdr_u_adc_gain_t gain;
+   guint32 *hist;               // 2 * HPSDR_U_ADC_CODES, adc_openhpsdr_u.h
+   GArray *rows;                // hpsdr_u_adc_row_t, only with a interval
+} hpsdr_u_adc_radio_t;
+
+typedef struct _hpsdr_u_adc_t {
+   double interval;             // Seconds, 0 when there are no intervals
+   gchar *csv_prefix;
+   GHashTable *radios;
+} hpsdr_u_adc_t;
+
+static void hpsdr_u_adc_radio_free(gpointer record)
+{
+   hpsdr_u_adc_radio_t *radio = (hpsdr_u_adc_radio_t *)record;
+
+   g_free(radio->hist);
+   if ( radio->rows != NULL ) { g_array_free(radio->rows, TRUE); }
+   hpsdr_u_tap_radio_free(radio);
+}
+
+static hpsdr_u_adc_radio_t *hpsdr_u_adc_radio(hpsdr_u_adc_t *adc, packet_info *pinfo,
+                                             const hpsdr_u_tap_info_t *tap_info)
+{
+   hpsdr_u_adc_radio_t *radio = NULL;
+
+   radio = (hpsdr_u_adc_radio_t *)hpsdr_u_tap_radio_lookup(adc->radios,
+                                                           hpsdr_u_tap_radio_name(pinfo, tap_info),
+                                                           sizeof(hpsdr_u_adc_radio_t));
+   if ( radio->hist == NULL ) {
+      radio->hist = g_new0(guint32, 2 * HPSDR_U_ADC_CODES);
+      radio->gain.alex_att = -1;
+      radio->gain.preamp = -1;
+      radio->gain.step_att = -1;
+   }
+
+   return radio;
+}
+
+static hpsdr_u_adc_row_t *hpsdr_u_adc_row(hpsdr_u_adc_radio_t *radio, guint32 interval)
+{
+   hpsdr_u_adc_row_t *row = NULL;
+
+   if ( radio->rows->len > 0 ) {
+      row = &g_array_index(radio->rows, hpsdr_u_adc_row_t, radio->rows->len - 1);
+      if ( row->interval == interval ) { return row; }
+   }
+
+   g_array_set_size(radio->rows, radio->rows->len + 1);
+   row = &g_array_index(radio->rows, hpsdr_u_adc_row_t, radio->rows->len - 1);
+   memset(row, 0, sizeof(hpsdr_u_adc_row_t));
+   row->interval = interval;
+
+   return row;
+}
+
+static void hpsdr_u_adc_reset(void *tapdata)
+{
+   hpsdr_u_adc_t *adc = (hpsdr_u_adc_t *)tapdata;
+
+   g_hash_table_remove_all(adc->radios);
+}
+
+// The ADC1 gain settings the host sent to the radio.
+static void hpsdr_u_adc_gain(hpsdr_u_adc_radio_t *radio, const hpsdr_u_tap_info_t *tap_info)
+{
+   const hpsdr_u_tap_frame_t *frame = NULL;
+   int x = -1;
+
+   for (x = 0; x < HPSDR_U_FRAMES; x++) {
+      frame = &tap_info->frame[x];
+      if ( !frame->have_cc ) { continue; }
+
+      if ( frame->c0_type == ADC_C0_CONF ) {
+         radio->gain.alex_att = ( frame->cc[3] & HOST_C3_P_ATT ) * 10;
+         radio->gain.preamp = ( frame->cc[3] & HOST_C3_PREAM ) ? 1 : 0;
+      } else if ( frame->c0_type == ADC_C0_MISC ) {
+         radio->gain.step_att = ( frame->cc[4] & HOST_C4_HA_A ) ? ( frame->cc[4] & HOST_C4_A1_A ) : 0;
+      }
+   }
+}
+
+static tap_packet_status
+hpsdr_u_adc_packet(void *tapdata, packet_info *pinfo, epan_dissect_t *edt _U_, const void *data)
+{
+   hpsdr_u_adc_t *adc = (hpsdr_u_adc_t *)tapdata;
+   const hpsdr_u_tap_info_t *tap_info = (const hpsdr_u_tap_info_t *)data;
+   hpsdr_u_adc_radio_t *radio = NULL;
+   hpsdr_u_adc_row_t *row = NULL;
+   hpsdr_u_adc_stats_t stats;
+   const guint8 *samples = NULL;
+   int count = 0;
+
+   if ( tap_info->end_point == 2 ) {
+      hpsdr_u_adc_gain(hpsdr_u_adc_radio(adc, pinfo, tap_info), tap_info);
+      return TAP_PACKET_DONT_REDRAW;
+   }
+
+   // Only the datagram that completes a wide band buffer has it.
+   if ( tap_info->end_point != 4 || tap_info->ep4_buffer == NULL ) { return TAP_PACKET_DONT_REDRAW; }
+
+   radio = hpsdr_u_adc_radio(adc, pinfo, tap_info);
+
+   count = tvb_reported_length(tap_info->ep4_buffer) / 2;
+   samples = tvb_get_ptr(tap_info->ep4_buffer, 0, count * 2);
+
+   memset(&stats, 0, sizeof(stats));
+   hpsdr_u_adc_stats_add(&stats, samples, count);
+   hpsdr_u_adc_hist_add(radio->hist, samples, count);
+
+   if ( stats.rail > 0 && radio->stats.rail == 0 ) { radio->rail_frame = pinfo->num; }
+   hpsdr_u_adc_stats_merge(&radio->stats, &stats);
+   radio->buffers += 1;
+
+   if ( adc->interval > 0 ) {
+      if ( radio->rows == NULL ) { radio->rows = g_array_new(FALSE, FALSE, sizeof(hpsdr_u_adc_row_t)); }
+      row = hpsdr_u_adc_row(radio, (guint32)( nstime_to_sec(&pinfo->rel_ts) / adc->interval ));
+      hpsdr_u_adc_stats_merge(&row->stats, &stats);
+      row->gain = radio->gain;
+      row->buffers += 1;
+   }
+
+   return TAP_PACKET_REDRAW;
+}
+
+// Attenuator and preamp settings, "-" for the ones not seen yet.
+static const gchar *hpsdr_u_adc_gain_str(const hpsdr_u_adc_gain_t *gain, gchar *buf, gsize size)
+{
+   gchar alex[8];
+   gchar step[8];
+
+   if ( gain->alex_att < 0 ) { g_strlcpy(alex, "-", sizeof(alex)); }
+   else { g_snprintf(alex, sizeof(alex), "%d", gain->alex_att); }
+   if ( gain->step_att < 0 ) { g_strlcpy(step, "-", sizeof(step)); }
+   else { g_snprintf(step, sizeof(step), "%d", gain->step_att); }
+
+   g_snprintf(buf, size, "%5s %5s %4s", alex, step,
+              ( gain->preamp < 0 ) ? "-" : ( gain->preamp ? "On" : "Off" ));
+
+   return buf;
+}
+
+static void hpsdr_u_adc_csv(hpsdr_u_adc_t *adc, hpsdr_u_adc_radio_t *radio)
+{
+   FILE *fh = NULL;
+   gchar *file_name = NULL;
+   hpsdr_u_adc_row_t *row = NULL;
+   guint32 count = 0;
+   guint x = 0;
+   int code = 0;
+
+   file_name = hpsdr_u_tap_file_name(adc->csv_prefix, radio->name, ".csv");
+   fh = ws_fopen(file_name, "w");
+   if ( fh == NULL ) {
+      fprintf(stderr, "tshark: hpsdr-u,adc can not open %s\n", file_name);
+      g_free(file_name);
+      return;
+   }
+
+   fprintf(fh, "radio,start_s,buffers,samples,min,max,dc,rms_dbfs,peak_dbfs,peak_bits,near_rail,rail,"
+               "alex_att_db,step_att_db,preamp\n");
+
+   for (x = 0; radio->rows != NULL && x < radio->rows->len; x++) {
+      row = &g_array_index(radio->rows, hpsdr_u_adc_row_t, x);
+
+      fprintf(fh, "%s,%.3f,%u,%u,%d,%d,%.2f,%.2f,%.2f,%.2f,%u,%u,", radio->name, row->interval * adc->interval,
+              row->buffers, row->stats.count, row->stats.min, row->stats.max, hpsdr_u_adc_dc(&row->stats),
+              hpsdr_u_adc_rms_dbfs(&row->stats), hpsdr_u_adc_peak_dbfs(&row->stats),
+              hpsdr_u_adc_peak_bits(&row->stats), row->stats.near_rail, row->stats.rail);
+
+      if ( row->gain.alex_att >= 0 ) { fprintf(fh, "%d", row->gain.alex_att); }
+      fprintf(fh, ",");
+      if ( row->gain.step_att >= 0 ) { fprintf(fh, "%d", row->gain.step_att); }
+      fprintf(fh, ",");
+      if ( row->gain.preamp >= 0 ) { fprintf(fh, "%d", row->gain.preamp); }
+      fprintf(fh, "\n");
+   }
+
+   fclose(fh);
+   g_free(file_name);
+
+   file_name = hpsdr_u_tap_file_name(adc->csv_prefix, radio->name, "_hist.csv");
+   fh = ws_fopen(file_name, "w");
+   if ( fh == NULL ) {
+      fprintf(stderr, "tshark: hpsdr-u,adc can not open %s\n", file_name);
+      g_free(file_name);
+      return;
+   }
+
+   fprintf(fh, "code,samples\n");
+   for (code = -32768; code <= 32767; code++) {
+      count = hpsdr_u_adc_hist_count(radio->hist, code);
+      if ( count > 0 ) { fprintf(fh, "%d,%u\n", code, count); }
+   }
+
+   fclose(fh);
+   g_free(file_name);
+}
+
+static void hpsdr_u_adc_draw(void *tapdata)
+{
+   hpsdr_u_adc_t *adc = (hpsdr_u_adc_t *)tapdata;
+   hpsdr_u_adc_radio_t *radio = NULL;
+   hpsdr_u_adc_row_t *row = NULL;
+   hpsdr_u_adc_stats_t *stats = NULL;
+   GList *radios = NULL;
+   GList *item = NULL;
+   gchar gain[32];
+   guint x = 0;
+
+   radios = hpsdr_u_tap_radio_list(adc->radios);
+
+   printf("\n");
+   printf("===================================================================\n");
+   printf("HPSDR-USB EP4 Raw ADC Samples - 0 dBFS is a sample of 2^15\n");
+
+   for (item = radios; item != NULL; item = item->next) {
+      radio = (hpsdr_u_adc_radio_t *)item->data;
+      if ( radio->buffers == 0 ) { continue; }
+
+      stats = &radio->stats;
+      printf("\nRadio: %s  Wide Band Buffers: %u  Samples: %u\n", radio->name, radio->buffers, stats->count);
+      printf("  Min: %d  Max: %d  DC: %.2f\n", stats->min, stats->max, hpsdr_u_adc_dc(stats));
+      printf("  RMS: %.2f dBFS  Peak: %.2f dBFS\n", hpsdr_u_adc_rms_dbfs(stats), hpsdr_u_adc_peak_dbfs(stats));
+      printf("  Bits Used: %.2f peak to peak, %.2f effective (histogram)\n",
+             hpsdr_u_adc_peak_bits(stats), hpsdr_u_adc_hist_bits(radio->hist));
+      printf("  Near Rail (99%%): %u  At Rail: %u", stats->near_rail, stats->rail);
+      if ( stats->rail > 0 ) { printf("  First at Rail: Frame %u", radio->rail_frame); }
+      printf("\n");
+      printf("  Alex Att dB, Step Att dB, Preamp: %s\n", hpsdr_u_adc_gain_str(&radio->gain, gain, sizeof(gain)));
+
+      if ( radio->rows != NULL ) {
+         printf(" Interval: %.3f s\n", adc->interval);
+         printf("  Start s  Buffers     Min     Max       DC  RMS dBFS  Peak dBFS  Bits  Near Rail   Rail  Alex  Step  Pre\n");
+         for (x = 0; x < radio->rows->len; x++) {
+            row = &g_array_index(radio->rows, hpsdr_u_adc_row_t, x);
+            stats = &row->stats;
+            printf("%9.3f %8u %7d %7d %8.2f %9.2f %10.2f %5.2f %10u %6u %s\n", row->interval * adc->interval,
+                   row->buffers, stats->min, stats->max, hpsdr_u_adc_dc(stats), hpsdr_u_adc_rms_dbfs(stats),
+                   hpsdr_u_adc_peak_dbfs(stats), hpsdr_u_adc_peak_bits(stats), stats->near_rail, stats->rail,
+                   hpsdr_u_adc_gain_str(&row->gain, gain, sizeof(gain)));
+         }
+      }
+
+      if ( adc->csv_prefix != NULL ) { hpsdr_u_adc_csv(adc, radio); }
+   }
+
+   printf("===================================================================\n");
+
+   g_list_free(radios);
+}
+
+static void hpsdr_u_adc_finish(void *tapdata)
+{
+   hpsdr_u_adc_t *adc = (hpsdr_u_adc_t *)tapdata;
+
+   g_hash_table_destroy(adc->radios);
+   g_free(adc->csv_prefix);
+   g_free(adc);
+}
+
+static void hpsdr_u_adc_init(const char *opt_arg, void *userdata _U_)
+{
+   hpsdr_u_adc_t *adc = NULL;
+   gchar **args = NULL;
+   const gchar *filter = NULL;
+
+   args = hpsdr_u_tap_args(opt_arg, "hpsdr-u,adc", 2, &filter);
+
+   adc = g_new0(hpsdr_u_adc_t, 1);
+   adc->interval = hpsdr_u_tap_number(args[0], "hpsdr-u,adc", "interval", 0);
+   if ( adc->interval < 0 ) { adc->interval = 0; }
+   if ( args[1][0] != '\0' ) { adc->csv_prefix = g_strdup(args[1]); }
+   adc->radios = hpsdr_u_tap_radio_table(hpsdr_u_adc_radio_free);
+   g_strfreev(args);
+
+   hpsdr_u_tap_listen("hpsdr-u,adc", adc, filter, hpsdr_u_adc_reset,
+                      hpsdr_u_adc_packet, hpsdr_u_adc_draw, hpsdr_u_adc_finish);
+}
+
+static stat_tap_ui hpsdr_u_adc_ui = {
+   REGISTER_STAT_GROUP_GENERIC,
+   NULL,
+   "hpsdr-u,adc",
+   hpsdr_u_adc_init,
+   0,
+   NULL
+};
+
+void register_hpsdr_u_adc_tap(void)
+{
+   register_stat_tap_ui(&hpsdr_u_adc_ui, NULL);
+}
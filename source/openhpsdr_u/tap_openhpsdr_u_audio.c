@@ -0,0 +1,377 @@
+/* tap_openhpsdr_u_audio.c
+ * OpenHPSDR USB over IP protocol Mic/Line and host audio to WAV files
+ *
+ * Version: 0.5.0
+ * Author:  Matthew J Wolf, N4MTT
+ *
+ * This file is part of the OpenHPSDR-USB Plug-in for Wireshark.
+ * Matthew J. Wolf <matthew.wolf.hpsdr@speciosus.net>
+ * Copyright 2020 Matthew J. Wolf
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * The OpenHPSDR-USB Plug-in for Wireshark is free software: you can
+ * redistribute it and/or modify it under the terms of the GNU
+ * General Public License as published by the Free Software Foundation,
+ * either version 2 of the License, or (at your option) any later version.
+ *
+ * The OpenHPSDR-USB Plug-in for Wireshark is distributed in the hope that
+ * it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See
+ * the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the OpenHPSDR-USB Plug-in for Wireshark.
+ * If not, see <http://www.gnu.org/licenses/>.
+ *
+ * tshark -z hpsdr-u,audio,<file prefix>[,<filter>]
+ *
+ * Writes two 16 bit 48kHz WAV files for every radio:
+ *  <file prefix>_<radio>_mic.wav   EP6 Mic/Line samples (mono)
+ *  <file prefix>_<radio>_host.wav  EP2 Left and Right audio samples (stereo)
+ *
+ * The Mic/Line samples are sent at 48kHz. At the higher IQ sample rates
+ * only every 2nd (96kHz), 4th (192kHz) or 8th (384kHz) Mic/Line sample is
+ * written. The samples are written as the datagrams are tapped, a radio
+ * only holds a small buffer per file.
+ */
+
+#include <epan/packet.h>
+#include <epan/tap.h>
+#include <epan/stat_tap_ui.h>
+#include <wsutil/file_util.h>
+
+#include <stdlib.h>
+#include <string.h>
+#include "tap_openhpsdr_u.h"
+#include "iq_openhpsdr_u.h"
+
+#define HPSDR_U_WAV_BUF    4096  // Samples buffered before a write
+#define HPSDR_U_WAV_HEADER 44
+
+typedef struct _hpsdr_u_wav_t {
+   FILE    *fh;
+   gchar   *file_name;
+   guint16  channels;
+   guint32  frames;              // Sample frames written
+   gboolean full;                // The RIFF sizes are at the 4 GiB limit
+   guint    buf_used;            // Bytes in buf
+   guint8   buf[HPSDR_U_WAV_BUF * 2];
+} hpsdr_u_wav_t;
+
+typedef struct _hpsdr_u_audio_radio_t {
+   gchar *name;
+   hpsdr_u_wav_t *mic;
+   hpsdr_u_wav_t *host;
+   guint32 mic_phase;            // Mic/Line sample count, used for the decimation
+   guint32 ep6_unknown_rx;       // EP6 datagrams skipped, number of receivers unknown
+} hpsdr_u_audio_radio_t;
+
+typedef struct _hpsdr_u_audio_t {
+   gchar *prefix;
+   GHashTable *radios;
+} hpsdr_u_audio_t;
+
+static void put_le16(guint8 *p, guint16 v)
+{
+   p[0] = (guint8)( v & 0xFF );
+   p[1] = (guint8)( v >> 8 );
+}
+
+static void put_le32(guint8 *p, guint32 v)
+{
+   p[0] = (guint8)( v & 0xFF );
+   p[1] = (guint8)(( v >> 8 ) & 0xFF );
+   p[2] = (guint8)(( v >> 16 ) & 0xFF );
+   p[3] = (guint8)( v >> 24 );
+}
+
+// The sizes in the RIFF header are filled in by hpsdr_u_wav_update().
+// hpsdr_u_wav_room() keeps 36 + data_size within 32 bits.
+static void hpsdr_u_wav_header(hpsdr_u_wav_t *wav, guint8 *h)
+{
+   guint32 data_size = wav->frames * wav->channels * 2;
+
+   memcpy(h, "RIFF", 4);
+   put_le32(h + 4, 36 + data_size);
+   memcpy(h + 8, "WAVEfmt ", 8);
+   put_le32(h + 16, 16);
+   put_le16(h + 20, 1);                                   // PCM
+   put_le16(h + 22, wav->channels);
+   put_le32(h + 24, HPSDR_U_AUDIO_RATE);
+   put_le32(h + 28, HPSDR_U_AUDIO_RATE * wav->channels * 2); // Byte rate
+   put_le16(h + 32, wav->channels * 2);                   // Block align
+   put_le16(h + 34, 16);                                  // Bits per sample
+   memcpy(h + 36, "data", 4);
+   put_le32(h + 40, data_size);
+}
+
+static hpsdr_u_wav_t *hpsdr_u_wav_open(const gchar *file_name, guint16 channels)
+{
+   hpsdr_u_wav_t *wav = NULL;
+   guint8 header[HPSDR_U_WAV_HEADER];
+
+   wav = g_new0(hpsdr_u_wav_t, 1);
+   wav->channels = channels;
+   wav->file_name = g_strdup(file_name);
+   wav->fh = ws_fopen(file_name, "wb");
+
+   if ( wav->fh == NULL ) {
+      fprintf(stderr, "tshark: hpsdr-u,audio can not open %s\n", file_name);
+      return wav;
+   }
+
+   hpsdr_u_wav_header(wav, header);
+   if ( fwrite(header, 1, HPSDR_U_WAV_HEADER, wav->fh) != HPSDR_U_WAV_HEADER ) {
+      fclose(wav->fh);
+      wav->fh = NULL;
+   }
+
+   return wav;
+}
+
+static void hpsdr_u_wav_flush(hpsdr_u_wav_t *wav)
+{
+   if ( wav->fh != NULL && wav->buf_used > 0 ) {
+      if ( fwrite(wav->buf, 1, wav->buf_used, wav->fh) != wav->buf_used ) {
+         fclose(wav->fh);
+         wav->fh = NULL;
+      }
+   }
+   wav->buf_used = 0;
+}
+
+// TRUE when one more sample frame fits. The RIFF sizes are 32 bits, the
+// file ends at 4 GiB (6.2 hours of 48 kHz stereo) with a warning.
+static gboolean hpsdr_u_wav_room(hpsdr_u_wav_t *wav)
+{
+   if ( ( (guint64)wav->frames + 1 ) * wav->channels * 2 + 36 <= G_MAXUINT32 ) { return TRUE; }
+
+   if ( !wav->full ) {
+      wav->full = TRUE;
+      fprintf(stderr, "tshark: hpsdr-u,audio %s is at the 4 GiB WAV limit, the rest is not written\n",
+              wav->file_name);
+   }
+
+   return FALSE;
+}
+
+// Big endian sample from the datagram, little endian in the file.
+static void hpsdr_u_wav_put(hpsdr_u_wav_t *wav, const guint8 *be_sample)
+{
+   if ( wav->fh == NULL ) { return; }
+
+   wav->buf[wav->buf_used] = be_sample[1];
+   wav->buf[wav->buf_used + 1] = be_sample[0];
+   wav->buf_used += 2;
+
+   if ( wav->buf_used == sizeof(wav->buf) ) { hpsdr_u_wav_flush(wav); }
+}
+
+// Write the buffered samples and the sizes in the header. The file is
+// complete after every update.
+static void hpsdr_u_wav_update(hpsdr_u_wav_t *wav)
+{
+   guint8 header[HPSDR_U_WAV_HEADER];
+
+   hpsdr_u_wav_flush(wav);
+
+   if ( wav->fh == NULL ) { return; }
+
+   hpsdr_u_wav_header(wav, header);
+   if ( fseek(wav->fh, 0, SEEK_SET) == 0 ) {
+      if ( fwrite(header, 1, HPSDR_U_WAV_HEADER, wav->fh) == HPSDR_U_WAV_HEADER ) {
+         fseek(wav->fh, 0, SEEK_END);
+      }
+   }
+   fflush(wav->fh);
+}
+
+static void hpsdr_u_wav_close(hpsdr_u_wav_t *wav)
+{
+   if ( wav == NULL ) { return; }
+
+   hpsdr_u_wav_update(wav);
+   if ( wav->fh != NULL ) { fclose(wav->fh); }
+   g_free(wav->file_name);
+   g_free(wav);
+}
+
+static void hpsdr_u_audio_radio_free(gpointer record)
+{
+   hpsdr_u_audio_radio_t *radio = (hpsdr_u_audio_radio_t *)record;
+
+   hpsdr_u_wav_close(radio->mic);
+   hpsdr_u_wav_close(radio->host);
+   hpsdr_u_tap_radio_free(radio);
+}
+
+static hpsdr_u_audio_radio_t *hpsdr_u_audio_radio(hpsdr_u_audio_t *audio, const gchar *radio_name)
+{
+   hpsdr_u_audio_radio_t *radio = NULL;
+   gchar *file_name = NULL;
+
+   radio = (hpsdr_u_audio_radio_t *)hpsdr_u_tap_radio_lookup(audio->radios, radio_name,
+                                                             sizeof(hpsdr_u_audio_radio_t));
+   if ( radio->mic == NULL ) {
+      file_name = hpsdr_u_tap_file_name(audio->prefix, radio_name, "_mic.wav");
+      radio->mic = hpsdr_u_wav_open(file_name, 1);
+      g_free(file_name);
+
+      file_name = hpsdr_u_tap_file_name(audio->prefix, radio_name, "_host.wav");
+      radio->host = hpsdr_u_wav_open(file_name, 2);
+      g_free(file_name);
+   }
+
+   return radio;
+}
+
+static void hpsdr_u_audio_reset(void *tapdata)
+{
+   hpsdr_u_audio_t *audio = (hpsdr_u_audio_t *)tapdata;
+
+   g_hash_table_remove_all(audio->radios);
+}
+
+static tap_packet_status
+hpsdr_u_audio_packet(void *tapdata, packet_info *pinfo, epan_dissect_t *edt _U_, const void *data)
+{
+   hpsdr_u_audio_t *audio = (hpsdr_u_audio_t *)tapdata;
+   const hpsdr_u_tap_info_t *tap_info = (const hpsdr_u_tap_info_t *)data;
+   hpsdr_u_audio_radio_t *radio = NULL;
+   const guint8 *p = NULL;
+
+   int samp_num = -1;
+   int stride = -1;
+   int x = -1;
+   int y = -1;
+   guint32 step = 1;
+
+   if ( tap_info->end_point != 2 && tap_info->end_point != 6 ) {
+      return TAP_PACKET_DONT_REDRAW;
+   }
+
+   radio = hpsdr_u_audio_radio(audio, hpsdr_u_tap_radio_name(pinfo, tap_info));
+
+   if ( tap_info->end_point == 6 ) {
+
+      // The Mic/Line sample follows the IQ samples of every receiver.
+      samp_num = hpsdr_u_ep6_samples(tap_info->rx_num);
+      if ( samp_num == 0 ) {
+         radio->ep6_unknown_rx += 1;
+         return TAP_PACKET_DONT_REDRAW;
+      }
+
+      stride = hpsdr_u_ep6_layout(tap_info->rx_num)->stride;
+      step = 1 << tap_info->speed_num;
+
+      for (x = 0; x < HPSDR_U_FRAMES; x++) {
+         if ( tap_info->frame[x].data == NULL ) { continue; }
+
+         p = tap_info->frame[x].data + ( tap_info->rx_num * 6 );
+         for (y = 0; y < samp_num; y++) {
+            if ( ( radio->mic_phase % step ) == 0 && hpsdr_u_wav_room(radio->mic) ) {
+               hpsdr_u_wav_put(radio->mic, p);
+               radio->mic->frames += 1;
+            }
+            radio->mic_phase += 1;
+            p += stride;
+         }
+      }
+
+   } else {
+
+      // L R I Q, 16 bits each.
+      for (x = 0; x < HPSDR_U_FRAMES; x++) {
+         if ( tap_info->frame[x].data == NULL ) { continue; }
+
+         p = tap_info->frame[x].data;
+         for (y = 0; y < HPSDR_U_EP2_SAMPLES && hpsdr_u_wav_room(radio->host); y++) {
+            hpsdr_u_wav_put(radio->host, p);
+            hpsdr_u_wav_put(radio->host, p + 2);
+            radio->host->frames += 1;
+            p += 8;
+         }
+      }
+   }
+
+   return TAP_PACKET_REDRAW;
+}
+
+static void hpsdr_u_audio_draw(void *tapdata)
+{
+   hpsdr_u_audio_t *audio = (hpsdr_u_audio_t *)tapdata;
+   hpsdr_u_audio_radio_t *radio = NULL;
+   GList *radios = NULL;
+   GList *item = NULL;
+
+   printf("\n");
+   printf("===================================================================\n");
+   printf("HPSDR-USB Audio - 16 bit %d Hz WAV\n", HPSDR_U_AUDIO_RATE);
+   printf("Radio                   Stream     Seconds  File\n");
+
+   radios = hpsdr_u_tap_radio_list(audio->radios);
+   for (item = radios; item != NULL; item = item->next) {
+      radio = (hpsdr_u_audio_radio_t *)item->data;
+
+      hpsdr_u_wav_update(radio->mic);
+      hpsdr_u_wav_update(radio->host);
+
+      printf("%-22s  Mic/Line %9.2f  %s%s\n", radio->name,
+             (double)radio->mic->frames / HPSDR_U_AUDIO_RATE, radio->mic->file_name,
+             radio->mic->full ? " (4 GiB limit, not complete)" : "");
+      printf("%-22s  Host L/R %9.2f  %s%s\n", "",
+             (double)radio->host->frames / HPSDR_U_AUDIO_RATE, radio->host->file_name,
+             radio->host->full ? " (4 GiB limit, not complete)" : "");
+
+      if ( radio->ep6_unknown_rx > 0 ) {
+         printf("%-22s  %u EP6 datagrams skipped, number of receivers not known.\n",
+                "", radio->ep6_unknown_rx);
+      }
+   }
+   g_list_free(radios);
+
+   printf("===================================================================\n");
+}
+
+static void hpsdr_u_audio_finish(void *tapdata)
+{
+   hpsdr_u_audio_t *audio = (hpsdr_u_audio_t *)tapdata;
+
+   g_hash_table_destroy(audio->radios);
+   g_free(audio->prefix);
+   g_free(audio);
+}
+
+static void hpsdr_u_audio_init(const char *opt_arg, void *userdata _U_)
+{
+   hpsdr_u_audio_t *audio = NULL;
+   gchar **args = NULL;
+   const gchar *filter = NULL;
+
+   args = hpsdr_u_tap_args(opt_arg, "hpsdr-u,audio", 1, &filter);
+
+   audio = g_new0(hpsdr_u_audio_t, 1);
+   audio->prefix = g_strdup(args[0][0] != '\0' ? args[0] : "hpsdr-u");
+   audio->radios = hpsdr_u_tap_radio_table(hpsdr_u_audio_radio_free);
+   g_strfreev(args);
+
+   hpsdr_u_tap_listen("hpsdr-u,audio", audio, filter, hpsdr_u_audio_reset,
+                      hpsdr_u_audio_packet, hpsdr_u_audio_draw, hpsdr_u_audio_finish);
+}
+
+static stat_tap_ui hpsdr_u_audio_ui = {
+   REGISTER_STAT_GROUP_GENERIC,
+   NULL,
+   "hpsdr-u,audio",
+   hpsdr_u_audio_init,
+   0,
+   NULL
+};
+
+void register_hpsdr_u_audio_tap(void)
+{
+   register_stat_tap_ui(&hpsdr_u_audio_ui, NULL);
+}
@@ -0,0 +1,410 @@
+/* tap_openhpsdr_u_burst.c
+ * OpenHPSDR USB over IP protocol EP6 and EP4 micro-bursts and receive buffer size
+ *
+ * Version: 0.5.0
+ * Author:  Matthew J Wolf, N4MTT
+ *
+ * This file is part of the OpenHPSDR-USB Plug-in for Wireshark.
+ * Matthew J. Wolf <matthew.wolf.hpsdr@speciosus.net>
+ * Copyright 2020 Matthew J. Wolf
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * The OpenHPSDR-USB Plug-in for Wireshark is free software: you can
+ * redistribute it and/or modify it under the terms of the GNU
+ * General Public License as published by the Free Software Foundation,
+ * either version 2 of the License, or (at your option) any later version.
+ *
+ * The OpenHPSDR-USB Plug-in for Wireshark is distributed in the hope that
+ * it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See
+ * the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the OpenHPSDR-USB Plug-in for Wireshark.
+ * If not, see <http://www.gnu.org/licenses/>.
+ *
+ * tshark -z hpsdr-u,burst[,<drain datagrams/s>[,<filter>]]
+ *
+ * Micro-bursts of the datagrams from a radio to a host. EP6 and EP4 go to
+ * the same host socket, they are one stream for the bursts and the receive
+ * buffer. For every radio and host:
+ *
+ *  - EP6 and EP4 inter-arrival histograms, BURST_DECADE bins per decade
+ *    from 1 us to 1 s. The percentiles are the upper edge of the bin.
+ *  - The most datagrams in a 1 ms, 10 ms and 100 ms window against the
+ *    nominal EP6 datagrams (number of receivers and speed) in the window.
+ *  - The receive buffer that would have held the datagrams: a queue that
+ *    the host drains at a rate, the largest queue is the smallest buffer.
+ *    The drain is 1.05, 1.25 and 2 times the nominal EP6 rate and
+ *    <drain datagrams/s> when given.
+ *
+ * A Linux socket counts the kernel buffer of a datagram (truesize), not
+ * the 1032 bytes. BURST_TRUESIZE is the usual truesize of a 1032 byte
+ * datagram, the rmem size is a estimate for net.core.rmem_max and
+ * SO_RCVBUF.
+ */
+
+#include <epan/packet.h>
+#include <epan/tap.h>
+#include <epan/stat_tap_ui.h>
+
+#include <math.h>
+#include <string.h>
+#include "tap_openhpsdr_u.h"
+
+#define BURST_DATAGRAM  1032    // Bytes of a EP6 or EP4 datagram
+#define BURST_TRUESIZE  2304    // Linux receive buffer bytes of a datagram
+#define BURST_DECADE    20      // Histogram bins per decade
+#define BURST_DECADES   6       // 1 us to 1 s
+#define BURST_BINS      ( ( BURST_DECADE * BURST_DECADES ) + 2 ) // Less than 1 us, 1 s or more
+#define BURST_EP        2       // EP6, EP4
+#define BURST_WINDOWS   3
+#define BURST_DRAINS    4       // Three times the nominal rate, the given rate
+#define BURST_COMPACT   4096    // Arrivals dropped from the window list at a time
+
+static const double hpsdr_u_burst_windows[BURST_WINDOWS] = { 0.001, 0.010, 0.100 };
+static const double hpsdr_u_burst_factors[BURST_DRAINS - 1] = { 1.05, 1.25, 2.0 };
+static const gchar *hpsdr_u_burst_ep_names[BURST_EP] = { "EP6", "EP4" };
+
+typedef struct _hpsdr_u_burst_arrival_t {
+   double time;
+   guint32 frame_num;
+} hpsdr_u_burst_arrival_t;
+
+typedef struct _hpsdr_u_burst_window_t {
+   guint head;                  // First arrival in the window
+   guint32 datagrams;           // In the window
+   guint32 worst;               // Most datagrams in the window
+   double nominal;              // Nominal EP6 datagrams of the window at the worst
+   double start;                // Of the worst
+   guint32 start_frame;
+   guint32 end_frame;
+} hpsdr_u_burst_window_t;
+
+typedef struct _hpsdr_u_burst_drain_t {
+   double queue;                // Datagrams
+   double time;                 // Of the queue
+   double rate;                 // Datagrams per second at the largest queue
+   double largest;
+   double largest_time;
+   guint32 largest_frame;
+} hpsdr_u_burst_drain_t;
+
+typedef struct _hpsdr_u_burst_link_t {
+   gchar *name;                 // <radio>-<host>
+   gchar *radio;
+   gchar *host;
+   guint32 hist[BURST_EP][BURST_BINS];
+   guint32 datagrams[BURST_EP];
+   double first[BURST_EP];
+   double last[BURST_EP];
+   double longest[BURST_EP];    // Inter-arrival
+   double nominal;              // Nominal EP6 datagrams per second, 0 not known
+   GArray *arrivals;            // hpsdr_u_burst_arrival_t, the last window and a few
+   hpsdr_u_burst_window_t window[BURST_WINDOWS];
+   hpsdr_u_burst_drain_t drain[BURST_DRAINS];
+} hpsdr_u_burst_link_t;
+
+typedef struct _hpsdr_u_burst_t {
+   double drain_rate;           // Datagrams per second, 0 not given
+   GHashTable *links;
+} hpsdr_u_burst_t;
+
+static void hpsdr_u_burst_link_free(gpointer record)
+{
+   hpsdr_u_burst_link_t *link = (hpsdr_u_burst_link_t *)record;
+
+   if ( link->arrivals != NULL ) { g_array_free(link->arrivals, TRUE); }
+   hpsdr_u_tap_link_free(link);
+}
+
+static void hpsdr_u_burst_reset(void *tapdata)
+{
+   hpsdr_u_burst_t *burst = (hpsdr_u_burst_t *)tapdata;
+
+   g_hash_table_remove_all(burst->links);
+}
+
+static int hpsdr_u_burst_bin(double seconds)
+{
+   int bin = 0;
+
+   if ( seconds < 1e-6 ) { return 0; }
+
+   bin = (int)floor(log10(seconds / 1e-6) * BURST_DECADE) + 1;
+   if ( bin >= BURST_BINS ) { bin = BURST_BINS - 1; }
+
+   return bin;
+}
+
+// Lower edge of a bin in seconds.
+static double hpsdr_u_burst_edge(int bin)
+{
+   if ( bin <= 0 ) { return 0; }
+
+   return 1e-6 * pow(10.0, (double)( bin - 1 ) / BURST_DECADE);
+}
+
+static void hpsdr_u_burst_windows_add(hpsdr_u_burst_link_t *link, double now, guint32 frame_num)
+{
+   hpsdr_u_burst_arrival_t arrival;
+   hpsdr_u_burst_arrival_t *head = NULL;
+   hpsdr_u_burst_window_t *window = NULL;
+   guint oldest = 0;
+   int w = -1;
+
+   arrival.time = now;
+   arrival.frame_num = frame_num;
+   g_array_append_val(link->arrivals, arrival);
+
+   for (w = 0; w < BURST_WINDOWS; w++) {
+      window = &link->window[w];
+      window->datagrams += 1;
+
+      while ( g_array_index(link->arrivals, hpsdr_u_burst_arrival_t, window->head).time <=
+              now - hpsdr_u_burst_windows[w] ) {
+         window->head += 1;
+         window->datagrams -= 1;
+      }
+
+      if ( window->datagrams > window->worst ) {
+         head = &g_array_index(link->arrivals, hpsdr_u_burst_arrival_t, window->head);
+         window->worst = window->datagrams;
+         window->nominal = link->nominal * hpsdr_u_burst_windows[w];
+         window->start = head->time;
+         window->start_frame = head->frame_num;
+         window->end_frame = frame_num;
+      }
+   }
+
+   // The longest window has the oldest head.
+   oldest = link->window[BURST_WINDOWS - 1].head;
+   if ( oldest >= BURST_COMPACT ) {
+      g_array_remove_range(link->arrivals, 0, oldest);
+      for (w = 0; w < BURST_WINDOWS; w++) { link->window[w].head -= oldest; }
+   }
+}
+
+static void hpsdr_u_burst_drains_add(hpsdr_u_burst_t *burst, hpsdr_u_burst_link_t *link, double now,
+                                     guint32 frame_num)
+{
+   hpsdr_u_burst_drain_t *drain = NULL;
+   double rate = 0;
+   int d = -1;
+
+   for (d = 0; d < BURST_DRAINS; d++) {
+      drain = &link->drain[d];
+      rate = ( d < BURST_DRAINS - 1 ) ? hpsdr_u_burst_factors[d] * link->nominal : burst->drain_rate;
+      if ( rate <= 0 ) { continue; }
+
+      drain->queue -= rate * ( now - drain->time );
+      if ( drain->queue < 0 ) { drain->queue = 0; }
+      drain->queue += 1;
+      drain->time = now;
+
+      if ( drain->queue > drain->largest ) {
+         drain->largest = drain->queue;
+         drain->largest_time = now;
+         drain->largest_frame = frame_num;
+         drain->rate = rate;
+      }
+   }
+}
+
+static tap_packet_status
+hpsdr_u_burst_packet(void *tapdata, packet_info *pinfo, epan_dissect_t *edt _U_, const void *data)
+{
+   hpsdr_u_burst_t *burst = (hpsdr_u_burst_t *)tapdata;
+   const hpsdr_u_tap_info_t *tap_info = (const hpsdr_u_tap_info_t *)data;
+   hpsdr_u_burst_link_t *link = NULL;
+   double now = 0;
+   double gap = 0;
+   int samples = 0;
+   int ep = 0;
+
+   if ( tap_info->end_point != 6 && tap_info->end_point != 4 ) { return TAP_PACKET_DONT_REDRAW; }
+   ep = ( tap_info->end_point == 6 ) ? 0 : 1;
+
+   link = (hpsdr_u_burst_link_t *)hpsdr_u_tap_link_lookup(burst->links, pinfo, tap_info, sizeof(hpsdr_u_burst_link_t));
+   if ( link->arrivals == NULL ) {
+      link->arrivals = g_array_new(FALSE, FALSE, sizeof(hpsdr_u_burst_arrival_t));
+   }
+
+   now = nstime_to_sec(&pinfo->rel_ts);
+
+   if ( tap_info->end_point == 6 ) {
+      samples = HPSDR_U_FRAMES * hpsdr_u_ep6_samples(tap_info->rx_num);
+      if ( samples > 0 ) { link->nominal = (double)( HPSDR_U_AUDIO_RATE << tap_info->speed_num ) / samples; }
+   }
+
+   if ( link->datagrams[ep] == 0 ) {
+      link->first[ep] = now;
+   } else {
+      gap = now - link->last[ep];
+      link->hist[ep][hpsdr_u_burst_bin(gap)] += 1;
+      if ( gap > link->longest[ep] ) { link->longest[ep] = gap; }
+   }
+   link->datagrams[ep] += 1;
+   link->last[ep] = now;
+
+   hpsdr_u_burst_windows_add(link, now, pinfo->num);
+   hpsdr_u_burst_drains_add(burst, link, now, pinfo->num);
+
+   return TAP_PACKET_REDRAW;
+}
+
+// Upper edge in seconds of the bin of a percentile of the inter-arrival times.
+static double hpsdr_u_burst_percentile(const hpsdr_u_burst_link_t *link, int ep, double percent)
+{
+   guint32 count = link->datagrams[ep] - 1;
+   guint32 rank = 0;
+   guint32 sum = 0;
+   int bin = 0;
+
+   rank = (guint32)ceil(percent / 100.0 * count);
+   if ( rank == 0 ) { rank = 1; }
+
+   for (bin = 0; bin < BURST_BINS - 1; bin++) {
+      sum += link->hist[ep][bin];
+      if ( sum >= rank ) { break; }
+   }
+
+   return ( bin < BURST_BINS - 1 ) ? MIN(hpsdr_u_burst_edge(bin + 1), link->longest[ep]) : link->longest[ep];
+}
+
+static void hpsdr_u_burst_link_draw(hpsdr_u_burst_link_t *link)
+{
+   hpsdr_u_burst_window_t *window = NULL;
+   hpsdr_u_burst_drain_t *drain = NULL;
+   guint32 sum[BURST_EP] = { 0, 0 };
+   double span = 0;
+   int bin = 0;
+   int ep = 0;
+   int w = 0;
+   int d = 0;
+
+   printf("\nRadio: %s  Host: %s\n", link->radio, link->host);
+   for (ep = 0; ep < BURST_EP; ep++) {
+      if ( link->datagrams[ep] == 0 ) { continue; }
+      span = link->last[ep] - link->first[ep];
+      printf(" %s Datagrams: %u  Rate: %.1f/s", hpsdr_u_burst_ep_names[ep], link->datagrams[ep],
+             ( span > 0 ) ? ( link->datagrams[ep] - 1 ) / span : 0.0);
+      if ( ep == 0 && link->nominal > 0 ) { printf("  Nominal: %.1f/s", link->nominal); }
+      printf("\n");
+      if ( link->datagrams[ep] < 2 ) { continue; }
+      printf("  Inter-arrival us  p50: %.1f  p99: %.1f  p99.9: %.1f  Max: %.1f\n",
+             hpsdr_u_burst_percentile(link, ep, 50) * 1e6, hpsdr_u_burst_percentile(link, ep, 99) * 1e6,
+             hpsdr_u_burst_percentile(link, ep, 99.9) * 1e6, link->longest[ep] * 1e6);
+   }
+
+   printf(" Inter-arrival histogram, bins that are not empty\n");
+   printf("      From us       To us        EP6     Cum %%        EP4     Cum %%\n");
+   for (bin = 0; bin < BURST_BINS; bin++) {
+      if ( link->hist[0][bin] == 0 && link->hist[1][bin] == 0 ) { continue; }
+
+      printf(" %12.1f", hpsdr_u_burst_edge(bin) * 1e6);
+      if ( bin < BURST_BINS - 1 ) {
+         printf(" %11.1f", hpsdr_u_burst_edge(bin + 1) * 1e6);
+      } else {
+         printf(" %11s", "-");
+      }
+      for (ep = 0; ep < BURST_EP; ep++) {
+         sum[ep] += link->hist[ep][bin];
+         printf(" %10u %8.3f", link->hist[ep][bin],
+                ( link->datagrams[ep] > 1 ) ? 100.0 * sum[ep] / ( link->datagrams[ep] - 1 ) : 0.0);
+      }
+      printf("\n");
+   }
+
+   printf(" Worst bursts (EP6 and EP4)\n");
+   printf("  Window ms  Datagrams  Nominal EP6   Ratio      Start s  Start Frame  End Frame\n");
+   for (w = 0; w < BURST_WINDOWS; w++) {
+      window = &link->window[w];
+      printf(" %10.0f %10u %12.1f", hpsdr_u_burst_windows[w] * 1000, window->worst, window->nominal);
+      if ( window->nominal > 0 ) {
+         printf(" %7.2f", window->worst / window->nominal);
+      } else {
+         printf(" %7s", "-");
+      }
+      printf(" %12.6f %12u %10u\n", window->start, window->start_frame, window->end_frame);
+   }
+
+   printf(" Receive buffer that holds the bursts\n");
+   printf("  Drain            Rate/s  Datagrams  Payload KiB  rmem bytes      Time s       Frame\n");
+   for (d = 0; d < BURST_DRAINS; d++) {
+      drain = &link->drain[d];
+      if ( drain->largest <= 0 ) { continue; }
+      if ( d < BURST_DRAINS - 1 ) {
+         printf("  %4.2f x Nominal", hpsdr_u_burst_factors[d]);
+      } else {
+         printf("  %-15s", "Given");
+      }
+      printf(" %7.1f %10.0f %12.1f %11.0f %11.6f %11u\n", drain->rate, ceil(drain->largest),
+             ceil(drain->largest) * BURST_DATAGRAM / 1024.0, ceil(drain->largest) * BURST_TRUESIZE,
+             drain->largest_time, drain->largest_frame);
+   }
+}
+
+static void hpsdr_u_burst_draw(void *tapdata)
+{
+   hpsdr_u_burst_t *burst = (hpsdr_u_burst_t *)tapdata;
+   GList *links = NULL;
+   GList *item = NULL;
+
+   links = hpsdr_u_tap_radio_list(burst->links);
+
+   printf("\n");
+   printf("===================================================================\n");
+   printf("HPSDR-USB EP6 and EP4 Micro-bursts and Receive Buffer Size\n");
+
+   for (item = links; item != NULL; item = item->next) {
+      hpsdr_u_burst_link_draw((hpsdr_u_burst_link_t *)item->data);
+   }
+
+   printf("===================================================================\n");
+
+   g_list_free(links);
+}
+
+static void hpsdr_u_burst_finish(void *tapdata)
+{
+   hpsdr_u_burst_t *burst = (hpsdr_u_burst_t *)tapdata;
+
+   g_hash_table_destroy(burst->links);
+   g_free(burst);
+}
+
+static void hpsdr_u_burst_init(const char *opt_arg, void *userdata _U_)
+{
+   hpsdr_u_burst_t *burst = NULL;
+   gchar **args = NULL;
+   const gchar *filter = NULL;
+
+   args = hpsdr_u_tap_args(opt_arg, "hpsdr-u,burst", 1, &filter);
+
+   burst = g_new0(hpsdr_u_burst_t, 1);
+   burst->drain_rate = hpsdr_u_tap_number(args[0], "hpsdr-u,burst", "drain datagrams/s", 0);
+   if ( burst->drain_rate < 0 ) { burst->drain_rate = 0; }
+   burst->links = hpsdr_u_tap_radio_table(hpsdr_u_burst_link_free);
+   g_strfreev(args);
+
+   hpsdr_u_tap_listen("hpsdr-u,burst", burst, filter, hpsdr_u_burst_reset,
+                      hpsdr_u_burst_packet, hpsdr_u_burst_draw, hpsdr_u_burst_finish);
+}
+
+static stat_tap_ui hpsdr_u_burst_ui = {
+   REGISTER_STAT_GROUP_GENERIC,
+   NULL,
+   "hpsdr-u,burst",
+   hpsdr_u_burst_init,
+   0,
+   NULL
+};
+
+void register_hpsdr_u_burst_tap(void)
+{
+   register_stat_tap_ui(&hpsdr_u_burst_ui, NULL);
+}
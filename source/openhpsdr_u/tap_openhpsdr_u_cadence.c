@@ -0,0 +1,287 @@
+/* tap_openhpsdr_u_cadence.c
+ * OpenHPSDR USB over IP protocol EP2 C&C register refresh cadence
+ *
+ * Version: 0.5.0
+ * Author:  Matthew J Wolf, N4MTT
+ *
+ * This file is part of the OpenHPSDR-USB Plug-in for Wireshark.
+ * Matthew J. Wolf <matthew.wolf.hpsdr@speciosus.net>
+ * Copyright 2020 Matthew J. Wolf
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * The OpenHPSDR-USB Plug-in for Wireshark is free software: you can
+ * redistribute it and/or modify it under the terms of the GNU
+ * General Public License as published by the Free Software Foundation,
+ * either version 2 of the License, or (at your option) any later version.
+ *
+ * The OpenHPSDR-USB Plug-in for Wireshark is distributed in the hope that
+ * it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See
+ * the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the OpenHPSDR-USB Plug-in for Wireshark.
+ * If not, see <http://www.gnu.org/licenses/>.
+ *
+ * tshark -z hpsdr-u,cadence[,<filter>]
+ *
+ * The host sends the registers (C0 Types) in a rotation, two USB frames
+ * per EP2 datagram. For every host and register: the frames sent in USB
+ * frame 1 and 2, how often the value changed, the refresh interval in
+ * datagrams (p50, p99, max) and in ms, and the worst staleness, the
+ * longest time without a refresh, up to the end of the capture. The core
+ * registers (C0 Type 0x00 to 0x12) that are never sent and the first full
+ * rotation are listed.
+ *
+ * Only counts are kept, the memory does not grow with the capture.
+ */
+
+#include <epan/packet.h>
+#include <epan/tap.h>
+#include <epan/stat_tap_ui.h>
+
+#include <stdlib.h>
+#include <string.h>
+#include "tap_openhpsdr_u.h"
+
+#define CADENCE_REGS      64    // EP2 C0 Types, 6 bits
+#define CADENCE_CORE_LAST 0x12  // Last core C0 Type
+#define CADENCE_GAPS      256   // Refresh intervals counted one by one, the last counts the longer ones
+#define CADENCE_ROTATION  64    // Longest rotation listed
+
+typedef struct _hpsdr_u_cadence_reg_t {
+   guint32 frames;
+   guint32 slot[HPSDR_U_FRAMES]; // Frames sent in USB frame 1 and 2
+   guint32 changed;             // Value not the same as the last time it was sent
+   guint32 value;               // C1 to C4
+   guint32 last_datagram;       // Datagram number of the host, from 1
+   double last_time;
+   double worst;                // Longest seconds between sends
+   guint32 max_gap;             // Longest datagrams between sends
+   guint32 gap[CADENCE_GAPS];   // Refresh intervals in datagrams, 0 is both frames
+} hpsdr_u_cadence_reg_t;
+
+typedef struct _hpsdr_u_cadence_host_t {
+   gchar *name;
+   guint32 datagrams;           // EP2 datagrams
+   guint32 both_same;           // Datagrams with the same C0 Type in both USB frames
+   double first_time;
+   double last_time;
+   hpsdr_u_cadence_reg_t reg[CADENCE_REGS];
+   guint8 rotation[CADENCE_ROTATION]; // First rotation, from the first C0 Type 0x00
+   int rotation_len;            // -1 when it is complete
+} hpsdr_u_cadence_host_t;
+
+typedef struct _hpsdr_u_cadence_t {
+   GHashTable *hosts;
+} hpsdr_u_cadence_t;
+
+static void hpsdr_u_cadence_reset(void *tapdata)
+{
+   hpsdr_u_cadence_t *cadence = (hpsdr_u_cadence_t *)tapdata;
+
+   g_hash_table_remove_all(cadence->hosts);
+}
+
+static void hpsdr_u_cadence_rotation(hpsdr_u_cadence_host_t *host, guint8 r)
+{
+   if ( host->rotation_len < 0 ) { return; }
+   if ( host->rotation_len == 0 && r != 0x00 ) { return; }
+
+   if ( host->rotation_len > 0 && r == 0x00 ) {
+      host->rotation_len = -host->rotation_len;
+      return;
+   }
+
+   if ( host->rotation_len < CADENCE_ROTATION ) {
+      host->rotation[host->rotation_len] = r;
+      host->rotation_len += 1;
+   }
+}
+
+static tap_packet_status
+hpsdr_u_cadence_packet(void *tapdata, packet_info *pinfo, epan_dissect_t *edt _U_, const void *data)
+{
+   hpsdr_u_cadence_t *cadence = (hpsdr_u_cadence_t *)tapdata;
+   const hpsdr_u_tap_info_t *tap_info = (const hpsdr_u_tap_info_t *)data;
+   const hpsdr_u_tap_frame_t *frame = NULL;
+   hpsdr_u_cadence_host_t *host = NULL;
+   hpsdr_u_cadence_reg_t *reg = NULL;
+   guint32 value = 0;
+   guint32 gap = 0;
+   double now = 0;
+   guint8 r = 0;
+   int x = -1;
+
+   if ( tap_info->end_point != 2 ) { return TAP_PACKET_DONT_REDRAW; }
+
+   host = (hpsdr_u_cadence_host_t *)hpsdr_u_tap_radio_lookup(cadence->hosts, hpsdr_u_tap_host_name(pinfo, tap_info),
+                                                             sizeof(hpsdr_u_cadence_host_t));
+
+   now = nstime_to_sec(&pinfo->rel_ts);
+   if ( host->datagrams == 0 ) { host->first_time = now; }
+   host->datagrams += 1;
+   host->last_time = now;
+
+   if ( tap_info->frame[0].have_cc && tap_info->frame[1].have_cc &&
+        ( ( tap_info->frame[0].cc[0] ^ tap_info->frame[1].cc[0] ) & 0x7E ) == 0 ) { host->both_same += 1; }
+
+   for (x = 0; x < HPSDR_U_FRAMES; x++) {
+      frame = &tap_info->frame[x];
+      if ( !frame->have_cc ) { continue; }
+
+      // Bit 7 is RQST on a Hermes-Lite2, it is not part of the register.
+      r = ( frame->cc[0] >> 1 ) & ( CADENCE_REGS - 1 );
+      value = ( (guint32)frame->cc[1] << 24 ) | ( frame->cc[2] << 16 ) | ( frame->cc[3] << 8 ) | frame->cc[4];
+      reg = &host->reg[r];
+
+      if ( reg->frames > 0 ) {
+         gap = host->datagrams - reg->last_datagram;
+         reg->gap[MIN(gap, CADENCE_GAPS - 1)] += 1;
+         if ( gap > reg->max_gap ) { reg->max_gap = gap; }
+         if ( now - reg->last_time > reg->worst ) { reg->worst = now - reg->last_time; }
+         if ( value != reg->value ) { reg->changed += 1; }
+      }
+
+      reg->frames += 1;
+      reg->slot[x] += 1;
+      reg->value = value;
+      reg->last_datagram = host->datagrams;
+      reg->last_time = now;
+
+      hpsdr_u_cadence_rotation(host, r);
+   }
+
+   return TAP_PACKET_REDRAW;
+}
+
+// Nearest rank percentile of the refresh intervals in datagrams.
+static guint32 hpsdr_u_cadence_percentile(const hpsdr_u_cadence_reg_t *reg, double percent)
+{
+   guint32 count = reg->frames - 1;
+   guint32 rank = 0;
+   guint32 sum = 0;
+   guint32 gap = 0;
+
+   rank = (guint32)( percent / 100.0 * count + 0.999999 );
+   if ( rank == 0 ) { rank = 1; }
+
+   for (gap = 0; gap < CADENCE_GAPS; gap++) {
+      sum += reg->gap[gap];
+      if ( sum >= rank ) { break; }
+   }
+
+   return ( gap >= CADENCE_GAPS - 1 ) ? reg->max_gap : gap;
+}
+
+static void hpsdr_u_cadence_draw(void *tapdata)
+{
+   hpsdr_u_cadence_t *cadence = (hpsdr_u_cadence_t *)tapdata;
+   hpsdr_u_cadence_host_t *host = NULL;
+   hpsdr_u_cadence_reg_t *reg = NULL;
+   GList *hosts = NULL;
+   GList *item = NULL;
+   double period = 0;
+   double worst = 0;
+   guint32 p50 = 0;
+   guint32 p99 = 0;
+   gboolean first = TRUE;
+   int len = 0;
+   int r = -1;
+
+   hosts = hpsdr_u_tap_radio_list(cadence->hosts);
+
+   printf("\n");
+   printf("===================================================================\n");
+   printf("HPSDR-USB EP2 C&C Register Refresh Cadence - intervals in EP2 datagrams\n");
+
+   for (item = hosts; item != NULL; item = item->next) {
+      host = (hpsdr_u_cadence_host_t *)item->data;
+
+      period = ( host->datagrams > 1 ) ? ( host->last_time - host->first_time ) / ( host->datagrams - 1 ) : 0;
+
+      printf("\nHost: %s  EP2 Datagrams: %u  Datagram Period: %.3f ms\n", host->name, host->datagrams, period * 1000);
+      printf(" Datagrams with the same C0 Type in both USB frames: %u (%.2f%%)\n", host->both_same,
+             ( host->datagrams > 0 ) ? 100.0 * host->both_same / host->datagrams : 0.0);
+
+      printf(" C0    Register                  Frames  Frame 1  Frame 2  Changed  p50  p99  Max   p50 ms   p99 ms  Worst ms\n");
+      for (r = 0; r < CADENCE_REGS; r++) {
+         reg = &host->reg[r];
+         if ( reg->frames == 0 ) { continue; }
+
+         // Time since the last send counts when it is longer.
+         worst = MAX(reg->worst, host->last_time - reg->last_time);
+
+         printf(" 0x%02X  %-24s %7u %8u %8u %8u", r, hpsdr_u_tap_c0_name((guint8)r), reg->frames,
+                reg->slot[0], reg->slot[1], reg->changed);
+         if ( reg->frames > 1 ) {
+            p50 = hpsdr_u_cadence_percentile(reg, 50);
+            p99 = hpsdr_u_cadence_percentile(reg, 99);
+            printf(" %4u %4u %4u %8.3f %8.3f", p50, p99, reg->max_gap, p50 * period * 1000, p99 * period * 1000);
+         } else {
+            printf(" %4s %4s %4s %8s %8s", "-", "-", "-", "-", "-");
+         }
+         printf(" %9.3f\n", worst * 1000);
+      }
+
+      first = TRUE;
+      for (r = 0; r <= CADENCE_CORE_LAST; r++) {
+         if ( host->reg[r].frames > 0 ) { continue; }
+         printf("%s 0x%02X %s", first ? " Not sent:" : ",", r, hpsdr_u_tap_c0_name((guint8)r));
+         first = FALSE;
+      }
+      if ( !first ) { printf("\n"); }
+
+      len = ABS(host->rotation_len);
+      if ( len > 0 ) {
+         printf(" %s:", ( host->rotation_len < 0 ) ? "Rotation" : "Rotation (not complete)");
+         for (r = 0; r < len; r++) { printf(" %02X", host->rotation[r]); }
+         printf("\n");
+      }
+   }
+
+   printf("===================================================================\n");
+
+   g_list_free(hosts);
+}
+
+static void hpsdr_u_cadence_finish(void *tapdata)
+{
+   hpsdr_u_cadence_t *cadence = (hpsdr_u_cadence_t *)tapdata;
+
+   g_hash_table_destroy(cadence->hosts);
+   g_free(cadence);
+}
+
+static void hpsdr_u_cadence_init(const char *opt_arg, void *userdata _U_)
+{
+   hpsdr_u_cadence_t *cadence = NULL;
+   gchar **args = NULL;
+   const gchar *filter = NULL;
+
+   args = hpsdr_u_tap_args(opt_arg, "hpsdr-u,cadence", 0, &filter);
+   g_strfreev(args);
+
+   cadence = g_new0(hpsdr_u_cadence_t, 1);
+   cadence->hosts = hpsdr_u_tap_radio_table(NULL);
+
+   hpsdr_u_tap_listen("hpsdr-u,cadence", cadence, filter, hpsdr_u_cadence_reset,
+                      hpsdr_u_cadence_packet, hpsdr_u_cadence_draw, hpsdr_u_cadence_finish);
+}
+
+static stat_tap_ui hpsdr_u_cadence_ui = {
+   REGISTER_STAT_GROUP_GENERIC,
+   NULL,
+   "hpsdr-u,cadence",
+   hpsdr_u_cadence_init,
+   0,
+   NULL
+};
+
+void register_hpsdr_u_cadence_tap(void)
+{
+   register_stat_tap_ui(&hpsdr_u_cadence_ui, NULL);
+}
@@ -0,0 +1,470 @@
+/* tap_openhpsdr_u_clock.c
+ * OpenHPSDR USB over IP protocol radio sample clock offset and drift
+ *
+ * Version: 0.5.0
+ * Author:  Matthew J Wolf, N4MTT
+ *
+ * This file is part of the OpenHPSDR-USB Plug-in for Wireshark.
+ * Matthew J. Wolf <matthew.wolf.hpsdr@speciosus.net>
+ * Copyright 2020 Matthew J. Wolf
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * The OpenHPSDR-USB Plug-in for Wireshark is free software: you can
+ * redistribute it and/or modify it under the terms of the GNU
+ * General Public License as published by the Free Software Foundation,
+ * either version 2 of the License, or (at your option) any later version.
+ *
+ * The OpenHPSDR-USB Plug-in for Wireshark is distributed in the hope that
+ * it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See
+ * the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the OpenHPSDR-USB Plug-in for Wireshark.
+ * If not, see <http://www.gnu.org/licenses/>.
+ *
+ * tshark -z hpsdr-u,clock[,<window seconds>[,<filter>]]
+ *
+ * Sample clock of every radio against the capture clock. The radio time of
+ * a EP6 datagram is the samples before it divided by the sample rate. The
+ * missing datagrams (sequence numbers) are counted with the layout and
+ * speed of the datagram before them, lost datagrams do not move the radio
+ * time. Late (out of order) datagrams are not used. Sequence numbers that
+ * go back (the radio was stopped and started) or jump far ahead start a new
+ * run with radio time 0.
+ *
+ * The network and the host only delay a datagram. In every window of
+ * <window seconds> (10 when not given) the datagram with the least delay,
+ * the smallest capture time less radio time, is kept. A second order least
+ * squares fit of the kept delays against the capture time, every run with
+ * its own intercept, gives the offset in ppm (in the middle of the capture)
+ * and the drift in ppm per hour. A
+ * radio that is fast has a positive offset. The capture clock error is in
+ * every radio the same, the difference between radios is not changed by it.
+ *
+ * The radios are grouped by the 10 MHz and 122.88 MHz sources of the last
+ * EP2 C0=0x00 USB frame sent to them. Radios locked to the same 10 MHz
+ * reference differ by the fit error.
+ */
+
+#include <epan/packet.h>
+#include <epan/tap.h>
+#include <epan/stat_tap_ui.h>
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include "tap_openhpsdr_u.h"
+#include "sample_openhpsdr_u.h"
+#include "cc_openhpsdr_u.h"
+
+#define CLOCK_WINDOW    10.0    // Default window seconds
+#define CLOCK_SEGMENTS  8       // Offsets listed over the capture
+
+static const gchar *hpsdr_u_clock_10mhz_names[4] = { "Atlas / Excalibur", "Penelope", "Mercury", "Not Defined" };
+
+typedef struct _hpsdr_u_clock_point_t {
+   double time;                 // Capture time, seconds
+   double delay;                // Capture time less radio time, seconds
+   guint32 run;                 // Run of sequence numbers
+} hpsdr_u_clock_point_t;
+
+typedef struct _hpsdr_u_clock_radio_t {
+   gchar *name;
+   guint32 datagrams;
+   guint32 missing;
+   guint32 late;
+   guint32 restarts;            // Runs after the first
+   guint32 unknown_rx;          // EP6 datagrams before the number of receivers is known
+   gboolean started;
+   guint32 last_seq;
+   double period;               // Radio time of the last datagram
+   double radio_time;           // Of the last datagram, from the start of the run
+   double first;                // Capture time of the first datagram
+   double run_first;            // Capture time of the first datagram of the run
+   gint64 window;               // Window of the kept point, -1 none
+   hpsdr_u_clock_point_t best;  // Least delay of the window
+   GArray *points;              // hpsdr_u_clock_point_t, one per window
+   int ref_10mhz;               // -1 not known
+   int ref_122;                 // 0 Penelope, 1 Mercury, -1 not known
+} hpsdr_u_clock_radio_t;
+
+typedef struct _hpsdr_u_clock_fit_t {
+   gboolean ok;
+   double ppm;                  // In the middle of the points
+   double drift;                // ppm per hour, second order fit only
+   double rms;                  // Delay residual, seconds
+} hpsdr_u_clock_fit_t;
+
+typedef struct _hpsdr_u_clock_t {
+   double window;
+   GHashTable *radios;
+} hpsdr_u_clock_t;
+
+static void hpsdr_u_clock_radio_free(gpointer record)
+{
+   hpsdr_u_clock_radio_t *radio = (hpsdr_u_clock_radio_t *)record;
+
+   if ( radio->points != NULL ) { g_array_free(radio->points, TRUE); }
+   hpsdr_u_tap_radio_free(radio);
+}
+
+static void hpsdr_u_clock_reset(void *tapdata)
+{
+   hpsdr_u_clock_t *clock = (hpsdr_u_clock_t *)tapdata;
+
+   g_hash_table_remove_all(clock->radios);
+}
+
+static hpsdr_u_clock_radio_t *hpsdr_u_clock_radio(hpsdr_u_clock_t *clock, packet_info *pinfo,
+                                                  const hpsdr_u_tap_info_t *tap_info)
+{
+   hpsdr_u_clock_radio_t *radio = NULL;
+
+   radio = (hpsdr_u_clock_radio_t *)hpsdr_u_tap_radio_lookup(clock->radios, hpsdr_u_tap_radio_name(pinfo, tap_info),
+                                                             sizeof(hpsdr_u_clock_radio_t));
+   if ( radio->points == NULL ) {
+      radio->points = g_array_new(FALSE, FALSE, sizeof(hpsdr_u_clock_point_t));
+      radio->window = -1;
+      radio->ref_10mhz = -1;
+      radio->ref_122 = -1;
+   }
+
+   return radio;
+}
+
+static void hpsdr_u_clock_ep2(hpsdr_u_clock_radio_t *radio, const hpsdr_u_tap_info_t *tap_info)
+{
+   const hpsdr_u_tap_frame_t *frame = NULL;
+   int x = -1;
+
+   for (x = 0; x < HPSDR_U_FRAMES; x++) {
+      frame = &tap_info->frame[x];
+
+      // Bit 7 is RQST on a Hermes-Lite2.
+      if ( !frame->have_cc || ( ( frame->cc[0] >> 1 ) & 0x3F ) != 0x00 ) { continue; }
+
+      radio->ref_10mhz = ( frame->cc[1] & HOST_C1_10MHZ ) >> 2;
+      radio->ref_122 = ( frame->cc[1] & HOST_C1_122S ) ? 1 : 0;
+   }
+}
+
+static void hpsdr_u_clock_ep6(hpsdr_u_clock_t *clock, hpsdr_u_clock_radio_t *radio,
+                              const hpsdr_u_tap_info_t *tap_info, double now)
+{
+   gint32 delta = 0;
+   gint64 window = 0;
+   double delay = 0;
+   int samples = 0;
+
+   samples = HPSDR_U_FRAMES * hpsdr_u_ep6_samples(tap_info->rx_num);
+   if ( samples == 0 ) {
+      radio->unknown_rx += 1;
+      return;
+   }
+
+   if ( radio->started ) {
+      delta = (gint32)( tap_info->seq - radio->last_seq );
+   }
+
+   if ( !radio->started ) {
+      radio->first = now;
+      radio->run_first = now;
+      radio->started = TRUE;
+   } else if ( delta < -HPSDR_U_SAMPLE_LATE_MAX || delta > HPSDR_U_SAMPLE_GAP_MAX ) {
+      // Restarted sequence numbers. The kept point of the window ends the run.
+      if ( radio->window >= 0 ) { g_array_append_val(radio->points, radio->best); }
+      radio->window = -1;
+      radio->restarts += 1;
+      radio->radio_time = 0;
+      radio->run_first = now;
+   } else if ( delta <= 0 ) {
+      radio->late += 1;
+      return;
+   } else {
+      radio->missing += delta - 1;
+      radio->radio_time += delta * radio->period;
+   }
+
+   radio->datagrams += 1;
+   radio->last_seq = tap_info->seq;
+   radio->period = (double)samples / ( HPSDR_U_AUDIO_RATE << tap_info->speed_num );
+
+   // Least delay of the window. The first datagram of a run is radio time 0.
+   delay = ( now - radio->run_first ) - radio->radio_time;
+   window = (gint64)floor(( now - radio->first ) / clock->window);
+   if ( window > radio->window ) {
+      if ( radio->window >= 0 ) { g_array_append_val(radio->points, radio->best); }
+      radio->window = window;
+      radio->best.time = now;
+      radio->best.delay = delay;
+      radio->best.run = radio->restarts;
+   } else if ( delay < radio->best.delay ) {
+      radio->best.time = now;
+      radio->best.delay = delay;
+   }
+}
+
+static tap_packet_status
+hpsdr_u_clock_packet(void *tapdata, packet_info *pinfo, epan_dissect_t *edt _U_, const void *data)
+{
+   hpsdr_u_clock_t *clock = (hpsdr_u_clock_t *)tapdata;
+   const hpsdr_u_tap_info_t *tap_info = (const hpsdr_u_tap_info_t *)data;
+   hpsdr_u_clock_radio_t *radio = NULL;
+
+   if ( tap_info->end_point != 2 && tap_info->end_point != 6 ) { return TAP_PACKET_DONT_REDRAW; }
+
+   radio = hpsdr_u_clock_radio(clock, pinfo, tap_info);
+
+   if ( tap_info->end_point == 2 ) {
+      hpsdr_u_clock_ep2(radio, tap_info);
+   } else {
+      hpsdr_u_clock_ep6(clock, radio, tap_info, nstime_to_sec(&pinfo->rel_ts));
+   }
+
+   return TAP_PACKET_REDRAW;
+}
+
+// Least squares fit of order 1 or 2 of the delay against the capture time,
+// points from to to - 1. The capture time is centered and scaled to -1 .. 1.
+// Every run has its own radio time origin, the delays and the terms of a run
+// are taken from their means in the run (a intercept per run).
+static hpsdr_u_clock_fit_t hpsdr_u_clock_fit(GArray *points, guint from, guint to, int order)
+{
+   hpsdr_u_clock_fit_t fit;
+   hpsdr_u_clock_point_t *point = NULL;
+   double a[2][3];
+   double rhs[2] = { 0, 0 };
+   double coef[2] = { 0, 0 };
+   double mean[3];
+   double u[2];
+   double mid = 0;
+   double half = 0;
+   double x = 0;
+   double dy = 0;
+   double ratio = 0;
+   double sum_sq = 0;
+   guint runs = 0;
+   guint run_end = 0;
+   guint i = 0;
+   guint j = 0;
+   int n = order;
+   int r = 0;
+   int c = 0;
+   int k = 0;
+
+   memset(&fit, 0, sizeof(fit));
+   memset(a, 0, sizeof(a));
+   if ( to <= from ) { return fit; }
+
+   mid = ( g_array_index(points, hpsdr_u_clock_point_t, from).time +
+           g_array_index(points, hpsdr_u_clock_point_t, to - 1).time ) / 2;
+   half = ( g_array_index(points, hpsdr_u_clock_point_t, to - 1).time -
+            g_array_index(points, hpsdr_u_clock_point_t, from).time ) / 2;
+   if ( half <= 0 ) { return fit; }
+
+   // Normal equations of the terms less their run means
+   for (i = from; i < to; i = run_end) {
+      memset(mean, 0, sizeof(mean));
+      for (run_end = i; run_end < to; run_end++) {
+         point = &g_array_index(points, hpsdr_u_clock_point_t, run_end);
+         if ( point->run != g_array_index(points, hpsdr_u_clock_point_t, i).run ) { break; }
+         x = ( point->time - mid ) / half;
+         mean[0] += x;
+         mean[1] += x * x;
+         mean[2] += point->delay;
+      }
+      for (k = 0; k < 3; k++) { mean[k] /= ( run_end - i ); }
+
+      for (j = i; j < run_end; j++) {
+         point = &g_array_index(points, hpsdr_u_clock_point_t, j);
+         x = ( point->time - mid ) / half;
+         u[0] = x - mean[0];
+         u[1] = ( x * x ) - mean[1];
+         dy = point->delay - mean[2];
+         for (r = 0; r < n; r++) {
+            for (c = 0; c < n; c++) { a[r][c] += u[r] * u[c]; }
+            a[r][n] += u[r] * dy;
+         }
+         sum_sq += dy * dy;
+      }
+      runs += 1;
+   }
+
+   if ( to - from < runs + n + 1 ) { return fit; }
+   for (r = 0; r < n; r++) { rhs[r] = a[r][n]; }
+
+   // Gaussian elimination, the matrix is symmetric positive definite.
+   for (k = 0; k < n; k++) {
+      if ( fabs(a[k][k]) < 1e-12 ) { return fit; }
+      for (r = k + 1; r < n; r++) {
+         ratio = a[r][k] / a[k][k];
+         for (c = k; c <= n; c++) { a[r][c] -= ratio * a[k][c]; }
+      }
+   }
+   for (r = n - 1; r >= 0; r--) {
+      coef[r] = a[r][n];
+      for (c = r + 1; c < n; c++) { coef[r] -= a[r][c] * coef[c]; }
+      coef[r] /= a[r][r];
+   }
+
+   // Residual sum of squares of a least squares fit
+   for (r = 0; r < n; r++) { sum_sq -= coef[r] * rhs[r]; }
+   if ( sum_sq < 0 ) { sum_sq = 0; }
+
+   // The delay falls when the radio clock is fast.
+   fit.ok = TRUE;
+   fit.ppm = -coef[0] / half * 1e6;
+   fit.drift = ( order == 2 ) ? -2.0 * coef[1] / ( half * half ) * 1e6 * 3600.0 : 0;
+   fit.rms = sqrt(sum_sq / ( to - from ));
+
+   return fit;
+}
+
+static void hpsdr_u_clock_radio_draw(hpsdr_u_clock_radio_t *radio)
+{
+   hpsdr_u_clock_fit_t fit;
+   hpsdr_u_clock_point_t *point = NULL;
+   guint from = 0;
+   guint to = 0;
+   int s = 0;
+
+   printf("\nRadio: %s\n", radio->name);
+   printf(" EP6 Datagrams: %u  Missing: %u  Late: %u  Number of Receivers not Known: %u\n", radio->datagrams,
+          radio->missing, radio->late, radio->unknown_rx);
+   printf(" Sequence Restarts: %u\n", radio->restarts);
+   printf(" 10 MHz Source: %s  122.88 MHz Source: %s\n",
+          ( radio->ref_10mhz >= 0 ) ? hpsdr_u_clock_10mhz_names[radio->ref_10mhz] : "Not Known",
+          ( radio->ref_122 < 0 ) ? "Not Known" : ( radio->ref_122 ? "Mercury" : "Penelope" ));
+   printf(" Windows: %u  Capture Time: %.3f s\n", radio->points->len,
+          ( radio->points->len > 0 ) ? g_array_index(radio->points, hpsdr_u_clock_point_t, radio->points->len - 1).time - radio->first : 0.0);
+
+   fit = hpsdr_u_clock_fit(radio->points, 0, radio->points->len, 2);
+   if ( !fit.ok ) {
+      fit = hpsdr_u_clock_fit(radio->points, 0, radio->points->len, 1);
+   }
+   if ( !fit.ok ) {
+      printf(" Not enough windows for a fit\n");
+      return;
+   }
+
+   printf(" Offset: %+.3f ppm  Drift: %+.4f ppm/hour  Fit Residual: %.1f us\n", fit.ppm, fit.drift, fit.rms * 1e6);
+
+   if ( radio->points->len < CLOCK_SEGMENTS * 3 ) { return; }
+
+   printf("  Capture Time s   Offset ppm\n");
+   for (s = 0; s < CLOCK_SEGMENTS; s++) {
+      from = ( radio->points->len * s ) / CLOCK_SEGMENTS;
+      to = ( radio->points->len * ( s + 1 ) ) / CLOCK_SEGMENTS;
+      fit = hpsdr_u_clock_fit(radio->points, from, to, 1);
+      point = &g_array_index(radio->points, hpsdr_u_clock_point_t, from);
+      if ( fit.ok ) { printf(" %15.1f %+12.3f\n", point->time, fit.ppm); }
+   }
+}
+
+static void hpsdr_u_clock_draw(void *tapdata)
+{
+   hpsdr_u_clock_t *clock = (hpsdr_u_clock_t *)tapdata;
+   hpsdr_u_clock_radio_t *radio = NULL;
+   hpsdr_u_clock_fit_t fit;
+   GList *radios = NULL;
+   GList *item = NULL;
+   double low = 0;
+   double high = 0;
+   int fitted = 0;
+   int ref = 0;
+
+   radios = hpsdr_u_tap_radio_list(clock->radios);
+
+   printf("\n");
+   printf("===================================================================\n");
+   printf("HPSDR-USB Radio Sample Clock - ppm of the capture clock, window %.1f s\n", clock->window);
+
+   for (item = radios; item != NULL; item = item->next) {
+      radio = (hpsdr_u_clock_radio_t *)item->data;
+      if ( radio->datagrams == 0 ) { continue; }
+
+      // The last window is kept at the end of the capture.
+      if ( radio->window >= 0 ) {
+         g_array_append_val(radio->points, radio->best);
+         radio->window = -1;
+      }
+
+      hpsdr_u_clock_radio_draw(radio);
+   }
+
+   // Radios by 10 MHz source. -1 is not known.
+   printf("\nRadios by 10 MHz Source\n");
+   for (ref = -1; ref < 4; ref++) {
+      fitted = 0;
+      for (item = radios; item != NULL; item = item->next) {
+         radio = (hpsdr_u_clock_radio_t *)item->data;
+         if ( radio->datagrams == 0 || radio->ref_10mhz != ref ) { continue; }
+
+         fit = hpsdr_u_clock_fit(radio->points, 0, radio->points->len, 1);
+         if ( !fit.ok ) { continue; }
+
+         if ( fitted == 0 ) {
+            printf(" %s\n", ( ref >= 0 ) ? hpsdr_u_clock_10mhz_names[ref] : "Not Known");
+            low = fit.ppm;
+            high = fit.ppm;
+         }
+         if ( fit.ppm < low ) { low = fit.ppm; }
+         if ( fit.ppm > high ) { high = fit.ppm; }
+         printf("  %-28s %+10.3f ppm  Residual %.1f us\n", radio->name, fit.ppm, fit.rms * 1e6);
+         fitted += 1;
+      }
+      if ( fitted > 1 ) { printf("  Spread: %.3f ppm\n", high - low); }
+   }
+
+   printf("===================================================================\n");
+
+   g_list_free(radios);
+}
+
+static void hpsdr_u_clock_finish(void *tapdata)
+{
+   hpsdr_u_clock_t *clock = (hpsdr_u_clock_t *)tapdata;
+
+   g_hash_table_destroy(clock->radios);
+   g_free(clock);
+}
+
+static void hpsdr_u_clock_init(const char *opt_arg, void *userdata _U_)
+{
+   hpsdr_u_clock_t *clock = NULL;
+   gchar **args = NULL;
+   const gchar *filter = NULL;
+
+   args = hpsdr_u_tap_args(opt_arg, "hpsdr-u,clock", 1, &filter);
+
+   clock = g_new0(hpsdr_u_clock_t, 1);
+   clock->window = hpsdr_u_tap_number(args[0], "hpsdr-u,clock", "window seconds", CLOCK_WINDOW);
+   if ( clock->window <= 0 ) {
+      fprintf(stderr, "tshark: hpsdr-u,clock window seconds %s is not more than 0\n", args[0]);
+      g_strfreev(args);
+      exit(1);
+   }
+   clock->radios = hpsdr_u_tap_radio_table(hpsdr_u_clock_radio_free);
+   g_strfreev(args);
+
+   hpsdr_u_tap_listen("hpsdr-u,clock", clock, filter, hpsdr_u_clock_reset,
+                      hpsdr_u_clock_packet, hpsdr_u_clock_draw, hpsdr_u_clock_finish);
+}
+
+static stat_tap_ui hpsdr_u_clock_ui = {
+   REGISTER_STAT_GROUP_GENERIC,
+   NULL,
+   "hpsdr-u,clock",
+   hpsdr_u_clock_init,
+   0,
+   NULL
+};
+
+void register_hpsdr_u_clock_tap(void)
+{
+   register_stat_tap_ui(&hpsdr_u_clock_ui, NULL);
+}
@@ -0,0 +1,433 @@
+/* tap_openhpsdr_u_confirm.c
+ * OpenHPSDR USB over IP protocol C&C register change to radio confirmation latency
+ *
+ * Version: 0.5.0
+ * Author:  Matthew J Wolf, N4MTT
+ *
+ * This file is part of the OpenHPSDR-USB Plug-in for Wireshark.
+ * Matthew J. Wolf <matthew.wolf.hpsdr@speciosus.net>
+ * Copyright 2020 Matthew J. Wolf
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * The OpenHPSDR-USB Plug-in for Wireshark is free software: you can
+ * redistribute it and/or modify it under the terms of the GNU
+ * General Public License as published by the Free Software Foundation,
+ * either version 2 of the License, or (at your option) any later version.
+ *
+ * The OpenHPSDR-USB Plug-in for Wireshark is distributed in the hope that
+ * it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See
+ * the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the OpenHPSDR-USB Plug-in for Wireshark.
+ * If not, see <http://www.gnu.org/licenses/>.
+ *
+ * tshark -z hpsdr-u,confirm[,<csv file prefix>[,<filter>]]
+ *
+ * Time from a EP2 register (C0 Type) value change to the first EP6 USB
+ * frame that confirms it, per radio and host and per register. The first
+ * value seen of a register is not a change. A register is confirmed by:
+ *
+ *  ACK   Hermes-Lite2 ACK, a EP6 C0 with bit 7 set that echoes the register
+ *        and the new C1 to C4 (the host set RQST).
+ *  Freq  NCO (C0 Type 0x01 to 0x08), a EP6 C0 Type 0x00 frame with the C1
+ *        "frequency changed" bit set.
+ *  Rate  Speed (C0 Type 0x00 C1 bits 0 and 1), the first of
+ *        CONFIRM_WINDOW EP6 datagrams that arrive at the new sample rate.
+ *
+ * The other changes can only be confirmed by a ACK. A change made again
+ * before it was confirmed is counted as superseded. The latencies are at
+ * the capture point, they have the network both ways in them.
+ *
+ *  <csv file prefix>_<radio>-<host>.csv  Every confirmed change
+ */
+
+#include <epan/packet.h>
+#include <epan/tap.h>
+#include <epan/stat_tap_ui.h>
+#include <wsutil/file_util.h>
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include "tap_openhpsdr_u.h"
+#include "cc_openhpsdr_u.h"
+
+#define CONFIRM_REGS      64     // EP2 C0 Types, 6 bits
+#define CONFIRM_SPEED     64     // Speed bits of C0 Type 0x00, kept as a register of its own
+#define CONFIRM_NUM       65
+#define CONFIRM_C0_ACK    0x80   // EP2 RQST, EP6 Hermes-Lite2 ACK
+#define CONFIRM_NCO_FIRST 0x01
+#define CONFIRM_NCO_LAST  0x08
+#define CONFIRM_WINDOW    8      // EP6 datagrams at the new sample rate
+#define CONFIRM_RATE_TOL  0.1    // Part of the datagram period
+
+enum {
+   CONFIRM_BY_ACK = 0,
+   CONFIRM_BY_FREQ,
+   CONFIRM_BY_RATE,
+   CONFIRM_BY_NUM
+};
+
+static const gchar *hpsdr_u_confirm_by_names[CONFIRM_BY_NUM] = {
+   "ACK",
+   "Freq",
+   "Rate",
+};
+
+typedef struct _hpsdr_u_confirm_event_t {
+   int reg;
+   int by;
+   guint32 old_value;
+   guint32 new_value;
+   guint32 frame_num;           // EP2 datagram with the change
+   guint32 confirm_frame;       // EP6 datagram that confirmed it
+   double start;                // Seconds from the start of the capture
+   double ms;
+} hpsdr_u_confirm_event_t;
+
+typedef struct _hpsdr_u_confirm_reg_t {
+   gboolean have;
+   guint32 value;               // C1 to C4, the speed bits for CONFIRM_SPEED
+   gboolean waiting;            // For the confirmation of new_value
+   guint32 old_value;
+   guint32 new_value;
+   double time;
+   guint32 frame_num;
+   guint32 changes;
+   guint32 superseded;          // Changed again before it was confirmed
+   guint32 by[CONFIRM_BY_NUM];
+   hpsdr_u_tap_dist_t dist;     // ms
+} hpsdr_u_confirm_reg_t;
+
+typedef struct _hpsdr_u_confirm_link_t {
+   gchar *name;                 // <radio>-<host>
+   gchar *radio;
+   gchar *host;
+   hpsdr_u_confirm_reg_t reg[CONFIRM_NUM];
+   double ep6_time[CONFIRM_WINDOW]; // Arrival of the last EP6 datagrams, oldest first
+   guint32 ep6_count;
+   GArray *events;              // hpsdr_u_confirm_event_t
+} hpsdr_u_confirm_link_t;
+
+typedef struct _hpsdr_u_confirm_t {
+   gchar *csv_prefix;
+   GHashTable *links;
+} hpsdr_u_confirm_t;
+
+static void hpsdr_u_confirm_link_free(gpointer record)
+{
+   hpsdr_u_confirm_link_t *link = (hpsdr_u_confirm_link_t *)record;
+   int r = -1;
+
+   for (r = 0; r < CONFIRM_NUM; r++) { hpsdr_u_tap_dist_free(&link->reg[r].dist); }
+   if ( link->events != NULL ) { g_array_free(link->events, TRUE); }
+   hpsdr_u_tap_link_free(link);
+}
+
+static hpsdr_u_confirm_link_t *hpsdr_u_confirm_link(hpsdr_u_confirm_t *confirm, packet_info *pinfo,
+                                                    const hpsdr_u_tap_info_t *tap_info)
+{
+   hpsdr_u_confirm_link_t *link = NULL;
+
+   link = (hpsdr_u_confirm_link_t *)hpsdr_u_tap_link_lookup(confirm->links, pinfo, tap_info, sizeof(hpsdr_u_confirm_link_t));
+   if ( link->events == NULL ) {
+      link->events = g_array_new(FALSE, FALSE, sizeof(hpsdr_u_confirm_event_t));
+   }
+
+   return link;
+}
+
+static void hpsdr_u_confirm_reset(void *tapdata)
+{
+   hpsdr_u_confirm_t *confirm = (hpsdr_u_confirm_t *)tapdata;
+
+   g_hash_table_remove_all(confirm->links);
+}
+
+// A register value sent by the host.
+static void hpsdr_u_confirm_value(hpsdr_u_confirm_reg_t *reg, guint32 value, double now, guint32 frame_num)
+{
+   if ( !reg->have ) {
+      reg->have = TRUE;
+      reg->value = value;
+      return;
+   }
+   if ( value == reg->value ) { return; }
+
+   if ( reg->waiting ) { reg->superseded += 1; }
+
+   reg->waiting = TRUE;
+   reg->old_value = reg->value;
+   reg->new_value = value;
+   reg->time = now;
+   reg->frame_num = frame_num;
+   reg->changes += 1;
+   reg->value = value;
+}
+
+static void hpsdr_u_confirm_done(hpsdr_u_confirm_link_t *link, int r, int by, double now, guint32 frame_num)
+{
+   hpsdr_u_confirm_reg_t *reg = &link->reg[r];
+   hpsdr_u_confirm_event_t event;
+
+   event.reg = r;
+   event.by = by;
+   event.old_value = reg->old_value;
+   event.new_value = reg->new_value;
+   event.frame_num = reg->frame_num;
+   event.confirm_frame = frame_num;
+   event.start = reg->time;
+   event.ms = ( now - reg->time ) * 1000.0;
+   g_array_append_val(link->events, event);
+
+   hpsdr_u_tap_dist_add(&reg->dist, event.ms);
+   reg->by[by] += 1;
+   reg->waiting = FALSE;
+}
+
+static void hpsdr_u_confirm_ep2(hpsdr_u_confirm_link_t *link, const hpsdr_u_tap_info_t *tap_info,
+                                double now, guint32 frame_num)
+{
+   const hpsdr_u_tap_frame_t *frame = NULL;
+   guint32 value = 0;
+   int r = -1;
+   int x = -1;
+
+   for (x = 0; x < HPSDR_U_FRAMES; x++) {
+      frame = &tap_info->frame[x];
+      if ( !frame->have_cc ) { continue; }
+
+      // Bit 7 is RQST on a Hermes-Lite2, it is not part of the register.
+      r = ( frame->cc[0] >> 1 ) & ( CONFIRM_REGS - 1 );
+      value = ( (guint32)frame->cc[1] << 24 ) | ( frame->cc[2] << 16 ) | ( frame->cc[3] << 8 ) | frame->cc[4];
+
+      hpsdr_u_confirm_value(&link->reg[r], value, now, frame_num);
+      if ( r == 0x00 ) {
+         hpsdr_u_confirm_value(&link->reg[CONFIRM_SPEED], frame->cc[1] & HOST_C1_SPEED, now, frame_num);
+      }
+   }
+}
+
+// The EP6 datagrams arrive at the new sample rate.
+static void hpsdr_u_confirm_rate(hpsdr_u_confirm_link_t *link, const hpsdr_u_tap_info_t *tap_info,
+                                 double now, guint32 frame_num)
+{
+   hpsdr_u_confirm_reg_t *reg = &link->reg[CONFIRM_SPEED];
+   double period = 0;
+   double expected = 0;
+   int samples = 0;
+
+   memmove(link->ep6_time, link->ep6_time + 1, ( CONFIRM_WINDOW - 1 ) * sizeof(double));
+   link->ep6_time[CONFIRM_WINDOW - 1] = now;
+   link->ep6_count += 1;
+
+   samples = HPSDR_U_FRAMES * hpsdr_u_ep6_samples(tap_info->rx_num);
+   if ( !reg->waiting || samples == 0 || link->ep6_count < CONFIRM_WINDOW ) { return; }
+   if ( link->ep6_time[0] < reg->time ) { return; }   // Not all after the change yet
+
+   period = ( link->ep6_time[CONFIRM_WINDOW - 1] - link->ep6_time[0] ) / ( CONFIRM_WINDOW - 1 );
+   expected = (double)samples / ( HPSDR_U_AUDIO_RATE << reg->new_value );
+
+   if ( fabs(period - expected) < CONFIRM_RATE_TOL * expected ) {
+      hpsdr_u_confirm_done(link, CONFIRM_SPEED, CONFIRM_BY_RATE, link->ep6_time[0], frame_num);
+   }
+}
+
+static void hpsdr_u_confirm_ep6(hpsdr_u_confirm_link_t *link, const hpsdr_u_tap_info_t *tap_info,
+                                double now, guint32 frame_num)
+{
+   const hpsdr_u_tap_frame_t *frame = NULL;
+   hpsdr_u_confirm_reg_t *reg = NULL;
+   guint32 value = 0;
+   int r = -1;
+   int x = -1;
+
+   for (x = 0; x < HPSDR_U_FRAMES; x++) {
+      frame = &tap_info->frame[x];
+      if ( !frame->have_cc ) { continue; }
+
+      if ( frame->cc[0] & CONFIRM_C0_ACK ) {
+         r = ( frame->cc[0] >> 1 ) & ( CONFIRM_REGS - 1 );
+         value = ( (guint32)frame->cc[1] << 24 ) | ( frame->cc[2] << 16 ) | ( frame->cc[3] << 8 ) | frame->cc[4];
+         reg = &link->reg[r];
+
+         if ( reg->waiting && reg->new_value == value ) {
+            hpsdr_u_confirm_done(link, r, CONFIRM_BY_ACK, now, frame_num);
+            if ( r == 0x00 && link->reg[CONFIRM_SPEED].waiting ) {
+               hpsdr_u_confirm_done(link, CONFIRM_SPEED, CONFIRM_BY_ACK, now, frame_num);
+            }
+         }
+
+      } else if ( frame->c0_type == 0x00 && ( frame->cc[1] & SDR_C1_FREQ ) ) {
+         for (r = CONFIRM_NCO_FIRST; r <= CONFIRM_NCO_LAST; r++) {
+            if ( link->reg[r].waiting ) { hpsdr_u_confirm_done(link, r, CONFIRM_BY_FREQ, now, frame_num); }
+         }
+      }
+   }
+
+   hpsdr_u_confirm_rate(link, tap_info, now, frame_num);
+}
+
+static tap_packet_status
+hpsdr_u_confirm_packet(void *tapdata, packet_info *pinfo, epan_dissect_t *edt _U_, const void *data)
+{
+   hpsdr_u_confirm_t *confirm = (hpsdr_u_confirm_t *)tapdata;
+   const hpsdr_u_tap_info_t *tap_info = (const hpsdr_u_tap_info_t *)data;
+   hpsdr_u_confirm_link_t *link = NULL;
+   double now = 0;
+
+   if ( tap_info->end_point != 2 && tap_info->end_point != 6 ) { return TAP_PACKET_DONT_REDRAW; }
+
+   link = hpsdr_u_confirm_link(confirm, pinfo, tap_info);
+   now = nstime_to_sec(&pinfo->rel_ts);
+
+   if ( tap_info->end_point == 2 ) {
+      hpsdr_u_confirm_ep2(link, tap_info, now, pinfo->num);
+   } else {
+      hpsdr_u_confirm_ep6(link, tap_info, now, pinfo->num);
+   }
+
+   return TAP_PACKET_REDRAW;
+}
+
+static const gchar *hpsdr_u_confirm_reg_name(int r)
+{
+   if ( r == CONFIRM_SPEED ) { return "Speed"; }
+
+   return hpsdr_u_tap_c0_name((guint8)r);
+}
+
+static void hpsdr_u_confirm_csv(hpsdr_u_confirm_t *confirm, hpsdr_u_confirm_link_t *link)
+{
+   FILE *fh = NULL;
+   gchar *file_name = NULL;
+   hpsdr_u_confirm_event_t *event = NULL;
+   guint x = 0;
+
+   file_name = hpsdr_u_tap_file_name(confirm->csv_prefix, link->name, ".csv");
+   fh = ws_fopen(file_name, "w");
+   if ( fh == NULL ) {
+      fprintf(stderr, "tshark: hpsdr-u,confirm can not open %s\n", file_name);
+      g_free(file_name);
+      return;
+   }
+
+   fprintf(fh, "radio,host,c0_type,register,old_value,new_value,start_s,frame,confirm_frame,by,latency_ms\n");
+
+   for (x = 0; x < link->events->len; x++) {
+      event = &g_array_index(link->events, hpsdr_u_confirm_event_t, x);
+      fprintf(fh, "%s,%s,", link->radio, link->host);
+      if ( event->reg == CONFIRM_SPEED ) {
+         fprintf(fh, "0x00,");
+      } else {
+         fprintf(fh, "0x%02X,", event->reg);
+      }
+      fprintf(fh, "%s,0x%08X,0x%08X,%.6f,%u,%u,%s,%.3f\n", hpsdr_u_confirm_reg_name(event->reg),
+              event->old_value, event->new_value, event->start, event->frame_num, event->confirm_frame,
+              hpsdr_u_confirm_by_names[event->by], event->ms);
+   }
+
+   fclose(fh);
+   g_free(file_name);
+}
+
+static void hpsdr_u_confirm_draw(void *tapdata)
+{
+   hpsdr_u_confirm_t *confirm = (hpsdr_u_confirm_t *)tapdata;
+   hpsdr_u_confirm_link_t *link = NULL;
+   hpsdr_u_confirm_reg_t *reg = NULL;
+   GList *links = NULL;
+   GList *item = NULL;
+   gchar by[32];
+   guint count = 0;
+   int r = -1;
+   int b = -1;
+
+   links = hpsdr_u_tap_radio_list(confirm->links);
+
+   printf("\n");
+   printf("===================================================================\n");
+   printf("HPSDR-USB C&C Register Change to Confirmation - ms at the capture point\n");
+
+   for (item = links; item != NULL; item = item->next) {
+      link = (hpsdr_u_confirm_link_t *)item->data;
+
+      printf("\nRadio: %s  Host: %s\n", link->radio, link->host);
+      printf(" C0    Register                 Changes  Confirmed  By         Superseded     Min ms     p50 ms     p99 ms     Max ms\n");
+
+      // The speed is listed after C0 Type 0x00.
+      for (r = -1; r < CONFIRM_REGS; r++) {
+         reg = &link->reg[( r < 0 ) ? CONFIRM_SPEED : r];
+         if ( reg->changes == 0 ) { continue; }
+
+         by[0] = '\0';
+         for (b = 0; b < CONFIRM_BY_NUM; b++) {
+            if ( reg->by[b] == 0 ) { continue; }
+            if ( by[0] != '\0' ) { g_strlcat(by, ",", sizeof(by)); }
+            g_strlcat(by, hpsdr_u_confirm_by_names[b], sizeof(by));
+         }
+
+         count = hpsdr_u_tap_dist_count(&reg->dist);
+         printf(" 0x%02X  %-24s %7u %10u  %-10s %10u", ( r < 0 ) ? 0 : r,
+                hpsdr_u_confirm_reg_name(( r < 0 ) ? CONFIRM_SPEED : r), reg->changes, count,
+                ( by[0] != '\0' ) ? by : "-", reg->superseded);
+         if ( count > 0 ) {
+            printf(" %10.3f %10.3f %10.3f %10.3f", hpsdr_u_tap_dist_percentile(&reg->dist, 0),
+                   hpsdr_u_tap_dist_percentile(&reg->dist, 50), hpsdr_u_tap_dist_percentile(&reg->dist, 99),
+                   hpsdr_u_tap_dist_percentile(&reg->dist, 100));
+         }
+         printf("\n");
+      }
+
+      if ( confirm->csv_prefix != NULL ) { hpsdr_u_confirm_csv(confirm, link); }
+   }
+
+   printf("===================================================================\n");
+
+   g_list_free(links);
+}
+
+static void hpsdr_u_confirm_finish(void *tapdata)
+{
+   hpsdr_u_confirm_t *confirm = (hpsdr_u_confirm_t *)tapdata;
+
+   g_hash_table_destroy(confirm->links);
+   g_free(confirm->csv_prefix);
+   g_free(confirm);
+}
+
+static void hpsdr_u_confirm_init(const char *opt_arg, void *userdata _U_)
+{
+   hpsdr_u_confirm_t *confirm = NULL;
+   gchar **args = NULL;
+   const gchar *filter = NULL;
+
+   args = hpsdr_u_tap_args(opt_arg, "hpsdr-u,confirm", 1, &filter);
+
+   confirm = g_new0(hpsdr_u_confirm_t, 1);
+   if ( args[0][0] != '\0' ) { confirm->csv_prefix = g_strdup(args[0]); }
+   confirm->links = hpsdr_u_tap_radio_table(hpsdr_u_confirm_link_free);
+   g_strfreev(args);
+
+   hpsdr_u_tap_listen("hpsdr-u,confirm", confirm, filter, hpsdr_u_confirm_reset,
+                      hpsdr_u_confirm_packet, hpsdr_u_confirm_draw, hpsdr_u_confirm_finish);
+}
+
+static stat_tap_ui hpsdr_u_confirm_ui = {
+   REGISTER_STAT_GROUP_GENERIC,
+   NULL,
+   "hpsdr-u,confirm",
+   hpsdr_u_confirm_init,
+   0,
+   NULL
+};
+
+void register_hpsdr_u_confirm_tap(void)
+{
+   register_stat_tap_ui(&hpsdr_u_confirm_ui, NULL);
+}
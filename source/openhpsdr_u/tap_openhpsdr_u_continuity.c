@@ -0,0 +1,333 @@
+/* tap_openhpsdr_u_continuity.c
+ * OpenHPSDR USB over IP protocol EP6 IQ sample continuity
+ *
+ * Version: 0.5.0
+ * Author:  Matthew J Wolf, N4MTT
+ *
+ * This file is part of the OpenHPSDR-USB Plug-in for Wireshark.
+ * Matthew J. Wolf <matthew.wolf.hpsdr@speciosus.net>
+ * Copyright 2020 Matthew J. Wolf
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * The OpenHPSDR-USB Plug-in for Wireshark is free software: you can
+ * redistribute it and/or modify it under the terms of the GNU
+ * General Public License as published by the Free Software Foundation,
+ * either version 2 of the License, or (at your option) any later version.
+ *
+ * The OpenHPSDR-USB Plug-in for Wireshark is distributed in the hope that
+ * it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See
+ * the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the OpenHPSDR-USB Plug-in for Wireshark.
+ * If not, see <http://www.gnu.org/licenses/>.
+ *
+ * tshark -z hpsdr-u,continuity[,<csv file prefix>[,<filter>]]
+ *
+ * Samples dropped inside datagrams with good sequence numbers, a FIFO in
+ * the radio that was not emptied in time. While a receiver has a steady
+ * carrier every IQ sample is predicted from the sample before it, a jump
+ * in phase or amplitude is a discontinuity. In the EP6 USB frames the
+ * samples of all the receivers are in one stream, a overrun drops them
+ * from every receiver at the same sample. The discontinuities at the same
+ * sample on every checked receiver (two or more) are counted on their own.
+ * Missing datagrams are not discontinuities, the check starts again after
+ * them.
+ *
+ *  <csv file prefix>_<radio>.csv  Every discontinuity
+ */
+
+#include <epan/packet.h>
+#include <epan/tap.h>
+#include <epan/stat_tap_ui.h>
+#include <wsutil/file_util.h>
+
+#include <stdlib.h>
+#include <string.h>
+#include "tap_openhpsdr_u.h"
+#include "iq_openhpsdr_u.h"
+#include "continuity_openhpsdr_u.h"
+
+#define CONTINUITY_LISTED 20    // Discontinuities listed in the report
+
+typedef struct _hpsdr_u_continuity_event_t {
+   guint32 frame_num;
+   guint32 seq;
+   gboolean have_sample;
+   guint64 sample;              // Absolute receiver sample number
+   int rx;                      // 0 is RX1
+   gboolean common;             // At the same sample on every checked receiver
+   double phase_deg;
+   double amp_db;
+} hpsdr_u_continuity_event_t;
+
+typedef struct _hpsdr_u_continuity_radio_t {
+   gchar *name;
+   guint32 datagrams;           // EP6 datagrams with IQ samples
+   guint32 unknown_rx;          // EP6 datagrams skipped, number of receivers not known
+   guint32 breaks;              // Check started again after missing datagrams or a new layout
+   guint32 common;              // Discontinuities at the same sample on every checked receiver
+   int rx_num;                  // Largest number of receivers
+   guint64 next_sample;         // First sample of the next EP6 datagram
+   gboolean started;
+   hpsdr_u_cont_t cont[HPSDR_U_RX_MAX];
+   GArray *events;              // hpsdr_u_continuity_event_t
+} hpsdr_u_continuity_radio_t;
+
+typedef struct _hpsdr_u_continuity_t {
+   gchar *csv_prefix;
+   GHashTable *radios;
+} hpsdr_u_continuity_t;
+
+static void hpsdr_u_continuity_radio_free(gpointer record)
+{
+   hpsdr_u_continuity_radio_t *radio = (hpsdr_u_continuity_radio_t *)record;
+
+   if ( radio->events != NULL ) { g_array_free(radio->events, TRUE); }
+   hpsdr_u_tap_radio_free(radio);
+}
+
+static void hpsdr_u_continuity_reset(void *tapdata)
+{
+   hpsdr_u_continuity_t *cont = (hpsdr_u_continuity_t *)tapdata;
+
+   g_hash_table_remove_all(cont->radios);
+}
+
+static tap_packet_status
+hpsdr_u_continuity_packet(void *tapdata, packet_info *pinfo, epan_dissect_t *edt _U_, const void *data)
+{
+   hpsdr_u_continuity_t *cont = (hpsdr_u_continuity_t *)tapdata;
+   const hpsdr_u_tap_info_t *tap_info = (const hpsdr_u_tap_info_t *)data;
+   hpsdr_u_continuity_radio_t *radio = NULL;
+   hpsdr_u_continuity_event_t event;
+
+   gint32 i[HPSDR_U_IQ_FRAME_MAX];
+   gint32 q[HPSDR_U_IQ_FRAME_MAX];
+   hpsdr_u_cont_event_t found[HPSDR_U_RX_MAX][HPSDR_U_IQ_FRAME_MAX];
+   int found_num[HPSDR_U_RX_MAX];
+   gboolean checked[HPSDR_U_RX_MAX];
+
+   int first_checked = -1;
+   int checked_num = 0;
+   int same = 0;
+   int rx_num = -1;
+   int samp_num = -1;
+   int x = -1;
+   int z = -1;
+   int y = -1;
+   int e = -1;
+   int f = -1;
+
+   if ( tap_info->end_point != 6 ) { return TAP_PACKET_DONT_REDRAW; }
+
+   radio = (hpsdr_u_continuity_radio_t *)hpsdr_u_tap_radio_lookup(cont->radios,
+                                                                  hpsdr_u_tap_radio_name(pinfo, tap_info),
+                                                                  sizeof(hpsdr_u_continuity_radio_t));
+
+   rx_num = tap_info->rx_num;
+   if ( rx_num <= 0 || rx_num > HPSDR_U_RX_MAX ) {
+      radio->unknown_rx += 1;
+      return TAP_PACKET_DONT_REDRAW;
+   }
+
+   if ( tap_info->have_sample && radio->started && tap_info->first_sample < radio->next_sample ) {
+      return TAP_PACKET_DONT_REDRAW;   // Late (out of order) datagram
+   }
+
+   // Missing datagrams or a new layout, the samples do not follow.
+   if ( radio->started && ( rx_num != radio->rx_num ||
+                            ( tap_info->have_sample && tap_info->first_sample != radio->next_sample ) ) ) {
+      for (z = 0; z < HPSDR_U_RX_MAX; z++) { hpsdr_u_cont_break(&radio->cont[z]); }
+      radio->breaks += 1;
+   }
+
+   radio->started = TRUE;
+   radio->datagrams += 1;
+   radio->rx_num = rx_num;
+   if ( radio->events == NULL ) { radio->events = g_array_new(FALSE, FALSE, sizeof(hpsdr_u_continuity_event_t)); }
+
+   for (x = 0; x < HPSDR_U_FRAMES; x++) {
+      if ( tap_info->frame[x].data == NULL ) { continue; }
+
+      samp_num = hpsdr_u_iq_unpack(tap_info->frame[x].data, rx_num, i, q);
+
+      checked_num = 0;
+      first_checked = -1;
+      for (z = 0; z < rx_num; z++) {
+         checked[z] = ( radio->cont[z].steady >= HPSDR_U_CONT_LOCK );
+         if ( checked[z] ) {
+            if ( first_checked < 0 ) { first_checked = z; }
+            checked_num += 1;
+         }
+         found_num[z] = hpsdr_u_cont_add(&radio->cont[z], &i[z * samp_num], &q[z * samp_num], samp_num,
+                                         found[z], HPSDR_U_IQ_FRAME_MAX);
+      }
+
+      for (z = 0; z < rx_num; z++) {
+         for (e = 0; e < found_num[z]; e++) {
+            // Receivers checked from the start of the USB frame with a discontinuity at this sample.
+            same = 0;
+            for (y = 0; y < rx_num; y++) {
+               if ( !checked[y] ) { continue; }
+               for (f = 0; f < found_num[y]; f++) {
+                  if ( found[y][f].offset == found[z][e].offset ) { same += 1; break; }
+               }
+            }
+
+            memset(&event, 0, sizeof(event));
+            event.frame_num = pinfo->num;
+            event.seq = tap_info->seq;
+            event.have_sample = tap_info->have_sample;
+            event.sample = tap_info->first_sample + ( x * samp_num ) + found[z][e].offset;
+            event.rx = z;
+            event.common = ( checked_num >= 2 && same == checked_num );
+            event.phase_deg = found[z][e].phase_deg;
+            event.amp_db = found[z][e].amp_db;
+            g_array_append_val(radio->events, event);
+
+            // Counted once, on the first checked receiver.
+            if ( event.common && z == first_checked ) { radio->common += 1; }
+         }
+      }
+   }
+
+   if ( tap_info->have_sample ) { radio->next_sample = tap_info->first_sample + ( HPSDR_U_FRAMES * hpsdr_u_ep6_samples(rx_num) ); }
+
+   return TAP_PACKET_REDRAW;
+}
+
+static void hpsdr_u_continuity_csv(hpsdr_u_continuity_t *cont, hpsdr_u_continuity_radio_t *radio)
+{
+   FILE *fh = NULL;
+   gchar *file_name = NULL;
+   hpsdr_u_continuity_event_t *event = NULL;
+   guint x = 0;
+
+   file_name = hpsdr_u_tap_file_name(cont->csv_prefix, radio->name, ".csv");
+   fh = ws_fopen(file_name, "w");
+   if ( fh == NULL ) {
+      fprintf(stderr, "tshark: hpsdr-u,continuity can not open %s\n", file_name);
+      g_free(file_name);
+      return;
+   }
+
+   fprintf(fh, "radio,frame,seq,sample,rx,all_rx,phase_deg,amp_db\n");
+
+   for (x = 0; x < radio->events->len; x++) {
+      event = &g_array_index(radio->events, hpsdr_u_continuity_event_t, x);
+
+      fprintf(fh, "%s,%u,%u,", radio->name, event->frame_num, event->seq);
+      if ( event->have_sample ) { fprintf(fh, "%" G_GUINT64_FORMAT, event->sample); }
+      fprintf(fh, ",%d,%d,%.1f,%.2f\n", event->rx + 1, event->common ? 1 : 0, event->phase_deg, event->amp_db);
+   }
+
+   fclose(fh);
+   g_free(file_name);
+}
+
+static void hpsdr_u_continuity_draw(void *tapdata)
+{
+   hpsdr_u_continuity_t *cont = (hpsdr_u_continuity_t *)tapdata;
+   hpsdr_u_continuity_radio_t *radio = NULL;
+   hpsdr_u_continuity_event_t *event = NULL;
+   hpsdr_u_cont_t *rx = NULL;
+   GList *radios = NULL;
+   GList *item = NULL;
+   gchar sample[24];
+   guint x = 0;
+   int z = -1;
+
+   radios = hpsdr_u_tap_radio_list(cont->radios);
+
+   printf("\n");
+   printf("===================================================================\n");
+   printf("HPSDR-USB EP6 IQ Continuity - Samples dropped inside datagrams\n");
+
+   for (item = radios; item != NULL; item = item->next) {
+      radio = (hpsdr_u_continuity_radio_t *)item->data;
+
+      printf("\nRadio: %s  EP6 Datagrams: %u  Receivers: %d\n", radio->name, radio->datagrams, radio->rx_num);
+      if ( radio->unknown_rx > 0 ) {
+         printf("  %u EP6 datagrams skipped, number of receivers not known.\n", radio->unknown_rx);
+      }
+      printf("  Check started again after missing datagrams: %u\n", radio->breaks);
+      printf("  Discontinuities on every checked receiver (FIFO overrun): %u\n", radio->common);
+
+      printf(" RX        Samples    Checked  Checked %%  Discontinuities  Per Million\n");
+      for (z = 0; z < HPSDR_U_RX_MAX; z++) {
+         rx = &radio->cont[z];
+         if ( rx->samples == 0 ) { continue; }
+
+         printf(" RX%-2d %12" G_GUINT64_FORMAT " %10" G_GUINT64_FORMAT " %10.1f %16u %12.3f\n", z + 1,
+                rx->samples, rx->checked, 100.0 * rx->checked / rx->samples, rx->events,
+                ( rx->checked > 0 ) ? 1e6 * rx->events / rx->checked : 0.0);
+      }
+
+      if ( radio->events == NULL || radio->events->len == 0 ) { continue; }
+
+      printf(" First %u discontinuities, * on every checked receiver\n", MIN(radio->events->len, CONTINUITY_LISTED));
+      printf("     Frame         Seq              Sample  RX   Phase deg  Amp dB\n");
+      for (x = 0; x < radio->events->len && x < CONTINUITY_LISTED; x++) {
+         event = &g_array_index(radio->events, hpsdr_u_continuity_event_t, x);
+
+         if ( event->have_sample ) {
+            g_snprintf(sample, sizeof(sample), "%" G_GUINT64_FORMAT, event->sample);
+         } else {
+            g_strlcpy(sample, "-", sizeof(sample));
+         }
+         printf("%10u %11u %19s  RX%-2d%c %9.1f %7.2f\n", event->frame_num, event->seq, sample,
+                event->rx + 1, event->common ? '*' : ' ', event->phase_deg, event->amp_db);
+      }
+
+      if ( cont->csv_prefix != NULL ) { hpsdr_u_continuity_csv(cont, radio); }
+   }
+
+   printf("===================================================================\n");
+
+   g_list_free(radios);
+}
+
+static void hpsdr_u_continuity_finish(void *tapdata)
+{
+   hpsdr_u_continuity_t *cont = (hpsdr_u_continuity_t *)tapdata;
+
+   g_hash_table_destroy(cont->radios);
+   g_free(cont->csv_prefix);
+   g_free(cont);
+}
+
+static void hpsdr_u_continuity_init(const char *opt_arg, void *userdata _U_)
+{
+   hpsdr_u_continuity_t *cont = NULL;
+   gchar **args = NULL;
+   const gchar *filter = NULL;
+
+   args = hpsdr_u_tap_args(opt_arg, "hpsdr-u,continuity", 1, &filter);
+
+   cont = g_new0(hpsdr_u_continuity_t, 1);
+   if ( args[0][0] != '\0' ) { cont->csv_prefix = g_strdup(args[0]); }
+   cont->radios = hpsdr_u_tap_radio_table(hpsdr_u_continuity_radio_free);
+   g_strfreev(args);
+
+   hpsdr_u_tap_listen("hpsdr-u,continuity", cont, filter, hpsdr_u_continuity_reset,
+                      hpsdr_u_continuity_packet, hpsdr_u_continuity_draw, hpsdr_u_continuity_finish);
+}
+
+static stat_tap_ui hpsdr_u_continuity_ui = {
+   REGISTER_STAT_GROUP_GENERIC,
+   NULL,
+   "hpsdr-u,continuity",
+   hpsdr_u_continuity_init,
+   0,
+   NULL
+};
+
+void register_hpsdr_u_continuity_tap(void)
+{
+   register_stat_tap_ui(&hpsdr_u_continuity_ui, NULL);
+}
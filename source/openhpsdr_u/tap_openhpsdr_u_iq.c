@@ -0,0 +1,259 @@
+/* tap_openhpsdr_u_iq.c
+ * OpenHPSDR USB over IP protocol per receiver IQ power and clipping
+ *
+ * Version: 0.5.0
+ * Author:  Matthew J Wolf, N4MTT
+ *
+ * This file is part of the OpenHPSDR-USB Plug-in for Wireshark.
+ * Matthew J. Wolf <matthew.wolf.hpsdr@speciosus.net>
+ * Copyright 2020 Matthew J. Wolf
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * The OpenHPSDR-USB Plug-in for Wireshark is free software: you can
+ * redistribute it and/or modify it under the terms of the GNU
+ * General Public License as published by the Free Software Foundation,
+ * either version 2 of the License, or (at your option) any later version.
+ *
+ * The OpenHPSDR-USB Plug-in for Wireshark is distributed in the hope that
+ * it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See
+ * the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the OpenHPSDR-USB Plug-in for Wireshark.
+ * If not, see <http://www.gnu.org/licenses/>.
+ *
+ * tshark -z hpsdr-u,iq[,<interval seconds>[,<filter>]]
+ *
+ * RMS power (dBFS), peak magnitude, DC offset and near full scale sample
+ * counts of every receiver. The whole capture is always reported, the
+ * intervals are only reported when a interval is given.
+ */
+
+#include <epan/packet.h>
+#include <epan/tap.h>
+#include <epan/stat_tap_ui.h>
+
+#include <stdlib.h>
+#include <string.h>
+#include "tap_openhpsdr_u.h"
+#include "iq_openhpsdr_u.h"
+
+typedef struct _hpsdr_u_iq_row_t {
+   guint32 interval;            // Interval number from the start of the capture
+   int rx_num;                  // Largest number of receivers in the interval
+   hpsdr_u_iq_stats_t stats[HPSDR_U_RX_MAX];
+} hpsdr_u_iq_row_t;
+
+typedef struct _hpsdr_u_iq_radio_t {
+   gchar *name;
+   guint32 datagrams;           // EP6 datagrams with IQ samples
+   guint32 unknown_rx;          // EP6 datagrams skipped, number of receivers not known
+   int rx_num;                  // Largest number of receivers
+   hpsdr_u_iq_stats_t stats[HPSDR_U_RX_MAX];
+   guint32 peak_frame[HPSDR_U_RX_MAX]; // Frame number of the datagram with the peak magnitude
+   GArray *rows;                // hpsdr_u_iq_row_t, only with a interval
+} hpsdr_u_iq_radio_t;
+
+typedef struct _hpsdr_u_iq_t {
+   double interval;             // Seconds, 0 when there are no intervals
+   GHashTable *radios;
+} hpsdr_u_iq_t;
+
+static void hpsdr_u_iq_radio_free(gpointer record)
+{
+   hpsdr_u_iq_radio_t *radio = (hpsdr_u_iq_radio_t *)record;
+
+   if ( radio->rows != NULL ) { g_array_free(radio->rows, TRUE); }
+   hpsdr_u_tap_radio_free(radio);
+}
+
+static hpsdr_u_iq_row_t *hpsdr_u_iq_row(hpsdr_u_iq_radio_t *radio, guint32 interval)
+{
+   hpsdr_u_iq_row_t *row = NULL;
+
+   if ( radio->rows->len > 0 ) {
+      row = &g_array_index(radio->rows, hpsdr_u_iq_row_t, radio->rows->len - 1);
+      if ( row->interval == interval ) { return row; }
+   }
+
+   g_array_set_size(radio->rows, radio->rows->len + 1);
+   row = &g_array_index(radio->rows, hpsdr_u_iq_row_t, radio->rows->len - 1);
+   memset(row, 0, sizeof(hpsdr_u_iq_row_t));
+   row->interval = interval;
+
+   return row;
+}
+
+static void hpsdr_u_iq_reset(void *tapdata)
+{
+   hpsdr_u_iq_t *iq = (hpsdr_u_iq_t *)tapdata;
+
+   g_hash_table_remove_all(iq->radios);
+}
+
+static tap_packet_status
+hpsdr_u_iq_packet(void *tapdata, packet_info *pinfo, epan_dissect_t *edt _U_, const void *data)
+{
+   hpsdr_u_iq_t *iq = (hpsdr_u_iq_t *)tapdata;
+   const hpsdr_u_tap_info_t *tap_info = (const hpsdr_u_tap_info_t *)data;
+   hpsdr_u_iq_radio_t *radio = NULL;
+   hpsdr_u_iq_row_t *row = NULL;
+
+   hpsdr_u_iq_stats_t stats[HPSDR_U_RX_MAX];
+   gint32 i[HPSDR_U_IQ_FRAME_MAX];
+   gint32 q[HPSDR_U_IQ_FRAME_MAX];
+
+   int rx_num = -1;
+   int samp_num = -1;
+   int x = -1;
+   int z = -1;
+
+   if ( tap_info->end_point != 6 ) { return TAP_PACKET_DONT_REDRAW; }
+
+   radio = (hpsdr_u_iq_radio_t *)hpsdr_u_tap_radio_lookup(iq->radios,
+                                                          hpsdr_u_tap_radio_name(pinfo, tap_info),
+                                                          sizeof(hpsdr_u_iq_radio_t));
+
+   rx_num = tap_info->rx_num;
+   if ( rx_num <= 0 || rx_num > HPSDR_U_RX_MAX ) {
+      radio->unknown_rx += 1;
+      return TAP_PACKET_DONT_REDRAW;
+   }
+
+   // Statistics of this datagram, then added to the totals and the interval.
+   memset(stats, 0, sizeof(stats));
+   for (x = 0; x < HPSDR_U_FRAMES; x++) {
+      if ( tap_info->frame[x].data == NULL ) { continue; }
+
+      samp_num = hpsdr_u_iq_unpack(tap_info->frame[x].data, rx_num, i, q);
+      for (z = 0; z < rx_num; z++) {
+         hpsdr_u_iq_stats_add(&stats[z], &i[z * samp_num], &q[z * samp_num], samp_num);
+      }
+   }
+
+   radio->datagrams += 1;
+   if ( rx_num > radio->rx_num ) { radio->rx_num = rx_num; }
+
+   if ( iq->interval > 0 ) {
+      if ( radio->rows == NULL ) { radio->rows = g_array_new(FALSE, FALSE, sizeof(hpsdr_u_iq_row_t)); }
+      row = hpsdr_u_iq_row(radio, (guint32)( nstime_to_sec(&pinfo->rel_ts) / iq->interval ));
+      if ( rx_num > row->rx_num ) { row->rx_num = rx_num; }
+   }
+
+   for (z = 0; z < rx_num; z++) {
+      if ( stats[z].peak_power > radio->stats[z].peak_power ) { radio->peak_frame[z] = pinfo->num; }
+      hpsdr_u_iq_stats_merge(&radio->stats[z], &stats[z]);
+      if ( row != NULL ) { hpsdr_u_iq_stats_merge(&row->stats[z], &stats[z]); }
+   }
+
+   return TAP_PACKET_REDRAW;
+}
+
+static void hpsdr_u_iq_draw(void *tapdata)
+{
+   hpsdr_u_iq_t *iq = (hpsdr_u_iq_t *)tapdata;
+   hpsdr_u_iq_radio_t *radio = NULL;
+   hpsdr_u_iq_row_t *row = NULL;
+   hpsdr_u_iq_stats_t *stats = NULL;
+   GList *radios = NULL;
+   GList *item = NULL;
+   gboolean first_line = TRUE;
+   guint x = 0;
+   int z = -1;
+
+   radios = hpsdr_u_tap_radio_list(iq->radios);
+
+   printf("\n");
+   printf("===================================================================\n");
+   printf("HPSDR-USB IQ Signal - 0 dBFS is a IQ magnitude of 2^23\n");
+
+   for (item = radios; item != NULL; item = item->next) {
+      radio = (hpsdr_u_iq_radio_t *)item->data;
+
+      printf("\nRadio: %s  EP6 Datagrams: %u  Receivers: %d\n", radio->name, radio->datagrams, radio->rx_num);
+      if ( radio->unknown_rx > 0 ) {
+         printf("  %u EP6 datagrams skipped, number of receivers not known.\n", radio->unknown_rx);
+      }
+
+      printf(" RX     Samples  RMS dBFS  Peak dBFS        Peak       DC I       DC Q  Near FS  Peak Frame\n");
+      for (z = 0; z < radio->rx_num; z++) {
+         stats = &radio->stats[z];
+         printf(" RX%-2d %10" G_GUINT64_FORMAT " %9.2f %10.2f %11.0f %10.1f %10.1f %8" G_GUINT64_FORMAT "  %10u\n",
+                z + 1, stats->count,
+                hpsdr_u_iq_rms_dbfs(stats), hpsdr_u_iq_peak_dbfs(stats), hpsdr_u_iq_peak(stats),
+                hpsdr_u_iq_dc_i(stats), hpsdr_u_iq_dc_q(stats), stats->near_fs, radio->peak_frame[z]);
+      }
+
+      if ( radio->rows == NULL ) { continue; }
+
+      printf(" Interval: %.3f s\n", iq->interval);
+      printf("  Start s  RX   RMS dBFS  Peak dBFS       DC I       DC Q  Near FS\n");
+      for (x = 0; x < radio->rows->len; x++) {
+         row = &g_array_index(radio->rows, hpsdr_u_iq_row_t, x);
+         first_line = TRUE;
+
+         for (z = 0; z < row->rx_num; z++) {
+            stats = &row->stats[z];
+            if ( stats->count == 0 ) { continue; }
+
+            if ( first_line ) {
+               printf("%9.3f", row->interval * iq->interval);
+               first_line = FALSE;
+            } else {
+               printf("%9s", "");
+            }
+            printf("  RX%-2d %9.2f %10.2f %10.1f %10.1f %8" G_GUINT64_FORMAT "\n", z + 1,
+                   hpsdr_u_iq_rms_dbfs(stats), hpsdr_u_iq_peak_dbfs(stats),
+                   hpsdr_u_iq_dc_i(stats), hpsdr_u_iq_dc_q(stats), stats->near_fs);
+         }
+      }
+   }
+
+   printf("===================================================================\n");
+
+   g_list_free(radios);
+}
+
+static void hpsdr_u_iq_finish(void *tapdata)
+{
+   hpsdr_u_iq_t *iq = (hpsdr_u_iq_t *)tapdata;
+
+   g_hash_table_destroy(iq->radios);
+   g_free(iq);
+}
+
+static void hpsdr_u_iq_init(const char *opt_arg, void *userdata _U_)
+{
+   hpsdr_u_iq_t *iq = NULL;
+   gchar **args = NULL;
+   const gchar *filter = NULL;
+
+   args = hpsdr_u_tap_args(opt_arg, "hpsdr-u,iq", 1, &filter);
+
+   iq = g_new0(hpsdr_u_iq_t, 1);
+   iq->interval = hpsdr_u_tap_number(args[0], "hpsdr-u,iq", "interval", 0);
+   if ( iq->interval < 0 ) { iq->interval = 0; }
+   iq->radios = hpsdr_u_tap_radio_table(hpsdr_u_iq_radio_free);
+   g_strfreev(args);
+
+   hpsdr_u_tap_listen("hpsdr-u,iq", iq, filter, hpsdr_u_iq_reset,
+                      hpsdr_u_iq_packet, hpsdr_u_iq_draw, hpsdr_u_iq_finish);
+}
+
+static stat_tap_ui hpsdr_u_iq_ui = {
+   REGISTER_STAT_GROUP_GENERIC,
+   NULL,
+   "hpsdr-u,iq",
+   hpsdr_u_iq_init,
+   0,
+   NULL
+};
+
+void register_hpsdr_u_iq_tap(void)
+{
+   register_stat_tap_ui(&hpsdr_u_iq_ui, NULL);
+}
@@ -0,0 +1,303 @@
+/* tap_openhpsdr_u_overflow.c
+ * OpenHPSDR USB over IP protocol ADC overflow accounting
+ *
+ * Version: 0.5.0
+ * Author:  Matthew J Wolf, N4MTT
+ *
+ * This file is part of the OpenHPSDR-USB Plug-in for Wireshark.
+ * Matthew J. Wolf <matthew.wolf.hpsdr@speciosus.net>
+ * Copyright 2020 Matthew J. Wolf
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * The OpenHPSDR-USB Plug-in for Wireshark is free software: you can
+ * redistribute it and/or modify it under the terms of the GNU
+ * General Public License as published by the Free Software Foundation,
+ * either version 2 of the License, or (at your option) any later version.
+ *
+ * The OpenHPSDR-USB Plug-in for Wireshark is distributed in the hope that
+ * it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See
+ * the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the OpenHPSDR-USB Plug-in for Wireshark.
+ * If not, see <http://www.gnu.org/licenses/>.
+ *
+ * tshark -z hpsdr-u,overflow[,<filter>]
+ *
+ * Counts the EP6 ADC overflow reports of every radio per ADC and per
+ * receiver. A receiver is charged with the overflows of the ADC the
+ * EP2 C0=0x0E ADC RX Assignment connects it to. Back to back overflow
+ * reports of an ADC are a burst. The longest bursts are listed with the
+ * frame numbers where they start and end.
+ */
+
+#include <epan/packet.h>
+#include <epan/tap.h>
+#include <epan/stat_tap_ui.h>
+
+#include <stdlib.h>
+#include <string.h>
+#include "tap_openhpsdr_u.h"
+
+#define HPSDR_U_OVERFLOW_BURSTS 10  // Longest bursts listed per radio
+
+typedef struct _hpsdr_u_overflow_burst_t {
+   guint8  adc;                 // 0 is ADC1
+   guint32 first_frame;         // Wireshark frame numbers
+   guint32 last_frame;
+   double  start;               // Seconds from the first frame of the capture
+   guint32 reports;             // Overflow reports in the burst
+} hpsdr_u_overflow_burst_t;
+
+typedef struct _hpsdr_u_overflow_adc_t {
+   guint32 reports;             // USB frames that report the state of the ADC
+   guint32 overflows;           // Reports with an overflow
+   guint32 bursts;
+   hpsdr_u_overflow_burst_t burst; // Burst in progress, reports is 0 when none
+} hpsdr_u_overflow_adc_t;
+
+typedef struct _hpsdr_u_overflow_radio_t {
+   gchar *name;
+   gboolean started;
+   guint32 frames;              // EP6 USB frames
+   double first_time;
+   double last_time;
+   hpsdr_u_overflow_adc_t adc[HPSDR_U_ADC];
+   guint32 rx_overflows[HPSDR_U_RX_ADC];
+   guint burst_num;             // Used entries of bursts
+   hpsdr_u_overflow_burst_t bursts[HPSDR_U_OVERFLOW_BURSTS]; // The longest finished bursts
+} hpsdr_u_overflow_radio_t;
+
+typedef struct _hpsdr_u_overflow_t {
+   GHashTable *radios;
+} hpsdr_u_overflow_t;
+
+static gint hpsdr_u_overflow_burst_compare(gconstpointer a, gconstpointer b)
+{
+   const hpsdr_u_overflow_burst_t *burst_a = (const hpsdr_u_overflow_burst_t *)a;
+   const hpsdr_u_overflow_burst_t *burst_b = (const hpsdr_u_overflow_burst_t *)b;
+
+   if ( burst_a->reports != burst_b->reports ) {
+      return ( burst_a->reports > burst_b->reports ) ? -1 : 1;
+   }
+
+   return ( burst_a->first_frame < burst_b->first_frame ) ? -1 : 1;
+}
+
+// Only the longest bursts are kept. When the list is full the new burst
+// replaces the shortest one if it is longer.
+static void hpsdr_u_overflow_end_burst(hpsdr_u_overflow_radio_t *radio, hpsdr_u_overflow_adc_t *adc)
+{
+   guint shortest = 0;
+   guint x = 0;
+
+   if ( adc->burst.reports == 0 ) { return; }
+
+   if ( radio->burst_num < HPSDR_U_OVERFLOW_BURSTS ) {
+      radio->bursts[radio->burst_num] = adc->burst;
+      radio->burst_num += 1;
+   } else {
+      for (x = 1; x < HPSDR_U_OVERFLOW_BURSTS; x++) {
+         if ( hpsdr_u_overflow_burst_compare(&radio->bursts[x], &radio->bursts[shortest]) > 0 ) {
+            shortest = x;
+         }
+      }
+      if ( hpsdr_u_overflow_burst_compare(&adc->burst, &radio->bursts[shortest]) < 0 ) {
+         radio->bursts[shortest] = adc->burst;
+      }
+   }
+
+   adc->burst.reports = 0;
+}
+
+static void hpsdr_u_overflow_reset(void *tapdata)
+{
+   hpsdr_u_overflow_t *overflow = (hpsdr_u_overflow_t *)tapdata;
+
+   g_hash_table_remove_all(overflow->radios);
+}
+
+static tap_packet_status
+hpsdr_u_overflow_packet(void *tapdata, packet_info *pinfo, epan_dissect_t *edt _U_, const void *data)
+{
+   hpsdr_u_overflow_t *overflow = (hpsdr_u_overflow_t *)tapdata;
+   const hpsdr_u_tap_info_t *tap_info = (const hpsdr_u_tap_info_t *)data;
+   const hpsdr_u_tap_frame_t *frame = NULL;
+   hpsdr_u_overflow_radio_t *radio = NULL;
+   hpsdr_u_overflow_adc_t *adc = NULL;
+
+   guint8 reported = 0;
+   double now = 0;
+   int rx_max = -1;
+   int x = -1;
+   int y = -1;
+   int z = -1;
+
+   if ( tap_info->end_point != 6 ) { return TAP_PACKET_DONT_REDRAW; }
+
+   radio = (hpsdr_u_overflow_radio_t *)hpsdr_u_tap_radio_lookup(overflow->radios,
+                                                                hpsdr_u_tap_radio_name(pinfo, tap_info),
+                                                                sizeof(hpsdr_u_overflow_radio_t));
+   now = nstime_to_sec(&pinfo->rel_ts);
+
+   if ( !radio->started ) {
+      radio->started = TRUE;
+      radio->first_time = now;
+   }
+   radio->last_time = now;
+
+   rx_max = ( tap_info->rx_num > 0 ) ? tap_info->rx_num : 1;
+   if ( rx_max > HPSDR_U_RX_ADC ) { rx_max = HPSDR_U_RX_ADC; }
+
+   for (x = 0; x < HPSDR_U_FRAMES; x++) {
+      frame = &tap_info->frame[x];
+      if ( !frame->have_cc ) { continue; }
+      radio->frames += 1;
+
+      // C0 Type 0x00 reports ADC1, C0 Type 0x04 reports ADC1 to ADC4.
+      if ( frame->c0_type == 0x00 ) {
+         reported = 0x01;
+      } else if ( frame->c0_type == 0x04 ) {
+         reported = 0x0F;
+      } else {
+         continue;
+      }
+
+      for (y = 0; y < HPSDR_U_ADC; y++) {
+         if ( !( reported & ( 1 << y ) ) ) { continue; }
+
+         adc = &radio->adc[y];
+         adc->reports += 1;
+
+         if ( !( frame->overflow & ( 1 << y ) ) ) {
+            hpsdr_u_overflow_end_burst(radio, adc);
+            continue;
+         }
+
+         adc->overflows += 1;
+
+         if ( adc->burst.reports == 0 ) {
+            adc->bursts += 1;
+            adc->burst.adc = y;
+            adc->burst.first_frame = pinfo->num;
+            adc->burst.start = now;
+         }
+         adc->burst.last_frame = pinfo->num;
+         adc->burst.reports += 1;
+
+         for (z = 0; z < rx_max; z++) {
+            if ( tap_info->rx_adc[z] == y ) { radio->rx_overflows[z] += 1; }
+         }
+      }
+   }
+
+   return TAP_PACKET_REDRAW;
+}
+
+static void hpsdr_u_overflow_draw(void *tapdata)
+{
+   hpsdr_u_overflow_t *overflow = (hpsdr_u_overflow_t *)tapdata;
+   hpsdr_u_overflow_radio_t *radio = NULL;
+   hpsdr_u_overflow_adc_t *adc = NULL;
+   hpsdr_u_overflow_burst_t *burst = NULL;
+   GArray *bursts = NULL;
+   GList *radios = NULL;
+   GList *item = NULL;
+   double duration = 0;
+   guint x = 0;
+
+   radios = hpsdr_u_tap_radio_list(overflow->radios);
+
+   printf("\n");
+   printf("===================================================================\n");
+   printf("HPSDR-USB ADC Overflow\n");
+
+   for (item = radios; item != NULL; item = item->next) {
+      radio = (hpsdr_u_overflow_radio_t *)item->data;
+      duration = radio->last_time - radio->first_time;
+
+      printf("\nRadio: %s  EP6 USB Frames: %u  Duration: %.3f s\n",
+             radio->name, radio->frames, duration);
+      printf(" ADC    Reports  Overflows  Percent  Per Second  Bursts\n");
+
+      for (x = 0; x < HPSDR_U_ADC; x++) {
+         adc = &radio->adc[x];
+         if ( adc->reports == 0 ) { continue; }
+
+         printf(" ADC%u %9u  %9u  %6.2f%%  %10.3f  %6u\n", x + 1, adc->reports, adc->overflows,
+                100.0 * adc->overflows / adc->reports,
+                ( duration > 0 ) ? adc->overflows / duration : 0.0, adc->bursts);
+      }
+
+      printf(" Receiver  Overflows\n");
+      for (x = 0; x < HPSDR_U_RX_ADC; x++) {
+         if ( radio->rx_overflows[x] == 0 ) { continue; }
+         printf(" RX%u       %9u\n", x + 1, radio->rx_overflows[x]);
+      }
+
+      // The bursts still in progress are listed with the finished bursts.
+      bursts = g_array_new(FALSE, FALSE, sizeof(hpsdr_u_overflow_burst_t));
+      g_array_append_vals(bursts, radio->bursts, radio->burst_num);
+      for (x = 0; x < HPSDR_U_ADC; x++) {
+         if ( radio->adc[x].burst.reports > 0 ) { g_array_append_val(bursts, radio->adc[x].burst); }
+      }
+      g_array_sort(bursts, hpsdr_u_overflow_burst_compare);
+
+      if ( bursts->len > 0 ) {
+         printf(" Longest Bursts\n");
+         printf(" ADC    Reports   Start s  First Frame  Last Frame\n");
+      }
+      for (x = 0; x < bursts->len && x < HPSDR_U_OVERFLOW_BURSTS; x++) {
+         burst = &g_array_index(bursts, hpsdr_u_overflow_burst_t, x);
+         printf(" ADC%u %9u %9.3f  %11u  %10u\n", burst->adc + 1, burst->reports,
+                burst->start, burst->first_frame, burst->last_frame);
+      }
+      g_array_free(bursts, TRUE);
+   }
+
+   printf("===================================================================\n");
+
+   g_list_free(radios);
+}
+
+static void hpsdr_u_overflow_finish(void *tapdata)
+{
+   hpsdr_u_overflow_t *overflow = (hpsdr_u_overflow_t *)tapdata;
+
+   g_hash_table_destroy(overflow->radios);
+   g_free(overflow);
+}
+
+static void hpsdr_u_overflow_init(const char *opt_arg, void *userdata _U_)
+{
+   hpsdr_u_overflow_t *overflow = NULL;
+   gchar **args = NULL;
+   const gchar *filter = NULL;
+
+   args = hpsdr_u_tap_args(opt_arg, "hpsdr-u,overflow", 0, &filter);
+   g_strfreev(args);
+
+   overflow = g_new0(hpsdr_u_overflow_t, 1);
+   overflow->radios = hpsdr_u_tap_radio_table(NULL);
+
+   hpsdr_u_tap_listen("hpsdr-u,overflow", overflow, filter, hpsdr_u_overflow_reset,
+                      hpsdr_u_overflow_packet, hpsdr_u_overflow_draw, hpsdr_u_overflow_finish);
+}
+
+static stat_tap_ui hpsdr_u_overflow_ui = {
+   REGISTER_STAT_GROUP_GENERIC,
+   NULL,
+   "hpsdr-u,overflow",
+   hpsdr_u_overflow_init,
+   0,
+   NULL
+};
+
+void register_hpsdr_u_overflow_tap(void)
+{
+   register_stat_tap_ui(&hpsdr_u_overflow_ui, NULL);
+}
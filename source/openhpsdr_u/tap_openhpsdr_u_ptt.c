@@ -0,0 +1,398 @@
+/* tap_openhpsdr_u_ptt.c
+ * OpenHPSDR USB over IP protocol MOX and PTT turnaround latency
+ *
+ * Version: 0.5.0
+ * Author:  Matthew J Wolf, N4MTT
+ *
+ * This file is part of the OpenHPSDR-USB Plug-in for Wireshark.
+ * Matthew J. Wolf <matthew.wolf.hpsdr@speciosus.net>
+ * Copyright 2020 Matthew J. Wolf
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * The OpenHPSDR-USB Plug-in for Wireshark is free software: you can
+ * redistribute it and/or modify it under the terms of the GNU
+ * General Public License as published by the Free Software Foundation,
+ * either version 2 of the License, or (at your option) any later version.
+ *
+ * The OpenHPSDR-USB Plug-in for Wireshark is distributed in the hope that
+ * it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See
+ * the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the OpenHPSDR-USB Plug-in for Wireshark.
+ * If not, see <http://www.gnu.org/licenses/>.
+ *
+ * tshark -z hpsdr-u,ptt[,<csv file prefix>[,<filter>]]
+ *
+ * TX / RX switching latency for every radio and host pair:
+ *
+ *  MOX on  -> TX   Host sets MOX (EP2 C0 bit 0) to the first EP6 datagram
+ *                  that shows the radio transmitting.
+ *  MOX off -> RX   Host clears MOX to the first EP6 datagram that shows the
+ *                  radio receiving.
+ *  Key -> MOX on   Hardware PTT, dot or dash (EP6 C0 bits 0 to 2) pressed
+ *                  to the first EP2 datagram with MOX set.
+ *  Unkey -> MOX off  Released to the first EP2 datagram with MOX clear.
+ *
+ * The radio is transmitting when the EP6 C0 Type 0x01 exciter or forward
+ * power reading is over PTT_FWD_COUNTS or, for a MOX change not made by the
+ * key, a PTT bit is set. A power reading is in a EP6 USB frame every few
+ * frames, that is the resolution of the TX and RX times. The latencies are
+ * at the capture point, they have the network both ways in them.
+ *
+ *  <csv file prefix>_<radio>-<host>.csv  Every latency
+ */
+
+#include <epan/packet.h>
+#include <epan/tap.h>
+#include <epan/stat_tap_ui.h>
+#include <wsutil/file_util.h>
+
+#include <stdlib.h>
+#include <string.h>
+#include "tap_openhpsdr_u.h"
+#include "cc_openhpsdr_u.h"
+
+#define PTT_C0_KEY      ( SDR_C0_PTT | SDR_C0_DASH | SDR_C0_DOT ) // EP6 C0 PTT, dash, dot
+#define PTT_C0_FWD      0x01   // EP6 C0 Type, exciter and forward power
+#define PTT_FWD_COUNTS  64     // Raw power reading over the ADC offset when transmitting
+
+enum {
+   PTT_MOX_ON = 0,
+   PTT_MOX_OFF,
+   PTT_KEY_ON,
+   PTT_KEY_OFF,
+   PTT_NUM
+};
+
+static const gchar *hpsdr_u_ptt_names[PTT_NUM] = {
+   "MOX on -> TX",
+   "MOX off -> RX",
+   "Key -> MOX on",
+   "Unkey -> MOX off",
+};
+
+static const gchar *hpsdr_u_ptt_csv_names[PTT_NUM] = {
+   "mox_on_tx",
+   "mox_off_rx",
+   "key_mox_on",
+   "unkey_mox_off",
+};
+
+typedef struct _hpsdr_u_ptt_event_t {
+   int kind;
+   guint32 frame_num;           // Datagram with the change
+   guint32 done_frame;          // Datagram that answered it
+   double start;                // Seconds from the start of the capture
+   double ms;
+} hpsdr_u_ptt_event_t;
+
+// A change waiting for the other side.
+typedef struct _hpsdr_u_ptt_pending_t {
+   gboolean waiting;
+   int kind;
+   gboolean state;              // New state
+   gboolean by_key;             // MOX change made by the hardware key
+   double time;
+   guint32 frame_num;
+} hpsdr_u_ptt_pending_t;
+
+typedef struct _hpsdr_u_ptt_link_t {
+   gchar *name;                 // <radio>-<host>
+   gchar *radio;
+   gchar *host;
+   gboolean have_mox;
+   gboolean mox;                // Host MOX
+   gboolean have_key;
+   gboolean key;                // Radio PTT, dot or dash
+   gboolean rf;                 // Last power reading shows the radio transmitting
+   gboolean tx_seen;            // The radio showed TX since MOX was last set
+   hpsdr_u_ptt_pending_t mox_change;
+   hpsdr_u_ptt_pending_t key_change;
+   guint32 changes[PTT_NUM];
+   guint32 unanswered[PTT_NUM]; // Changed again before the other side answered
+   hpsdr_u_tap_dist_t dist[PTT_NUM]; // ms
+   GArray *events;              // hpsdr_u_ptt_event_t
+} hpsdr_u_ptt_link_t;
+
+typedef struct _hpsdr_u_ptt_t {
+   gchar *csv_prefix;
+   GHashTable *links;
+} hpsdr_u_ptt_t;
+
+static void hpsdr_u_ptt_link_free(gpointer record)
+{
+   hpsdr_u_ptt_link_t *link = (hpsdr_u_ptt_link_t *)record;
+   int k = -1;
+
+   for (k = 0; k < PTT_NUM; k++) { hpsdr_u_tap_dist_free(&link->dist[k]); }
+   if ( link->events != NULL ) { g_array_free(link->events, TRUE); }
+   hpsdr_u_tap_link_free(link);
+}
+
+static hpsdr_u_ptt_link_t *hpsdr_u_ptt_link(hpsdr_u_ptt_t *ptt, packet_info *pinfo, const hpsdr_u_tap_info_t *tap_info)
+{
+   hpsdr_u_ptt_link_t *link = NULL;
+
+   link = (hpsdr_u_ptt_link_t *)hpsdr_u_tap_link_lookup(ptt->links, pinfo, tap_info, sizeof(hpsdr_u_ptt_link_t));
+   if ( link->events == NULL ) {
+      link->events = g_array_new(FALSE, FALSE, sizeof(hpsdr_u_ptt_event_t));
+   }
+
+   return link;
+}
+
+static void hpsdr_u_ptt_reset(void *tapdata)
+{
+   hpsdr_u_ptt_t *ptt = (hpsdr_u_ptt_t *)tapdata;
+
+   g_hash_table_remove_all(ptt->links);
+}
+
+static void hpsdr_u_ptt_start(hpsdr_u_ptt_link_t *link, hpsdr_u_ptt_pending_t *change, int kind,
+                              gboolean by_key, double now, guint32 frame_num)
+{
+   if ( change->waiting ) { link->unanswered[change->kind] += 1; }
+
+   change->waiting = TRUE;
+   change->kind = kind;
+   change->state = ( kind == PTT_MOX_ON || kind == PTT_KEY_ON );
+   change->by_key = by_key;
+   change->time = now;
+   change->frame_num = frame_num;
+   link->changes[kind] += 1;
+}
+
+static void hpsdr_u_ptt_done(hpsdr_u_ptt_link_t *link, hpsdr_u_ptt_pending_t *change, double now, guint32 frame_num)
+{
+   hpsdr_u_ptt_event_t event;
+
+   event.kind = change->kind;
+   event.frame_num = change->frame_num;
+   event.done_frame = frame_num;
+   event.start = change->time;
+   event.ms = ( now - change->time ) * 1000.0;
+   g_array_append_val(link->events, event);
+
+   hpsdr_u_tap_dist_add(&link->dist[change->kind], event.ms);
+   change->waiting = FALSE;
+}
+
+// Host to radio, MOX changes.
+static void hpsdr_u_ptt_ep2(hpsdr_u_ptt_link_t *link, const hpsdr_u_tap_info_t *tap_info, double now, guint32 frame_num)
+{
+   gboolean mox = FALSE;
+   gboolean by_key = FALSE;
+   int x = -1;
+
+   for (x = 0; x < HPSDR_U_FRAMES; x++) {
+      if ( !tap_info->frame[x].have_cc ) { continue; }
+      mox = ( tap_info->frame[x].cc[0] & HOST_C0_MOX ) ? TRUE : FALSE;
+
+      if ( !link->have_mox ) {
+         link->have_mox = TRUE;
+         link->mox = mox;
+         continue;
+      }
+      if ( mox == link->mox ) { continue; }
+
+      // The host followed the hardware key.
+      by_key = FALSE;
+      if ( link->key_change.waiting && link->key_change.state == mox ) {
+         hpsdr_u_ptt_done(link, &link->key_change, now, frame_num);
+         by_key = TRUE;
+      }
+
+      hpsdr_u_ptt_start(link, &link->mox_change, mox ? PTT_MOX_ON : PTT_MOX_OFF, by_key, now, frame_num);
+      link->mox = mox;
+      if ( mox ) { link->tx_seen = FALSE; }
+   }
+}
+
+// Radio to host, key and power readings.
+static void hpsdr_u_ptt_ep6(hpsdr_u_ptt_link_t *link, const hpsdr_u_tap_info_t *tap_info, double now, guint32 frame_num)
+{
+   const hpsdr_u_tap_frame_t *frame = NULL;
+   hpsdr_u_ptt_pending_t *change = &link->mox_change;
+   gboolean key = FALSE;
+   gboolean tx = FALSE;
+   guint16 exciter = 0;
+   guint16 forward = 0;
+   int x = -1;
+
+   for (x = 0; x < HPSDR_U_FRAMES; x++) {
+      frame = &tap_info->frame[x];
+      if ( !frame->have_cc ) { continue; }
+      key = ( frame->cc[0] & PTT_C0_KEY ) ? TRUE : FALSE;
+
+      if ( frame->c0_type == PTT_C0_FWD ) {
+         exciter = ( frame->cc[1] << 8 ) | frame->cc[2];
+         forward = ( frame->cc[3] << 8 ) | frame->cc[4];
+         link->rf = ( exciter > PTT_FWD_COUNTS || forward > PTT_FWD_COUNTS );
+      }
+
+      if ( !link->have_key ) {
+         link->have_key = TRUE;
+         link->key = key;
+      } else if ( key != link->key ) {
+         link->key = key;
+         // A key the host has not followed yet. A radio that sends MOX
+         // back in the PTT bit is not a key.
+         if ( !link->have_mox || key != link->mox ) {
+            hpsdr_u_ptt_start(link, &link->key_change, key ? PTT_KEY_ON : PTT_KEY_OFF, FALSE, now, frame_num);
+         } else if ( link->key_change.waiting ) {
+            link->unanswered[link->key_change.kind] += 1;
+            link->key_change.waiting = FALSE;
+         }
+      }
+
+      // The key is only the TX state when the host did not follow the key.
+      tx = link->rf || ( !change->by_key && key );
+      if ( link->mox && tx ) { link->tx_seen = TRUE; }
+
+      if ( !change->waiting ) { continue; }
+
+      if ( change->state && tx ) {
+         hpsdr_u_ptt_done(link, change, now, frame_num);
+      } else if ( !change->state && !tx && link->tx_seen ) {
+         hpsdr_u_ptt_done(link, change, now, frame_num);
+      }
+   }
+}
+
+static tap_packet_status
+hpsdr_u_ptt_packet(void *tapdata, packet_info *pinfo, epan_dissect_t *edt _U_, const void *data)
+{
+   hpsdr_u_ptt_t *ptt = (hpsdr_u_ptt_t *)tapdata;
+   const hpsdr_u_tap_info_t *tap_info = (const hpsdr_u_tap_info_t *)data;
+   hpsdr_u_ptt_link_t *link = NULL;
+   double now = 0;
+
+   if ( tap_info->end_point != 2 && tap_info->end_point != 6 ) { return TAP_PACKET_DONT_REDRAW; }
+
+   link = hpsdr_u_ptt_link(ptt, pinfo, tap_info);
+   now = nstime_to_sec(&pinfo->rel_ts);
+
+   if ( tap_info->end_point == 2 ) {
+      hpsdr_u_ptt_ep2(link, tap_info, now, pinfo->num);
+   } else {
+      hpsdr_u_ptt_ep6(link, tap_info, now, pinfo->num);
+   }
+
+   return TAP_PACKET_REDRAW;
+}
+
+static void hpsdr_u_ptt_csv(hpsdr_u_ptt_t *ptt, hpsdr_u_ptt_link_t *link)
+{
+   FILE *fh = NULL;
+   gchar *file_name = NULL;
+   hpsdr_u_ptt_event_t *event = NULL;
+   guint x = 0;
+
+   file_name = hpsdr_u_tap_file_name(ptt->csv_prefix, link->name, ".csv");
+   fh = ws_fopen(file_name, "w");
+   if ( fh == NULL ) {
+      fprintf(stderr, "tshark: hpsdr-u,ptt can not open %s\n", file_name);
+      g_free(file_name);
+      return;
+   }
+
+   fprintf(fh, "radio,host,change,start_s,frame,answer_frame,latency_ms\n");
+
+   for (x = 0; x < link->events->len; x++) {
+      event = &g_array_index(link->events, hpsdr_u_ptt_event_t, x);
+      fprintf(fh, "%s,%s,%s,%.6f,%u,%u,%.3f\n", link->radio, link->host, hpsdr_u_ptt_csv_names[event->kind],
+              event->start, event->frame_num, event->done_frame, event->ms);
+   }
+
+   fclose(fh);
+   g_free(file_name);
+}
+
+static void hpsdr_u_ptt_draw(void *tapdata)
+{
+   hpsdr_u_ptt_t *ptt = (hpsdr_u_ptt_t *)tapdata;
+   hpsdr_u_ptt_link_t *link = NULL;
+   hpsdr_u_tap_dist_t *dist = NULL;
+   GList *links = NULL;
+   GList *item = NULL;
+   int k = -1;
+
+   links = hpsdr_u_tap_radio_list(ptt->links);
+
+   printf("\n");
+   printf("===================================================================\n");
+   printf("HPSDR-USB MOX / PTT Turnaround Latency - ms at the capture point\n");
+
+   for (item = links; item != NULL; item = item->next) {
+      link = (hpsdr_u_ptt_link_t *)item->data;
+
+      printf("\nRadio: %s  Host: %s\n", link->radio, link->host);
+      printf(" Change              Changes  Answered  Not Answered     Min ms     p50 ms     p99 ms     Max ms\n");
+      for (k = 0; k < PTT_NUM; k++) {
+         dist = &link->dist[k];
+         printf(" %-18s %8u %9u %13u", hpsdr_u_ptt_names[k], link->changes[k], hpsdr_u_tap_dist_count(dist),
+                link->unanswered[k]);
+         if ( hpsdr_u_tap_dist_count(dist) > 0 ) {
+            printf(" %10.3f %10.3f %10.3f %10.3f", hpsdr_u_tap_dist_percentile(dist, 0),
+                   hpsdr_u_tap_dist_percentile(dist, 50), hpsdr_u_tap_dist_percentile(dist, 99),
+                   hpsdr_u_tap_dist_percentile(dist, 100));
+         }
+         printf("\n");
+      }
+
+      if ( link->changes[PTT_MOX_ON] > 0 && hpsdr_u_tap_dist_count(&link->dist[PTT_MOX_ON]) == 0 ) {
+         printf("  The radio never showed TX, no power readings or PTT bit.\n");
+      }
+
+      if ( ptt->csv_prefix != NULL ) { hpsdr_u_ptt_csv(ptt, link); }
+   }
+
+   printf("===================================================================\n");
+
+   g_list_free(links);
+}
+
+static void hpsdr_u_ptt_finish(void *tapdata)
+{
+   hpsdr_u_ptt_t *ptt = (hpsdr_u_ptt_t *)tapdata;
+
+   g_hash_table_destroy(ptt->links);
+   g_free(ptt->csv_prefix);
+   g_free(ptt);
+}
+
+static void hpsdr_u_ptt_init(const char *opt_arg, void *userdata _U_)
+{
+   hpsdr_u_ptt_t *ptt = NULL;
+   gchar **args = NULL;
+   const gchar *filter = NULL;
+
+   args = hpsdr_u_tap_args(opt_arg, "hpsdr-u,ptt", 1, &filter);
+
+   ptt = g_new0(hpsdr_u_ptt_t, 1);
+   if ( args[0][0] != '\0' ) { ptt->csv_prefix = g_strdup(args[0]); }
+   ptt->links = hpsdr_u_tap_radio_table(hpsdr_u_ptt_link_free);
+   g_strfreev(args);
+
+   hpsdr_u_tap_listen("hpsdr-u,ptt", ptt, filter, hpsdr_u_ptt_reset,
+                      hpsdr_u_ptt_packet, hpsdr_u_ptt_draw, hpsdr_u_ptt_finish);
+}
+
+static stat_tap_ui hpsdr_u_ptt_ui = {
+   REGISTER_STAT_GROUP_GENERIC,
+   NULL,
+   "hpsdr-u,ptt",
+   hpsdr_u_ptt_init,
+   0,
+   NULL
+};
+
+void register_hpsdr_u_ptt_tap(void)
+{
+   register_stat_tap_ui(&hpsdr_u_ptt_ui, NULL);
+}
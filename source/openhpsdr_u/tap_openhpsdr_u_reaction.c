@@ -0,0 +1,458 @@
+/* tap_openhpsdr_u_reaction.c
+ * OpenHPSDR USB over IP protocol host reaction time from EP6 arrival to EP2 send
+ *
+ * Version: 0.5.0
+ * Author:  Matthew J Wolf, N4MTT
+ *
+ * This file is part of the OpenHPSDR-USB Plug-in for Wireshark.
+ * Matthew J. Wolf <matthew.wolf.hpsdr@speciosus.net>
+ * Copyright 2020 Matthew J. Wolf
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * The OpenHPSDR-USB Plug-in for Wireshark is free software: you can
+ * redistribute it and/or modify it under the terms of the GNU
+ * General Public License as published by the Free Software Foundation,
+ * either version 2 of the License, or (at your option) any later version.
+ *
+ * The OpenHPSDR-USB Plug-in for Wireshark is distributed in the hope that
+ * it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See
+ * the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the OpenHPSDR-USB Plug-in for Wireshark.
+ * If not, see <http://www.gnu.org/licenses/>.
+ *
+ * tshark -z hpsdr-u,reaction[,<outlier ms>[,<csv file prefix>[,<filter>]]]
+ *
+ * Host reaction time for every radio and host: the time from the last EP6
+ * datagram to the next EP2 datagram the host sends. On a capture taken at
+ * the host it is the processing loop latency of the host application. A
+ * EP2 datagram with no EP6 datagram since the EP2 datagram before it is
+ * counted, it is not a reaction time.
+ *
+ * The reaction times are split by a EP6 sequence gap in the EP6 datagrams
+ * the host reacted to. The outliers are the reaction times over <outlier
+ * ms>, the largest 0.1% (p99.9) when not given. An outlier near a EP6
+ * sequence gap has a gap within REACTION_NEAR of the EP2 datagram. The part
+ * of the capture time near a gap is the part expected by chance.
+ *
+ *  <csv file prefix>_<radio>-<host>.csv  Every reaction time
+ */
+
+#include <epan/packet.h>
+#include <epan/tap.h>
+#include <epan/stat_tap_ui.h>
+#include <wsutil/file_util.h>
+
+#include <stdlib.h>
+#include <string.h>
+#include "sample_openhpsdr_u.h"
+#include "tap_openhpsdr_u.h"
+
+#define REACTION_NEAR   0.010   // Seconds from a EP6 sequence gap
+#define REACTION_LISTED 20      // Outliers listed
+#define REACTION_BINS   10
+
+// Upper edges of the histogram bins in ms, the last bin has the rest.
+static const double hpsdr_u_reaction_edges[REACTION_BINS - 1] = {
+   0.1, 0.2, 0.5, 1.0, 2.0, 5.0, 10.0, 20.0, 50.0
+};
+
+typedef struct _hpsdr_u_reaction_time_t {
+   double time;                 // EP2 datagram, seconds from the start of the capture
+   double ms;                   // Reaction time
+   guint32 ep2_frame;
+   guint32 ep6_frame;           // Last EP6 datagram before the EP2 datagram
+   guint32 ep6_count;           // EP6 datagrams since the EP2 datagram before
+   gboolean gap;                // A EP6 sequence gap in those EP6 datagrams
+} hpsdr_u_reaction_time_t;
+
+typedef struct _hpsdr_u_reaction_gap_t {
+   double time;
+   guint32 frame_num;
+   guint32 missing;             // EP6 datagrams missing
+} hpsdr_u_reaction_gap_t;
+
+typedef struct _hpsdr_u_reaction_link_t {
+   gchar *name;                 // <radio>-<host>
+   gchar *radio;
+   gchar *host;
+   GArray *times;               // hpsdr_u_reaction_time_t
+   GArray *gaps;                // hpsdr_u_reaction_gap_t, in time order
+   guint32 ep2_datagrams;
+   guint32 ep2_no_ep6;          // EP2 datagrams with no EP6 datagram since the one before
+   guint32 ep6_datagrams;
+   guint32 ep6_last_seq;
+   guint32 ep6_restarts;        // The radio started the sequence numbers again
+   double ep6_time;             // Last EP6 datagram
+   guint32 ep6_frame;
+   guint32 ep6_count;           // EP6 datagrams since the last EP2 datagram
+   gboolean ep6_gap;            // A sequence gap since the last EP2 datagram
+   double first;
+   double last;
+} hpsdr_u_reaction_link_t;
+
+typedef struct _hpsdr_u_reaction_t {
+   double outlier_ms;           // 0 is p99.9
+   gchar *csv_prefix;
+   GHashTable *links;
+} hpsdr_u_reaction_t;
+
+static void hpsdr_u_reaction_link_free(gpointer record)
+{
+   hpsdr_u_reaction_link_t *link = (hpsdr_u_reaction_link_t *)record;
+
+   if ( link->times != NULL ) { g_array_free(link->times, TRUE); }
+   if ( link->gaps != NULL ) { g_array_free(link->gaps, TRUE); }
+   hpsdr_u_tap_link_free(link);
+}
+
+static void hpsdr_u_reaction_reset(void *tapdata)
+{
+   hpsdr_u_reaction_t *reaction = (hpsdr_u_reaction_t *)tapdata;
+
+   g_hash_table_remove_all(reaction->links);
+}
+
+static tap_packet_status
+hpsdr_u_reaction_packet(void *tapdata, packet_info *pinfo, epan_dissect_t *edt _U_, const void *data)
+{
+   hpsdr_u_reaction_t *reaction = (hpsdr_u_reaction_t *)tapdata;
+   const hpsdr_u_tap_info_t *tap_info = (const hpsdr_u_tap_info_t *)data;
+   hpsdr_u_reaction_link_t *link = NULL;
+   hpsdr_u_reaction_time_t time;
+   hpsdr_u_reaction_gap_t gap;
+   gint32 delta = 0;
+   double now = 0;
+
+   if ( tap_info->end_point != 2 && tap_info->end_point != 6 ) { return TAP_PACKET_DONT_REDRAW; }
+
+   link = (hpsdr_u_reaction_link_t *)hpsdr_u_tap_link_lookup(reaction->links, pinfo, tap_info, sizeof(hpsdr_u_reaction_link_t));
+   if ( link->times == NULL ) {
+      link->times = g_array_new(FALSE, FALSE, sizeof(hpsdr_u_reaction_time_t));
+      link->gaps = g_array_new(FALSE, FALSE, sizeof(hpsdr_u_reaction_gap_t));
+   }
+
+   now = nstime_to_sec(&pinfo->rel_ts);
+   if ( link->ep2_datagrams == 0 && link->ep6_datagrams == 0 ) { link->first = now; }
+   link->last = now;
+
+   if ( tap_info->end_point == 6 ) {
+      delta = (gint32)( tap_info->seq - link->ep6_last_seq );
+
+      // A sequence number a little behind is a late datagram, not a gap.
+      // Further back or far ahead the radio started the sequence again.
+      if ( link->ep6_datagrams == 0 || delta < -HPSDR_U_SAMPLE_LATE_MAX || delta > HPSDR_U_SAMPLE_GAP_MAX ) {
+         if ( link->ep6_datagrams > 0 ) { link->ep6_restarts += 1; }
+         link->ep6_last_seq = tap_info->seq;
+      } else if ( delta > 0 ) {
+         if ( delta > 1 ) {
+            gap.time = now;
+            gap.frame_num = pinfo->num;
+            gap.missing = delta - 1;
+            g_array_append_val(link->gaps, gap);
+            link->ep6_gap = TRUE;
+         }
+         link->ep6_last_seq = tap_info->seq;
+      }
+
+      link->ep6_datagrams += 1;
+      link->ep6_time = now;
+      link->ep6_frame = pinfo->num;
+      link->ep6_count += 1;
+      return TAP_PACKET_REDRAW;
+   }
+
+   link->ep2_datagrams += 1;
+
+   if ( link->ep6_count == 0 ) {
+      link->ep2_no_ep6 += 1;
+      return TAP_PACKET_REDRAW;
+   }
+
+   time.time = now;
+   time.ms = ( now - link->ep6_time ) * 1000.0;
+   time.ep2_frame = pinfo->num;
+   time.ep6_frame = link->ep6_frame;
+   time.ep6_count = link->ep6_count;
+   time.gap = link->ep6_gap;
+   g_array_append_val(link->times, time);
+
+   link->ep6_count = 0;
+   link->ep6_gap = FALSE;
+
+   return TAP_PACKET_REDRAW;
+}
+
+// Distance in seconds from time to the nearest EP6 sequence gap, -1 no gaps.
+static double hpsdr_u_reaction_gap_distance(GArray *gaps, double time)
+{
+   guint low = 0;
+   guint high = gaps->len;
+   guint mid = 0;
+   double distance = -1;
+
+   if ( gaps->len == 0 ) { return -1; }
+
+   // First gap at or after time
+   while ( low < high ) {
+      mid = low + (( high - low ) / 2 );
+      if ( g_array_index(gaps, hpsdr_u_reaction_gap_t, mid).time < time ) {
+         low = mid + 1;
+      } else {
+         high = mid;
+      }
+   }
+
+   if ( low < gaps->len ) { distance = g_array_index(gaps, hpsdr_u_reaction_gap_t, low).time - time; }
+   if ( low > 0 && ( distance < 0 || time - g_array_index(gaps, hpsdr_u_reaction_gap_t, low - 1).time < distance ) ) {
+      distance = time - g_array_index(gaps, hpsdr_u_reaction_gap_t, low - 1).time;
+   }
+
+   return distance;
+}
+
+// Part of the capture time within REACTION_NEAR of a EP6 sequence gap.
+static double hpsdr_u_reaction_near_part(const hpsdr_u_reaction_link_t *link)
+{
+   double span = link->last - link->first;
+   double near = 0;
+   double start = 0;
+   double end = 0;
+   double covered = link->first;
+   guint x = 0;
+
+   if ( span <= 0 ) { return 0; }
+
+   for (x = 0; x < link->gaps->len; x++) {
+      start = MAX(g_array_index(link->gaps, hpsdr_u_reaction_gap_t, x).time - REACTION_NEAR, covered);
+      end = MIN(g_array_index(link->gaps, hpsdr_u_reaction_gap_t, x).time + REACTION_NEAR, link->last);
+      if ( end > start ) {
+         near += end - start;
+         covered = end;
+      }
+   }
+
+   return near / span;
+}
+
+static gint hpsdr_u_reaction_compare(gconstpointer a, gconstpointer b)
+{
+   double x = ((const hpsdr_u_reaction_time_t *)a)->ms;
+   double y = ((const hpsdr_u_reaction_time_t *)b)->ms;
+
+   return ( x < y ) - ( x > y );
+}
+
+static void hpsdr_u_reaction_print_dist(const gchar *label, hpsdr_u_tap_dist_t *dist)
+{
+   printf("  %-12s %9u", label, hpsdr_u_tap_dist_count(dist));
+   if ( hpsdr_u_tap_dist_count(dist) == 0 ) {
+      printf("\n");
+      return;
+   }
+   printf(" %9.3f %9.3f %9.3f %9.3f %9.3f %9.3f\n", hpsdr_u_tap_dist_percentile(dist, 0),
+          hpsdr_u_tap_dist_percentile(dist, 50), hpsdr_u_tap_dist_percentile(dist, 90),
+          hpsdr_u_tap_dist_percentile(dist, 99), hpsdr_u_tap_dist_percentile(dist, 99.9),
+          hpsdr_u_tap_dist_percentile(dist, 100));
+}
+
+static void hpsdr_u_reaction_csv(hpsdr_u_reaction_t *reaction, hpsdr_u_reaction_link_t *link)
+{
+   hpsdr_u_reaction_time_t *time = NULL;
+   gchar *file_name = NULL;
+   FILE *fh = NULL;
+   guint x = 0;
+
+   file_name = hpsdr_u_tap_file_name(reaction->csv_prefix, link->name, ".csv");
+   fh = ws_fopen(file_name, "w");
+   if ( fh == NULL ) {
+      fprintf(stderr, "tshark: hpsdr-u,reaction can not open %s\n", file_name);
+      g_free(file_name);
+      return;
+   }
+
+   fprintf(fh, "radio,host,time_s,ep6_frame,ep2_frame,reaction_ms,ep6_datagrams,ep6_gap\n");
+   for (x = 0; x < link->times->len; x++) {
+      time = &g_array_index(link->times, hpsdr_u_reaction_time_t, x);
+      fprintf(fh, "%s,%s,%.6f,%u,%u,%.3f,%u,%d\n", link->radio, link->host, time->time, time->ep6_frame,
+              time->ep2_frame, time->ms, time->ep6_count, time->gap ? 1 : 0);
+   }
+
+   fclose(fh);
+   g_free(file_name);
+}
+
+static void hpsdr_u_reaction_link_draw(hpsdr_u_reaction_t *reaction, hpsdr_u_reaction_link_t *link)
+{
+   hpsdr_u_reaction_time_t *time = NULL;
+   hpsdr_u_tap_dist_t all;
+   hpsdr_u_tap_dist_t gap;
+   hpsdr_u_tap_dist_t no_gap;
+   GArray *outliers = NULL;
+   guint32 bins[REACTION_BINS];
+   guint32 near = 0;
+   guint32 missing = 0;
+   double threshold = 0;
+   double near_part = 0;
+   double distance = 0;
+   int bin = 0;
+   guint x = 0;
+
+   memset(&all, 0, sizeof(all));
+   memset(&gap, 0, sizeof(gap));
+   memset(&no_gap, 0, sizeof(no_gap));
+   memset(bins, 0, sizeof(bins));
+
+   for (x = 0; x < link->times->len; x++) {
+      time = &g_array_index(link->times, hpsdr_u_reaction_time_t, x);
+      hpsdr_u_tap_dist_add(&all, time->ms);
+      hpsdr_u_tap_dist_add(time->gap ? &gap : &no_gap, time->ms);
+
+      for (bin = 0; bin < REACTION_BINS - 1 && time->ms > hpsdr_u_reaction_edges[bin]; bin++) { }
+      bins[bin] += 1;
+   }
+
+   for (x = 0; x < link->gaps->len; x++) {
+      missing += g_array_index(link->gaps, hpsdr_u_reaction_gap_t, x).missing;
+   }
+
+   printf("\nRadio: %s  Host: %s\n", link->radio, link->host);
+   printf(" EP2 Datagrams: %u  Reactions: %u  No EP6 Since the EP2 Before: %u\n", link->ep2_datagrams,
+          link->times->len, link->ep2_no_ep6);
+   printf(" EP6 Datagrams: %u  Sequence Gaps: %u  Missing: %u  Sequence Restarts: %u\n", link->ep6_datagrams,
+          link->gaps->len, missing, link->ep6_restarts);
+
+   if ( link->times->len == 0 ) {
+      hpsdr_u_tap_dist_free(&all);
+      return;
+   }
+
+   printf(" Reaction ms         Count       Min       p50       p90       p99     p99.9       Max\n");
+   hpsdr_u_reaction_print_dist("All", &all);
+   hpsdr_u_reaction_print_dist("EP6 gap", &gap);
+   hpsdr_u_reaction_print_dist("No EP6 gap", &no_gap);
+
+   printf(" Histogram ms\n");
+   for (bin = 0; bin < REACTION_BINS; bin++) {
+      if ( bin == 0 ) {
+         printf("  %6s - %6.1f", "0", hpsdr_u_reaction_edges[0]);
+      } else if ( bin < REACTION_BINS - 1 ) {
+         printf("  %6.1f - %6.1f", hpsdr_u_reaction_edges[bin - 1], hpsdr_u_reaction_edges[bin]);
+      } else {
+         printf("  %6.1f - %6s", hpsdr_u_reaction_edges[bin - 1], "");
+      }
+      printf(" %9u %8.3f%%\n", bins[bin], 100.0 * bins[bin] / link->times->len);
+   }
+
+   threshold = ( reaction->outlier_ms > 0 ) ? reaction->outlier_ms : hpsdr_u_tap_dist_percentile(&all, 99.9);
+
+   outliers = g_array_new(FALSE, FALSE, sizeof(hpsdr_u_reaction_time_t));
+   for (x = 0; x < link->times->len; x++) {
+      time = &g_array_index(link->times, hpsdr_u_reaction_time_t, x);
+      if ( time->ms < threshold || ( reaction->outlier_ms > 0 && time->ms == threshold ) ) { continue; }
+      g_array_append_val(outliers, *time);
+
+      distance = hpsdr_u_reaction_gap_distance(link->gaps, time->time);
+      if ( distance >= 0 && distance <= REACTION_NEAR ) { near += 1; }
+   }
+   g_array_sort(outliers, hpsdr_u_reaction_compare);
+
+   near_part = hpsdr_u_reaction_near_part(link);
+   printf(" Outliers (%s %.3f ms): %u  Near a EP6 gap: %u (%.1f%%)  Capture time near a EP6 gap: %.1f%%\n",
+          ( reaction->outlier_ms > 0 ) ? "over" : "p99.9", threshold, outliers->len, near,
+          ( outliers->len > 0 ) ? 100.0 * near / outliers->len : 0.0, 100.0 * near_part);
+
+   if ( outliers->len > 0 ) {
+      printf(" Largest %u outliers\n", MIN(outliers->len, REACTION_LISTED));
+      printf("  EP6 Frame  EP2 Frame       Time s  Reaction ms  EP6  Gap  Nearest Gap ms\n");
+      for (x = 0; x < outliers->len && x < REACTION_LISTED; x++) {
+         time = &g_array_index(outliers, hpsdr_u_reaction_time_t, x);
+         distance = hpsdr_u_reaction_gap_distance(link->gaps, time->time);
+         printf(" %10u %10u %12.6f %12.3f %4u %4s", time->ep6_frame, time->ep2_frame, time->time, time->ms,
+                time->ep6_count, time->gap ? "yes" : "no");
+         if ( distance >= 0 ) {
+            printf(" %15.3f\n", distance * 1000);
+         } else {
+            printf(" %15s\n", "-");
+         }
+      }
+   }
+
+   g_array_free(outliers, TRUE);
+   hpsdr_u_tap_dist_free(&all);
+   hpsdr_u_tap_dist_free(&gap);
+   hpsdr_u_tap_dist_free(&no_gap);
+}
+
+static void hpsdr_u_reaction_draw(void *tapdata)
+{
+   hpsdr_u_reaction_t *reaction = (hpsdr_u_reaction_t *)tapdata;
+   hpsdr_u_reaction_link_t *link = NULL;
+   GList *links = NULL;
+   GList *item = NULL;
+
+   links = hpsdr_u_tap_radio_list(reaction->links);
+
+   printf("\n");
+   printf("===================================================================\n");
+   printf("HPSDR-USB Host Reaction Time - last EP6 datagram to the next EP2 datagram\n");
+
+   for (item = links; item != NULL; item = item->next) {
+      link = (hpsdr_u_reaction_link_t *)item->data;
+      if ( link->ep2_datagrams == 0 ) { continue; }
+
+      hpsdr_u_reaction_link_draw(reaction, link);
+      if ( reaction->csv_prefix != NULL ) { hpsdr_u_reaction_csv(reaction, link); }
+   }
+
+   printf("===================================================================\n");
+
+   g_list_free(links);
+}
+
+static void hpsdr_u_reaction_finish(void *tapdata)
+{
+   hpsdr_u_reaction_t *reaction = (hpsdr_u_reaction_t *)tapdata;
+
+   g_hash_table_destroy(reaction->links);
+   g_free(reaction->csv_prefix);
+   g_free(reaction);
+}
+
+static void hpsdr_u_reaction_init(const char *opt_arg, void *userdata _U_)
+{
+   hpsdr_u_reaction_t *reaction = NULL;
+   gchar **args = NULL;
+   const gchar *filter = NULL;
+
+   args = hpsdr_u_tap_args(opt_arg, "hpsdr-u,reaction", 2, &filter);
+
+   reaction = g_new0(hpsdr_u_reaction_t, 1);
+   reaction->outlier_ms = hpsdr_u_tap_number(args[0], "hpsdr-u,reaction", "outlier ms", 0);
+   if ( reaction->outlier_ms < 0 ) { reaction->outlier_ms = 0; }
+   if ( args[1][0] != '\0' ) { reaction->csv_prefix = g_strdup(args[1]); }
+   reaction->links = hpsdr_u_tap_radio_table(hpsdr_u_reaction_link_free);
+   g_strfreev(args);
+
+   hpsdr_u_tap_listen("hpsdr-u,reaction", reaction, filter, hpsdr_u_reaction_reset,
+                      hpsdr_u_reaction_packet, hpsdr_u_reaction_draw, hpsdr_u_reaction_finish);
+}
+
+static stat_tap_ui hpsdr_u_reaction_ui = {
+   REGISTER_STAT_GROUP_GENERIC,
+   NULL,
+   "hpsdr-u,reaction",
+   hpsdr_u_reaction_init,
+   0,
+   NULL
+};
+
+void register_hpsdr_u_reaction_tap(void)
+{
+   register_stat_tap_ui(&hpsdr_u_reaction_ui, NULL);
+}
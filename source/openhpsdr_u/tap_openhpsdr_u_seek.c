@@ -0,0 +1,169 @@
+/* tap_openhpsdr_u_seek.c
+ * OpenHPSDR USB over IP protocol EP6 datagram of a IQ sample number
+ *
+ * Version: 0.5.0
+ * Author:  Matthew J Wolf, N4MTT
+ *
+ * This file is part of the OpenHPSDR-USB Plug-in for Wireshark.
+ * Matthew J. Wolf <matthew.wolf.hpsdr@speciosus.net>
+ * Copyright 2020 Matthew J. Wolf
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * The OpenHPSDR-USB Plug-in for Wireshark is free software: you can
+ * redistribute it and/or modify it under the terms of the GNU
+ * General Public License as published by the Free Software Foundation,
+ * either version 2 of the License, or (at your option) any later version.
+ *
+ * The OpenHPSDR-USB Plug-in for Wireshark is distributed in the hope that
+ * it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See
+ * the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the OpenHPSDR-USB Plug-in for Wireshark.
+ * If not, see <http://www.gnu.org/licenses/>.
+ *
+ * tshark -z hpsdr-u,seek,<sample>[,<filter>]
+ *
+ * The EP6 datagram that has the absolute IQ sample number <sample>, for
+ * every radio and host. The samples are numbered per conversation by the
+ * dissector (hpsdr-u.sample.first), the tap keeps the sample index of the
+ * conversation and looks the sample up at the report with a binary search.
+ */
+
+#include <epan/packet.h>
+#include <epan/tap.h>
+#include <epan/stat_tap_ui.h>
+
+#include <stdlib.h>
+#include <string.h>
+#include "tap_openhpsdr_u.h"
+#include "sample_openhpsdr_u.h"
+
+typedef struct _hpsdr_u_seek_link_t {
+   gchar *name;                 // <radio>-<host>
+   gchar *radio;
+   gchar *host;
+   wmem_array_t *index;         // Sample index of the conversation, file scope
+   guint32 datagrams;           // EP6 datagrams with sample numbers
+} hpsdr_u_seek_link_t;
+
+typedef struct _hpsdr_u_seek_t {
+   guint64 sample;
+   GHashTable *links;
+} hpsdr_u_seek_t;
+
+static void hpsdr_u_seek_reset(void *tapdata)
+{
+   hpsdr_u_seek_t *seek = (hpsdr_u_seek_t *)tapdata;
+
+   g_hash_table_remove_all(seek->links);
+}
+
+static tap_packet_status
+hpsdr_u_seek_packet(void *tapdata, packet_info *pinfo, epan_dissect_t *edt _U_, const void *data)
+{
+   hpsdr_u_seek_t *seek = (hpsdr_u_seek_t *)tapdata;
+   const hpsdr_u_tap_info_t *tap_info = (const hpsdr_u_tap_info_t *)data;
+   hpsdr_u_seek_link_t *link = NULL;
+
+   if ( tap_info->end_point != 6 || !tap_info->have_sample || tap_info->sample_index == NULL ) {
+      return TAP_PACKET_DONT_REDRAW;
+   }
+
+   link = (hpsdr_u_seek_link_t *)hpsdr_u_tap_link_lookup(seek->links, pinfo, tap_info, sizeof(hpsdr_u_seek_link_t));
+   link->index = tap_info->sample_index;
+   link->datagrams += 1;
+
+   return TAP_PACKET_REDRAW;
+}
+
+static void hpsdr_u_seek_draw(void *tapdata)
+{
+   hpsdr_u_seek_t *seek = (hpsdr_u_seek_t *)tapdata;
+   hpsdr_u_seek_link_t *link = NULL;
+   const hpsdr_u_sample_entry_t *entry = NULL;
+   guint64 next_sample = 0;
+   GList *links = NULL;
+   GList *item = NULL;
+
+   links = hpsdr_u_tap_radio_list(seek->links);
+
+   printf("\n");
+   printf("===================================================================\n");
+   printf("HPSDR-USB EP6 Datagram of Sample %" G_GUINT64_FORMAT "\n", seek->sample);
+
+   for (item = links; item != NULL; item = item->next) {
+      link = (hpsdr_u_seek_link_t *)item->data;
+
+      // The index is sorted by the first sample, the last entry is the end of the samples.
+      entry = (const hpsdr_u_sample_entry_t *)wmem_array_index(link->index, wmem_array_get_count(link->index) - 1);
+      next_sample = entry->first_sample + entry->samples;
+
+      printf("\nRadio: %s  Host: %s  EP6 Datagrams: %u  Samples: %" G_GUINT64_FORMAT "\n",
+             link->radio, link->host, link->datagrams, next_sample);
+
+      entry = hpsdr_u_sample_index_find(link->index, seek->sample);
+      if ( entry == NULL ) {
+         printf(" %s\n", ( seek->sample >= next_sample ) ? "After the end of the capture"
+                                                                : "In a gap or a late (out of order) datagram");
+         continue;
+      }
+
+      printf(" Frame: %u  First sample: %" G_GUINT64_FORMAT "  Samples: %u  Sample in the datagram: %u\n",
+             entry->frame_num, entry->first_sample, entry->samples, (guint32)( seek->sample - entry->first_sample ));
+   }
+
+   printf("===================================================================\n");
+
+   g_list_free(links);
+}
+
+static void hpsdr_u_seek_finish(void *tapdata)
+{
+   hpsdr_u_seek_t *seek = (hpsdr_u_seek_t *)tapdata;
+
+   g_hash_table_destroy(seek->links);
+   g_free(seek);
+}
+
+static void hpsdr_u_seek_init(const char *opt_arg, void *userdata _U_)
+{
+   hpsdr_u_seek_t *seek = NULL;
+   gchar **args = NULL;
+   const gchar *filter = NULL;
+   gchar *end = NULL;
+   guint64 sample = 0;
+
+   args = hpsdr_u_tap_args(opt_arg, "hpsdr-u,seek", 1, &filter);
+   sample = g_ascii_strtoull(args[0], &end, 10);
+   if ( args[0][0] == '\0' || *end != '\0' ) {
+      fprintf(stderr, "tshark: hpsdr-u,seek sample \"%s\" is not a sample number\n", args[0]);
+      exit(1);
+   }
+   g_strfreev(args);
+
+   seek = g_new0(hpsdr_u_seek_t, 1);
+   seek->sample = sample;
+   seek->links = hpsdr_u_tap_radio_table(hpsdr_u_tap_link_free);
+
+   hpsdr_u_tap_listen("hpsdr-u,seek", seek, filter, hpsdr_u_seek_reset,
+                      hpsdr_u_seek_packet, hpsdr_u_seek_draw, hpsdr_u_seek_finish);
+}
+
+static stat_tap_ui hpsdr_u_seek_ui = {
+   REGISTER_STAT_GROUP_GENERIC,
+   NULL,
+   "hpsdr-u,seek",
+   hpsdr_u_seek_init,
+   0,
+   NULL
+};
+
+void register_hpsdr_u_seek_tap(void)
+{
+   register_stat_tap_ui(&hpsdr_u_seek_ui, NULL);
+}
@@ -0,0 +1,654 @@
+/* tap_openhpsdr_u_spectrum.c
+ * OpenHPSDR USB over IP protocol EP6 receiver spectrum and noise floor
+ *
+ * Version: 0.5.0
+ * Author:  Matthew J Wolf, N4MTT
+ *
+ * This file is part of the OpenHPSDR-USB Plug-in for Wireshark.
+ * Matthew J. Wolf <matthew.wolf.hpsdr@speciosus.net>
+ * Copyright 2020 Matthew J. Wolf
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * The OpenHPSDR-USB Plug-in for Wireshark is free software: you can
+ * redistribute it and/or modify it under the terms of the GNU
+ * General Public License as published by the Free Software Foundation,
+ * either version 2 of the License, or (at your option) any later version.
+ *
+ * The OpenHPSDR-USB Plug-in for Wireshark is distributed in the hope that
+ * it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See
+ * the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the OpenHPSDR-USB Plug-in for Wireshark.
+ * If not, see <http://www.gnu.org/licenses/>.
+ *
+ * tshark -z hpsdr-u,spectrum[,<fft points>[,<interval seconds>[,<file prefix>[,<filter>]]]]
+ *
+ * Averaged power spectrum of the IQ samples of every receiver. A Hann
+ * windowed FFT (1024 points when not given, a power of 2 from 64 to 65536)
+ * is done on every block of fft points samples in order. The noise floor
+ * is the median bin and the spurs are the strongest peaks 10 dB or more
+ * over the noise floor. The frequencies are the EP2 RX 1 to RX 7 NCO
+ * frequency (C0 Type 0x02 to 0x08) plus the bin offset. When the NCO is
+ * not known the offset from the NCO is given. A interval with a retune is
+ * marked. The whole capture is always reported, the intervals and the
+ * spectrogram files are only made when a interval is given.
+ *
+ *  <file prefix>_<radio>_spectrum.csv  Noise floor and spurs per interval
+ *  <file prefix>_<radio>_rx<n>.csv      Spectrogram, dBFS per bin per interval
+ *  <file prefix>_<radio>_rx<n>.pgm      Spectrogram image, a line per interval
+ *
+ * The samples before and after missing datagrams are not put in the same
+ * FFT block.
+ */
+
+#include <epan/packet.h>
+#include <epan/tap.h>
+#include <epan/stat_tap_ui.h>
+#include <wsutil/file_util.h>
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include "tap_openhpsdr_u.h"
+#include "iq_openhpsdr_u.h"
+#include "fft_openhpsdr_u.h"
+
+#define SPECTRUM_FFT_POINTS 1024
+#define SPECTRUM_SPURS      5     // Spurs kept per interval
+#define SPECTRUM_SPUR_DB    10.0  // Over the noise floor
+#define SPECTRUM_RX_NCO     7     // EP2 C0 Type 0x02 to 0x08 is RX 1 to RX 7 NCO
+#define SPECTRUM_C0_RX1_NCO 0x02
+#define SPECTRUM_PGM_RANGE  10.0  // dB under the lowest noise floor that is black
+
+typedef struct _hpsdr_u_spectrum_spur_t {
+   double hz;                   // Absolute, or the offset from the NCO when it is not known
+   double dbfs;
+} hpsdr_u_spectrum_spur_t;
+
+// Noise floor and spurs of a receiver in a interval, or the whole capture.
+typedef struct _hpsdr_u_spectrum_row_t {
+   guint32 interval;            // Interval number from the start of the capture
+   int rx;                      // 0 is RX1
+   guint32 ffts;
+   guint32 nco_hz;              // 0 not known
+   guint32 rate;                // Sample rate Hz
+   gboolean retuned;            // NCO or sample rate changed in the interval
+   double floor_dbfs;
+   int spurs;
+   hpsdr_u_spectrum_spur_t spur[SPECTRUM_SPURS];
+} hpsdr_u_spectrum_row_t;
+
+typedef struct _hpsdr_u_spectrum_rx_t {
+   double *i;                   // FFT block being filled
+   double *q;
+   int fill;
+   double *power;               // Sum of |X|^2 of the interval
+   guint32 ffts;
+   gboolean retuned;
+   double *total_power;         // Sum of |X|^2 of the whole capture
+   guint32 total_ffts;
+   gboolean total_retuned;
+   GArray *lines;               // Spectrogram, fft points floats (dBFS) per interval
+} hpsdr_u_spectrum_rx_t;
+
+typedef struct _hpsdr_u_spectrum_radio_t {
+   gchar *name;
+   guint32 datagrams;           // EP6 datagrams with IQ samples
+   guint32 unknown_rx;          // EP6 datagrams skipped, number of receivers not known
+   guint32 gaps;                // Partial FFT blocks dropped at missing datagrams
+   int rx_num;                  // Number of receivers of the last datagram
+   int rx_max;                  // Largest number of receivers
+   guint64 next_sample;         // First sample of the next EP6 datagram
+   gboolean started;
+   guint32 interval;            // Interval of the FFT blocks being summed
+   guint32 nco[SPECTRUM_RX_NCO]; // EP2 NCO Hz, 0 not known
+   guint32 rate;
+   hpsdr_u_spectrum_rx_t *rx[HPSDR_U_RX_MAX];
+   GArray *rows;                // hpsdr_u_spectrum_row_t, only with a interval
+} hpsdr_u_spectrum_radio_t;
+
+typedef struct _hpsdr_u_spectrum_t {
+   const hpsdr_u_fft_plan_t *plan; // Made once, used for every receiver
+   double interval;             // Seconds, 0 when there are no intervals
+   gchar *file_prefix;
+   double *re;                  // FFT work space, fft points
+   double *im;
+   double *db;                  // dBFS per bin
+   double *sorted;              // dBFS per bin for the median
+   GHashTable *radios;
+} hpsdr_u_spectrum_t;
+
+static void hpsdr_u_spectrum_radio_free(gpointer record)
+{
+   hpsdr_u_spectrum_radio_t *radio = (hpsdr_u_spectrum_radio_t *)record;
+   hpsdr_u_spectrum_rx_t *rx = NULL;
+   int z = -1;
+
+   for (z = 0; z < HPSDR_U_RX_MAX; z++) {
+      rx = radio->rx[z];
+      if ( rx == NULL ) { continue; }
+
+      g_free(rx->i);
+      g_free(rx->q);
+      g_free(rx->power);
+      g_free(rx->total_power);
+      if ( rx->lines != NULL ) { g_array_free(rx->lines, TRUE); }
+      g_free(rx);
+   }
+
+   if ( radio->rows != NULL ) { g_array_free(radio->rows, TRUE); }
+   hpsdr_u_tap_radio_free(radio);
+}
+
+static hpsdr_u_spectrum_rx_t *hpsdr_u_spectrum_rx(hpsdr_u_spectrum_t *sp, hpsdr_u_spectrum_radio_t *radio, int z)
+{
+   hpsdr_u_spectrum_rx_t *rx = radio->rx[z];
+   int n = sp->plan->n;
+
+   if ( rx == NULL ) {
+      rx = g_new0(hpsdr_u_spectrum_rx_t, 1);
+      rx->i = g_new(double, n);
+      rx->q = g_new(double, n);
+      rx->power = g_new0(double, n);
+      rx->total_power = g_new0(double, n);
+      radio->rx[z] = rx;
+   }
+
+   return rx;
+}
+
+static void hpsdr_u_spectrum_reset(void *tapdata)
+{
+   hpsdr_u_spectrum_t *sp = (hpsdr_u_spectrum_t *)tapdata;
+
+   g_hash_table_remove_all(sp->radios);
+}
+
+static int hpsdr_u_spectrum_compare(const void *a, const void *b)
+{
+   double x = *(const double *)a;
+   double y = *(const double *)b;
+
+   return ( x > y ) - ( x < y );
+}
+
+// Noise floor and spurs of the summed spectrum. sp->db has the dBFS of
+// every bin after.
+static void hpsdr_u_spectrum_analyze(hpsdr_u_spectrum_t *sp, const double *power, hpsdr_u_spectrum_row_t *row)
+{
+   int n = sp->plan->n;
+   double full_scale = 0;
+   double p = 0;
+   double hz = 0;
+   int k = 0;
+   int s = 0;
+
+   full_scale = HPSDR_U_IQ_FULL_SCALE * sp->plan->window_sum;
+   full_scale = full_scale * full_scale * row->ffts;
+
+   for (k = 0; k < n; k++) {
+      p = power[k] / full_scale;
+      sp->db[k] = ( p > 0 ) ? 10.0 * log10(p) : HPSDR_U_IQ_DBFS_FLOOR;
+      if ( sp->db[k] < HPSDR_U_IQ_DBFS_FLOOR ) { sp->db[k] = HPSDR_U_IQ_DBFS_FLOOR; }
+   }
+
+   memcpy(sp->sorted, sp->db, n * sizeof(double));
+   qsort(sp->sorted, n, sizeof(double), hpsdr_u_spectrum_compare);
+   row->floor_dbfs = sp->sorted[n / 2];
+
+   // Local peaks, the strongest first.
+   row->spurs = 0;
+   for (k = 1; k < n - 1; k++) {
+      if ( sp->db[k] < row->floor_dbfs + SPECTRUM_SPUR_DB ) { continue; }
+      if ( sp->db[k] <= sp->db[k - 1] || sp->db[k] < sp->db[k + 1] ) { continue; }
+      if ( row->spurs == SPECTRUM_SPURS && sp->db[k] <= row->spur[SPECTRUM_SPURS - 1].dbfs ) { continue; }
+
+      hz = (double)row->nco_hz + ( (double)( k - ( n / 2 )) * row->rate / n );
+
+      s = ( row->spurs < SPECTRUM_SPURS ) ? row->spurs++ : SPECTRUM_SPURS - 1;
+      while ( s > 0 && row->spur[s - 1].dbfs < sp->db[k] ) {
+         row->spur[s] = row->spur[s - 1];
+         s--;
+      }
+      row->spur[s].hz = hz;
+      row->spur[s].dbfs = sp->db[k];
+   }
+}
+
+// End of a interval, the summed spectra become rows and spectrogram lines.
+static void hpsdr_u_spectrum_close(hpsdr_u_spectrum_t *sp, hpsdr_u_spectrum_radio_t *radio)
+{
+   hpsdr_u_spectrum_rx_t *rx = NULL;
+   hpsdr_u_spectrum_row_t row;
+   float *line = NULL;
+   int n = sp->plan->n;
+   int k = 0;
+   int z = -1;
+
+   for (z = 0; z < HPSDR_U_RX_MAX; z++) {
+      rx = radio->rx[z];
+      if ( rx == NULL || rx->ffts == 0 ) { continue; }
+
+      for (k = 0; k < n; k++) { rx->total_power[k] += rx->power[k]; }
+      rx->total_ffts += rx->ffts;
+      if ( rx->retuned ) { rx->total_retuned = TRUE; }
+
+      if ( sp->interval > 0 ) {
+         memset(&row, 0, sizeof(row));
+         row.interval = radio->interval;
+         row.rx = z;
+         row.ffts = rx->ffts;
+         row.nco_hz = ( z < SPECTRUM_RX_NCO ) ? radio->nco[z] : 0;
+         row.rate = radio->rate;
+         row.retuned = rx->retuned;
+         hpsdr_u_spectrum_analyze(sp, rx->power, &row);
+
+         if ( radio->rows == NULL ) { radio->rows = g_array_new(FALSE, FALSE, sizeof(hpsdr_u_spectrum_row_t)); }
+         g_array_append_val(radio->rows, row);
+
+         if ( rx->lines == NULL ) { rx->lines = g_array_new(FALSE, FALSE, sizeof(float)); }
+         g_array_set_size(rx->lines, rx->lines->len + n);
+         line = &g_array_index(rx->lines, float, rx->lines->len - n);
+         for (k = 0; k < n; k++) { line[k] = (float)sp->db[k]; }
+      }
+
+      memset(rx->power, 0, n * sizeof(double));
+      rx->ffts = 0;
+      rx->retuned = FALSE;
+   }
+}
+
+// The host sets the NCO of a receiver with a EP2 USB frame.
+static void hpsdr_u_spectrum_nco(hpsdr_u_spectrum_radio_t *radio, const hpsdr_u_tap_info_t *tap_info)
+{
+   const hpsdr_u_tap_frame_t *frame = NULL;
+   guint32 nco = 0;
+   int x = -1;
+   int z = -1;
+
+   for (x = 0; x < HPSDR_U_FRAMES; x++) {
+      frame = &tap_info->frame[x];
+      if ( !frame->have_cc ) { continue; }
+      if ( frame->c0_type < SPECTRUM_C0_RX1_NCO || frame->c0_type >= SPECTRUM_C0_RX1_NCO + SPECTRUM_RX_NCO ) {
+         continue;
+      }
+
+      z = frame->c0_type - SPECTRUM_C0_RX1_NCO;
+      nco = ( (guint32)frame->cc[1] << 24 ) | ( frame->cc[2] << 16 ) | ( frame->cc[3] << 8 ) | frame->cc[4];
+
+      if ( nco != radio->nco[z] && radio->rx[z] != NULL && radio->rx[z]->ffts > 0 ) { radio->rx[z]->retuned = TRUE; }
+      radio->nco[z] = nco;
+   }
+}
+
+static tap_packet_status
+hpsdr_u_spectrum_packet(void *tapdata, packet_info *pinfo, epan_dissect_t *edt _U_, const void *data)
+{
+   hpsdr_u_spectrum_t *sp = (hpsdr_u_spectrum_t *)tapdata;
+   const hpsdr_u_tap_info_t *tap_info = (const hpsdr_u_tap_info_t *)data;
+   hpsdr_u_spectrum_radio_t *radio = NULL;
+   hpsdr_u_spectrum_rx_t *rx = NULL;
+
+   gint32 i[HPSDR_U_IQ_FRAME_MAX];
+   gint32 q[HPSDR_U_IQ_FRAME_MAX];
+
+   guint32 interval = 0;
+   guint32 rate = 0;
+   int rx_num = -1;
+   int samp_num = -1;
+   int x = -1;
+   int z = -1;
+   int s = -1;
+
+   if ( tap_info->end_point != 2 && tap_info->end_point != 6 ) { return TAP_PACKET_DONT_REDRAW; }
+
+   radio = (hpsdr_u_spectrum_radio_t *)hpsdr_u_tap_radio_lookup(sp->radios,
+                                                                hpsdr_u_tap_radio_name(pinfo, tap_info),
+                                                                sizeof(hpsdr_u_spectrum_radio_t));
+
+   if ( tap_info->end_point == 2 ) {
+      hpsdr_u_spectrum_nco(radio, tap_info);
+      return TAP_PACKET_DONT_REDRAW;
+   }
+
+   rx_num = tap_info->rx_num;
+   if ( rx_num <= 0 || rx_num > HPSDR_U_RX_MAX ) {
+      radio->unknown_rx += 1;
+      return TAP_PACKET_DONT_REDRAW;
+   }
+
+   if ( sp->interval > 0 ) { interval = (guint32)( nstime_to_sec(&pinfo->rel_ts) / sp->interval ); }
+   if ( radio->started && interval != radio->interval ) { hpsdr_u_spectrum_close(sp, radio); }
+   radio->interval = interval;
+
+   rate = HPSDR_U_AUDIO_RATE << tap_info->speed_num;
+   for (z = 0; radio->started && rate != radio->rate && z < HPSDR_U_RX_MAX; z++) {
+      if ( radio->rx[z] != NULL && radio->rx[z]->ffts > 0 ) { radio->rx[z]->retuned = TRUE; }
+   }
+   radio->rate = rate;
+
+   // Missing datagrams or a new layout, the partial FFT blocks are dropped.
+   if ( radio->started && ( rx_num != radio->rx_num ||
+                            ( tap_info->have_sample && tap_info->first_sample != radio->next_sample ) ) ) {
+      for (z = 0; z < HPSDR_U_RX_MAX; z++) {
+         if ( radio->rx[z] != NULL && radio->rx[z]->fill > 0 ) {
+            radio->rx[z]->fill = 0;
+            radio->gaps += 1;
+         }
+      }
+   }
+
+   radio->started = TRUE;
+   radio->datagrams += 1;
+   radio->rx_num = rx_num;
+   if ( rx_num > radio->rx_max ) { radio->rx_max = rx_num; }
+
+   for (x = 0; x < HPSDR_U_FRAMES; x++) {
+      if ( tap_info->frame[x].data == NULL ) { continue; }
+
+      samp_num = hpsdr_u_iq_unpack(tap_info->frame[x].data, rx_num, i, q);
+      for (z = 0; z < rx_num; z++) {
+         rx = hpsdr_u_spectrum_rx(sp, radio, z);
+
+         for (s = 0; s < samp_num; s++) {
+            rx->i[rx->fill] = i[( z * samp_num ) + s];
+            rx->q[rx->fill] = q[( z * samp_num ) + s];
+            rx->fill += 1;
+
+            if ( rx->fill == sp->plan->n ) {
+               hpsdr_u_fft_power_add(sp->plan, rx->i, rx->q, sp->re, sp->im, rx->power);
+               rx->ffts += 1;
+               rx->fill = 0;
+            }
+         }
+      }
+   }
+
+   if ( tap_info->have_sample ) { radio->next_sample = tap_info->first_sample + ( HPSDR_U_FRAMES * hpsdr_u_ep6_samples(rx_num) ); }
+
+   return TAP_PACKET_REDRAW;
+}
+
+// Spectrum spurs, MHz when the NCO is known, kHz offset when it is not.
+static void hpsdr_u_spectrum_print_spurs(const hpsdr_u_spectrum_row_t *row, int count)
+{
+   int s = -1;
+
+   for (s = 0; s < row->spurs && s < count; s++) {
+      if ( row->nco_hz > 0 ) {
+         printf("  %.6f/%.1f", row->spur[s].hz / 1e6, row->spur[s].dbfs);
+      } else {
+         printf("  %+.3fk/%.1f", row->spur[s].hz / 1e3, row->spur[s].dbfs);
+      }
+   }
+   printf("\n");
+}
+
+static FILE *hpsdr_u_spectrum_open(hpsdr_u_spectrum_t *sp, hpsdr_u_spectrum_radio_t *radio, const gchar *suffix)
+{
+   FILE *fh = NULL;
+   gchar *file_name = NULL;
+
+   file_name = hpsdr_u_tap_file_name(sp->file_prefix, radio->name, suffix);
+   fh = ws_fopen(file_name, ( g_str_has_suffix(suffix, ".pgm") ) ? "wb" : "w");
+   if ( fh == NULL ) { fprintf(stderr, "tshark: hpsdr-u,spectrum can not open %s\n", file_name); }
+   g_free(file_name);
+
+   return fh;
+}
+
+static void hpsdr_u_spectrum_csv(hpsdr_u_spectrum_t *sp, hpsdr_u_spectrum_radio_t *radio)
+{
+   FILE *fh = NULL;
+   hpsdr_u_spectrum_row_t *row = NULL;
+   guint x = 0;
+   int s = -1;
+
+   fh = hpsdr_u_spectrum_open(sp, radio, "_spectrum.csv");
+   if ( fh == NULL ) { return; }
+
+   fprintf(fh, "radio,start_s,rx,ffts,nco_hz,rate_hz,retuned,floor_dbfs");
+   for (s = 0; s < SPECTRUM_SPURS; s++) { fprintf(fh, ",spur%d_hz,spur%d_dbfs", s + 1, s + 1); }
+   fprintf(fh, "\n");
+
+   for (x = 0; x < radio->rows->len; x++) {
+      row = &g_array_index(radio->rows, hpsdr_u_spectrum_row_t, x);
+
+      fprintf(fh, "%s,%.3f,%d,%u,", radio->name, row->interval * sp->interval, row->rx + 1, row->ffts);
+      if ( row->nco_hz > 0 ) { fprintf(fh, "%u", row->nco_hz); }
+      fprintf(fh, ",%u,%d,%.2f", row->rate, row->retuned ? 1 : 0, row->floor_dbfs);
+      for (s = 0; s < SPECTRUM_SPURS; s++) {
+         if ( s < row->spurs ) {
+            fprintf(fh, ",%.1f,%.2f", row->spur[s].hz, row->spur[s].dbfs);
+         } else {
+            fprintf(fh, ",,");
+         }
+      }
+      fprintf(fh, "\n");
+   }
+
+   fclose(fh);
+}
+
+// Spectrogram of a receiver as CSV and as a PGM (8 bit gray) image. The
+// lowest frequency is on the left, the first interval at the top. Black is
+// SPECTRUM_PGM_RANGE dB under the lowest noise floor, white the highest bin.
+static void hpsdr_u_spectrum_spectrogram(hpsdr_u_spectrum_t *sp, hpsdr_u_spectrum_radio_t *radio, int z)
+{
+   hpsdr_u_spectrum_rx_t *rx = radio->rx[z];
+   hpsdr_u_spectrum_row_t *row = NULL;
+   FILE *fh = NULL;
+   gchar suffix[32];
+   guint8 *pixels = NULL;
+   const float *line = NULL;
+   double low = 0;
+   double high = 0;
+   double v = 0;
+   guint lines = 0;
+   guint y = 0;
+   guint x = 0;
+   int n = sp->plan->n;
+   int k = 0;
+
+   lines = rx->lines->len / n;
+
+   // Rows of this receiver, in the same order as the lines.
+   g_snprintf(suffix, sizeof(suffix), "_rx%d.csv", z + 1);
+   fh = hpsdr_u_spectrum_open(sp, radio, suffix);
+   if ( fh != NULL ) {
+      fprintf(fh, "start_s,nco_hz");
+      for (k = 0; k < n; k++) { fprintf(fh, ",%.1f", (double)( k - ( n / 2 )) * radio->rate / n); }
+      fprintf(fh, "\n");
+
+      for (x = 0, y = 0; x < radio->rows->len && y < lines; x++) {
+         row = &g_array_index(radio->rows, hpsdr_u_spectrum_row_t, x);
+         if ( row->rx != z ) { continue; }
+
+         fprintf(fh, "%.3f,", row->interval * sp->interval);
+         if ( row->nco_hz > 0 ) { fprintf(fh, "%u", row->nco_hz); }
+         line = &g_array_index(rx->lines, float, y * n);
+         for (k = 0; k < n; k++) { fprintf(fh, ",%.2f", line[k]); }
+         fprintf(fh, "\n");
+         y++;
+      }
+
+      fclose(fh);
+   }
+
+   low = 0;
+   high = HPSDR_U_IQ_DBFS_FLOOR;
+   for (x = 0; x < radio->rows->len; x++) {
+      row = &g_array_index(radio->rows, hpsdr_u_spectrum_row_t, x);
+      if ( row->rx == z && row->floor_dbfs < low ) { low = row->floor_dbfs; }
+   }
+   low -= SPECTRUM_PGM_RANGE;
+   for (x = 0; x < rx->lines->len; x++) {
+      if ( g_array_index(rx->lines, float, x) > high ) { high = g_array_index(rx->lines, float, x); }
+   }
+   if ( high <= low ) { high = low + 1; }
+
+   g_snprintf(suffix, sizeof(suffix), "_rx%d.pgm", z + 1);
+   fh = hpsdr_u_spectrum_open(sp, radio, suffix);
+   if ( fh == NULL ) { return; }
+
+   pixels = g_new(guint8, rx->lines->len);
+   for (x = 0; x < rx->lines->len; x++) {
+      v = 255.0 * ( g_array_index(rx->lines, float, x) - low ) / ( high - low );
+      pixels[x] = (guint8)(( v < 0 ) ? 0 : ( ( v > 255 ) ? 255 : v ));
+   }
+
+   fprintf(fh, "P5\n# HPSDR-USB %s RX%d, %.2f to %.2f dBFS\n%d %u\n255\n", radio->name, z + 1, low, high, n, lines);
+   fwrite(pixels, 1, rx->lines->len, fh);
+
+   fclose(fh);
+   g_free(pixels);
+}
+
+static void hpsdr_u_spectrum_draw(void *tapdata)
+{
+   hpsdr_u_spectrum_t *sp = (hpsdr_u_spectrum_t *)tapdata;
+   hpsdr_u_spectrum_radio_t *radio = NULL;
+   hpsdr_u_spectrum_rx_t *rx = NULL;
+   hpsdr_u_spectrum_row_t *row = NULL;
+   hpsdr_u_spectrum_row_t total;
+   GList *radios = NULL;
+   GList *item = NULL;
+   guint32 interval = 0;
+   guint x = 0;
+   int z = -1;
+
+   radios = hpsdr_u_tap_radio_list(sp->radios);
+
+   printf("\n");
+   printf("===================================================================\n");
+   printf("HPSDR-USB EP6 Spectrum - %d point FFT, Hann window\n", sp->plan->n);
+   printf("0 dBFS is a IQ magnitude of 2^23, spurs are MHz/dBFS (kHz from the NCO)\n");
+
+   for (item = radios; item != NULL; item = item->next) {
+      radio = (hpsdr_u_spectrum_radio_t *)item->data;
+      if ( radio->datagrams == 0 ) { continue; }
+
+      // The last interval is still being summed.
+      hpsdr_u_spectrum_close(sp, radio);
+
+      printf("\nRadio: %s  EP6 Datagrams: %u  Receivers: %d\n", radio->name, radio->datagrams, radio->rx_max);
+      if ( radio->unknown_rx > 0 ) {
+         printf("  %u EP6 datagrams skipped, number of receivers not known.\n", radio->unknown_rx);
+      }
+      if ( radio->gaps > 0 ) { printf("  %u partial FFT blocks dropped at missing datagrams.\n", radio->gaps); }
+
+      printf(" RX      NCO MHz  Rate kHz     FFTs  Floor dBFS  Spurs\n");
+      for (z = 0; z < radio->rx_max; z++) {
+         rx = radio->rx[z];
+         if ( rx == NULL || rx->total_ffts == 0 ) { continue; }
+
+         memset(&total, 0, sizeof(total));
+         total.ffts = rx->total_ffts;
+         total.nco_hz = ( z < SPECTRUM_RX_NCO ) ? radio->nco[z] : 0;
+         total.rate = radio->rate;
+         hpsdr_u_spectrum_analyze(sp, rx->total_power, &total);
+
+         printf(" RX%-2d %11.6f %9.1f %8u %11.2f", z + 1, total.nco_hz / 1e6, total.rate / 1e3,
+                total.ffts, total.floor_dbfs);
+         hpsdr_u_spectrum_print_spurs(&total, SPECTRUM_SPURS);
+         if ( rx->total_retuned ) { printf("      Retuned in the capture, the spurs are at the last NCO.\n"); }
+      }
+
+      if ( radio->rows == NULL ) { continue; }
+
+      printf(" Interval: %.3f s  * retuned in the interval\n", sp->interval);
+      printf("  Start s  RX       NCO MHz     FFTs  Floor dBFS  Spurs\n");
+      for (x = 0; x < radio->rows->len; x++) {
+         row = &g_array_index(radio->rows, hpsdr_u_spectrum_row_t, x);
+
+         if ( x == 0 || row->interval != interval ) {
+            printf("%9.3f", row->interval * sp->interval);
+         } else {
+            printf("%9s", "");
+         }
+         interval = row->interval;
+
+         printf("  RX%-2d%c %11.6f %8u %11.2f", row->rx + 1, row->retuned ? '*' : ' ',
+                row->nco_hz / 1e6, row->ffts, row->floor_dbfs);
+         hpsdr_u_spectrum_print_spurs(row, 3);
+      }
+
+      if ( sp->file_prefix != NULL ) {
+         hpsdr_u_spectrum_csv(sp, radio);
+         for (z = 0; z < HPSDR_U_RX_MAX; z++) {
+            if ( radio->rx[z] != NULL && radio->rx[z]->lines != NULL ) { hpsdr_u_spectrum_spectrogram(sp, radio, z); }
+         }
+      }
+   }
+
+   printf("===================================================================\n");
+
+   g_list_free(radios);
+}
+
+static void hpsdr_u_spectrum_finish(void *tapdata)
+{
+   hpsdr_u_spectrum_t *sp = (hpsdr_u_spectrum_t *)tapdata;
+
+   g_hash_table_destroy(sp->radios);
+   g_free(sp->re);
+   g_free(sp->im);
+   g_free(sp->db);
+   g_free(sp->sorted);
+   g_free(sp->file_prefix);
+   g_free(sp);
+}
+
+static void hpsdr_u_spectrum_init(const char *opt_arg, void *userdata _U_)
+{
+   hpsdr_u_spectrum_t *sp = NULL;
+   gchar **args = NULL;
+   const gchar *filter = NULL;
+   const hpsdr_u_fft_plan_t *plan = NULL;
+   int n = -1;
+
+   args = hpsdr_u_tap_args(opt_arg, "hpsdr-u,spectrum", 3, &filter);
+
+   n = (int)hpsdr_u_tap_number(args[0], "hpsdr-u,spectrum", "fft points", SPECTRUM_FFT_POINTS);
+   plan = hpsdr_u_fft_plan(n);
+   if ( plan == NULL ) {
+      fprintf(stderr, "tshark: hpsdr-u,spectrum FFT points %d is not a power of 2 from %d to %d\n",
+              n, 1 << HPSDR_U_FFT_MIN_LOG2, 1 << HPSDR_U_FFT_MAX_LOG2);
+      g_strfreev(args);
+      exit(1);
+   }
+
+   sp = g_new0(hpsdr_u_spectrum_t, 1);
+   sp->plan = plan;
+   sp->interval = hpsdr_u_tap_number(args[1], "hpsdr-u,spectrum", "interval", 0);
+   if ( sp->interval < 0 ) { sp->interval = 0; }
+   if ( args[2][0] != '\0' ) { sp->file_prefix = g_strdup(args[2]); }
+   sp->re = g_new(double, n);
+   sp->im = g_new(double, n);
+   sp->db = g_new(double, n);
+   sp->sorted = g_new(double, n);
+   sp->radios = hpsdr_u_tap_radio_table(hpsdr_u_spectrum_radio_free);
+   g_strfreev(args);
+
+   hpsdr_u_tap_listen("hpsdr-u,spectrum", sp, filter, hpsdr_u_spectrum_reset,
+                      hpsdr_u_spectrum_packet, hpsdr_u_spectrum_draw, hpsdr_u_spectrum_finish);
+}
+
+static stat_tap_ui hpsdr_u_spectrum_ui = {
+   REGISTER_STAT_GROUP_GENERIC,
+   NULL,
+   "hpsdr-u,spectrum",
+   hpsdr_u_spectrum_init,
+   0,
+   NULL
+};
+
+void register_hpsdr_u_spectrum_tap(void)
+{
+   register_stat_tap_ui(&hpsdr_u_spectrum_ui, NULL);
+}
@@ -0,0 +1,218 @@
+/* tap_openhpsdr_u_starved.c
+ * OpenHPSDR USB over IP protocol EP2 starved host zero sample runs
+ *
+ * Version: 0.5.0
+ * Author:  Matthew J Wolf, N4MTT
+ *
+ * This file is part of the OpenHPSDR-USB Plug-in for Wireshark.
+ * Matthew J. Wolf <matthew.wolf.hpsdr@speciosus.net>
+ * Copyright 2020 Matthew J. Wolf
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * The OpenHPSDR-USB Plug-in for Wireshark is free software: you can
+ * redistribute it and/or modify it under the terms of the GNU
+ * General Public License as published by the Free Software Foundation,
+ * either version 2 of the License, or (at your option) any later version.
+ *
+ * The OpenHPSDR-USB Plug-in for Wireshark is distributed in the hope that
+ * it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See
+ * the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the OpenHPSDR-USB Plug-in for Wireshark.
+ * If not, see <http://www.gnu.org/licenses/>.
+ *
+ * tshark -z hpsdr-u,starved[,<filter>]
+ *
+ * Zero EP2 samples (Left, Right, I and Q all zero) for every radio and
+ * host. The starved runs are found by the dissector, a run of zero
+ * samples between samples that are not zero and not longer than the
+ * ep2_starved_max preference. The run length percentiles are of the
+ * longest run that ends in a datagram, two runs seldom end in one.
+ */
+
+#include <epan/packet.h>
+#include <epan/tap.h>
+#include <epan/stat_tap_ui.h>
+
+#include <string.h>
+#include "tap_openhpsdr_u.h"
+
+#define STARVED_LISTED 20       // Runs listed
+
+typedef struct _hpsdr_u_starved_run_t {
+   guint32 start;               // First frame of the run
+   guint32 end;                 // Frame the run ends in
+   double time;                 // Seconds from the start of the capture, of the end
+   guint32 samples;
+} hpsdr_u_starved_run_t;
+
+typedef struct _hpsdr_u_starved_link_t {
+   gchar *name;                 // <radio>-<host>
+   gchar *radio;
+   gchar *host;
+   guint32 datagrams;
+   guint32 zero_datagrams;      // Datagrams with a zero sample
+   guint64 zero;
+   guint32 runs;
+   guint64 starved;
+   hpsdr_u_starved_run_t longest;
+   hpsdr_u_starved_run_t listed[STARVED_LISTED];
+   hpsdr_u_tap_dist_t lengths;
+   double first;
+   double last;
+} hpsdr_u_starved_link_t;
+
+typedef struct _hpsdr_u_starved_t {
+   GHashTable *links;
+} hpsdr_u_starved_t;
+
+static void hpsdr_u_starved_link_free(gpointer record)
+{
+   hpsdr_u_starved_link_t *link = (hpsdr_u_starved_link_t *)record;
+
+   hpsdr_u_tap_dist_free(&link->lengths);
+   hpsdr_u_tap_link_free(link);
+}
+
+static void hpsdr_u_starved_reset(void *tapdata)
+{
+   hpsdr_u_starved_t *starved = (hpsdr_u_starved_t *)tapdata;
+
+   g_hash_table_remove_all(starved->links);
+}
+
+static tap_packet_status
+hpsdr_u_starved_packet(void *tapdata, packet_info *pinfo, epan_dissect_t *edt _U_, const void *data)
+{
+   hpsdr_u_starved_t *starved = (hpsdr_u_starved_t *)tapdata;
+   const hpsdr_u_tap_info_t *tap_info = (const hpsdr_u_tap_info_t *)data;
+   hpsdr_u_starved_link_t *link = NULL;
+   hpsdr_u_starved_run_t run;
+   double now = 0;
+
+   if ( tap_info->end_point != 2 ) { return TAP_PACKET_DONT_REDRAW; }
+
+   link = (hpsdr_u_starved_link_t *)hpsdr_u_tap_link_lookup(starved->links, pinfo, tap_info, sizeof(hpsdr_u_starved_link_t));
+
+   now = nstime_to_sec(&pinfo->rel_ts);
+   if ( link->datagrams == 0 ) { link->first = now; }
+   link->last = now;
+   link->datagrams += 1;
+
+   if ( tap_info->ep2_zero > 0 ) {
+      link->zero_datagrams += 1;
+      link->zero += tap_info->ep2_zero;
+   }
+
+   if ( tap_info->ep2_starved_runs == 0 ) { return TAP_PACKET_REDRAW; }
+
+   run.start = tap_info->ep2_run_start;
+   run.end = pinfo->num;
+   run.time = now;
+   run.samples = tap_info->ep2_starved_longest;
+
+   if ( link->runs < STARVED_LISTED ) { link->listed[link->runs] = run; }
+   if ( run.samples > link->longest.samples ) { link->longest = run; }
+
+   link->runs += tap_info->ep2_starved_runs;
+   link->starved += tap_info->ep2_starved;
+   hpsdr_u_tap_dist_add(&link->lengths, run.samples);
+
+   return TAP_PACKET_REDRAW;
+}
+
+static void hpsdr_u_starved_draw(void *tapdata)
+{
+   hpsdr_u_starved_t *starved = (hpsdr_u_starved_t *)tapdata;
+   hpsdr_u_starved_link_t *link = NULL;
+   hpsdr_u_starved_run_t *run = NULL;
+   GList *links = NULL;
+   GList *item = NULL;
+   double samples = 0;
+   double span = 0;
+   guint32 x = 0;
+
+   links = hpsdr_u_tap_radio_list(starved->links);
+
+   printf("\n");
+   printf("===================================================================\n");
+   printf("HPSDR-USB EP2 Starved Host - zero Left, Right, I and Q samples\n");
+
+   for (item = links; item != NULL; item = item->next) {
+      link = (hpsdr_u_starved_link_t *)item->data;
+      samples = (double)link->datagrams * HPSDR_U_FRAMES * HPSDR_U_EP2_SAMPLES;
+      span = link->last - link->first;
+
+      printf("\nRadio: %s  Host: %s\n", link->radio, link->host);
+      printf(" EP2 Datagrams: %u  With Zero Samples: %u\n", link->datagrams, link->zero_datagrams);
+      printf(" Zero Samples: %" G_GUINT64_FORMAT " (%.3f%%)  Starved: %" G_GUINT64_FORMAT " (%.3f%%, %.3f ms)\n",
+             link->zero, ( samples > 0 ) ? 100.0 * link->zero / samples : 0.0,
+             link->starved, ( samples > 0 ) ? 100.0 * link->starved / samples : 0.0,
+             1000.0 * link->starved / HPSDR_U_AUDIO_RATE);
+      printf(" Starved Runs: %u", link->runs);
+      if ( span > 0 ) { printf("  %.2f per minute", 60.0 * link->runs / span); }
+      printf("\n");
+
+      if ( link->runs == 0 ) { continue; }
+
+      printf(" Run Length Samples  p50: %.0f  p99: %.0f  Max: %u (%.3f ms, frames %u to %u)\n",
+             hpsdr_u_tap_dist_percentile(&link->lengths, 50), hpsdr_u_tap_dist_percentile(&link->lengths, 99),
+             link->longest.samples, 1000.0 * link->longest.samples / HPSDR_U_AUDIO_RATE,
+             link->longest.start, link->longest.end);
+
+      printf(" First %u starved runs\n", MIN(link->runs, STARVED_LISTED));
+      printf("      Start        End       Time s   Samples        ms\n");
+      for (x = 0; x < link->runs && x < STARVED_LISTED; x++) {
+         run = &link->listed[x];
+         printf(" %10u %10u %12.6f %9u %9.3f\n", run->start, run->end, run->time, run->samples,
+                1000.0 * run->samples / HPSDR_U_AUDIO_RATE);
+      }
+   }
+
+   printf("===================================================================\n");
+
+   g_list_free(links);
+}
+
+static void hpsdr_u_starved_finish(void *tapdata)
+{
+   hpsdr_u_starved_t *starved = (hpsdr_u_starved_t *)tapdata;
+
+   g_hash_table_destroy(starved->links);
+   g_free(starved);
+}
+
+static void hpsdr_u_starved_init(const char *opt_arg, void *userdata _U_)
+{
+   hpsdr_u_starved_t *starved = NULL;
+   gchar **args = NULL;
+   const gchar *filter = NULL;
+
+   args = hpsdr_u_tap_args(opt_arg, "hpsdr-u,starved", 0, &filter);
+   g_strfreev(args);
+
+   starved = g_new0(hpsdr_u_starved_t, 1);
+   starved->links = hpsdr_u_tap_radio_table(hpsdr_u_starved_link_free);
+
+   hpsdr_u_tap_listen("hpsdr-u,starved", starved, filter, hpsdr_u_starved_reset,
+                      hpsdr_u_starved_packet, hpsdr_u_starved_draw, hpsdr_u_starved_finish);
+}
+
+static stat_tap_ui hpsdr_u_starved_ui = {
+   REGISTER_STAT_GROUP_GENERIC,
+   NULL,
+   "hpsdr-u,starved",
+   hpsdr_u_starved_init,
+   0,
+   NULL
+};
+
+void register_hpsdr_u_starved_tap(void)
+{
+   register_stat_tap_ui(&hpsdr_u_starved_ui, NULL);
+}
@@ -0,0 +1,225 @@
+/* tap_openhpsdr_u_sync.c
+ * OpenHPSDR USB over IP protocol EP2 sync offsets per host
+ *
+ * Version: 0.5.0
+ * Author:  Matthew J Wolf, N4MTT
+ *
+ * This file is part of the OpenHPSDR-USB Plug-in for Wireshark.
+ * Matthew J. Wolf <matthew.wolf.hpsdr@speciosus.net>
+ * Copyright 2020 Matthew J. Wolf
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * The OpenHPSDR-USB Plug-in for Wireshark is free software: you can
+ * redistribute it and/or modify it under the terms of the GNU
+ * General Public License as published by the Free Software Foundation,
+ * either version 2 of the License, or (at your option) any later version.
+ *
+ * The OpenHPSDR-USB Plug-in for Wireshark is distributed in the hope that
+ * it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See
+ * the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the OpenHPSDR-USB Plug-in for Wireshark.
+ * If not, see <http://www.gnu.org/licenses/>.
+ *
+ * tshark -z hpsdr-u,sync[,<filter>]
+ *
+ * Counts the extra bytes some host applications put in front of the EP2
+ * sync, per host. A host application usually puts the same number of
+ * extra bytes in front of every USB frame. The most common offsets are
+ * listed with the first frame that had them.
+ */
+
+#include <epan/packet.h>
+#include <epan/tap.h>
+#include <epan/stat_tap_ui.h>
+
+#include <stdlib.h>
+#include <string.h>
+#include "tap_openhpsdr_u.h"
+
+#define HPSDR_U_SYNC_OFFSETS 64  // Offsets counted one by one, the last counts the larger ones
+#define HPSDR_U_SYNC_LISTED  5   // Most common offsets listed per host
+
+typedef struct _hpsdr_u_sync_offset_t {
+   guint32 offset;              // Extra bytes in front of the sync
+   guint32 frames;
+   guint32 first_frame;         // Wireshark frame number
+} hpsdr_u_sync_offset_t;
+
+typedef struct _hpsdr_u_sync_host_t {
+   gchar *name;
+   guint32 datagrams;           // EP2 datagrams
+   guint32 frames;              // EP2 USB frames
+   guint32 missing;             // USB frames without the sync
+   guint32 missing_first_frame;
+   guint32 not_searched;        // USB frames the dissector did not search, the offset is not known
+   guint32 max_offset;
+   hpsdr_u_sync_offset_t offset[HPSDR_U_SYNC_OFFSETS];
+} hpsdr_u_sync_host_t;
+
+typedef struct _hpsdr_u_sync_t {
+   GHashTable *hosts;
+} hpsdr_u_sync_t;
+
+static void hpsdr_u_sync_reset(void *tapdata)
+{
+   hpsdr_u_sync_t *sync = (hpsdr_u_sync_t *)tapdata;
+
+   g_hash_table_remove_all(sync->hosts);
+}
+
+static tap_packet_status
+hpsdr_u_sync_packet(void *tapdata, packet_info *pinfo, epan_dissect_t *edt _U_, const void *data)
+{
+   hpsdr_u_sync_t *sync = (hpsdr_u_sync_t *)tapdata;
+   const hpsdr_u_tap_info_t *tap_info = (const hpsdr_u_tap_info_t *)data;
+   hpsdr_u_sync_host_t *host = NULL;
+   hpsdr_u_sync_offset_t *offset = NULL;
+
+   gint skew = -1;
+   int x = -1;
+
+   if ( tap_info->end_point != 2 ) { return TAP_PACKET_DONT_REDRAW; }
+
+   host = (hpsdr_u_sync_host_t *)hpsdr_u_tap_radio_lookup(sync->hosts, hpsdr_u_tap_host_name(pinfo, tap_info),
+                                                          sizeof(hpsdr_u_sync_host_t));
+   host->datagrams += 1;
+
+   for (x = 0; x < HPSDR_U_FRAMES; x++) {
+      skew = tap_info->frame[x].sync_skew;
+
+      // The USB frame is past the snaplen of the capture.
+      if ( skew >= 0 && !tap_info->frame[x].have_cc ) { continue; }
+
+      // The sync preference is off or the frame was too short to search.
+      if ( skew == HPSDR_U_SYNC_NOT_SEARCHED ) {
+         if ( tap_info->frame[x].have_cc ) { host->not_searched += 1; }
+         continue;
+      }
+      host->frames += 1;
+
+      if ( skew < 0 ) {
+         if ( host->missing == 0 ) { host->missing_first_frame = pinfo->num; }
+         host->missing += 1;
+         continue;
+      }
+
+      if ( (guint32)skew > host->max_offset ) { host->max_offset = skew; }
+      if ( skew >= HPSDR_U_SYNC_OFFSETS ) { skew = HPSDR_U_SYNC_OFFSETS - 1; }
+
+      offset = &host->offset[skew];
+      if ( offset->frames == 0 ) {
+         offset->offset = skew;
+         offset->first_frame = pinfo->num;
+      }
+      offset->frames += 1;
+   }
+
+   return TAP_PACKET_REDRAW;
+}
+
+static gint hpsdr_u_sync_offset_compare(gconstpointer a, gconstpointer b)
+{
+   const hpsdr_u_sync_offset_t *offset_a = (const hpsdr_u_sync_offset_t *)a;
+   const hpsdr_u_sync_offset_t *offset_b = (const hpsdr_u_sync_offset_t *)b;
+
+   if ( offset_a->frames != offset_b->frames ) {
+      return ( offset_a->frames > offset_b->frames ) ? -1 : 1;
+   }
+
+   return ( offset_a->offset < offset_b->offset ) ? -1 : 1;
+}
+
+static void hpsdr_u_sync_draw(void *tapdata)
+{
+   hpsdr_u_sync_t *sync = (hpsdr_u_sync_t *)tapdata;
+   hpsdr_u_sync_host_t *host = NULL;
+   hpsdr_u_sync_offset_t offsets[HPSDR_U_SYNC_OFFSETS];
+   hpsdr_u_sync_offset_t *offset = NULL;
+   GList *hosts = NULL;
+   GList *item = NULL;
+   guint32 skewed = 0;
+   int x = -1;
+
+   hosts = hpsdr_u_tap_radio_list(sync->hosts);
+
+   printf("\n");
+   printf("===================================================================\n");
+   printf("HPSDR-USB EP2 Sync Offsets\n");
+
+   for (item = hosts; item != NULL; item = item->next) {
+      host = (hpsdr_u_sync_host_t *)item->data;
+
+      skewed = host->frames - host->missing - host->offset[0].frames;
+
+      printf("\nHost: %s  EP2 Datagrams: %u  USB Frames: %u\n", host->name, host->datagrams, host->frames);
+      printf(" Sync in place: %u  Extra bytes: %u  Not found: %u  Most extra bytes: %u\n",
+             host->offset[0].frames, skewed, host->missing, host->max_offset);
+      if ( host->missing > 0 ) {
+         printf(" First frame without the sync: %u\n", host->missing_first_frame);
+      }
+      if ( host->not_searched > 0 ) {
+         printf(" Not searched (EP2 sync preference off): %u\n", host->not_searched);
+      }
+
+      memcpy(offsets, host->offset, sizeof(offsets));
+      qsort(offsets, HPSDR_U_SYNC_OFFSETS, sizeof(hpsdr_u_sync_offset_t), hpsdr_u_sync_offset_compare);
+
+      printf(" Extra Bytes  USB Frames  Percent  First Frame\n");
+      for (x = 0; x < HPSDR_U_SYNC_LISTED; x++) {
+         offset = &offsets[x];
+         if ( offset->frames == 0 ) { break; }
+
+         printf(" %s%10u  %10u  %6.2f%%  %11u\n",
+                ( offset->offset == HPSDR_U_SYNC_OFFSETS - 1 ) ? ">=" : "  ", offset->offset,
+                offset->frames, 100.0 * offset->frames / host->frames, offset->first_frame);
+      }
+   }
+
+   printf("===================================================================\n");
+
+   g_list_free(hosts);
+}
+
+static void hpsdr_u_sync_finish(void *tapdata)
+{
+   hpsdr_u_sync_t *sync = (hpsdr_u_sync_t *)tapdata;
+
+   g_hash_table_destroy(sync->hosts);
+   g_free(sync);
+}
+
+static void hpsdr_u_sync_init(const char *opt_arg, void *userdata _U_)
+{
+   hpsdr_u_sync_t *sync = NULL;
+   gchar **args = NULL;
+   const gchar *filter = NULL;
+
+   args = hpsdr_u_tap_args(opt_arg, "hpsdr-u,sync", 0, &filter);
+   g_strfreev(args);
+
+   sync = g_new0(hpsdr_u_sync_t, 1);
+   sync->hosts = hpsdr_u_tap_radio_table(NULL);
+
+   hpsdr_u_tap_listen("hpsdr-u,sync", sync, filter, hpsdr_u_sync_reset,
+                      hpsdr_u_sync_packet, hpsdr_u_sync_draw, hpsdr_u_sync_finish);
+}
+
+static stat_tap_ui hpsdr_u_sync_ui = {
+   REGISTER_STAT_GROUP_GENERIC,
+   NULL,
+   "hpsdr-u,sync",
+   hpsdr_u_sync_init,
+   0,
+   NULL
+};
+
+void register_hpsdr_u_sync_tap(void)
+{
+   register_stat_tap_ui(&hpsdr_u_sync_ui, NULL);
+}
@@ -0,0 +1,351 @@
+/* tap_openhpsdr_u_telemetry.c
+ * OpenHPSDR USB over IP protocol power, SWR and supply voltage time series
+ *
+ * Version: 0.5.0
+ * Author:  Matthew J Wolf, N4MTT
+ *
+ * This file is part of the OpenHPSDR-USB Plug-in for Wireshark.
+ * Matthew J. Wolf <matthew.wolf.hpsdr@speciosus.net>
+ * Copyright 2020 Matthew J. Wolf
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * The OpenHPSDR-USB Plug-in for Wireshark is free software: you can
+ * redistribute it and/or modify it under the terms of the GNU
+ * General Public License as published by the Free Software Foundation,
+ * either version 2 of the License, or (at your option) any later version.
+ *
+ * The OpenHPSDR-USB Plug-in for Wireshark is distributed in the hope that
+ * it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See
+ * the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the OpenHPSDR-USB Plug-in for Wireshark.
+ * If not, see <http://www.gnu.org/licenses/>.
+ *
+ * tshark -z hpsdr-u,telemetry[,<interval seconds>[,<csv file>[,<filter>]]]
+ *
+ * Collects the EP6 C0 Type 0x01 (Forward Power), 0x02 (Reverse Power, AIN3)
+ * and 0x03 (AIN4, Power Supply) readings of every radio. The readings are
+ * converted with the calibration of the board and reported as min/avg/max
+ * per interval.
+ */
+
+#include <epan/packet.h>
+#include <epan/tap.h>
+#include <epan/stat_tap_ui.h>
+#include <wsutil/file_util.h>
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include "tap_openhpsdr_u.h"
+#include "cal_openhpsdr_u.h"
+
+enum {
+   TELEMETRY_FWD = 0,
+   TELEMETRY_REV,
+   TELEMETRY_SWR,
+   TELEMETRY_SUPPLY,
+   TELEMETRY_AIN3,
+   TELEMETRY_AIN4,
+   TELEMETRY_NUM
+};
+
+static const gchar *hpsdr_u_telemetry_names[TELEMETRY_NUM] = {
+   "Forward Power W",
+   "Reverse Power W",
+   "SWR",
+   "Supply V",
+   "AIN3 V",
+   "AIN4 V",
+};
+
+static const gchar *hpsdr_u_telemetry_csv_names[TELEMETRY_NUM] = {
+   "fwd_w",
+   "rev_w",
+   "swr",
+   "supply_v",
+   "ain3_v",
+   "ain4_v",
+};
+
+typedef struct _hpsdr_u_telemetry_stat_t {
+   guint32 count;
+   double min;
+   double max;
+   double sum;
+} hpsdr_u_telemetry_stat_t;
+
+typedef struct _hpsdr_u_telemetry_row_t {
+   guint32 interval;            // Interval number from the start of the capture
+   hpsdr_u_telemetry_stat_t stat[TELEMETRY_NUM];
+} hpsdr_u_telemetry_row_t;
+
+typedef struct _hpsdr_u_telemetry_radio_t {
+   gchar *name;
+   const hpsdr_u_cal_t *cal;
+   GArray *rows;                // hpsdr_u_telemetry_row_t, only intervals with readings
+   double fwd_watts;            // Last forward power, paired with the next reverse power
+   gboolean have_fwd;
+} hpsdr_u_telemetry_radio_t;
+
+typedef struct _hpsdr_u_telemetry_t {
+   double interval;             // Seconds
+   gchar *csv_name;
+   GHashTable *radios;
+} hpsdr_u_telemetry_t;
+
+static void hpsdr_u_telemetry_radio_free(gpointer record)
+{
+   hpsdr_u_telemetry_radio_t *radio = (hpsdr_u_telemetry_radio_t *)record;
+
+   g_array_free(radio->rows, TRUE);
+   hpsdr_u_tap_radio_free(radio);
+}
+
+static hpsdr_u_telemetry_row_t *hpsdr_u_telemetry_row(hpsdr_u_telemetry_radio_t *radio, guint32 interval)
+{
+   hpsdr_u_telemetry_row_t *row = NULL;
+   hpsdr_u_telemetry_row_t new_row;
+
+   if ( radio->rows->len > 0 ) {
+      row = &g_array_index(radio->rows, hpsdr_u_telemetry_row_t, radio->rows->len - 1);
+      if ( row->interval == interval ) { return row; }
+   }
+
+   memset(&new_row, 0, sizeof(new_row));
+   new_row.interval = interval;
+   g_array_append_val(radio->rows, new_row);
+
+   return &g_array_index(radio->rows, hpsdr_u_telemetry_row_t, radio->rows->len - 1);
+}
+
+static void hpsdr_u_telemetry_add(hpsdr_u_telemetry_row_t *row, int reading, double value)
+{
+   hpsdr_u_telemetry_stat_t *stat = &row->stat[reading];
+
+   if ( stat->count == 0 || value < stat->min ) { stat->min = value; }
+   if ( stat->count == 0 || value > stat->max ) { stat->max = value; }
+   stat->sum += value;
+   stat->count += 1;
+}
+
+static void hpsdr_u_telemetry_reset(void *tapdata)
+{
+   hpsdr_u_telemetry_t *telemetry = (hpsdr_u_telemetry_t *)tapdata;
+
+   g_hash_table_remove_all(telemetry->radios);
+}
+
+static tap_packet_status
+hpsdr_u_telemetry_packet(void *tapdata, packet_info *pinfo, epan_dissect_t *edt _U_, const void *data)
+{
+   hpsdr_u_telemetry_t *telemetry = (hpsdr_u_telemetry_t *)tapdata;
+   const hpsdr_u_tap_info_t *tap_info = (const hpsdr_u_tap_info_t *)data;
+   const hpsdr_u_tap_frame_t *frame = NULL;
+   hpsdr_u_telemetry_radio_t *radio = NULL;
+   hpsdr_u_telemetry_row_t *row = NULL;
+   const hpsdr_u_cal_t *cal = NULL;
+
+   guint16 first = 0;           // C1 C2
+   guint16 second = 0;          // C3 C4
+   double rev_watts = 0;
+   double rho = 0;
+   int x = -1;
+
+   if ( tap_info->end_point != 6 ) { return TAP_PACKET_DONT_REDRAW; }
+
+   radio = (hpsdr_u_telemetry_radio_t *)hpsdr_u_tap_radio_lookup(telemetry->radios,
+                                                                 hpsdr_u_tap_radio_name(pinfo, tap_info),
+                                                                 sizeof(hpsdr_u_telemetry_radio_t));
+   if ( radio->rows == NULL ) {
+      radio->rows = g_array_new(FALSE, FALSE, sizeof(hpsdr_u_telemetry_row_t));
+   }
+
+   cal = hpsdr_u_cal(tap_info->board_id);
+   radio->cal = cal;
+
+   for (x = 0; x < HPSDR_U_FRAMES; x++) {
+      frame = &tap_info->frame[x];
+      if ( !frame->have_cc ) { continue; }
+
+      if ( frame->c0_type < 0x01 || frame->c0_type > 0x03 ) { continue; }
+
+      // Rows are only added for intervals that have a reading.
+      if ( row == NULL ) {
+         row = hpsdr_u_telemetry_row(radio, (guint32)( nstime_to_sec(&pinfo->rel_ts) / telemetry->interval ));
+      }
+
+      first = ( frame->cc[1] << 8 ) | frame->cc[2];
+      second = ( frame->cc[3] << 8 ) | frame->cc[4];
+
+      if ( frame->c0_type == 0x01 ) {         // Forward Power, C3 C4 Alex / Apollo (AIN1)
+         radio->fwd_watts = hpsdr_u_cal_power_watts(cal, second);
+         radio->have_fwd = TRUE;
+         hpsdr_u_telemetry_add(row, TELEMETRY_FWD, radio->fwd_watts);
+
+      } else if ( frame->c0_type == 0x02 ) {  // Reverse Power (AIN2), AIN3
+         rev_watts = hpsdr_u_cal_power_watts(cal, first);
+         hpsdr_u_telemetry_add(row, TELEMETRY_REV, rev_watts);
+         hpsdr_u_telemetry_add(row, TELEMETRY_AIN3, second / 4095.0 * cal->refvoltage);
+
+         // SWR from the last forward power. There is no SWR without forward power.
+         if ( radio->have_fwd && radio->fwd_watts > 0 ) {
+            rho = sqrt(rev_watts / radio->fwd_watts);
+            if ( rho < 1.0 ) {
+               hpsdr_u_telemetry_add(row, TELEMETRY_SWR, ( 1.0 + rho ) / ( 1.0 - rho ));
+            }
+         }
+
+      } else {                                // AIN4, Power Supply (AIN6)
+         hpsdr_u_telemetry_add(row, TELEMETRY_AIN4, first / 4095.0 * cal->refvoltage);
+         hpsdr_u_telemetry_add(row, TELEMETRY_SUPPLY, hpsdr_u_cal_supply_volts(cal, second));
+      }
+   }
+
+   return ( row != NULL ) ? TAP_PACKET_REDRAW : TAP_PACKET_DONT_REDRAW;
+}
+
+static void hpsdr_u_telemetry_csv(hpsdr_u_telemetry_t *telemetry, GList *radios)
+{
+   FILE *fh = NULL;
+   GList *item = NULL;
+   hpsdr_u_telemetry_radio_t *radio = NULL;
+   hpsdr_u_telemetry_row_t *row = NULL;
+   hpsdr_u_telemetry_stat_t *stat = NULL;
+   guint x = 0;
+   int y = -1;
+
+   fh = ws_fopen(telemetry->csv_name, "w");
+   if ( fh == NULL ) {
+      fprintf(stderr, "tshark: hpsdr-u,telemetry can not open %s\n", telemetry->csv_name);
+      return;
+   }
+
+   fprintf(fh, "radio,board,start_s");
+   for (y = 0; y < TELEMETRY_NUM; y++) {
+      fprintf(fh, ",%s_min,%s_avg,%s_max", hpsdr_u_telemetry_csv_names[y],
+              hpsdr_u_telemetry_csv_names[y], hpsdr_u_telemetry_csv_names[y]);
+   }
+   fprintf(fh, "\n");
+
+   for (item = radios; item != NULL; item = item->next) {
+      radio = (hpsdr_u_telemetry_radio_t *)item->data;
+
+      for (x = 0; x < radio->rows->len; x++) {
+         row = &g_array_index(radio->rows, hpsdr_u_telemetry_row_t, x);
+
+         fprintf(fh, "%s,%s,%.3f", radio->name, radio->cal->name, row->interval * telemetry->interval);
+         for (y = 0; y < TELEMETRY_NUM; y++) {
+            stat = &row->stat[y];
+            if ( stat->count == 0 ) {
+               fprintf(fh, ",,,");
+            } else {
+               fprintf(fh, ",%.4f,%.4f,%.4f", stat->min, stat->sum / stat->count, stat->max);
+            }
+         }
+         fprintf(fh, "\n");
+      }
+   }
+
+   fclose(fh);
+}
+
+static void hpsdr_u_telemetry_draw(void *tapdata)
+{
+   hpsdr_u_telemetry_t *telemetry = (hpsdr_u_telemetry_t *)tapdata;
+   hpsdr_u_telemetry_radio_t *radio = NULL;
+   hpsdr_u_telemetry_row_t *row = NULL;
+   hpsdr_u_telemetry_stat_t *stat = NULL;
+   GList *radios = NULL;
+   GList *item = NULL;
+   gboolean first_line = TRUE;
+   guint x = 0;
+   int y = -1;
+
+   radios = hpsdr_u_tap_radio_list(telemetry->radios);
+
+   printf("\n");
+   printf("===================================================================\n");
+   printf("HPSDR-USB Telemetry - Interval: %.3f s\n", telemetry->interval);
+
+   for (item = radios; item != NULL; item = item->next) {
+      radio = (hpsdr_u_telemetry_radio_t *)item->data;
+
+      printf("\nRadio: %s  Board: %s  Bridge: %.3f V  Reference: %.2f V  ADC Offset: %d\n",
+             radio->name, radio->cal->name, radio->cal->bridge_volt,
+             radio->cal->refvoltage, radio->cal->adc_cal_offset);
+      printf("  Start s  Reading              Count          Min          Avg          Max\n");
+
+      for (x = 0; x < radio->rows->len; x++) {
+         row = &g_array_index(radio->rows, hpsdr_u_telemetry_row_t, x);
+         first_line = TRUE;
+
+         for (y = 0; y < TELEMETRY_NUM; y++) {
+            stat = &row->stat[y];
+            if ( stat->count == 0 ) { continue; }
+
+            if ( first_line ) {
+               printf("%9.3f", row->interval * telemetry->interval);
+               first_line = FALSE;
+            } else {
+               printf("%9s", "");
+            }
+            printf("  %-16s %9u %12.4f %12.4f %12.4f\n", hpsdr_u_telemetry_names[y],
+                   stat->count, stat->min, stat->sum / stat->count, stat->max);
+         }
+      }
+   }
+
+   printf("===================================================================\n");
+
+   if ( telemetry->csv_name != NULL ) { hpsdr_u_telemetry_csv(telemetry, radios); }
+
+   g_list_free(radios);
+}
+
+static void hpsdr_u_telemetry_finish(void *tapdata)
+{
+   hpsdr_u_telemetry_t *telemetry = (hpsdr_u_telemetry_t *)tapdata;
+
+   g_hash_table_destroy(telemetry->radios);
+   g_free(telemetry->csv_name);
+   g_free(telemetry);
+}
+
+static void hpsdr_u_telemetry_init(const char *opt_arg, void *userdata _U_)
+{
+   hpsdr_u_telemetry_t *telemetry = NULL;
+   gchar **args = NULL;
+   const gchar *filter = NULL;
+
+   args = hpsdr_u_tap_args(opt_arg, "hpsdr-u,telemetry", 2, &filter);
+
+   telemetry = g_new0(hpsdr_u_telemetry_t, 1);
+   telemetry->interval = hpsdr_u_tap_number(args[0], "hpsdr-u,telemetry", "interval", 0);
+   if ( telemetry->interval <= 0 ) { telemetry->interval = 1.0; }
+   if ( args[1][0] != '\0' ) { telemetry->csv_name = g_strdup(args[1]); }
+   telemetry->radios = hpsdr_u_tap_radio_table(hpsdr_u_telemetry_radio_free);
+   g_strfreev(args);
+
+   hpsdr_u_tap_listen("hpsdr-u,telemetry", telemetry, filter, hpsdr_u_telemetry_reset,
+                      hpsdr_u_telemetry_packet, hpsdr_u_telemetry_draw, hpsdr_u_telemetry_finish);
+}
+
+static stat_tap_ui hpsdr_u_telemetry_ui = {
+   REGISTER_STAT_GROUP_GENERIC,
+   NULL,
+   "hpsdr-u,telemetry",
+   hpsdr_u_telemetry_init,
+   0,
+   NULL
+};
+
+void register_hpsdr_u_telemetry_tap(void)
+{
+   register_stat_tap_ui(&hpsdr_u_telemetry_ui, NULL);
+}
@@ -0,0 +1,415 @@
+/* tap_openhpsdr_u_txbuffer.c
+ * OpenHPSDR USB over IP protocol EP2 host pacing and radio TX buffer model
+ *
+ * Version: 0.5.0
+ * Author:  Matthew J Wolf, N4MTT
+ *
+ * This file is part of the OpenHPSDR-USB Plug-in for Wireshark.
+ * Matthew J. Wolf <matthew.wolf.hpsdr@speciosus.net>
+ * Copyright 2020 Matthew J. Wolf
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * The OpenHPSDR-USB Plug-in for Wireshark is free software: you can
+ * redistribute it and/or modify it under the terms of the GNU
+ * General Public License as published by the Free Software Foundation,
+ * either version 2 of the License, or (at your option) any later version.
+ *
+ * The OpenHPSDR-USB Plug-in for Wireshark is distributed in the hope that
+ * it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See
+ * the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the OpenHPSDR-USB Plug-in for Wireshark.
+ * If not, see <http://www.gnu.org/licenses/>.
+ *
+ * tshark -z hpsdr-u,txbuffer[,<buffer samples>[,<interval seconds>[,<filter>]]]
+ *
+ * Model of the radio TX buffer for every radio and host. Every EP2
+ * datagram adds 126 L/R/I/Q samples, the radio takes them out at 48 kHz
+ * (the EP2 samples are 48 kHz at every EP2 speed). The 48 kHz is measured
+ * in the capture clock: it is scaled by the EP6 sample rate seen so far in
+ * the session against the EP2 speed, so a radio clock off from the
+ * capture clock does not build up into false underruns. The capture clock
+ * is used until TXBUFFER_CLOCK_SPAN seconds of EP6 datagrams are seen. The
+ * EP6 datagrams missing by the sequence numbers are counted in the expected
+ * time, the time between the runs of restarted sequence numbers is not. The
+ * buffer is <buffer samples> deep (4096 when not given) and starts half
+ * full at the first EP2 datagram. The model runs as the EP2 datagrams
+ * arrive, only the first underruns and overfills are kept.
+ *
+ * A underrun is the buffer empty before a datagram arrives, a overfill a
+ * datagram that does not fit. The buffer fill (at every arrival), the EP2
+ * inter-arrival time and the EP2 and EP6 datagram rates against the
+ * expected rates are reported. The intervals are only reported when a
+ * interval is given.
+ */
+
+#include <epan/packet.h>
+#include <epan/tap.h>
+#include <epan/stat_tap_ui.h>
+
+#include <stdlib.h>
+#include <string.h>
+#include "sample_openhpsdr_u.h"
+#include "tap_openhpsdr_u.h"
+
+#define TXBUFFER_SAMPLES  4096  // Default buffer depth
+#define TXBUFFER_LISTED   20    // Underruns and overfills listed
+#define TXBUFFER_CLOCK_SPAN 1.0 // Seconds of EP6 datagrams before the radio clock is used
+#define TXBUFFER_DATAGRAM ( HPSDR_U_FRAMES * HPSDR_U_EP2_SAMPLES )
+
+typedef struct _hpsdr_u_txbuffer_event_t {
+   gboolean overfill;
+   guint32 frame_num;
+   double time;
+   double samples;              // Missing (underrun) or dropped (overfill)
+} hpsdr_u_txbuffer_event_t;
+
+typedef struct _hpsdr_u_txbuffer_row_t {
+   guint32 interval;            // Interval number from the start of the capture
+   double min;                  // Fill in samples
+   double max;
+   guint32 underruns;
+   guint32 overfills;
+} hpsdr_u_txbuffer_row_t;
+
+typedef struct _hpsdr_u_txbuffer_link_t {
+   gchar *name;                 // <radio>-<host>
+   gchar *radio;
+   gchar *host;
+   guint32 ep2_datagrams;
+   double ep2_first;
+   double ep2_last;
+   double fill;                 // Samples in the buffer after the last EP2 datagram
+   guint32 underruns;
+   guint32 overfills;
+   hpsdr_u_txbuffer_event_t events[TXBUFFER_LISTED]; // The first underruns and overfills
+   GArray *rows;                // hpsdr_u_txbuffer_row_t, NULL when there are no intervals
+   hpsdr_u_tap_dist_t fill_dist; // Fill at every EP2 datagram, before its samples are added
+   hpsdr_u_tap_dist_t gap_dist; // EP2 inter-arrival seconds
+   guint32 ep6_datagrams;       // With a known number of receivers
+   guint32 ep6_last_seq;
+   guint32 ep6_missing;         // Datagrams missing by the sequence numbers
+   guint32 ep6_late;            // Datagrams behind the last sequence number, not counted
+   guint32 ep6_restarts;        // Runs of sequence numbers after the first
+   double ep6_first;
+   double ep6_last;
+   double ep6_run_first;        // First datagram of the run
+   double ep6_span;             // Capture seconds of the finished runs
+   double ep6_samples;          // Samples per receiver, the last datagram not counted
+   double ep6_expected;         // Sum of the expected datagram periods, the last not counted
+   double ep6_period;           // Expected period of the last datagram
+} hpsdr_u_txbuffer_link_t;
+
+typedef struct _hpsdr_u_txbuffer_t {
+   double buffer;               // Samples
+   double interval;             // Seconds, 0 when there are no intervals
+   GHashTable *links;
+} hpsdr_u_txbuffer_t;
+
+static void hpsdr_u_txbuffer_link_free(gpointer record)
+{
+   hpsdr_u_txbuffer_link_t *link = (hpsdr_u_txbuffer_link_t *)record;
+
+   if ( link->rows != NULL ) { g_array_free(link->rows, TRUE); }
+   hpsdr_u_tap_dist_free(&link->fill_dist);
+   hpsdr_u_tap_dist_free(&link->gap_dist);
+   hpsdr_u_tap_link_free(link);
+}
+
+static void hpsdr_u_txbuffer_reset(void *tapdata)
+{
+   hpsdr_u_txbuffer_t *txbuffer = (hpsdr_u_txbuffer_t *)tapdata;
+
+   g_hash_table_remove_all(txbuffer->links);
+}
+
+static hpsdr_u_txbuffer_row_t *hpsdr_u_txbuffer_row(GArray *rows, guint32 interval, double fill)
+{
+   hpsdr_u_txbuffer_row_t *row = NULL;
+
+   if ( rows->len > 0 ) {
+      row = &g_array_index(rows, hpsdr_u_txbuffer_row_t, rows->len - 1);
+      if ( row->interval == interval ) { return row; }
+   }
+
+   g_array_set_size(rows, rows->len + 1);
+   row = &g_array_index(rows, hpsdr_u_txbuffer_row_t, rows->len - 1);
+   memset(row, 0, sizeof(hpsdr_u_txbuffer_row_t));
+   row->interval = interval;
+   row->min = fill;
+   row->max = fill;
+
+   return row;
+}
+
+// Radio clock in the capture clock, from the EP6 datagrams so far. 1.0
+// until there are min_span seconds of EP6 datagrams.
+static double hpsdr_u_txbuffer_clock(const hpsdr_u_txbuffer_link_t *link, double min_span)
+{
+   double ep6_span = 0;
+
+   ep6_span = link->ep6_span + ( link->ep6_last - link->ep6_run_first );
+   if ( link->ep6_datagrams > 1 && link->ep6_expected > 0 && ep6_span > 0 && ep6_span >= min_span ) {
+      return link->ep6_expected / ep6_span;
+   }
+
+   return 1.0;
+}
+
+// Step the buffer model to a EP2 datagram.
+static void hpsdr_u_txbuffer_arrival(hpsdr_u_txbuffer_t *txbuffer, hpsdr_u_txbuffer_link_t *link, double now,
+                                     guint32 frame_num)
+{
+   hpsdr_u_txbuffer_event_t event;
+   hpsdr_u_txbuffer_row_t *row = NULL;
+   double rate = 0;
+
+   rate = HPSDR_U_AUDIO_RATE * hpsdr_u_txbuffer_clock(link, TXBUFFER_CLOCK_SPAN);
+
+   if ( link->ep2_datagrams == 0 ) {
+      link->ep2_first = now;
+      link->fill = txbuffer->buffer / 2;
+   } else {
+      hpsdr_u_tap_dist_add(&link->gap_dist, now - link->ep2_last);
+      link->fill -= rate * ( now - link->ep2_last );
+   }
+   link->ep2_last = now;
+   link->ep2_datagrams += 1;
+
+   event.frame_num = frame_num;
+   event.time = now;
+   event.overfill = FALSE;
+   event.samples = 0;
+
+   if ( txbuffer->interval > 0 ) {
+      if ( link->rows == NULL ) { link->rows = g_array_new(FALSE, FALSE, sizeof(hpsdr_u_txbuffer_row_t)); }
+      row = hpsdr_u_txbuffer_row(link->rows, (guint32)( now / txbuffer->interval ), MAX(link->fill, 0));
+   }
+
+   if ( link->fill < 0 ) {
+      event.samples = -link->fill;
+      if ( link->underruns + link->overfills < TXBUFFER_LISTED ) {
+         link->events[link->underruns + link->overfills] = event;
+      }
+      link->underruns += 1;
+      if ( row != NULL ) { row->underruns += 1; }
+      link->fill = 0;
+   }
+
+   hpsdr_u_tap_dist_add(&link->fill_dist, link->fill);
+   if ( row != NULL && link->fill < row->min ) { row->min = link->fill; }
+
+   link->fill += TXBUFFER_DATAGRAM;
+   if ( link->fill > txbuffer->buffer ) {
+      event.overfill = TRUE;
+      event.samples = link->fill - txbuffer->buffer;
+      if ( link->underruns + link->overfills < TXBUFFER_LISTED ) {
+         link->events[link->underruns + link->overfills] = event;
+      }
+      link->overfills += 1;
+      if ( row != NULL ) { row->overfills += 1; }
+      link->fill = txbuffer->buffer;
+   }
+   if ( row != NULL && link->fill > row->max ) { row->max = link->fill; }
+}
+
+static tap_packet_status
+hpsdr_u_txbuffer_packet(void *tapdata, packet_info *pinfo, epan_dissect_t *edt _U_, const void *data)
+{
+   hpsdr_u_txbuffer_t *txbuffer = (hpsdr_u_txbuffer_t *)tapdata;
+   const hpsdr_u_tap_info_t *tap_info = (const hpsdr_u_tap_info_t *)data;
+   hpsdr_u_txbuffer_link_t *link = NULL;
+   double now = 0;
+   gint32 delta = 0;
+   int samples = 0;
+
+   if ( tap_info->end_point != 2 && tap_info->end_point != 6 ) { return TAP_PACKET_DONT_REDRAW; }
+
+   link = (hpsdr_u_txbuffer_link_t *)hpsdr_u_tap_link_lookup(txbuffer->links, pinfo, tap_info,
+                                                            sizeof(hpsdr_u_txbuffer_link_t));
+   now = nstime_to_sec(&pinfo->rel_ts);
+
+   if ( tap_info->end_point == 2 ) {
+      hpsdr_u_txbuffer_arrival(txbuffer, link, now, pinfo->num);
+      return TAP_PACKET_REDRAW;
+   }
+
+   samples = HPSDR_U_FRAMES * hpsdr_u_ep6_samples(tap_info->rx_num);
+   if ( samples == 0 ) { return TAP_PACKET_DONT_REDRAW; }
+
+   if ( link->ep6_datagrams > 0 ) {
+      delta = (gint32)( tap_info->seq - link->ep6_last_seq );
+   }
+
+   // The samples and the expected time of a datagram are counted when the next one arrives.
+   // The missing datagrams have the period of the last datagram.
+   if ( link->ep6_datagrams == 0 ) {
+      link->ep6_first = now;
+      link->ep6_run_first = now;
+   } else if ( delta < -HPSDR_U_SAMPLE_LATE_MAX || delta > HPSDR_U_SAMPLE_GAP_MAX ) {
+      link->ep6_restarts += 1;
+      link->ep6_span += link->ep6_last - link->ep6_run_first;
+      link->ep6_run_first = now;
+   } else if ( delta <= 0 ) {
+      link->ep6_late += 1;
+      return TAP_PACKET_DONT_REDRAW;
+   } else {
+      link->ep6_missing += delta - 1;
+      link->ep6_expected += delta * link->ep6_period;
+   }
+   link->ep6_last_seq = tap_info->seq;
+   link->ep6_period = (double)samples / ( HPSDR_U_AUDIO_RATE << tap_info->speed_num );
+   link->ep6_datagrams += 1;
+   link->ep6_last = now;
+
+   return TAP_PACKET_REDRAW;
+}
+
+static void hpsdr_u_txbuffer_print_dist(const gchar *label, hpsdr_u_tap_dist_t *dist, double scale)
+{
+   printf("  %-22s %10.3f %10.3f %10.3f %10.3f %10.3f\n", label, hpsdr_u_tap_dist_percentile(dist, 0) * scale,
+          hpsdr_u_tap_dist_percentile(dist, 1) * scale, hpsdr_u_tap_dist_percentile(dist, 50) * scale,
+          hpsdr_u_tap_dist_percentile(dist, 99) * scale, hpsdr_u_tap_dist_percentile(dist, 100) * scale);
+}
+
+// Report of the buffer model of a session.
+static void hpsdr_u_txbuffer_link_draw(hpsdr_u_txbuffer_t *txbuffer, hpsdr_u_txbuffer_link_t *link)
+{
+   hpsdr_u_txbuffer_event_t *listed = NULL;
+   hpsdr_u_txbuffer_row_t *row = NULL;
+   double clock = 1.0;
+   double rate = 0;
+   double span = 0;
+   double ep6_span = 0;
+   guint32 ep6_periods = 0;
+   guint x = 0;
+
+   // The periods are the ones counted in ep6_expected, the missing datagrams included.
+   ep6_span = link->ep6_span + ( link->ep6_last - link->ep6_run_first );
+   ep6_periods = link->ep6_datagrams - 1 - link->ep6_restarts + link->ep6_missing;
+   clock = hpsdr_u_txbuffer_clock(link, 0);
+   rate = HPSDR_U_AUDIO_RATE * clock;
+
+   span = link->ep2_last - link->ep2_first;
+
+   printf("\nRadio: %s  Host: %s\n", link->radio, link->host);
+   printf(" EP2 Datagrams: %u  Rate: %.2f/s  Expected: %.2f/s\n", link->ep2_datagrams,
+          ( span > 0 ) ? ( link->ep2_datagrams - 1 ) / span : 0.0, (double)HPSDR_U_AUDIO_RATE / TXBUFFER_DATAGRAM);
+   if ( link->ep6_datagrams > 1 && link->ep6_expected > 0 && ep6_span > 0 ) {
+      printf(" EP6 Datagrams: %u  Rate: %.2f/s  Expected: %.2f/s  Radio Clock: %+.1f ppm of the capture clock\n",
+             link->ep6_datagrams, ep6_periods / ep6_span, ep6_periods / link->ep6_expected, ( clock - 1.0 ) * 1e6);
+      printf(" EP6 Missing: %u  Late: %u  Sequence Restarts: %u\n", link->ep6_missing, link->ep6_late,
+             link->ep6_restarts);
+   } else {
+      printf(" EP6 Datagrams: %u, the radio clock is taken to be the capture clock.\n", link->ep6_datagrams);
+   }
+   printf(" Buffer: %.0f samples (%.3f ms)  TX Drain: %.1f samples/s\n", txbuffer->buffer,
+          txbuffer->buffer / rate * 1000, rate);
+   printf(" Predicted Underruns: %u  Overfills: %u\n", link->underruns, link->overfills);
+
+   if ( link->ep2_datagrams > 1 ) {
+      printf("  %-22s %10s %10s %10s %10s %10s\n", "", "Min", "p1", "p50", "p99", "Max");
+      hpsdr_u_txbuffer_print_dist("Buffer fill samples", &link->fill_dist, 1.0);
+      hpsdr_u_txbuffer_print_dist("Buffer fill ms", &link->fill_dist, 1000.0 / rate);
+      hpsdr_u_txbuffer_print_dist("EP2 inter-arrival ms", &link->gap_dist, 1000.0);
+   }
+
+   if ( link->underruns + link->overfills > 0 ) {
+      printf(" First %u underruns and overfills\n", MIN(link->underruns + link->overfills, TXBUFFER_LISTED));
+      printf("      Frame       Time s  Event       Samples\n");
+      for (x = 0; x < link->underruns + link->overfills && x < TXBUFFER_LISTED; x++) {
+         listed = &link->events[x];
+         printf(" %10u %12.6f  %-9s %9.1f\n", listed->frame_num, listed->time,
+                listed->overfill ? "Overfill" : "Underrun", listed->samples);
+      }
+   }
+
+   if ( link->rows != NULL ) {
+      printf(" Interval: %.3f s\n", txbuffer->interval);
+      printf("  Start s   Min Fill   Max Fill  Underruns  Overfills\n");
+      for (x = 0; x < link->rows->len; x++) {
+         row = &g_array_index(link->rows, hpsdr_u_txbuffer_row_t, x);
+         printf("%9.3f %10.1f %10.1f %10u %10u\n", row->interval * txbuffer->interval, row->min, row->max,
+                row->underruns, row->overfills);
+      }
+   }
+}
+
+static void hpsdr_u_txbuffer_draw(void *tapdata)
+{
+   hpsdr_u_txbuffer_t *txbuffer = (hpsdr_u_txbuffer_t *)tapdata;
+   hpsdr_u_txbuffer_link_t *link = NULL;
+   GList *links = NULL;
+   GList *item = NULL;
+
+   links = hpsdr_u_tap_radio_list(txbuffer->links);
+
+   printf("\n");
+   printf("===================================================================\n");
+   printf("HPSDR-USB EP2 Host Pacing and TX Buffer Model - fill in 48 kHz samples\n");
+
+   for (item = links; item != NULL; item = item->next) {
+      link = (hpsdr_u_txbuffer_link_t *)item->data;
+      if ( link->ep2_datagrams == 0 ) { continue; }
+      hpsdr_u_txbuffer_link_draw(txbuffer, link);
+   }
+
+   printf("===================================================================\n");
+
+   g_list_free(links);
+}
+
+static void hpsdr_u_txbuffer_finish(void *tapdata)
+{
+   hpsdr_u_txbuffer_t *txbuffer = (hpsdr_u_txbuffer_t *)tapdata;
+
+   g_hash_table_destroy(txbuffer->links);
+   g_free(txbuffer);
+}
+
+static void hpsdr_u_txbuffer_init(const char *opt_arg, void *userdata _U_)
+{
+   hpsdr_u_txbuffer_t *txbuffer = NULL;
+   gchar **args = NULL;
+   const gchar *filter = NULL;
+   int buffer = -1;
+
+   args = hpsdr_u_tap_args(opt_arg, "hpsdr-u,txbuffer", 2, &filter);
+
+   buffer = (int)hpsdr_u_tap_number(args[0], "hpsdr-u,txbuffer", "buffer samples", TXBUFFER_SAMPLES);
+   if ( buffer < TXBUFFER_DATAGRAM ) {
+      fprintf(stderr, "tshark: hpsdr-u,txbuffer buffer samples %d is less than a datagram, %d samples\n",
+              buffer, TXBUFFER_DATAGRAM);
+      g_strfreev(args);
+      exit(1);
+   }
+
+   txbuffer = g_new0(hpsdr_u_txbuffer_t, 1);
+   txbuffer->buffer = buffer;
+   txbuffer->interval = hpsdr_u_tap_number(args[1], "hpsdr-u,txbuffer", "interval", 0);
+   if ( txbuffer->interval < 0 ) { txbuffer->interval = 0; }
+   txbuffer->links = hpsdr_u_tap_radio_table(hpsdr_u_txbuffer_link_free);
+   g_strfreev(args);
+
+   hpsdr_u_tap_listen("hpsdr-u,txbuffer", txbuffer, filter, hpsdr_u_txbuffer_reset,
+                      hpsdr_u_txbuffer_packet, hpsdr_u_txbuffer_draw, hpsdr_u_txbuffer_finish);
+}
+
+static stat_tap_ui hpsdr_u_txbuffer_ui = {
+   REGISTER_STAT_GROUP_GENERIC,
+   NULL,
+   "hpsdr-u,txbuffer",
+   hpsdr_u_txbuffer_init,
+   0,
+   NULL
+};
+
+void register_hpsdr_u_txbuffer_tap(void)
+{
+   register_stat_tap_ui(&hpsdr_u_txbuffer_ui, NULL);
+}
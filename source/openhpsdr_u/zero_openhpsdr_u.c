@@ -0,0 +1,74 @@
+/* zero_openhpsdr_u.c
+ * OpenHPSDR USB over IP protocol EP2 zero sample scan
+ *
+ * Version: 0.5.0
+ * Author:  Matthew J Wolf, N4MTT
+ *
+ * This file is part of the OpenHPSDR-USB Plug-in for Wireshark.
+ * Matthew J. Wolf <matthew.wolf.hpsdr@speciosus.net>
+ * Copyright 2020 Matthew J. Wolf
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * The OpenHPSDR-USB Plug-in for Wireshark is free software: you can
+ * redistribute it and/or modify it under the terms of the GNU
+ * General Public License as published by the Free Software Foundation,
+ * either version 2 of the License, or (at your option) any later version.
+ *
+ * The OpenHPSDR-USB Plug-in for Wireshark is distributed in the hope that
+ * it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See
+ * the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the OpenHPSDR-USB Plug-in for Wireshark.
+ * If not, see <http://www.gnu.org/licenses/>.
+ *
+ * A host that can not keep up sends EP2 USB frames with zero Left, Right,
+ * I and Q samples in place of the samples it did not have. Most EP2 USB
+ * frames have no zero samples, the scan is for the 504 sample bytes of
+ * every EP2 USB frame.
+ */
+
+#include <epan/packet.h>
+
+#include <string.h>
+#include "zero_openhpsdr_u.h"
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+guint64 hpsdr_u_zero_mask(const guint8 *data, int count)
+{
+   guint64 mask = 0;
+   guint64 sample = 0;
+   int x = 0;
+
+   if ( count > 64 ) { count = 64; }
+
+#ifdef __SSE2__
+   // Two samples at a time. A compare is 0xFF in the bytes that are zero,
+   // a sample is zero when all of its eight bytes are.
+   __m128i v_zero = _mm_setzero_si128();
+   int bits = 0;
+
+   for (x = 0; x + 2 <= count; x += 2) {
+      bits = _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128((const __m128i *)( data + ( x * HPSDR_U_ZERO_SAMPLE ) )),
+                                              v_zero));
+      if ( bits == 0 ) { continue; }
+      if ( ( bits & 0x00FF ) == 0x00FF ) { mask |= G_GUINT64_CONSTANT(1) << x; }
+      if ( ( bits & 0xFF00 ) == 0xFF00 ) { mask |= G_GUINT64_CONSTANT(1) << ( x + 1 ); }
+   }
+#endif
+
+   // The sample left over from the SSE2 loop, or all of them without SSE2.
+   for (; x < count; x++) {
+      memcpy(&sample, data + ( x * HPSDR_U_ZERO_SAMPLE ), sizeof(sample));
+      if ( sample == 0 ) { mask |= G_GUINT64_CONSTANT(1) << x; }
+   }
+
+   return mask;
+}
@@ -0,0 +1,35 @@
+/* zero_openhpsdr_u.h
+ * Header file for the OpenHPSDR USB over IP protocol EP2 zero sample scan
+ *
+ * Version: 0.5.0
+ * Author:  Matthew J Wolf, N4MTT
+ *
+ * This file is part of the OpenHPSDR-USB Plug-in for Wireshark.
+ * Matthew J. Wolf <matthew.wolf.hpsdr@speciosus.net>
+ * Copyright 2020 Matthew J. Wolf
+ *
+ * The OpenHPSDR-USB Plug-in for Wireshark is free software: you can
+ * redistribute it and/or modify it under the terms of the GNU
+ * General Public License as published by the Free Software Foundation,
+ * either version 2 of the License, or (at your option) any later version.
+ *
+ * The OpenHPSDR-USB Plug-in for Wireshark is distributed in the hope that
+ * it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See
+ * the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the OpenHPSDR-USB Plug-in for Wireshark.
+ * If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __ZERO_OPENHPSDR_U_H__
+#define __ZERO_OPENHPSDR_U_H__
+
+#define HPSDR_U_ZERO_SAMPLE 8   // Bytes of a EP2 sample, Left, Right, I and Q
+
+// Zero samples of count (64 or less) EP2 samples. Bit x is set when the
+// Left, Right, I and Q of sample x are all zero.
+guint64 hpsdr_u_zero_mask(const guint8 *data, int count);
+
+#endif